@@ -61,13 +61,11 @@ void DynBufExampleApp::OnInitializeContent()
 	// Setting the relative shader parameter
 	meshShaderParamDefinitions.emplace_back(Mox::HashSpName("c_mod"), m_ColorModBuffer.get());
 
-	m_CubeEntity = &AddEntity({ Mox::Vector3f::Zero() });
+	m_CubeEntity = AddEntity({ Mox::Vector3f::Zero() });
+	Mox::Entity& cubeEntity = *GetEntity(m_CubeEntity);
 
-	std::unique_ptr<Mox::MeshComponent> cubeMesh = std::make_unique<Mox::MeshComponent>(
-		Mox::DrawableCreationInfo{ m_CubeEntity->GetRenderProxy().get(), m_VertexBuffer, m_IndexBuffer, std::move(meshShaderParamDefinitions)}, *m_CubeEntity);
-
-
-	m_CubeEntity->AddComponent(std::move(cubeMesh));
+	cubeEntity.AddComponent<Mox::MeshComponent>(
+		Mox::DrawableCreationInfo{ cubeEntity.GetRenderProxy().get(), m_VertexBuffer, m_IndexBuffer, std::move(meshShaderParamDefinitions)});
 
 	// Window events delegates
 	m_MainWindow->OnMouseMoveDelegate.Add<DynBufExampleApp, &DynBufExampleApp::OnMouseMove>(this);
@@ -87,7 +85,7 @@ void DynBufExampleApp::OnMouseWheel(float InDeltaRot)
 {
 	static float curScale = 1.0f;
 	curScale = std::clamp<float>(curScale + (InDeltaRot > 0 ? 0.4f : -0.4f), 0.1f, 3.f);
-	m_CubeEntity->SetScale(curScale, 1.0, 1.0);
+	GetEntity(m_CubeEntity)->SetScale(curScale, 1.0, 1.0);
 
 
 }
@@ -105,14 +103,14 @@ void DynBufExampleApp::OnMouseMove(int32_t InX, int32_t InY)
 
 void DynBufExampleApp::OnLeftMouseDrag(int32_t InDeltaX, int32_t InDeltaY)
 {
-	m_CubeEntity->Rotate(
+	GetEntity(m_CubeEntity)->Rotate(
 		-InDeltaX / static_cast<float>(m_MainWindow->GetFrameWidth()),
 		-InDeltaY / static_cast<float>(m_MainWindow->GetFrameHeight()));
 }
 
 void DynBufExampleApp::OnRightMouseDrag(int32_t InDeltaX, int32_t InDeltaY)
 {
-	m_CubeEntity->Translate(InDeltaX / static_cast<float>(m_MainWindow->GetFrameWidth()), -InDeltaY / static_cast<float>(m_MainWindow->GetFrameHeight()), 0.f);
+	GetEntity(m_CubeEntity)->Translate(InDeltaX / static_cast<float>(m_MainWindow->GetFrameWidth()), -InDeltaY / static_cast<float>(m_MainWindow->GetFrameHeight()), 0.f);
 }
 
 void DynBufExampleApp::OnTypingKeyPressed(Mox::KEYBOARD_KEY InKeyPressed)
@@ -45,7 +45,7 @@ private:
 
 	Mox::PipelineState* m_PipelineState;
 
-	Mox::Entity* m_CubeEntity;
+	Mox::EntityHandle m_CubeEntity;
 
 
 	// Vertex data for colored cube
@@ -0,0 +1,131 @@
+/*
+ MatrixKernelsBenchmark.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include "MoxMath.h"
+#include "MoxMatrixKernels.h"
+
+// Compares the batch matrix kernels, on every instruction set supported by the running CPU,
+// with a per-component path where each component owns its matrices and computes its own product on a virtual callback.
+// Build in Release to get meaningful numbers.
+
+namespace
+{
+	// Mimics a component reacting to a transform change one at a time, with its data scattered on the heap
+	class PerComponentTransform
+	{
+	public:
+		virtual ~PerComponentTransform() = default;
+
+		virtual void OnTransformChanged(const Mox::Matrix4f& InViewProj)
+		{
+			m_Mvp = InViewProj * m_Model;
+		}
+
+		Mox::Matrix4f m_Model;
+		Mox::Matrix4f m_Mvp;
+	};
+
+	constexpr int RepetitionsNum = 5;
+
+	// Returns the best time out of all the repetitions, in nanoseconds per matrix
+	template<typename FuncType>
+	double MeasureNsPerMatrix(size_t InMatricesNum, FuncType&& InFunc)
+	{
+		double bestNs = std::numeric_limits<double>::max();
+		for (int repIdx = 0; repIdx < RepetitionsNum; ++repIdx)
+		{
+			const auto t0 = std::chrono::steady_clock::now();
+			InFunc();
+			const auto t1 = std::chrono::steady_clock::now();
+			bestNs = std::min(bestNs, static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+		}
+		return bestNs / static_cast<double>(InMatricesNum);
+	}
+
+	float ComputeMaxDifference(const std::vector<Mox::Matrix4f>& InLeft, const std::vector<std::unique_ptr<PerComponentTransform>>& InRight)
+	{
+		float maxDiff = 0.f;
+		for (size_t matIdx = 0; matIdx < InLeft.size(); ++matIdx)
+		{
+			maxDiff = std::max(maxDiff, (InLeft[matIdx] - InRight[matIdx]->m_Mvp).cwiseAbs().maxCoeff());
+		}
+		return maxDiff;
+	}
+}
+
+int main()
+{
+	std::mt19937 randomGenerator(42);
+	std::uniform_real_distribution<float> valueDistribution(-10.f, 10.f);
+
+	Mox::Matrix4f viewProj;
+	for (int coeffIdx = 0; coeffIdx < 16; ++coeffIdx)
+	{
+		viewProj.data()[coeffIdx] = valueDistribution(randomGenerator);
+	}
+
+	std::cout << "Best supported path: " << Mox::GetMatrixKernelPathName(Mox::GetBestMatrixKernelPath()) << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+
+	for (size_t matricesNum : { size_t(10000), size_t(100000), size_t(1000000) })
+	{
+		std::vector<Mox::Matrix4f> models(matricesNum);
+		std::vector<Mox::Matrix4f> mvps(matricesNum);
+		std::vector<std::unique_ptr<PerComponentTransform>> components;
+		components.reserve(matricesNum);
+
+		for (size_t matIdx = 0; matIdx < matricesNum; ++matIdx)
+		{
+			for (int coeffIdx = 0; coeffIdx < 16; ++coeffIdx)
+			{
+				models[matIdx].data()[coeffIdx] = valueDistribution(randomGenerator);
+			}
+			components.push_back(std::make_unique<PerComponentTransform>());
+			components.back()->m_Model = models[matIdx];
+		}
+
+		// Components are visited in an order unrelated to their allocation, as it happens in a live scene
+		std::vector<PerComponentTransform*> visitOrder(matricesNum);
+		std::transform(components.begin(), components.end(), visitOrder.begin(), [](auto& InComp) { return InComp.get(); });
+		std::shuffle(visitOrder.begin(), visitOrder.end(), randomGenerator);
+
+		std::cout << "--- " << matricesNum << " matrices ---" << std::endl;
+
+		const double perComponentNs = MeasureNsPerMatrix(matricesNum, [&]() {
+			for (PerComponentTransform* curComponent : visitOrder)
+			{
+				curComponent->OnTransformChanged(viewProj);
+			}
+		});
+		std::cout << std::setw(16) << "Per-component" << ": " << perComponentNs << " ns/matrix" << std::endl;
+
+		for (Mox::MATRIX_KERNEL_PATH curPath : { Mox::MATRIX_KERNEL_PATH::SCALAR, Mox::MATRIX_KERNEL_PATH::SSE, Mox::MATRIX_KERNEL_PATH::AVX2, Mox::MATRIX_KERNEL_PATH::NEON })
+		{
+			if (!Mox::SetMatrixKernelPath(curPath))
+			{
+				continue;
+			}
+
+			const double batchNs = MeasureNsPerMatrix(matricesNum, [&]() {
+				Mox::MultiplyMatrixBatch(viewProj, models.data(), mvps.data(), matricesNum);
+			});
+
+			std::cout << std::setw(16) << (std::string("Batch ") + Mox::GetMatrixKernelPathName(curPath)) << ": " << batchNs << " ns/matrix"
+				<< " (x" << perComponentNs / batchNs << ")"
+				<< " max error " << ComputeMaxDifference(mvps, components) << std::endl;
+		}
+
+		Mox::SetMatrixKernelPath(Mox::GetBestMatrixKernelPath());
+	}
+}
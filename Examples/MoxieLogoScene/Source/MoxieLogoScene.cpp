@@ -12,6 +12,7 @@
 #include "GraphicsAllocator.h"
 #include "MoxEntity.h"
 #include "MoxMeshComponent.h"
+#include "MoxOcclusionBuffer.h"
 
 
 #define MOXIE_LOGO_CONTENT_PATH(NAME) LQUOTE(MOXIE_LOGO_PROJ_ROOT_PATH/Content/NAME)
@@ -67,8 +68,9 @@ void MoxieLogoSceneApp::OnInitializeContent()
 		sizeof(uint16_t) * skydomeMeshIndices.size()
 	);
 
-	m_SkydomeEntity = &AddEntity(Mox::EntityCreationInfo{ 
+	m_SkydomeEntity = AddEntity(Mox::EntityCreationInfo{ 
 		Mox::Vector3f::Zero(), Mox::Vector3f::Zero(), Mox::Vector3f(10,10,10)});
+	Mox::Entity& skydomeEntity = *GetEntity(m_SkydomeEntity);
 
 	// Create the skydome cube texture
 	// Texture courtesy of https://www.solarsystemscope.com/textures/
@@ -79,14 +81,12 @@ void MoxieLogoSceneApp::OnInitializeContent()
 	};
 
 	// Create mesh component and add it to the entity
-	std::shared_ptr<Mox::MeshComponent> skydomeMesh = std::make_unique<Mox::MeshComponent>(
+	skydomeEntity.AddComponent<Mox::MeshComponent>(
 		Mox::DrawableCreationInfo{
-			m_SkydomeEntity->GetRenderProxy().get(), m_SkydomeVertexBuffer, m_SkydomeIndexBuffer,
+			skydomeEntity.GetRenderProxy().get(), m_SkydomeVertexBuffer, m_SkydomeIndexBuffer,
 			Mox::BufferMeshParams(), std::move(meshShaderParamDefinitions), 
 			true // Render back faces
-		}, *m_SkydomeEntity);
-
-	m_SkydomeEntity->AddComponent(skydomeMesh);
+		});
 	// ----- ENDS SKYDOME -----
 
 	// ----- SPHERE -----
@@ -94,7 +94,8 @@ void MoxieLogoSceneApp::OnInitializeContent()
 	static std::vector<Mox::Vector3f> sphereMeshVertices;
 	static std::vector<Mox::Vector2f> sphereMeshUvs;
 	static std::vector<uint16_t> sphereMeshIndices;
-	Mox::UVSphere(15, 15, sphereMeshVertices, sphereMeshUvs, sphereMeshIndices);
+	// Finer than the other meshes, as coarser levels of detail replace it when it gets small on screen
+	Mox::UVSphere(48, 48, sphereMeshVertices, sphereMeshUvs, sphereMeshIndices);
 
 	static std::vector<TexVertexType> sphereVbData;
 	sphereVbData.reserve(sphereMeshVertices.size());
@@ -108,21 +109,23 @@ void MoxieLogoSceneApp::OnInitializeContent()
 
 	}
 
-	m_SphereVertexBuffer = &Mox::GraphicsAllocator::Get()->AllocateVertexBuffer(
+	// Each level of detail keeps half the triangles of the previous one, all sharing the sphere vertex buffer
+	std::vector<Mox::MeshLod> sphereLods;
+	Mox::GraphicsAllocator::Get()->AllocateMeshWithLods(
 		m_VertexLayoutDesc,
 		sphereVbData.data(),
 		sizeof(TexVertexType),
-		sizeof(TexVertexType) * sphereVbData.size()
-	);
-
-	m_SphereIndexBuffer = &Mox::GraphicsAllocator::Get()->AllocateIndexBuffer(
+		sizeof(TexVertexType) * sphereVbData.size(),
 		sphereMeshIndices.data(),
 		sizeof(uint16_t),
-		sizeof(uint16_t) * sphereMeshIndices.size()
+		sizeof(uint16_t) * sphereMeshIndices.size(),
+		Mox::MeshLodSettings(),
+		m_SphereVertexBuffer, m_SphereIndexBuffer, sphereLods
 	);
 
-	m_SphereEntity = &AddEntity(Mox::EntityCreationInfo
+	m_SphereEntity = AddEntity(Mox::EntityCreationInfo
 		{ Mox::Vector3f::Zero(), Mox::Vector3f(180.f,0.f,0.f), Mox::Vector3f(3.5f,3.5f,3.5f) });
+	Mox::Entity& sphereEntity = *GetEntity(m_SphereEntity);
 
 	// Creating buffer for the color mod
 	m_ColorModBuffer = std::make_unique<Mox::ConstantBuffer>(Mox::BUFFER_ALLOC_TYPE::DYNAMIC, sizeof(float));
@@ -141,14 +144,31 @@ void MoxieLogoSceneApp::OnInitializeContent()
 		{Mox::HashSpName("albedo_cube"), m_SphereCubeTexture.get()}
 	};
 
-	// Create mesh component and add it to the entity
-	std::shared_ptr<Mox::MeshComponent> sphereMesh = std::make_unique<Mox::MeshComponent>(
-		Mox::DrawableCreationInfo{
-			m_SphereEntity->GetRenderProxy().get(), m_SphereVertexBuffer, m_SphereIndexBuffer,
-			std::move(sphereBufferParamDefinitions), std::move(sphereMeshShaderParamDefinitions),
-		}, *m_SphereEntity);
+	Mox::DrawableCreationInfo sphereDrawableInfo{
+		sphereEntity.GetRenderProxy().get(), m_SphereVertexBuffer, m_SphereIndexBuffer,
+		std::move(sphereBufferParamDefinitions), std::move(sphereMeshShaderParamDefinitions),
+	};
+
+	// The sphere hides what is behind it, so it is also rasterized as an occluder.
+	// A coarser sphere shrunk to fit inside the rendered one is enough, and it never hides something the sphere does not hide.
+	std::vector<Mox::Vector3f> occluderVertices;
+	std::vector<Mox::Vector2f> occluderUvs;
+	std::vector<uint16_t> occluderIndices;
+	Mox::UVSphere(8, 8, occluderVertices, occluderUvs, occluderIndices);
 
-	m_SphereEntity->AddComponent(sphereMesh);
+	std::shared_ptr<Mox::OccluderMesh> sphereOccluder = std::make_shared<Mox::OccluderMesh>();
+	for (const Mox::Vector3f& pos : occluderVertices)
+	{
+		sphereOccluder->m_Positions.push_back(pos * 0.9f);
+	}
+	sphereOccluder->m_Indices.assign(occluderIndices.begin(), occluderIndices.end());
+
+	sphereDrawableInfo.m_Occluder = std::move(sphereOccluder);
+
+	sphereDrawableInfo.m_Lods = std::move(sphereLods);
+
+	// Create mesh component and add it to the entity
+	sphereEntity.AddComponent<Mox::MeshComponent>(std::move(sphereDrawableInfo));
 	// ----- ENDS SPHERE -----
 
 	// ----- QUAD -----
@@ -166,7 +186,8 @@ void MoxieLogoSceneApp::OnInitializeContent()
 		sizeof(m_QuadIndexData)
 	);
 
-	m_QuadEntity = &AddEntity(Mox::EntityCreationInfo{ Mox::Vector3f(0.f,-1.5f,-4.f),Mox::Vector3f::Zero(), Mox::Vector3f(1.5f,1.5f,1.5f) });
+	m_QuadEntity = AddEntity(Mox::EntityCreationInfo{ Mox::Vector3f(0.f,-1.5f,-4.f),Mox::Vector3f::Zero(), Mox::Vector3f(1.5f,1.5f,1.5f) });
+	Mox::Entity& quadEntity = *GetEntity(m_QuadEntity);
 
 	m_QuadTexture = std::make_unique<Mox::Texture>(MOXIE_LOGO_CONTENT_PATH(TexLogo.dds));
 	// Set it as shader parameter
@@ -174,13 +195,11 @@ void MoxieLogoSceneApp::OnInitializeContent()
 		{Mox::HashSpName("albedo_tex"), m_QuadTexture.get()}
 	};
 	// Create mesh component and add it to the entity
-	std::unique_ptr<Mox::MeshComponent> quadMesh = std::make_unique<Mox::MeshComponent>(
+	quadEntity.AddComponent<Mox::MeshComponent>(
 		Mox::DrawableCreationInfo{
-			m_QuadEntity->GetRenderProxy().get(), m_QuadVertexBuffer, m_QuadIndexBuffer,
+			quadEntity.GetRenderProxy().get(), m_QuadVertexBuffer, m_QuadIndexBuffer,
 			Mox::BufferMeshParams(), std::move(quadMeshShaderParamDefinitions),
-		}, *m_QuadEntity);
-
-	m_QuadEntity->AddComponent(std::move(quadMesh));
+		});
 
 	// ----- QUAD ENDS -----
 
@@ -192,9 +211,9 @@ void MoxieLogoSceneApp::UpdateContent(float InDeltaTime)
 
 	float rotX = InDeltaTime * rotationSpeed;
 
-	m_SkydomeEntity->Rotate(rotX, 0.f);
+	GetEntity(m_SkydomeEntity)->Rotate(rotX, 0.f);
 
-	m_SphereEntity->Rotate(rotX, 0.f);
+	GetEntity(m_SphereEntity)->Rotate(rotX, 0.f);
 
 	// Updating color modifier
 	static float progress = 0.f, counter = 0.f;
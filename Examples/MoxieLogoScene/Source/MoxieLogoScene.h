@@ -38,7 +38,7 @@
 		Mox::IndexBuffer* m_SkydomeIndexBuffer;
 		std::unique_ptr<Mox::Texture> m_SkydomeCubeTexture;
 
-		Mox::Entity* m_SkydomeEntity;
+		Mox::EntityHandle m_SkydomeEntity;
 
 		// ----- Sphere-related data -----
 
@@ -48,7 +48,7 @@
 		// Standalone Constant Buffer for the color modifier
 		std::unique_ptr<Mox::ConstantBuffer> m_ColorModBuffer;
 
-		Mox::Entity* m_SphereEntity;
+		Mox::EntityHandle m_SphereEntity;
 
 		// ----- Quad-related data -----
 
@@ -67,7 +67,7 @@
 		Mox::IndexBuffer* m_QuadIndexBuffer;
 		std::unique_ptr<Mox::Texture> m_QuadTexture;
 
-		Mox::Entity* m_QuadEntity;
+		Mox::EntityHandle m_QuadEntity;
 
 	protected:
 
@@ -64,7 +64,8 @@ void TexturesExampleApplication::OnInitializeContent()
 		sizeof(m_QuadIndexData)
 	);
 
-	m_QuadEntity = &AddEntity(Mox::EntityCreationInfo{ Mox::Vector3f(2.5f,-2.5f,0),Mox::Vector3f::Zero(), Mox::Vector3f(1.5f,1.5f,1.5f) });
+	m_QuadEntity = AddEntity(Mox::EntityCreationInfo{ Mox::Vector3f(2.5f,-2.5f,0),Mox::Vector3f::Zero(), Mox::Vector3f(1.5f,1.5f,1.5f) });
+	Mox::Entity& quadEntity = *GetEntity(m_QuadEntity);
 
 	m_QuadTexture = std::make_unique<Mox::Texture>(TEXTURES_EXAMPLE_CONTENT_PATH(MarsMap.dds));
 	// Set it as shader parameter
@@ -72,13 +73,11 @@ void TexturesExampleApplication::OnInitializeContent()
 		{Mox::HashSpName("albedo_tex"), m_QuadTexture.get()}
 	};
 	// Create mesh component and add it to the entity
-	std::unique_ptr<Mox::MeshComponent> quadMesh = std::make_unique<Mox::MeshComponent>(
+	quadEntity.AddComponent<Mox::MeshComponent>(
 		Mox::DrawableCreationInfo{
-			m_QuadEntity->GetRenderProxy().get(), m_QuadVertexBuffer, m_QuadIndexBuffer,
+			quadEntity.GetRenderProxy().get(), m_QuadVertexBuffer, m_QuadIndexBuffer,
 			Mox::BufferMeshParams(), std::move(quadMeshShaderParamDefinitions),
-		}, *m_QuadEntity);
-
-	m_QuadEntity->AddComponent(std::move(quadMesh));
+		});
 
 	// ----- QUAD ENDS -----
 
@@ -110,7 +109,8 @@ void TexturesExampleApplication::OnInitializeContent()
 		sizeof(uint16_t) * sphereMeshIndices.size()
 	);
 
-	m_SphereEntity = &AddEntity({ Mox::Vector3f::Zero() });
+	m_SphereEntity = AddEntity({ Mox::Vector3f::Zero() });
+	Mox::Entity& sphereEntity = *GetEntity(m_SphereEntity);
 
 	// Create the sphere cube texture
 	// Texture courtesy of https://www.solarsystemscope.com/textures/
@@ -120,13 +120,11 @@ void TexturesExampleApplication::OnInitializeContent()
 		{Mox::HashSpName("albedo_cube"), m_SphereCubeTexture.get()}
 	};
 	// Create mesh component and add it to the entity
-	std::unique_ptr<Mox::MeshComponent> sphereMesh = std::make_unique<Mox::MeshComponent>(
+	sphereEntity.AddComponent<Mox::MeshComponent>(
 		Mox::DrawableCreationInfo{
-			m_SphereEntity->GetRenderProxy().get(), m_SphereVertexBuffer, m_SphereIndexBuffer,
+			sphereEntity.GetRenderProxy().get(), m_SphereVertexBuffer, m_SphereIndexBuffer,
 			Mox::BufferMeshParams(), std::move(meshShaderParamDefinitions),
-			},*m_SphereEntity);
-
-	m_SphereEntity->AddComponent(std::move(sphereMesh));
+			});
 	// ----- ENDS SPHERE -----
 
 
@@ -140,7 +138,7 @@ void TexturesExampleApplication::OnInitializeContent()
 
 void TexturesExampleApplication::OnMouseWheel(float InDeltaRot)
 {
-	m_SphereEntity->Translate(0, 0, (InDeltaRot > 0 ? 1 : -1));
+	GetEntity(m_SphereEntity)->Translate(0, 0, (InDeltaRot > 0 ? 1 : -1));
 
 }
 
@@ -157,14 +155,14 @@ void TexturesExampleApplication::OnMouseMove(int32_t InX, int32_t InY)
 
 void TexturesExampleApplication::OnLeftMouseDrag(int32_t InDeltaX, int32_t InDeltaY)
 {
-	m_SphereEntity->Rotate(
+	GetEntity(m_SphereEntity)->Rotate(
 		-InDeltaX / static_cast<float>(m_MainWindow->GetFrameWidth()),
 		-InDeltaY / static_cast<float>(m_MainWindow->GetFrameHeight()));
 }
 
 void TexturesExampleApplication::OnRightMouseDrag(int32_t InDeltaX, int32_t InDeltaY)
 {
-	m_SphereEntity->Translate(InDeltaX / static_cast<float>(m_MainWindow->GetFrameWidth()), -InDeltaY / static_cast<float>(m_MainWindow->GetFrameHeight()), 0.f);
+	GetEntity(m_SphereEntity)->Translate(InDeltaX / static_cast<float>(m_MainWindow->GetFrameWidth()), -InDeltaY / static_cast<float>(m_MainWindow->GetFrameHeight()), 0.f);
 }
 
 void TexturesExampleApplication::OnTypingKeyPressed(Mox::KEYBOARD_KEY InKeyPressed)
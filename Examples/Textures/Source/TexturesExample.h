@@ -47,7 +47,7 @@ private:
 	Mox::IndexBuffer* m_SphereIndexBuffer;
 	std::unique_ptr<Mox::Texture> m_SphereCubeTexture;
 
-	Mox::Entity* m_SphereEntity;
+	Mox::EntityHandle m_SphereEntity;
 
 	// ----- Quad-related data -----
 
@@ -66,7 +66,7 @@ private:
 	Mox::IndexBuffer* m_QuadIndexBuffer;
 	std::unique_ptr<Mox::Texture> m_QuadTexture;
 
-	Mox::Entity* m_QuadEntity;
+	Mox::EntityHandle m_QuadEntity;
 
 protected:
 
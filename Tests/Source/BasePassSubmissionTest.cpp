@@ -0,0 +1,318 @@
+/*
+ BasePassSubmissionTest.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include "MoxTestUtils.h"
+#include "MockGraphics.h"
+#include "BasePass.h"
+#include "ContextView.h"
+
+// Records frames of the base pass on the mock command list, counting the calls that reach the graphics API.
+// Draws sorted by state and instanced share their binds, so repeated meshes cost a few calls for the whole scene
+// instead of a few calls per object, also when each object has its own parameters.
+
+namespace
+{
+	constexpr uint32_t ObjectsNum = 64;
+
+	struct Vertex
+	{
+		Mox::Vector3f m_Position;
+		Mox::Vector3f m_Color;
+		Mox::Vector3f m_TexCoord;
+	};
+
+	struct Mesh
+	{
+		Mox::VertexBuffer* m_VertexBuffer;
+		Mox::IndexBuffer* m_IndexBuffer;
+	};
+
+	// Element of the instances buffer of the base pass, as declared in BasePass_VS.hlsl
+	struct InstanceData
+	{
+		Mox::Matrix4f m_Model;
+		uint32_t m_FeaturesField;
+		float m_ColorModifier;
+		uint32_t m_ColorTextureIndex;
+		uint32_t m_ColorCubeIndex;
+	};
+
+	// Scene drawn by a base pass, everything in it is owned by its mock allocator
+	struct TestScene
+	{
+		TestScene()
+		{
+			Mox::GraphicsAllocator::SetDefaultInstance(&m_Allocator);
+
+			m_BasePass.SetupPass(m_CmdList);
+		}
+
+		~TestScene()
+		{
+			Mox::GraphicsAllocator::SetDefaultInstance(nullptr);
+		}
+
+		Mox::MockGraphicsAllocator m_Allocator;
+		Mox::MockDevice m_Device;
+		Mox::MockCommandList m_CmdList{ m_Device };
+		Mox::BasePass m_BasePass;
+
+		std::vector<std::unique_ptr<Mox::ConstantBuffer>> m_ColorModBuffers;
+		std::vector<std::shared_ptr<Mox::RenderProxy>> m_Proxies;
+	};
+
+	// Base pass vertex layout, or the same elements with color and texture coordinates swapped
+	Mox::INPUT_LAYOUT_DESC MakeLayoutDesc(bool InIsSwapped = false)
+	{
+		return Mox::INPUT_LAYOUT_DESC{ {
+			{"POSITION", Mox::BUFFER_FORMAT::R32G32B32_FLOAT},
+			{InIsSwapped ? "TEXCOORD" : "COLOR", Mox::BUFFER_FORMAT::R32G32B32_FLOAT},
+			{InIsSwapped ? "COLOR" : "TEXCOORD", Mox::BUFFER_FORMAT::R32G32B32_FLOAT} } };
+	}
+
+	Mesh AllocateQuad(Mox::MockGraphicsAllocator& InAllocator, float InHalfSize, const Mox::INPUT_LAYOUT_DESC& InLayoutDesc)
+	{
+		const Vertex quadVertices[] = {
+			{ Mox::Vector3f(-InHalfSize, -InHalfSize, 0.f), Mox::Vector3f::Ones(), Mox::Vector3f(0.f, 1.f, 0.f) },
+			{ Mox::Vector3f(-InHalfSize, InHalfSize, 0.f), Mox::Vector3f::Ones(), Mox::Vector3f(0.f, 0.f, 0.f) },
+			{ Mox::Vector3f(InHalfSize, InHalfSize, 0.f), Mox::Vector3f::Ones(), Mox::Vector3f(1.f, 0.f, 0.f) },
+			{ Mox::Vector3f(InHalfSize, -InHalfSize, 0.f), Mox::Vector3f::Ones(), Mox::Vector3f(1.f, 1.f, 0.f) } };
+		const uint16_t quadIndices[] = { 0, 1, 2, 0, 2, 3 };
+
+		return Mesh{ &InAllocator.AllocateVertexBuffer(InLayoutDesc, quadVertices, sizeof(Vertex), sizeof(quadVertices)),
+			&InAllocator.AllocateIndexBuffer(quadIndices, sizeof(uint16_t), sizeof(quadIndices)) };
+	}
+
+	// Creates an object drawing the mesh at the given position and gives it to the base pass
+	void AddObject(TestScene& InOutScene, const Mesh& InMesh, Mox::ConstantBuffer* InColorModBuffer, const Mox::Vector3f& InPosition)
+	{
+		InOutScene.m_Proxies.push_back(std::make_shared<Mox::RenderProxy>());
+		Mox::RenderProxy& proxy = *InOutScene.m_Proxies.back();
+
+		Mox::Affine3f transform = Mox::Affine3f::Identity();
+		transform.translate(InPosition);
+		proxy.SetModelMatrix(transform.matrix());
+
+		Mox::DrawableCreationInfo drawableInfo{ &proxy, InMesh.m_VertexBuffer, InMesh.m_IndexBuffer };
+		if (InColorModBuffer)
+		{
+			drawableInfo.m_BufferShaderParameters.emplace_back(Mox::HashSpName("c_mod"), InColorModBuffer);
+		}
+		InOutScene.m_Allocator.CreateDrawables({ drawableInfo });
+
+		InOutScene.m_BasePass.ProcessRenderProxy(proxy);
+	}
+
+	// Camera at (0, 0, -10) looking at the origin
+	Mox::ContextView MakeView()
+	{
+		Mox::ContextView view;
+		view.m_ZMin = 0.1f;
+		view.m_ZMax = 100.f;
+		view.m_Fov = 0.8f;
+		view.m_AspectRatio = 16.f / 9.f;
+		view.m_ViewMatrix = Mox::LookAt(Mox::Vector3f(0.f, 0.f, -10.f), Mox::Vector3f::Zero(), Mox::Vector3f(0.f, 1.f, 0.f));
+		view.m_ProjMatrix = Mox::Perspective(view.m_ZMin, view.m_ZMax, view.m_AspectRatio, view.m_Fov);
+		view.UpdateViewProjMatrix();
+
+		return view;
+	}
+
+	// Color modifier given to the object with the given index
+	float GetColorModifier(uint32_t InObjectIdx)
+	{
+		return 1.f + InObjectIdx;
+	}
+
+	// Fills the scene with a grid of objects in view, each one drawing one of the given number of meshes.
+	// Meshes are assigned in turns, so that objects sharing a mesh are never created one after the other.
+	// Each object has its own color modifier, with its own value.
+	void FillScene(TestScene& InOutScene, uint32_t InMeshesNum)
+	{
+		std::vector<Mesh> meshes;
+		for (uint32_t meshIdx = 0; meshIdx < InMeshesNum; ++meshIdx)
+		{
+			meshes.push_back(AllocateQuad(InOutScene.m_Allocator, 0.2f, MakeLayoutDesc()));
+		}
+
+		for (uint32_t objectIdx = 0; objectIdx < ObjectsNum; ++objectIdx)
+		{
+			InOutScene.m_ColorModBuffers.push_back(std::make_unique<Mox::ConstantBuffer>(Mox::BUFFER_ALLOC_TYPE::DYNAMIC, sizeof(float)));
+		}
+
+		// Buffers get their resources before the renderer processes the drawables using them
+		InOutScene.m_Allocator.AllocatePendingBufferResources();
+
+		for (uint32_t objectIdx = 0; objectIdx < ObjectsNum; ++objectIdx)
+		{
+			const uint32_t meshIdx = objectIdx % InMeshesNum;
+
+			// Written as the renderer applies the updates of the frame
+			const float colorModifier = GetColorModifier(objectIdx);
+			InOutScene.m_ColorModBuffers[objectIdx]->GetResource()->SetData(&colorModifier, sizeof(float));
+
+			AddObject(InOutScene, meshes[meshIdx], InOutScene.m_ColorModBuffers[objectIdx].get(),
+				Mox::Vector3f((objectIdx % 8) * 0.6f - 2.1f, (objectIdx / 8) * 0.5f - 1.75f, static_cast<float>(objectIdx % 3)));
+		}
+	}
+
+	void TestRepeatedMeshesShareBinds()
+	{
+		TestScene scene;
+		FillScene(scene, 2);
+		TestCheck(scene.m_BasePass.GetDrawCommandsNum() == ObjectsNum)
+
+		scene.m_BasePass.SendDrawCommands(scene.m_CmdList, MakeView());
+
+		// Every object uses the same pipeline state, bound once for the frame
+		TestCheck(scene.m_CmdList.GetCallsNum(Mox::MOCK_CALL::SET_PIPELINE_STATE) == 1)
+		TestCheck(scene.m_CmdList.GetCallsNum(Mox::MOCK_CALL::SET_RESOURCE_BINDER) == 1)
+
+		// Objects are sorted by mesh, so each mesh is bound once even though they were created interleaved,
+		// and all the objects of a mesh become a single instanced draw
+		TestCheck(scene.m_CmdList.GetCallsNum(Mox::MOCK_CALL::SET_VERTEX_BUFFER) == 2)
+		TestCheck(scene.m_CmdList.GetCallsNum(Mox::MOCK_CALL::SET_INDEX_BUFFER) == 2)
+		TestCheck(scene.m_CmdList.GetCallsNum(Mox::MOCK_CALL::DRAW_INDEXED) == 2)
+
+		// Nothing is bound per object, textures are indexed from the descriptor heap set once
+		TestCheck(scene.m_CmdList.GetCallsNum(Mox::MOCK_CALL::REFERENCE_VIEWS_HEAP) == 2)
+		TestCheck(scene.m_CmdList.GetCallsNum(Mox::MOCK_CALL::REFERENCE_CBV) == 0)
+		TestCheck(scene.m_CmdList.GetCallsNum(Mox::MOCK_CALL::REFERENCE_SRV) == 0)
+		TestCheck(scene.m_CmdList.GetRecordedCalls().size() < ObjectsNum)
+	}
+
+	void TestListDropsRedundantBinds()
+	{
+		TestScene scene;
+		FillScene(scene, 2);
+
+		scene.m_BasePass.SendDrawCommands(scene.m_CmdList, MakeView());
+
+		// The pass sets the whole state for each of the two draws, and the list only lets through what changes the bound state
+		TestCheck(scene.m_CmdList.GetCallsNum(Mox::MOCK_CALL::SET_PIPELINE_STATE) == 1)
+		TestCheck(scene.m_CmdList.GetCallsNum(Mox::MOCK_CALL::SET_RESOURCE_BINDER) == 1)
+		TestCheck(scene.m_CmdList.GetCallsNum(Mox::MOCK_CALL::SET_DESCRIPTOR_HEAPS) == 1)
+		TestCheck(scene.m_CmdList.GetCallsNum(Mox::MOCK_CALL::SET_GRAPHICS_ROOT_CONSTANTS) == 1)
+		TestCheck(scene.m_CmdList.GetCallsNum(Mox::MOCK_CALL::REFERENCE_VIEWS_HEAP) == 2)
+		TestCheck(scene.m_CmdList.GetCallsNum(Mox::MOCK_CALL::SET_PRIMITIVE_TOPOLOGY) == 1)
+
+		// The second draw only changes geometry and instances: pipeline state, resource binder, heaps, 
+		// view constants, the two texture tables and topology were already bound
+		TestCheck(scene.m_CmdList.GetSkippedBindsNum() == 7)
+	}
+
+	void TestParametersGoInInstanceData()
+	{
+		TestScene scene;
+		FillScene(scene, 2);
+
+		scene.m_BasePass.SendDrawCommands(scene.m_CmdList, MakeView());
+
+		// Objects of a mesh are drawn together although each one has its own modifier
+		TestCheck(scene.m_CmdList.GetCallsNum(Mox::MOCK_CALL::DRAW_INDEXED) == 2)
+
+		const std::vector<std::byte>& instancesData = scene.m_Allocator.GetLastFrameData();
+		TestCheck(instancesData.size() == ObjectsNum * sizeof(InstanceData))
+
+		// Every object finds its own modifier in the instances, whatever order they are drawn in
+		std::multiset<float> instanceModifiers;
+		for (size_t instanceIdx = 0; instanceIdx < ObjectsNum; ++instanceIdx)
+		{
+			InstanceData instance;
+			memcpy(&instance, instancesData.data() + instanceIdx * sizeof(InstanceData), sizeof(InstanceData));
+			instanceModifiers.insert(instance.m_ColorModifier);
+		}
+
+		std::multiset<float> objectModifiers;
+		for (uint32_t objectIdx = 0; objectIdx < ObjectsNum; ++objectIdx)
+		{
+			objectModifiers.insert(GetColorModifier(objectIdx));
+		}
+
+		TestCheck(instanceModifiers == objectModifiers)
+	}
+
+	void TestCallsDropWithRepeatedMeshes()
+	{
+		TestScene repeatedMeshesScene;
+		FillScene(repeatedMeshesScene, 2);
+		repeatedMeshesScene.m_BasePass.SendDrawCommands(repeatedMeshesScene.m_CmdList, MakeView());
+
+		TestScene uniqueMeshesScene;
+		FillScene(uniqueMeshesScene, ObjectsNum);
+		uniqueMeshesScene.m_BasePass.SendDrawCommands(uniqueMeshesScene.m_CmdList, MakeView());
+
+		// With nothing to share every object is drawn on its own, which also shows that all of them are in view
+		TestCheck(uniqueMeshesScene.m_CmdList.GetCallsNum(Mox::MOCK_CALL::DRAW_INDEXED) == ObjectsNum)
+
+		// Same number of objects, a fraction of the calls
+		TestCheck(repeatedMeshesScene.m_CmdList.GetRecordedCalls().size() * 8 < uniqueMeshesScene.m_CmdList.GetRecordedCalls().size())
+	}
+
+	void TestFramesRecordTheSameCalls()
+	{
+		TestScene scene;
+		FillScene(scene, 2);
+
+		scene.m_BasePass.SendDrawCommands(scene.m_CmdList, MakeView());
+		const size_t firstFrameCallsNum = scene.m_CmdList.GetRecordedCalls().size();
+
+		// Binds of the previous frame do not carry over to a list reset for recording
+		scene.m_CmdList.Reset();
+		scene.m_BasePass.SendDrawCommands(scene.m_CmdList, MakeView());
+		TestCheck(scene.m_CmdList.GetRecordedCalls().size() == firstFrameCallsNum)
+		TestCheck(scene.m_CmdList.GetCallsNum(Mox::MOCK_CALL::SET_PIPELINE_STATE) == 1)
+	}
+
+	void TestVertexLayoutsGetTheirOwnState()
+	{
+		TestScene scene;
+		const Mesh defaultLayoutMesh = AllocateQuad(scene.m_Allocator, 0.2f, MakeLayoutDesc());
+		const Mesh swappedLayoutMesh = AllocateQuad(scene.m_Allocator, 0.2f, MakeLayoutDesc(true));
+		scene.m_Allocator.AllocatePendingBufferResources();
+
+		AddObject(scene, defaultLayoutMesh, nullptr, Mox::Vector3f(-1.f, 0.f, 0.f));
+		AddObject(scene, swappedLayoutMesh, nullptr, Mox::Vector3f(0.f, 0.f, 0.f));
+		AddObject(scene, defaultLayoutMesh, nullptr, Mox::Vector3f(1.f, 0.f, 0.f));
+
+		// The layout of the first drawable is not reused for the following ones, and drawables with the same layout share the state
+		TestCheck(scene.m_Allocator.GetPipelineStatesNum() == 2)
+		TestCheck(scene.m_Allocator.GetPipelineStateCache().GetHitsNum() == 1)
+
+		scene.m_BasePass.SendDrawCommands(scene.m_CmdList, MakeView());
+		TestCheck(scene.m_CmdList.GetCallsNum(Mox::MOCK_CALL::SET_PIPELINE_STATE) == 2)
+
+		// Each state has its own resource binder, which drops the root arguments: the view constants are set again after switching
+		TestCheck(scene.m_CmdList.GetCallsNum(Mox::MOCK_CALL::SET_GRAPHICS_ROOT_CONSTANTS) == 2)
+	}
+}
+
+int main()
+{
+	Mox::RunTestCase("Repeated meshes share their binds", TestRepeatedMeshesShareBinds);
+
+	Mox::RunTestCase("Command list drops the redundant binds of the pass", TestListDropsRedundantBinds);
+
+	Mox::RunTestCase("Per-object parameters go in the instance data", TestParametersGoInInstanceData);
+
+	Mox::RunTestCase("API calls per frame drop with repeated meshes", TestCallsDropWithRepeatedMeshes);
+
+	Mox::RunTestCase("Every frame records the same calls", TestFramesRecordTheSameCalls);
+
+	Mox::RunTestCase("Vertex layouts get their own pipeline state", TestVertexLayoutsGetTheirOwnState);
+
+	return Mox::GetTestExitCode();
+}
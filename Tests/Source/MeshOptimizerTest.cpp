@@ -0,0 +1,223 @@
+/*
+ MeshOptimizerTest.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <array>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include "MoxTestUtils.h"
+#include "MockGraphics.h"
+#include "MoxGeometry.h"
+#include "MoxMeshOptimizer.h"
+
+// Optimizes the buffers of meshes with shuffled triangles and vertices, measuring the vertex cache before and after,
+// and allocates a mesh together with its levels of detail as the examples do.
+
+namespace
+{
+	// Vertices of a regular grid miss the cache about 0.5 times per triangle at best, and each of them is transformed once
+	constexpr float MaxOptimizedAcmr = .7f;
+	constexpr float MaxOptimizedAtvr = 1.3f;
+
+	constexpr uint32_t GridCellsNum = 100;
+
+	struct Vertex
+	{
+		Mox::Vector3f m_Position;
+		Mox::Vector3f m_TexCoord;
+	};
+
+	Mox::INPUT_LAYOUT_DESC MakeLayoutDesc()
+	{
+		return Mox::INPUT_LAYOUT_DESC{ { {"POSITION", Mox::BUFFER_FORMAT::R32G32B32_FLOAT}, {"TEXCOORD", Mox::BUFFER_FORMAT::R32G32B32_FLOAT} } };
+	}
+
+	// Grid with triangles and vertices in random order, as meshes exported without care for the Gpu caches
+	void MakeShuffledGrid(std::vector<Vertex>& OutVertices, std::vector<uint32_t>& OutIndices)
+	{
+		std::mt19937 randomGenerator(7);
+
+		const uint32_t verticesNum = (GridCellsNum + 1) * (GridCellsNum + 1);
+		std::vector<uint32_t> vertexOrder(verticesNum);
+		std::iota(vertexOrder.begin(), vertexOrder.end(), 0);
+		std::shuffle(vertexOrder.begin(), vertexOrder.end(), randomGenerator);
+
+		OutVertices.resize(verticesNum);
+		for (uint32_t vertexIdx = 0; vertexIdx < verticesNum; ++vertexIdx)
+		{
+			const Mox::Vector3f position(static_cast<float>(vertexIdx % (GridCellsNum + 1)), static_cast<float>(vertexIdx / (GridCellsNum + 1)), 0.f);
+			OutVertices[vertexOrder[vertexIdx]] = { position, position / GridCellsNum };
+		}
+
+		std::vector<std::array<uint32_t, 3>> gridTriangles;
+		for (uint32_t row = 0; row < GridCellsNum; ++row)
+		{
+			for (uint32_t col = 0; col < GridCellsNum; ++col)
+			{
+				const uint32_t bottomLeft = row * (GridCellsNum + 1) + col, topLeft = bottomLeft + GridCellsNum + 1;
+				gridTriangles.push_back({ vertexOrder[bottomLeft], vertexOrder[topLeft], vertexOrder[bottomLeft + 1] });
+				gridTriangles.push_back({ vertexOrder[bottomLeft + 1], vertexOrder[topLeft], vertexOrder[topLeft + 1] });
+			}
+		}
+		std::shuffle(gridTriangles.begin(), gridTriangles.end(), randomGenerator);
+
+		OutIndices.clear();
+		for (const std::array<uint32_t, 3>& triangle : gridTriangles)
+		{
+			OutIndices.insert(OutIndices.end(), triangle.begin(), triangle.end());
+		}
+	}
+
+	// Triangles as the positions of their corners, starting from the smallest so that the winding is kept.
+	// Grid positions are integers, so they compare exactly.
+	std::vector<std::array<float, 9>> GetSortedTriangles(const std::vector<Vertex>& InVertices, const std::vector<uint32_t>& InIndices)
+	{
+		std::vector<std::array<float, 9>> sortedTriangles;
+		for (size_t firstIndex = 0; firstIndex < InIndices.size(); firstIndex += 3)
+		{
+			std::array<std::array<float, 3>, 3> corners;
+			for (uint32_t cornerIdx = 0; cornerIdx < 3; ++cornerIdx)
+			{
+				const Mox::Vector3f& position = InVertices[InIndices[firstIndex + cornerIdx]].m_Position;
+				corners[cornerIdx] = { position.x(), position.y(), position.z() };
+			}
+			std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+
+			std::array<float, 9> triangle;
+			for (uint32_t cornerIdx = 0; cornerIdx < 3; ++cornerIdx)
+			{
+				std::copy(corners[cornerIdx].begin(), corners[cornerIdx].end(), triangle.begin() + cornerIdx * 3);
+			}
+			sortedTriangles.push_back(triangle);
+		}
+
+		std::sort(sortedTriangles.begin(), sortedTriangles.end());
+		return sortedTriangles;
+	}
+
+	void TestVertexCacheImproves()
+	{
+		std::vector<Vertex> gridVertices;
+		std::vector<uint32_t> gridIndices;
+		MakeShuffledGrid(gridVertices, gridIndices);
+
+		std::vector<Vertex> optimizedVertices = gridVertices;
+		std::vector<uint32_t> optimizedIndices = gridIndices;
+		Mox::MeshOptimizationStats optimizationStats;
+		Mox::OptimizeMeshBuffers(optimizedVertices.data(), sizeof(Vertex), static_cast<uint32_t>(optimizedVertices.size()), MakeLayoutDesc().GetPositionOffset(sizeof(Vertex)),
+			optimizedIndices.data(), sizeof(uint32_t), static_cast<uint32_t>(optimizedIndices.size()), &optimizationStats);
+
+		// In random order, almost every corner of every triangle misses the cache
+		TestCheck(optimizationStats.m_Before.m_Acmr > 2.5f)
+		TestCheck(optimizationStats.m_After.m_Acmr < MaxOptimizedAcmr && optimizationStats.m_After.m_Atvr < MaxOptimizedAtvr)
+
+		const Mox::VertexCacheStats measuredStats = Mox::AnalyzeVertexCache(optimizedIndices, static_cast<uint32_t>(optimizedVertices.size()));
+		TestCheck(measuredStats.m_Acmr == optimizationStats.m_After.m_Acmr && measuredStats.m_Atvr == optimizationStats.m_After.m_Atvr)
+	}
+
+	void TestTrianglesArePreserved()
+	{
+		std::vector<Vertex> gridVertices;
+		std::vector<uint32_t> gridIndices;
+		MakeShuffledGrid(gridVertices, gridIndices);
+
+		std::vector<Vertex> optimizedVertices = gridVertices;
+		std::vector<uint32_t> optimizedIndices = gridIndices;
+		Mox::OptimizeMeshBuffers(optimizedVertices.data(), sizeof(Vertex), static_cast<uint32_t>(optimizedVertices.size()), MakeLayoutDesc().GetPositionOffset(sizeof(Vertex)),
+			optimizedIndices.data(), sizeof(uint32_t), static_cast<uint32_t>(optimizedIndices.size()));
+
+		TestCheck(optimizedIndices != gridIndices)
+		TestCheck(GetSortedTriangles(optimizedVertices, optimizedIndices) == GetSortedTriangles(gridVertices, gridIndices))
+	}
+
+	void TestVertexFetchIsSequential()
+	{
+		std::vector<Vertex> gridVertices;
+		std::vector<uint32_t> gridIndices;
+		MakeShuffledGrid(gridVertices, gridIndices);
+
+		// 16 bit indices, as most meshes of the examples use
+		std::vector<uint16_t> shortIndices(gridIndices.begin(), gridIndices.end());
+		Mox::OptimizeMeshBuffers(gridVertices.data(), sizeof(Vertex), static_cast<uint32_t>(gridVertices.size()), MakeLayoutDesc().GetPositionOffset(sizeof(Vertex)),
+			shortIndices.data(), sizeof(uint16_t), static_cast<uint32_t>(shortIndices.size()));
+
+		// Each vertex referenced for the first time is the one after the last new vertex
+		uint32_t nextVertexIdx = 0;
+		bool isSequential = true;
+		for (uint16_t vertexIdx : shortIndices)
+		{
+			isSequential &= vertexIdx <= nextVertexIdx;
+			nextVertexIdx = std::max(nextVertexIdx, vertexIdx + 1u);
+		}
+		TestCheck(isSequential && nextVertexIdx == gridVertices.size())
+	}
+
+	void TestMeshWithLodsSharesVertices()
+	{
+		Mox::MockGraphicsAllocator allocator;
+		Mox::GraphicsAllocator::SetDefaultInstance(&allocator);
+
+		std::vector<Mox::Vector3f> sphereVertices;
+		std::vector<Mox::Vector2f> sphereUvs;
+		std::vector<uint16_t> sphereIndices;
+		Mox::UVSphere(48, 48, sphereVertices, sphereUvs, sphereIndices);
+
+		std::vector<Vertex> sphereVbData;
+		for (const Mox::Vector3f& position : sphereVertices)
+		{
+			sphereVbData.push_back({ position, position });
+		}
+
+		Mox::MeshLodSettings lodSettings;
+		lodSettings.m_LodsNum = 3;
+
+		Mox::VertexBuffer* sphereVertexBuffer = nullptr;
+		Mox::IndexBuffer* sphereIndexBuffer = nullptr;
+		std::vector<Mox::MeshLod> sphereLods;
+		allocator.AllocateMeshWithLods(MakeLayoutDesc(), sphereVbData.data(), sizeof(Vertex), static_cast<uint32_t>(sizeof(Vertex) * sphereVbData.size()),
+			sphereIndices.data(), sizeof(uint16_t), static_cast<uint32_t>(sizeof(uint16_t) * sphereIndices.size()), lodSettings,
+			sphereVertexBuffer, sphereIndexBuffer, sphereLods);
+
+		TestCheck(sphereVertexBuffer && sphereIndexBuffer && sphereIndexBuffer->GetElementsNum() == sphereIndices.size())
+		TestCheck(sphereLods.size() == lodSettings.m_LodsNum)
+
+		// Levels get coarser and are drawn at smaller sizes, as the drawable expects them
+		int32_t previousIndicesNum = sphereIndexBuffer->GetElementsNum();
+		float previousScreenSize = std::numeric_limits<float>::max();
+		for (const Mox::MeshLod& sphereLod : sphereLods)
+		{
+			TestCheck(sphereLod.m_VertexBuffer == sphereVertexBuffer && sphereLod.m_IndexBuffer != sphereIndexBuffer)
+			TestCheck(sphereLod.m_IndexBuffer->GetElementsNum() < previousIndicesNum)
+			TestCheck(sphereLod.m_ScreenSize > 0.f && sphereLod.m_ScreenSize < previousScreenSize)
+
+			previousIndicesNum = sphereLod.m_IndexBuffer->GetElementsNum();
+			previousScreenSize = sphereLod.m_ScreenSize;
+		}
+
+		Mox::GraphicsAllocator::SetDefaultInstance(nullptr);
+	}
+}
+
+int main()
+{
+	Mox::RunTestCase("Optimized buffers hit the vertex cache", TestVertexCacheImproves);
+
+	Mox::RunTestCase("Optimized buffers keep the same triangles", TestTrianglesArePreserved);
+
+	Mox::RunTestCase("Optimized vertices are fetched in order", TestVertexFetchIsSequential);
+
+	Mox::RunTestCase("Levels of detail share the vertex buffer of the mesh", TestMeshWithLodsSharesVertices);
+
+	return Mox::GetTestExitCode();
+}
@@ -0,0 +1,267 @@
+/*
+ MeshSimplifierTest.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+#include <cstdint>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include "MoxTestUtils.h"
+#include "MoxMath.h"
+#include "MoxGeometry.h"
+#include "MoxMeshSimplifier.h"
+
+// Generates levels of detail of procedural meshes and measures how far the source surface is from each level,
+// as the largest distance of a source vertex from the triangles of the level, to compare it with the error the level reports.
+
+namespace
+{
+	// The reported error is an average over the surface around the collapsed vertices, so single vertices can be further than that
+	constexpr float ErrorBoundScale = 2.f;
+
+	Mox::SimplifierMesh MakeSphere()
+	{
+		std::vector<Mox::Vector3f> sphereVertices;
+		std::vector<Mox::Vector2f> sphereUvs;
+		std::vector<uint16_t> sphereIndices;
+		Mox::UVSphere(48, 48, sphereVertices, sphereUvs, sphereIndices);
+
+		// Texture coordinates are kept as attributes, as a mesh loaded from a file would have them
+		Mox::SimplifierMesh sphereMesh{ sphereVertices, {}, 2, std::vector<uint32_t>(sphereIndices.begin(), sphereIndices.end()) };
+		for (const Mox::Vector2f& uv : sphereUvs)
+		{
+			sphereMesh.m_Attributes.push_back(uv.x());
+			sphereMesh.m_Attributes.push_back(uv.y());
+		}
+
+		return sphereMesh;
+	}
+
+	// Unit square grid, displaced along z by the given amplitude
+	Mox::SimplifierMesh MakeTerrain(uint32_t InCellsNum, float InAmplitude)
+	{
+		Mox::SimplifierMesh terrainMesh;
+		for (uint32_t row = 0; row <= InCellsNum; ++row)
+		{
+			for (uint32_t col = 0; col <= InCellsNum; ++col)
+			{
+				const float x = static_cast<float>(col) / InCellsNum, y = static_cast<float>(row) / InCellsNum;
+				terrainMesh.m_Positions.push_back(Mox::Vector3f(x, y, InAmplitude * std::sin(col * .4f) * std::cos(row * .3f)));
+			}
+		}
+
+		for (uint32_t row = 0; row < InCellsNum; ++row)
+		{
+			for (uint32_t col = 0; col < InCellsNum; ++col)
+			{
+				const uint32_t bottomLeft = row * (InCellsNum + 1) + col, topLeft = bottomLeft + InCellsNum + 1;
+				terrainMesh.m_Indices.insert(terrainMesh.m_Indices.end(), { bottomLeft, topLeft, bottomLeft + 1, bottomLeft + 1, topLeft, topLeft + 1 });
+			}
+		}
+
+		return terrainMesh;
+	}
+
+	// Closest point on a triangle, from Ericson's "Real-Time Collision Detection"
+	float ComputePointTriangleDistance(const Mox::Vector3f& InPoint, const Mox::Vector3f& InA, const Mox::Vector3f& InB, const Mox::Vector3f& InC)
+	{
+		const Mox::Vector3f ab = InB - InA, ac = InC - InA, ap = InPoint - InA;
+		const float d1 = ab.dot(ap), d2 = ac.dot(ap);
+		if (d1 <= 0.f && d2 <= 0.f)
+		{
+			return ap.norm();
+		}
+
+		const Mox::Vector3f bp = InPoint - InB;
+		const float d3 = ab.dot(bp), d4 = ac.dot(bp);
+		if (d3 >= 0.f && d4 <= d3)
+		{
+			return bp.norm();
+		}
+
+		const float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
+		{
+			return (InPoint - (InA + ab * (d1 / (d1 - d3)))).norm();
+		}
+
+		const Mox::Vector3f cp = InPoint - InC;
+		const float d5 = ab.dot(cp), d6 = ac.dot(cp);
+		if (d6 >= 0.f && d5 <= d6)
+		{
+			return cp.norm();
+		}
+
+		const float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f)
+		{
+			return (InPoint - (InA + ac * (d2 / (d2 - d6)))).norm();
+		}
+
+		const float va = d3 * d6 - d5 * d4;
+		if (va <= 0.f && d4 - d3 >= 0.f && d5 - d6 >= 0.f)
+		{
+			return (InPoint - (InB + (InC - InB) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))))).norm();
+		}
+
+		const float denominator = 1.f / (va + vb + vc);
+		return (InPoint - (InA + ab * (vb * denominator) + ac * (vc * denominator))).norm();
+	}
+
+	// Largest distance of a vertex of the source mesh from the surface of the level
+	float ComputeSourceDistance(const Mox::SimplifierMesh& InMesh, const std::vector<uint32_t>& InLodIndices)
+	{
+		float maxDistance = 0.f;
+		for (const Mox::Vector3f& position : InMesh.m_Positions)
+		{
+			float closestDistance = std::numeric_limits<float>::max();
+			for (size_t firstIndex = 0; firstIndex < InLodIndices.size(); firstIndex += 3)
+			{
+				closestDistance = std::min(closestDistance, ComputePointTriangleDistance(position,
+					InMesh.m_Positions[InLodIndices[firstIndex]], InMesh.m_Positions[InLodIndices[firstIndex + 1]], InMesh.m_Positions[InLodIndices[firstIndex + 2]]));
+			}
+
+			maxDistance = std::max(maxDistance, closestDistance);
+		}
+
+		return maxDistance;
+	}
+
+	float ComputeArea(const Mox::SimplifierMesh& InMesh, const std::vector<uint32_t>& InIndices)
+	{
+		float area = 0.f;
+		for (size_t firstIndex = 0; firstIndex < InIndices.size(); firstIndex += 3)
+		{
+			const Mox::Vector3f& a = InMesh.m_Positions[InIndices[firstIndex]];
+			area += .5f * (InMesh.m_Positions[InIndices[firstIndex + 1]] - a).cross(InMesh.m_Positions[InIndices[firstIndex + 2]] - a).norm();
+		}
+
+		return area;
+	}
+
+	// Every level has fewer triangles and no less error than the previous one, and the source surface is within the bound of its error
+	bool AreLevelsWithinErrorBounds(const Mox::SimplifierMesh& InMesh, const std::vector<Mox::SimplifiedMeshLod>& InLods)
+	{
+		size_t previousIndicesNum = InMesh.m_Indices.size();
+		float previousError = 0.f;
+
+		for (const Mox::SimplifiedMeshLod& lod : InLods)
+		{
+			if (lod.m_Indices.empty() || lod.m_Indices.size() >= previousIndicesNum || lod.m_Error < previousError)
+			{
+				return false;
+			}
+
+			if (ComputeSourceDistance(InMesh, lod.m_Indices) > ErrorBoundScale * lod.m_Error + 1e-5f)
+			{
+				return false;
+			}
+
+			previousIndicesNum = lod.m_Indices.size();
+			previousError = lod.m_Error;
+		}
+
+		return true;
+	}
+
+	void TestLevelsWithinErrorBounds()
+	{
+		Mox::MeshLodSettings lodSettings;
+		lodSettings.m_LodsNum = 4;
+
+		for (const Mox::SimplifierMesh& mesh : { MakeSphere(), MakeTerrain(48, .05f) })
+		{
+			std::vector<Mox::SimplifiedMeshLod> meshLods;
+			Mox::GenerateMeshLods(mesh, lodSettings, meshLods);
+
+			TestCheck(meshLods.size() == lodSettings.m_LodsNum)
+			TestCheck(AreLevelsWithinErrorBounds(mesh, meshLods))
+
+			// Each level aims at half the triangles of the previous one
+			TestCheck(meshLods.back().m_Indices.size() <= mesh.m_Indices.size() / 8)
+		}
+	}
+
+	void TestLevelsStopAtMaxError()
+	{
+		const Mox::SimplifierMesh sphereMesh = MakeSphere();
+
+		Mox::MeshLodSettings lodSettings;
+		lodSettings.m_LodsNum = 6;
+		lodSettings.m_MaxError = .02f;
+
+		std::vector<Mox::SimplifiedMeshLod> sphereLods;
+		Mox::GenerateMeshLods(sphereMesh, lodSettings, sphereLods);
+
+		// Halving the triangles six times would make the sphere a few triangles, far past the allowed error
+		TestCheck(!sphereLods.empty() && sphereLods.size() < lodSettings.m_LodsNum)
+		TestCheck(std::all_of(sphereLods.begin(), sphereLods.end(), [&lodSettings](const Mox::SimplifiedMeshLod& InLod) { return InLod.m_Error <= lodSettings.m_MaxError; }))
+		TestCheck(AreLevelsWithinErrorBounds(sphereMesh, sphereLods))
+	}
+
+	void TestFlatMeshKeepsOutline()
+	{
+		const Mox::SimplifierMesh flatMesh = MakeTerrain(32, 0.f);
+
+		Mox::MeshLodSettings lodSettings;
+		lodSettings.m_LodsNum = 4;
+		lodSettings.m_LockBorders = true;
+
+		std::vector<Mox::SimplifiedMeshLod> flatLods;
+		Mox::GenerateMeshLods(flatMesh, lodSettings, flatLods);
+
+		TestCheck(flatLods.size() == lodSettings.m_LodsNum)
+
+		const float sourceArea = ComputeArea(flatMesh, flatMesh.m_Indices);
+		for (const Mox::SimplifiedMeshLod& lod : flatLods)
+		{
+			// Collapses inside a plane cost nothing, and with the border locked the levels cover the same square
+			TestCheck(lod.m_Error < 1e-5f)
+			TestCheck(std::abs(ComputeArea(flatMesh, lod.m_Indices) - sourceArea) < 1e-4f * sourceArea)
+		}
+	}
+
+	void TestParallelGenerationMatchesSerial()
+	{
+		const Mox::SimplifierMesh sphereMesh = MakeSphere();
+		const Mox::SimplifierMesh terrainMesh = MakeTerrain(48, .05f);
+
+		Mox::MeshLodSettings lodSettings;
+		lodSettings.m_LodsNum = 3;
+
+		std::vector<std::vector<Mox::SimplifiedMeshLod>> parallelLods;
+		Mox::GenerateMeshLods({ &sphereMesh, &terrainMesh, &sphereMesh, &terrainMesh }, lodSettings, parallelLods);
+
+		TestCheck(parallelLods.size() == 4)
+
+		for (size_t meshIdx = 0; meshIdx < parallelLods.size(); ++meshIdx)
+		{
+			std::vector<Mox::SimplifiedMeshLod> serialLods;
+			Mox::GenerateMeshLods(meshIdx % 2 == 0 ? sphereMesh : terrainMesh, lodSettings, serialLods);
+
+			bool areLodsEqual = serialLods.size() == parallelLods[meshIdx].size();
+			for (size_t lodIdx = 0; areLodsEqual && lodIdx < serialLods.size(); ++lodIdx)
+			{
+				areLodsEqual = serialLods[lodIdx].m_Indices == parallelLods[meshIdx][lodIdx].m_Indices && serialLods[lodIdx].m_Error == parallelLods[meshIdx][lodIdx].m_Error;
+			}
+			TestCheck(areLodsEqual)
+		}
+	}
+}
+
+int main()
+{
+	Mox::RunTestCase("Source surface is within the error bound of each level", TestLevelsWithinErrorBounds);
+
+	Mox::RunTestCase("Levels stop at the max error", TestLevelsStopAtMaxError);
+
+	Mox::RunTestCase("Flat mesh with locked borders keeps its outline", TestFlatMeshKeepsOutline);
+
+	Mox::RunTestCase("Parallel generation matches the serial one", TestParallelGenerationMatchesSerial);
+
+	return Mox::GetTestExitCode();
+}
@@ -0,0 +1,287 @@
+/*
+ MockGraphics.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#include "MockGraphics.h"
+#include "MoxMath.h"
+#include "MoxUtils.h"
+#include <algorithm>
+#include <iterator>
+#include <functional>
+#include <iostream>
+#include <cstdlib>
+#include <string>
+
+namespace Mox {
+
+	MockResource::MockResource(uint16_t InSubresourcesNum /*= 1*/, Mox::RESOURCE_STATE InInitialState /*= Mox::RESOURCE_STATE::NEUTRAL*/)
+	{
+		m_GpuPtr = 0;
+		m_DataSize = 0;
+		m_Alignment = 0;
+		m_SubresourcesNum = InSubresourcesNum;
+		m_TrackedState = InInitialState;
+	}
+
+	MockCommandList::MockCommandList(Mox::Device& InDevice, bool InIsCopyList /*= false*/)
+		: CommandList(InDevice)
+	{
+		m_CanTransitionResources = !InIsCopyList;
+	}
+
+	size_t MockCommandList::GetCallsNum(Mox::MOCK_CALL InCallType) const
+	{
+		return std::count_if(m_RecordedCalls.begin(), m_RecordedCalls.end(), 
+			[InCallType](const Mox::MockCall& InCall) { return InCall.m_Type == InCallType; });
+	}
+
+	void MockCommandList::Reset()
+	{
+		m_RecordedCalls.clear();
+		m_IsClosed = false;
+
+		ResetBoundState();
+	}
+
+	void MockCommandList::ResourceBarriers_Internal(const std::vector<Mox::ResourceTransition>& InTransitions)
+	{
+		m_RecordedCalls.push_back(Mox::MockCall{ Mox::MOCK_CALL::RESOURCE_BARRIERS, InTransitions, {} });
+	}
+
+	void MockCommandList::AliasingBarriers_Internal(const std::vector<Mox::Resource*>& InResources)
+	{
+		m_RecordedCalls.push_back(Mox::MockCall{ Mox::MOCK_CALL::ALIASING_BARRIERS, {}, InResources });
+	}
+
+	void MockCommandList::DiscardResources_Internal(const std::vector<Mox::Resource*>& InResources)
+	{
+		m_RecordedCalls.push_back(Mox::MockCall{ Mox::MOCK_CALL::DISCARD_RESOURCES, {}, InResources });
+	}
+
+	void MockTransientResourceAllocator::GetTextureAllocationInfo(const Mox::RgTextureDesc& InDesc, uint64_t& OutSize, uint64_t& OutAlignment)
+	{
+		OutSize = Mox::Align(static_cast<uint64_t>(InDesc.m_Width) * InDesc.m_Height * 4, PlacementAlignment);
+		OutAlignment = PlacementAlignment;
+	}
+
+	void MockTransientResourceAllocator::ReserveMemory(uint64_t InSize)
+	{
+		if (InSize > m_HeapSize)
+		{
+			m_PlacedTextures.clear();
+			m_HeapSize = InSize;
+		}
+	}
+
+	Mox::Resource& MockTransientResourceAllocator::PlaceTexture(const Mox::RgTextureDesc& InDesc, uint64_t InHeapOffset, Mox::RESOURCE_STATE InInitialState)
+	{
+		Check(InHeapOffset + Mox::Align(static_cast<uint64_t>(InDesc.m_Width) * InDesc.m_Height * 4, PlacementAlignment) <= m_HeapSize)
+
+		for (const PlacedTexture& placedTexture : m_PlacedTextures)
+		{
+			if (placedTexture.m_Desc == InDesc && placedTexture.m_HeapOffset == InHeapOffset)
+			{
+				return *placedTexture.m_Resource;
+			}
+		}
+
+		++m_CreatedTexturesNum;
+		m_PlacedTextures.push_back(PlacedTexture{ InDesc, InHeapOffset, std::make_unique<Mox::MockResource>(1, InInitialState) });
+
+		return *m_PlacedTextures.back().m_Resource;
+	}
+
+	MockCommandQueue::MockCommandQueue(Mox::Device& InDevice, bool InIsCopyQueue /*= false*/)
+		: m_Device(InDevice), m_IsCopyQueue(InIsCopyQueue)
+	{
+
+	}
+
+	Mox::CommandList& MockCommandQueue::GetAvailableCommandList()
+	{
+		// Lists are never recycled, so that the calls of every submission can be inspected at the end of a test
+		m_CmdListPool.push_back(std::make_unique<Mox::MockCommandList>(m_Device, m_IsCopyQueue));
+
+		return *m_CmdListPool.back();
+	}
+
+	uint64_t MockCommandQueue::ExecuteCmdList(Mox::CommandList& InCmdList)
+	{
+		InCmdList.Close();
+
+		m_ExecutedLists.push_back(static_cast<Mox::MockCommandList*>(&InCmdList));
+
+		return ++m_LastSignaledFenceValue;
+	}
+
+	void MockCommandQueue::WaitForFenceValue(uint64_t InFenceValue)
+	{
+		if (!IsFenceComplete(InFenceValue))
+		{
+			m_CpuWaitsNum++;
+
+			CompleteUpTo(InFenceValue);
+		}
+	}
+
+	void MockCommandQueue::GpuWaitForQueue(Mox::CommandQueue& InOtherQueue, uint64_t InFenceValue)
+	{
+		m_GpuWaits.emplace_back(&InOtherQueue, InFenceValue);
+	}
+
+	void MockCommandQueue::CompleteUpTo(uint64_t InFenceValue)
+	{
+		// The Gpu cannot complete work that was never submitted
+		m_CompletedFenceValue = std::max(m_CompletedFenceValue, std::min(InFenceValue, m_LastSignaledFenceValue));
+	}
+
+	void MockConstantBufferView::CreateNullView()
+	{
+		if (!m_NullCbv)
+		{
+			m_NullCbv = std::make_unique<Mox::MockConstantBufferView>(nullptr);
+		}
+	}
+
+	uint32_t MockShaderResourceView::m_CreatedViewsNum = 0;
+
+	void MockShaderResourceView::CreateNullViews()
+	{
+		if (!m_NullTex2DSrv)
+		{
+			m_NullTex2DSrv = std::make_unique<Mox::MockShaderResourceView>();
+			m_NullCubeSrv = std::make_unique<Mox::MockShaderResourceView>();
+		}
+	}
+
+	MockGraphicsAllocator::MockGraphicsAllocator()
+		: GraphicsAllocatorBase(std::make_unique<Mox::PipelineStateCache>(nullptr))
+	{
+		Mox::MockConstantBufferView::CreateNullView();
+		Mox::MockShaderResourceView::CreateNullViews();
+	}
+
+	void MockGraphicsAllocator::AllocatePendingBufferResources()
+	{
+		Mox::FrameRenderUpdates& pendingUpdates = Mox::GetSimThreadUpdatesForRenderer();
+
+		for (const Mox::BufferResourceRequest& bufferRequest : pendingUpdates.m_BufferResourceRequests)
+		{
+			AllocateResourceForBuffer(bufferRequest);
+		}
+
+		pendingUpdates.m_BufferResourceRequests.clear();
+		pendingUpdates.m_StaticBufferUpdates.clear();
+		pendingUpdates.m_DynamicBufferUpdates.clear();
+	}
+
+	void MockGraphicsAllocator::ReleaseBuffers(std::vector<std::unique_ptr<Mox::ConstantBuffer>>&& InBuffers)
+	{
+		// Their resources and views are kept, so buffers only need to outlive them
+		std::move(InBuffers.begin(), InBuffers.end(), std::back_inserter(m_ReleasedBuffers));
+	}
+
+	Mox::VertexBuffer& MockGraphicsAllocator::AllocateVertexBuffer(const Mox::INPUT_LAYOUT_DESC& InLayoutDesc, const void* InData, uint32_t InStride, uint32_t InSize)
+	{
+		m_VertexBuffers.emplace_back(InLayoutDesc, InData, InStride, InSize);
+		return m_VertexBuffers.back();
+	}
+
+	Mox::IndexBuffer& MockGraphicsAllocator::AllocateIndexBuffer(const void* InData, uint32_t InStride, uint32_t InSize)
+	{
+		m_IndexBuffers.emplace_back(InData, InStride, InSize);
+		return m_IndexBuffers.back();
+	}
+
+	Mox::BufferResource& MockGraphicsAllocator::AllocateDynamicBuffer(uint32_t InSize)
+	{
+		m_BufferResources.push_back(std::make_unique<Mox::BufferResource>(Mox::RES_CONTENT_TYPE::CONSTANT, Mox::BUFFER_ALLOC_TYPE::DYNAMIC,
+			m_BufferMemory, nullptr, m_NextGpuAddress, InSize));
+		m_NextGpuAddress += InSize;
+
+		return *m_BufferResources.back();
+	}
+
+	void MockGraphicsAllocator::AllocateFrameData(uint32_t InSize, void*& OutCpuPtr, Mox::GPU_V_ADDRESS& OutGpuPtr)
+	{
+		m_FrameData.emplace_back(InSize);
+
+		OutCpuPtr = m_FrameData.back().data();
+		OutGpuPtr = m_NextGpuAddress;
+		m_NextGpuAddress += InSize;
+	}
+
+	std::vector<RenderProxy*> MockGraphicsAllocator::RegisterProxies(const std::vector<Mox::RenderProxyRequest>& InRequests)
+	{
+		std::vector<Mox::RenderProxy*> outProxies;  outProxies.reserve(InRequests.size());
+		for (const Mox::RenderProxyRequest& proxyRequest : InRequests)
+		{
+			m_RenderProxies.push_back(proxyRequest.m_TargetProxy);
+			outProxies.push_back(proxyRequest.m_TargetProxy.get());
+		}
+
+		return outProxies;
+	}
+
+	void MockGraphicsAllocator::AllocateResourceForBuffer(const Mox::BufferResourceRequest& InResourceRequest)
+	{
+		// Constant buffers are requested without a stride
+		m_BufferResources.push_back(std::make_unique<Mox::BufferResource>(InResourceRequest.m_ContentType, InResourceRequest.m_AllocType,
+			m_BufferMemory, nullptr, m_NextGpuAddress, InResourceRequest.m_AllocationSize, std::max(InResourceRequest.m_Stride, 1u)));
+		m_NextGpuAddress += InResourceRequest.m_AllocationSize;
+
+		InResourceRequest.m_TargetBufferHolder->SetBufferResource(*m_BufferResources.back());
+	}
+
+	Mox::VertexBufferView& MockGraphicsAllocator::AllocateVertexBufferView(Mox::BufferResource& InVBResource)
+	{
+		m_VertexBufferViews.emplace_back(InVBResource);
+		return m_VertexBufferViews.back();
+	}
+
+	Mox::IndexBufferView& MockGraphicsAllocator::AllocateIndexBufferView(Mox::BufferResource& InIB, Mox::BUFFER_FORMAT InFormat, uint32_t InElementsNum)
+	{
+		m_IndexBufferViews.emplace_back(InIB, InFormat, InElementsNum);
+		return m_IndexBufferViews.back();
+	}
+
+	Mox::ConstantBufferView& MockGraphicsAllocator::AllocateConstantBufferView(Mox::BufferResource& InResource)
+	{
+		m_ConstantBufferViews.emplace_back(&InResource);
+		return m_ConstantBufferViews.back();
+	}
+
+	Mox::Shader& MockGraphicsAllocator::AllocateShader(wchar_t const* InShaderPath)
+	{
+		// The same shader file gets the same hash, as its bytecode would
+		m_Shaders.emplace_back(std::hash<std::wstring>()(InShaderPath));
+		return m_Shaders.back();
+	}
+
+	Mox::PipelineState& MockGraphicsAllocator::AllocatePipelineState()
+	{
+		m_PipelineStates.emplace_back();
+		return m_PipelineStates.back();
+	}
+
+	void MockGraphicsAllocator::CreateDrawables(const std::vector<Mox::DrawableCreationInfo>& InRequests)
+	{
+		for (const Mox::DrawableCreationInfo& drawableRequest : InRequests)
+		{
+			m_Drawables.push_back(std::make_unique<Mox::Drawable>(drawableRequest));
+
+			drawableRequest.m_OwningProxy->AddDrawable(m_Drawables.back().get());
+		}
+	}
+
+	void MockGraphicsAllocator::StopForUnsupportedCall(const char* InCallName)
+	{
+		std::cout << "Mock graphics allocator does not support " << InCallName << std::endl;
+		std::abort();
+	}
+
+}
@@ -0,0 +1,231 @@
+/*
+ OcclusionBufferTest.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+#include <cstdint>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include "MoxTestUtils.h"
+#include "MoxMath.h"
+#include "MoxGeometry.h"
+#include "MoxOcclusionBuffer.h"
+
+// Rasterizes occluders with the Cpu occlusion buffer and compares its depth with reference depth images,
+// produced by a straightforward per pixel rasterizer working in double precision.
+
+namespace
+{
+	constexpr uint32_t BufferWidth = 128;
+	constexpr uint32_t BufferHeight = 64;
+
+	// Pixel centers closer than this to an edge, in pixels, can fall on either side depending on precision and are not compared
+	constexpr double EdgeTolerance = 1e-3;
+
+	constexpr float DepthTolerance = 1e-4f;
+
+	struct Occluder
+	{
+		Mox::OccluderMesh m_Mesh;
+		Mox::Matrix4f m_ModelMatrix;
+	};
+
+	struct ReferenceImage
+	{
+		std::vector<float> m_Depth;
+		// Pixels whose center is too close to a triangle edge to expect the same coverage
+		std::vector<bool> m_IsAmbiguous;
+	};
+
+	Mox::Matrix4f ComputeViewProj()
+	{
+		const Mox::Matrix4f viewMatrix = Mox::LookAt(Mox::Vector3f(0.f, 0.f, -10.f), Mox::Vector3f::Zero(), Mox::Vector3f(0.f, 1.f, 0.f));
+		const Mox::Matrix4f projMatrix = Mox::Perspective(0.1f, 100.f, static_cast<float>(BufferWidth) / BufferHeight, 0.8f);
+
+		return projMatrix * viewMatrix;
+	}
+
+	Mox::Matrix4f ComputeModelMatrix(const Mox::Vector3f& InPosition, float InRotationY, float InScale)
+	{
+		Mox::Affine3f transform = Mox::Affine3f::Identity();
+		transform.translate(InPosition);
+		transform.rotate(Eigen::AngleAxisf(InRotationY, Mox::Vector3f::UnitY()));
+		transform.scale(InScale);
+
+		return transform.matrix();
+	}
+
+	Mox::OccluderMesh MakeQuad(float InHalfSize)
+	{
+		return Mox::OccluderMesh{
+			{ Mox::Vector3f(-InHalfSize, -InHalfSize, 0.f), Mox::Vector3f(-InHalfSize, InHalfSize, 0.f), Mox::Vector3f(InHalfSize, InHalfSize, 0.f), Mox::Vector3f(InHalfSize, -InHalfSize, 0.f) },
+			{ 0, 1, 2, 0, 2, 3 } };
+	}
+
+	Mox::OccluderMesh MakeSphere()
+	{
+		std::vector<Mox::Vector3f> sphereVertices;
+		std::vector<Mox::Vector2f> sphereUvs;
+		std::vector<uint16_t> sphereIndices;
+		Mox::UVSphere(10, 10, sphereVertices, sphereUvs, sphereIndices);
+
+		return Mox::OccluderMesh{ sphereVertices, std::vector<uint32_t>(sphereIndices.begin(), sphereIndices.end()) };
+	}
+
+	ReferenceImage RasterizeReference(const Mox::Matrix4f& InViewProj, const std::vector<Occluder>& InOccluders)
+	{
+		ReferenceImage referenceImage{ std::vector<float>(BufferWidth * BufferHeight, 1.f), std::vector<bool>(BufferWidth * BufferHeight, false) };
+
+		for (const Occluder& occluder : InOccluders)
+		{
+			const Mox::Matrix4f modelViewProj = InViewProj * occluder.m_ModelMatrix;
+
+			for (size_t firstIndex = 0; firstIndex < occluder.m_Mesh.m_Indices.size(); firstIndex += 3)
+			{
+				double screenX[3], screenY[3], screenZ[3];
+				bool isCrossingNearPlane = false;
+
+				for (uint32_t vertexIdx = 0; vertexIdx < 3; ++vertexIdx)
+				{
+					const Mox::Vector3f& position = occluder.m_Mesh.m_Positions[occluder.m_Mesh.m_Indices[firstIndex + vertexIdx]];
+					const Mox::Vector4f clipPosition = modelViewProj * Mox::Vector4f(position.x(), position.y(), position.z(), 1.f);
+
+					isCrossingNearPlane |= clipPosition.z() < 0.f;
+
+					screenX[vertexIdx] = (clipPosition.x() / static_cast<double>(clipPosition.w()) * 0.5 + 0.5) * BufferWidth;
+					screenY[vertexIdx] = (0.5 - clipPosition.y() / static_cast<double>(clipPosition.w()) * 0.5) * BufferHeight;
+					screenZ[vertexIdx] = clipPosition.z() / static_cast<double>(clipPosition.w());
+				}
+
+				const double doubleArea = (screenX[1] - screenX[0]) * (screenY[2] - screenY[0]) - (screenX[2] - screenX[0]) * (screenY[1] - screenY[0]);
+				if (isCrossingNearPlane || std::abs(doubleArea) < 1e-6)
+				{
+					continue;
+				}
+
+				for (uint32_t row = 0; row < BufferHeight; ++row)
+				{
+					for (uint32_t col = 0; col < BufferWidth; ++col)
+					{
+						const double centerX = col + 0.5, centerY = row + 0.5;
+
+						// Barycentric coordinates of the pixel center, and its distance from the nearest edge
+						double weights[3];
+						double edgeDistance = std::numeric_limits<double>::max();
+						for (uint32_t edgeIdx = 0; edgeIdx < 3; ++edgeIdx)
+						{
+							const uint32_t startIdx = (edgeIdx + 1) % 3, endIdx = (edgeIdx + 2) % 3;
+							const double edgeX = screenX[endIdx] - screenX[startIdx], edgeY = screenY[endIdx] - screenY[startIdx];
+							const double edgeFunction = edgeX * (centerY - screenY[startIdx]) - edgeY * (centerX - screenX[startIdx]);
+
+							weights[edgeIdx] = edgeFunction / doubleArea;
+							edgeDistance = std::min(edgeDistance, std::abs(edgeFunction) / std::sqrt(edgeX * edgeX + edgeY * edgeY));
+						}
+
+						const bool isInside = weights[0] >= 0.0 && weights[1] >= 0.0 && weights[2] >= 0.0;
+						const size_t pixelIdx = row * BufferWidth + col;
+
+						if (edgeDistance < EdgeTolerance)
+						{
+							referenceImage.m_IsAmbiguous[pixelIdx] = true;
+						}
+						else if (isInside)
+						{
+							const double depth = weights[0] * screenZ[0] + weights[1] * screenZ[1] + weights[2] * screenZ[2];
+							referenceImage.m_Depth[pixelIdx] = std::min(referenceImage.m_Depth[pixelIdx], static_cast<float>(depth));
+						}
+					}
+				}
+			}
+		}
+
+		return referenceImage;
+	}
+
+	// Number of pixels where the depth of the buffer differs from the reference
+	uint32_t CompareWithReference(const std::vector<Occluder>& InOccluders)
+	{
+		const Mox::Matrix4f viewProj = ComputeViewProj();
+
+		Mox::OcclusionBuffer occlusionBuffer(BufferWidth, BufferHeight);
+		occlusionBuffer.BeginFrame(viewProj);
+		for (const Occluder& occluder : InOccluders)
+		{
+			occlusionBuffer.AddOccluder(occluder.m_Mesh, occluder.m_ModelMatrix);
+		}
+		occlusionBuffer.Rasterize();
+
+		const ReferenceImage referenceImage = RasterizeReference(viewProj, InOccluders);
+
+		uint32_t differentPixelsNum = 0;
+		for (size_t pixelIdx = 0; pixelIdx < referenceImage.m_Depth.size(); ++pixelIdx)
+		{
+			if (!referenceImage.m_IsAmbiguous[pixelIdx] && std::abs(occlusionBuffer.GetDepth()[pixelIdx] - referenceImage.m_Depth[pixelIdx]) > DepthTolerance)
+			{
+				++differentPixelsNum;
+			}
+		}
+
+		return differentPixelsNum;
+	}
+
+	void TestSingleQuadDepth()
+	{
+		TestCheck(CompareWithReference({ { MakeQuad(2.f), ComputeModelMatrix(Mox::Vector3f(0.3f, -0.2f, 0.f), 0.f, 1.f) } }) == 0)
+
+		// Slanted, so that depth changes across the screen
+		TestCheck(CompareWithReference({ { MakeQuad(2.f), ComputeModelMatrix(Mox::Vector3f(-0.5f, 0.1f, 1.f), 0.9f, 1.f) } }) == 0)
+	}
+
+	void TestIntersectingOccludersDepth()
+	{
+		// Two slanted quads crossing each other and a sphere partially in front of them, the nearest surface has to win on every pixel
+		TestCheck(CompareWithReference({
+			{ MakeQuad(3.f), ComputeModelMatrix(Mox::Vector3f(0.f, 0.f, 0.f), 0.6f, 1.f) },
+			{ MakeQuad(3.f), ComputeModelMatrix(Mox::Vector3f(0.2f, 0.1f, 0.f), -0.6f, 1.f) },
+			{ MakeSphere(), ComputeModelMatrix(Mox::Vector3f(1.5f, 0.5f, -2.f), 0.3f, 1.2f) } }) == 0)
+	}
+
+	void TestNearPlaneTrianglesDropped()
+	{
+		// The quad reaches behind the camera, so its triangles are skipped and the buffer stays empty where they are
+		TestCheck(CompareWithReference({ { MakeQuad(20.f), ComputeModelMatrix(Mox::Vector3f(0.f, 0.f, -10.f), 1.2f, 1.f) } }) == 0)
+	}
+
+	void TestOccludedBoxes()
+	{
+		Mox::OcclusionBuffer occlusionBuffer(BufferWidth, BufferHeight);
+		occlusionBuffer.BeginFrame(ComputeViewProj());
+		occlusionBuffer.AddOccluder(MakeQuad(2.f), ComputeModelMatrix(Mox::Vector3f::Zero(), 0.f, 1.f));
+		occlusionBuffer.Rasterize();
+
+		// Behind the quad and smaller than it on screen
+		TestCheck(occlusionBuffer.IsOccluded(Mox::Aabb(Mox::Vector3f(-0.5f, -0.5f, 3.f), Mox::Vector3f(0.5f, 0.5f, 4.f))))
+
+		// In front of the quad
+		TestCheck(!occlusionBuffer.IsOccluded(Mox::Aabb(Mox::Vector3f(-0.5f, -0.5f, -3.f), Mox::Vector3f(0.5f, 0.5f, -2.f))))
+
+		// Behind the quad, but partially outside of it on screen
+		TestCheck(!occlusionBuffer.IsOccluded(Mox::Aabb(Mox::Vector3f(1.5f, -0.5f, 1.f), Mox::Vector3f(3.f, 0.5f, 2.f))))
+
+		// Crossing the quad
+		TestCheck(!occlusionBuffer.IsOccluded(Mox::Aabb(Mox::Vector3f(-0.5f, -0.5f, -1.f), Mox::Vector3f(0.5f, 0.5f, 1.f))))
+	}
+}
+
+int main()
+{
+	Mox::RunTestCase("Single occluder depth matches the reference", TestSingleQuadDepth);
+
+	Mox::RunTestCase("Nearest of intersecting occluders matches the reference", TestIntersectingOccludersDepth);
+
+	Mox::RunTestCase("Occluder triangles crossing the near plane are dropped", TestNearPlaneTrianglesDropped);
+
+	Mox::RunTestCase("Boxes are occluded only when fully hidden", TestOccludedBoxes);
+
+	return Mox::GetTestExitCode();
+}
@@ -0,0 +1,137 @@
+/*
+ PipelineStateCacheTest.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+#include "MoxTestUtils.h"
+#include "MockGraphics.h"
+#include "PipelineStateCache.h"
+#include "PersistentBlobCache.h"
+
+// States are shared only between equal descriptions, both in memory and on disk,
+// where a stored blob is only used for the description it was compiled from.
+
+namespace
+{
+	constexpr uint64_t ContextHash = 7;
+
+	// Descriptions differing only in their culling mode
+	struct TestDescs
+	{
+		Mox::INPUT_LAYOUT_DESC m_LayoutDesc{ { {"POSITION", Mox::BUFFER_FORMAT::R32G32B32_FLOAT} } };
+		Mox::PipelineState::RESOURCE_BINDER_DESC m_BinderDesc{ Mox::PipelineState::RESOURCE_BINDER_FLAGS::ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT, {}, {} };
+		Mox::MockShader m_VertexShader{ 1 };
+		Mox::MockShader m_PixelShader{ 2 };
+
+		Mox::PipelineState::GRAPHICS_PSO_DESC m_FrontFacesDesc{ m_LayoutDesc, m_BinderDesc, Mox::PRIMITIVE_TOPOLOGY_TYPE::PTT_TRIANGLE,
+			m_VertexShader, m_PixelShader, Mox::BUFFER_FORMAT::D32_FLOAT, Mox::BUFFER_FORMAT::R8G8B8A8_UNORM, false };
+
+		Mox::PipelineState::GRAPHICS_PSO_DESC m_BackFacesDesc{ m_LayoutDesc, m_BinderDesc, Mox::PRIMITIVE_TOPOLOGY_TYPE::PTT_TRIANGLE,
+			m_VertexShader, m_PixelShader, Mox::BUFFER_FORMAT::D32_FLOAT, Mox::BUFFER_FORMAT::R8G8B8A8_UNORM, true };
+	};
+
+	std::filesystem::path GetCacheDirectory()
+	{
+		return std::filesystem::temp_directory_path() / "MoxiePipelineStateCacheTest";
+	}
+
+	std::unique_ptr<Mox::PersistentBlobCache> MakeDiskCache()
+	{
+		return std::make_unique<Mox::PersistentBlobCache>(GetCacheDirectory(), ContextHash);
+	}
+
+	void TestEqualDescsShareState()
+	{
+		Mox::MockGraphicsAllocator allocator;
+		Mox::GraphicsAllocator::SetDefaultInstance(&allocator);
+
+		TestDescs descs;
+		Mox::PipelineStateCache stateCache(nullptr);
+
+		Mox::PipelineState& firstState = stateCache.GetOrCreate(descs.m_FrontFacesDesc);
+		TestCheck(&stateCache.GetOrCreate(descs.m_FrontFacesDesc) == &firstState)
+		TestCheck(&stateCache.GetOrCreate(descs.m_BackFacesDesc) != &firstState)
+
+		TestCheck(stateCache.GetHitsNum() == 1 && stateCache.GetMissesNum() == 2)
+		TestCheck(allocator.GetPipelineStatesNum() == 2)
+
+		Mox::GraphicsAllocator::SetDefaultInstance(nullptr);
+	}
+
+	void TestStoredStatesAreReused()
+	{
+		std::filesystem::remove_all(GetCacheDirectory());
+
+		Mox::MockGraphicsAllocator allocator;
+		Mox::GraphicsAllocator::SetDefaultInstance(&allocator);
+
+		TestDescs descs;
+		{
+			Mox::PipelineStateCache firstRunCache(MakeDiskCache());
+			firstRunCache.GetOrCreate(descs.m_FrontFacesDesc);
+			TestCheck(firstRunCache.GetDiskHitsNum() == 0)
+		}
+
+		// A later run finds the compiled blob of the same description
+		Mox::PipelineStateCache secondRunCache(MakeDiskCache());
+		TestCheck(secondRunCache.GetOrCreate(descs.m_FrontFacesDesc).IsGraphics())
+		TestCheck(secondRunCache.GetDiskHitsNum() == 1)
+
+		Mox::GraphicsAllocator::SetDefaultInstance(nullptr);
+		std::filesystem::remove_all(GetCacheDirectory());
+	}
+
+	void TestBlobOfAnotherDescIsMiss()
+	{
+		std::filesystem::remove_all(GetCacheDirectory());
+
+		Mox::MockGraphicsAllocator allocator;
+		Mox::GraphicsAllocator::SetDefaultInstance(&allocator);
+
+		TestDescs descs;
+
+		// Simulating a hash collision: the entry of the front faces description holds the blob of the back faces one,
+		// stored as the cache stores it, after the key of its description
+		std::vector<uint8_t> collidingBlob;
+		Mox::PipelineStateCache::BuildDescKey(descs.m_BackFacesDesc, collidingBlob);
+		const std::vector<uint8_t> compiledBlob = Mox::MockPipelineState().GetCachedBlob();
+		collidingBlob.insert(collidingBlob.end(), compiledBlob.begin(), compiledBlob.end());
+
+		// Category used by the cache for pipeline states
+		MakeDiskCache()->Store("pso", Mox::PipelineStateCache::ComputeDescHash(descs.m_FrontFacesDesc), collidingBlob.data(), collidingBlob.size());
+
+		{
+			Mox::PipelineStateCache stateCache(MakeDiskCache());
+			stateCache.GetOrCreate(descs.m_FrontFacesDesc);
+			TestCheck(stateCache.GetDiskHitsNum() == 0)
+		}
+
+		// The entry got replaced by the blob of the right description
+		Mox::PipelineStateCache laterRunCache(MakeDiskCache());
+		laterRunCache.GetOrCreate(descs.m_FrontFacesDesc);
+		TestCheck(laterRunCache.GetDiskHitsNum() == 1)
+
+		Mox::GraphicsAllocator::SetDefaultInstance(nullptr);
+		std::filesystem::remove_all(GetCacheDirectory());
+	}
+}
+
+int main()
+{
+	Mox::RunTestCase("Equal descriptions share the pipeline state", TestEqualDescsShareState);
+
+	Mox::RunTestCase("Stored pipeline states are reused by later runs", TestStoredStatesAreReused);
+
+	Mox::RunTestCase("Stored blob of another description is a miss", TestBlobOfAnotherDescIsMiss);
+
+	return Mox::GetTestExitCode();
+}
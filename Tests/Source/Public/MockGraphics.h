@@ -0,0 +1,402 @@
+/*
+ MockGraphics.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef MockGraphics_h__
+#define MockGraphics_h__
+
+#include <cstdint>
+#include <vector>
+#include <tuple>
+#include <memory>
+#include <deque>
+#include "CommandList.h"
+#include "CommandQueue.h"
+#include "Device.h"
+#include "GraphicsAllocator.h"
+#include "GraphicsUtils.h"
+#include "RenderGraph.h"
+#include "MoxDrawable.h"
+#include "MoxRenderProxy.h"
+
+namespace Mox {
+
+	// Device that does not talk to any graphics API, it only exists because command lists need one
+	class MockDevice : public Mox::Device
+	{
+	public:
+		virtual void ReportLiveObjects() override {}
+
+		virtual void ShutDown() override {}
+
+		virtual uint64_t GetPipelineCacheContextHash() const override { return 0; }
+	};
+
+	// Resource without memory behind it, only its tracked state is meaningful
+	struct MockResource : public Mox::Resource
+	{
+		MockResource(uint16_t InSubresourcesNum = 1, Mox::RESOURCE_STATE InInitialState = Mox::RESOURCE_STATE::NEUTRAL);
+
+		virtual void Map(void** OutCpuPp) override { *OutCpuPp = nullptr; }
+
+		virtual void UnMap() override {}
+	};
+
+	// Platform calls a command list can make, one for each _Internal function
+	enum class MOCK_CALL : uint8_t
+	{
+		RESOURCE_BARRIERS,
+		ALIASING_BARRIERS,
+		DISCARD_RESOURCES,
+		CLEAR_RTV,
+		CLEAR_DEPTH,
+		DRAW_INDEXED,
+		DISPATCH,
+		UPLOAD_BUFFER_DATA,
+		SET_PIPELINE_STATE,
+		SET_RESOURCE_BINDER,
+		SET_DESCRIPTOR_HEAPS,
+		SET_PRIMITIVE_TOPOLOGY,
+		SET_VERTEX_BUFFER,
+		SET_INDEX_BUFFER,
+		SET_GRAPHICS_ROOT_CONSTANTS,
+		SET_GRAPHICS_ROOT_TABLE,
+		SET_GRAPHICS_ROOT_SHADER_RESOURCE,
+		STAGE_DYNAMIC_CBV,
+		REFERENCE_SRV,
+		REFERENCE_CBV,
+		REFERENCE_VIEWS_HEAP,
+		OTHER
+	};
+
+	struct MockCall
+	{
+		Mox::MOCK_CALL m_Type;
+		// Filled for resource barriers
+		std::vector<Mox::ResourceTransition> m_Transitions;
+		// Filled for aliasing barriers and discards
+		std::vector<Mox::Resource*> m_Resources;
+	};
+
+	/*
+	* Command list recording every call that reaches the platform layer, instead of sending it to a graphics API.
+	* Since the base class filters redundant binds and transitions before the _Internal functions,
+	* the recorded calls are the ones a real list would have sent to the driver.
+	*/
+	class MockCommandList : public Mox::CommandList
+	{
+	public:
+		MockCommandList(Mox::Device& InDevice, bool InIsCopyList = false);
+
+		const std::vector<Mox::MockCall>& GetRecordedCalls() const { return m_RecordedCalls; }
+
+		size_t GetCallsNum(Mox::MOCK_CALL InCallType) const;
+
+		// Forgets the recorded calls and everything bound, as if the list was reset for a new recording
+		void Reset();
+
+		bool IsClosed() const { return m_IsClosed; }
+
+		virtual void SetViewportAndScissorRect(Mox::ViewPort& InViewport, Mox::Rect& InScissorRect) override { Record(Mox::MOCK_CALL::OTHER); }
+		virtual void SetRenderTargetFromWindow(Mox::Window& InWindow) override { Record(Mox::MOCK_CALL::OTHER); }
+		virtual void SetComputeRootConstants(uint64_t InRootParameterIndex, uint64_t InNum32BitValuesToSet, const void* InSrcData, uint64_t InDestOffsetIn32BitValues) override { Record(Mox::MOCK_CALL::OTHER); }
+		virtual void CommitStagedViews() override { Record(Mox::MOCK_CALL::OTHER); }
+		virtual void UploadViewToGPU(Mox::ShaderResourceView& InSRV) override { Record(Mox::MOCK_CALL::OTHER); }
+		virtual void UploadUavToGpu(Mox::UnorderedAccessView& InUav) override { Record(Mox::MOCK_CALL::OTHER); }
+		virtual void ReferenceComputeTable(uint32_t InRootIdx, Mox::ShaderResourceView& InUav) override { Record(Mox::MOCK_CALL::OTHER); }
+		virtual void ReferenceComputeTable(uint32_t InRootIdx, Mox::UnorderedAccessView& InUav) override { Record(Mox::MOCK_CALL::OTHER); }
+
+	protected:
+		virtual void Close_Internal() override { m_IsClosed = true; }
+		virtual void ResourceBarriers_Internal(const std::vector<Mox::ResourceTransition>& InTransitions) override;
+		virtual void AliasingBarriers_Internal(const std::vector<Mox::Resource*>& InResources) override;
+		virtual void DiscardResources_Internal(const std::vector<Mox::Resource*>& InResources) override;
+		virtual void ClearRTV_Internal(Mox::CpuDescHandle& InDescHandle, float* InColor) override { Record(Mox::MOCK_CALL::CLEAR_RTV); }
+		virtual void ClearDepth_Internal(Mox::CpuDescHandle& InDescHandle) override { Record(Mox::MOCK_CALL::CLEAR_DEPTH); }
+		virtual void DrawIndexed_Internal(uint64_t InIndexCountPerInstance, uint32_t InInstancesNum) override { Record(Mox::MOCK_CALL::DRAW_INDEXED); }
+		virtual void Dispatch_Internal(uint32_t InGroupsNumX, uint32_t InGroupsNumY, uint32_t InGroupsNumZ) override { Record(Mox::MOCK_CALL::DISPATCH); }
+		virtual void UploadBufferData_Internal(Mox::BufferResource& DestinationBuffer, Mox::BufferResource& IntermediateBuffer, const void* InBufferData, size_t InDataSize) override { Record(Mox::MOCK_CALL::UPLOAD_BUFFER_DATA); }
+		virtual void SetPipelineState_Internal(Mox::PipelineState& InPipelineState) override { Record(Mox::MOCK_CALL::SET_PIPELINE_STATE); }
+		virtual void SetResourceBinder_Internal(Mox::PipelineState& InPipelineState) override { Record(Mox::MOCK_CALL::SET_RESOURCE_BINDER); }
+		virtual void SetDescriptorHeaps_Internal() override { Record(Mox::MOCK_CALL::SET_DESCRIPTOR_HEAPS); }
+		virtual void SetPrimitiveTopology_Internal(Mox::PRIMITIVE_TOPOLOGY InPrimTopology) override { Record(Mox::MOCK_CALL::SET_PRIMITIVE_TOPOLOGY); }
+		virtual void SetVertexBuffer_Internal(Mox::VertexBufferView& InVertexBufView) override { Record(Mox::MOCK_CALL::SET_VERTEX_BUFFER); }
+		virtual void SetIndexBuffer_Internal(Mox::IndexBufferView& InIndexBufView) override { Record(Mox::MOCK_CALL::SET_INDEX_BUFFER); }
+		virtual void SetGraphicsRootConstants_Internal(uint64_t InRootParameterIndex, uint64_t InNum32BitValuesToSet, const void* InSrcData, uint64_t InDestOffsetIn32BitValues) override { Record(Mox::MOCK_CALL::SET_GRAPHICS_ROOT_CONSTANTS); }
+		virtual void SetGraphicsRootTable_Internal(uint32_t InRootIndex, Mox::ConstantBufferView& InView) override { Record(Mox::MOCK_CALL::SET_GRAPHICS_ROOT_TABLE); }
+		virtual void SetGraphicsRootShaderResource_Internal(uint32_t InRootIndex, Mox::GPU_V_ADDRESS InBufferLocation) override { Record(Mox::MOCK_CALL::SET_GRAPHICS_ROOT_SHADER_RESOURCE); }
+		virtual void StageDynamicCbv_Internal(uint32_t InRootIndex, Mox::ConstantBufferView& InCbv) override { Record(Mox::MOCK_CALL::STAGE_DYNAMIC_CBV); }
+		virtual void ReferenceSRV_Internal(uint32_t InRootIdx, Mox::ShaderResourceView& InSRV) override { Record(Mox::MOCK_CALL::REFERENCE_SRV); }
+		virtual void ReferenceCBV_Internal(uint32_t InRootIdx, Mox::ConstantBufferView& InCBV) override { Record(Mox::MOCK_CALL::REFERENCE_CBV); }
+		virtual void ReferenceViewsHeap_Internal(uint32_t InRootIdx) override { Record(Mox::MOCK_CALL::REFERENCE_VIEWS_HEAP); }
+
+	private:
+		void Record(Mox::MOCK_CALL InCallType) { m_RecordedCalls.push_back(Mox::MockCall{ InCallType, {}, {} }); }
+
+		std::vector<Mox::MockCall> m_RecordedCalls;
+
+		bool m_IsClosed = false;
+	};
+
+	/*
+	* Command queue where the Gpu progress is driven by the test: submitted lists get increasing fence values,
+	* which are reported as completed only after calling CompleteUpTo.
+	* Waiting for a fence value on the Cpu simulates the Gpu catching up to it.
+	*/
+	class MockCommandQueue : public Mox::CommandQueue
+	{
+	public:
+		MockCommandQueue(Mox::Device& InDevice, bool InIsCopyQueue = false);
+
+		virtual Mox::CommandList& GetAvailableCommandList() override;
+
+		virtual uint64_t ExecuteCmdList(Mox::CommandList& InCmdList) override;
+
+		virtual void Flush() override { CompleteUpTo(m_LastSignaledFenceValue); }
+
+		virtual uint64_t GetCompletedFenceValue() override { return m_CompletedFenceValue; }
+
+		virtual bool IsFenceComplete(uint64_t InFenceValue) override { return m_CompletedFenceValue >= InFenceValue; }
+
+		virtual void WaitForFenceValue(uint64_t InFenceValue) override;
+
+		virtual void GpuWaitForQueue(Mox::CommandQueue& InOtherQueue, uint64_t InFenceValue) override;
+
+		virtual void OnRenderFrameStarted() override {}
+
+		virtual void OnRenderFrameFinished() override {}
+
+		virtual uint64_t ComputeFramesInFlightNum() override { return m_LastSignaledFenceValue - m_CompletedFenceValue; }
+
+		virtual void WaitForGpuFrames(uint64_t InFramesToWaitNum) override { Flush(); }
+
+		// Simulates the Gpu completing the work submitted up to the given fence value
+		void CompleteUpTo(uint64_t InFenceValue);
+
+		uint64_t GetLastSignaledFenceValue() const { return m_LastSignaledFenceValue; }
+
+		// Number of times the Cpu had to stall waiting for the Gpu
+		uint32_t GetCpuWaitsNum() const { return m_CpuWaitsNum; }
+
+		// Fence values of other queues that the Gpu was asked to wait for on this queue, in request order
+		const std::vector<std::tuple<Mox::CommandQueue*, uint64_t>>& GetGpuWaits() const { return m_GpuWaits; }
+
+		// Lists in submission order
+		const std::vector<Mox::MockCommandList*>& GetExecutedLists() const { return m_ExecutedLists; }
+
+	private:
+		Mox::Device& m_Device;
+
+		bool m_IsCopyQueue;
+
+		std::vector<std::unique_ptr<Mox::MockCommandList>> m_CmdListPool;
+
+		std::vector<Mox::MockCommandList*> m_ExecutedLists;
+
+		std::vector<std::tuple<Mox::CommandQueue*, uint64_t>> m_GpuWaits;
+
+		uint64_t m_LastSignaledFenceValue = 0;
+
+		uint64_t m_CompletedFenceValue = 0;
+
+		uint32_t m_CpuWaitsNum = 0;
+	};
+
+	/*
+	* Transient allocator whose heap is only a size. Textures take 4 bytes per texel, rounded up to 64KB like placed resources.
+	* Placed textures are kept until the heap grows, as a real allocator would do.
+	*/
+	class MockTransientResourceAllocator : public Mox::TransientResourceAllocator
+	{
+	public:
+		static constexpr uint64_t PlacementAlignment = 64 * 1024;
+
+		virtual void GetTextureAllocationInfo(const Mox::RgTextureDesc& InDesc, uint64_t& OutSize, uint64_t& OutAlignment) override;
+
+		virtual void ReserveMemory(uint64_t InSize) override;
+
+		virtual Mox::Resource& PlaceTexture(const Mox::RgTextureDesc& InDesc, uint64_t InHeapOffset, Mox::RESOURCE_STATE InInitialState) override;
+
+		uint64_t GetHeapSize() const { return m_HeapSize; }
+
+		// Number of textures created since the allocator was constructed, including the ones released when the heap grew
+		uint32_t GetCreatedTexturesNum() const { return m_CreatedTexturesNum; }
+
+	private:
+		struct PlacedTexture
+		{
+			Mox::RgTextureDesc m_Desc;
+			uint64_t m_HeapOffset;
+			std::unique_ptr<Mox::MockResource> m_Resource;
+		};
+
+		std::vector<PlacedTexture> m_PlacedTextures;
+
+		uint64_t m_HeapSize = 0;
+
+		uint32_t m_CreatedTexturesNum = 0;
+	};
+
+	// Shader without code, identified by the given hash in place of the hash of its bytecode
+	struct MockShader : public Mox::Shader
+	{
+		MockShader(uint64_t InBytecodeHash) { m_BytecodeHash = InBytecodeHash; }
+	};
+
+	// Pipeline state that is never compiled, every state has its own resource binder.
+	// Its cached blob is always the same, and only that blob is accepted.
+	class MockPipelineState : public Mox::PipelineState
+	{
+	public:
+		virtual void Init(GRAPHICS_PSO_DESC& InPipelineStateDesc) override { m_IsGraphicsPSO = true; }
+
+		virtual void Init(COMPUTE_PSO_DESC& InPipelineStateDesc) override { m_IsGraphicsPSO = false; }
+
+		virtual bool InitFromCachedBlob(GRAPHICS_PSO_DESC& InPipelineStateDesc, const std::vector<uint8_t>& InCachedBlob) override
+		{
+			m_IsGraphicsPSO = InCachedBlob == GetCachedBlob();
+			return m_IsGraphicsPSO;
+		}
+
+		virtual std::vector<uint8_t> GetCachedBlob() const override { return { 'M', 'O', 'C', 'K' }; }
+
+		virtual const void* GetResourceBinderHandle() const override { return this; }
+	};
+
+	struct MockVertexBufferView : public Mox::VertexBufferView
+	{
+		MockVertexBufferView(Mox::BufferResource& InVB) : VertexBufferView(InVB) { }
+
+		virtual void ReferenceResource(Mox::BufferResource& InVB) override {}
+	};
+
+	struct MockIndexBufferView : public Mox::IndexBufferView
+	{
+		MockIndexBufferView(Mox::BufferResource& InIB, Mox::BUFFER_FORMAT InFormat, uint32_t InElementsNum) : IndexBufferView(InIB, InFormat, InElementsNum) { }
+
+		virtual void ReferenceResource(Mox::BufferResource& InIB, Mox::BUFFER_FORMAT InFormat, uint32_t InElementsNum) override {}
+	};
+
+	// Views of static buffers count as Gpu allocated, the ones of dynamic buffers need to be staged when drawing
+	struct MockConstantBufferView : public Mox::ConstantBufferView
+	{
+		MockConstantBufferView(Mox::BufferResource* InBuffer) { m_ReferencedBuffer = InBuffer; }
+
+		virtual void ReferenceBuffer(Mox::BufferResource& InBuffer) override { m_ReferencedBuffer = &InBuffer; }
+
+		virtual bool IsGpuAllocated() override { return !m_ReferencedBuffer || m_ReferencedBuffer->GetType() == Mox::BUFFER_ALLOC_TYPE::STATIC; }
+
+		virtual void RebuildResourceReference() override {}
+
+		// Null views are shared by every allocator, created by the first one
+		static void CreateNullView();
+	};
+
+	struct MockShaderResourceView : public Mox::ShaderResourceView
+	{
+		// Views get consecutive heap indices in creation order
+		MockShaderResourceView() : m_HeapIndex(m_CreatedViewsNum++) {}
+
+		virtual void InitAsTex2DOrCubemap(Mox::TextureResource& InTexture) override {}
+
+		virtual uint32_t GetHeapIndex() override { return m_HeapIndex; }
+
+		virtual bool IsGpuAllocated() override { return true; }
+
+		virtual void RebuildResourceReference() override {}
+
+		static void CreateNullViews();
+
+	private:
+		uint32_t m_HeapIndex;
+
+		static uint32_t m_CreatedViewsNum;
+	};
+
+	/*
+	* Graphics allocator giving Cpu memory to buffers and views that only hold their references, so that render passes
+	* can build and send draw commands without a graphics API. Pipeline states are not stored on disk.
+	* Allocations that need a platform (windows, queues, textures) are not supported and stop the test, except for transient textures.
+	*/
+	class MockGraphicsAllocator : public Mox::GraphicsAllocatorBase
+	{
+	public:
+		MockGraphicsAllocator();
+
+		// Gives a resource to every buffer created since the last call, which the renderer would do at the start of the next frame.
+		// The content of the buffers is dropped, since nothing reads it.
+		void AllocatePendingBufferResources();
+
+		// Number of pipeline states that were created, either directly or through the pipeline state cache
+		size_t GetPipelineStatesNum() const { return m_PipelineStates.size(); }
+
+		// Memory given by the last AllocateFrameData call, e.g. the instance data of the last recorded pass
+		const std::vector<std::byte>& GetLastFrameData() const { return m_FrameData.back(); }
+
+		virtual void Initialize(Mox::CommandList& InCmdList) override {}
+		virtual void OnNewFrameStarted() override {}
+		virtual void OnNewFrameEnded() override {}
+		virtual void UpdateStaticBufferResources(Mox::CommandList& InCmdList, const std::vector<Mox::BufferResourceUpdate>& InUpdates) override {}
+		virtual void SetUploadQueue(Mox::CommandQueue& InUploadQueue) override {}
+		virtual Mox::TransientResourceAllocator& GetTransientResourceAllocator() override { return m_TransientResourceAllocator; }
+		virtual void OnUploadSubmitted(uint64_t InFenceValue) override {}
+		virtual void RetireUploads(uint64_t InCompletedFenceValue) override {}
+		virtual void OnFrameSubmitted(uint64_t InFenceValue) override {}
+		virtual void ReclaimReleasedObjects(uint64_t InCompletedFenceValue) override {}
+		// Proxies and drawables are kept until the allocator is destroyed
+		virtual void ReleaseRenderProxies(const std::vector<std::shared_ptr<Mox::RenderProxy>>& InProxies) override {}
+		virtual void ReleaseBuffers(std::vector<std::unique_ptr<Mox::ConstantBuffer>>&& InBuffers) override;
+		virtual Mox::VertexBuffer& AllocateVertexBuffer(const Mox::INPUT_LAYOUT_DESC& InLayoutDesc, const void* InData, uint32_t InStride, uint32_t InSize) override;
+		virtual Mox::IndexBuffer& AllocateIndexBuffer(const void* InData, uint32_t InStride, uint32_t InSize) override;
+		virtual Mox::BufferResource& AllocateDynamicBuffer(uint32_t InSize) override;
+		virtual void AllocateFrameData(uint32_t InSize, void*& OutCpuPtr, Mox::GPU_V_ADDRESS& OutGpuPtr) override;
+		virtual void AllocateResourceForTexture(const Mox::TextureResourceRequest& InTexDesc) override { StopForUnsupportedCall("AllocateResourceForTexture"); }
+		virtual void UpdateTextureResources(Mox::CommandList& InCmdList, const std::vector<Mox::TextureResourceUpdate>& InTextureUpdates) override { StopForUnsupportedCall("UpdateTextureResources"); }
+		virtual std::vector<RenderProxy*> RegisterProxies(const std::vector<Mox::RenderProxyRequest>& InRequests) override;
+		virtual void AllocateResourceForBuffer(const Mox::BufferResourceRequest& InResourceRequest) override;
+		virtual Mox::VertexBufferView& AllocateVertexBufferView(Mox::BufferResource& InVBResource) override;
+		virtual Mox::IndexBufferView& AllocateIndexBufferView(Mox::BufferResource& InIB, Mox::BUFFER_FORMAT InFormat, uint32_t InElementsNum) override;
+		virtual Mox::ConstantBufferView& AllocateConstantBufferView(Mox::BufferResource& InResource) override;
+		virtual Mox::ShaderResourceView& AllocateShaderResourceView(Mox::TextureResource& InTexture) override { StopForUnsupportedCall("AllocateShaderResourceView"); }
+		virtual Mox::ShaderResourceView& AllocateSrvTex2DArray(Mox::TextureResource& InTexture, uint32_t InArraySize, uint32_t InMostDetailedMip = 0, int32_t InMipLevels = -1, uint32_t InFirstArraySlice = 0, uint32_t InPlaceSlice = 0) override { StopForUnsupportedCall("AllocateSrvTex2DArray"); }
+		virtual Mox::UnorderedAccessView& AllocateUavTex2DArray(Mox::TextureResource& InTexture, uint32_t InArraySize, int32_t InMipSlice = -1, uint32_t InFirstArraySlice = 0, uint32_t InPlaceSlice = 0) override { StopForUnsupportedCall("AllocateUavTex2DArray"); }
+		virtual Mox::Shader& AllocateShader(wchar_t const* InShaderPath) override;
+		virtual Mox::PipelineState& AllocatePipelineState() override;
+		virtual Mox::Window& AllocateWindow(Mox::WindowInitInput& InWindowInitInput) override { StopForUnsupportedCall("AllocateWindow"); }
+		virtual Mox::CommandQueue& AllocateCommandQueue(class Device& InDevice, COMMAND_LIST_TYPE InCmdListType) override { StopForUnsupportedCall("AllocateCommandQueue"); }
+		virtual void CreateDrawables(const std::vector<Mox::DrawableCreationInfo>& InRequests) override;
+		virtual std::vector<RenderProxy*> CreateSpawnBatch(const Mox::SpawnBatchRequest& InSpawnBatch) override { StopForUnsupportedCall("CreateSpawnBatch"); }
+
+	private:
+		[[noreturn]] static void StopForUnsupportedCall(const char* InCallName);
+
+		// Memory behind every buffer, Gpu addresses are only handed out in increasing order and never dereferenced
+		Mox::MockResource m_BufferMemory;
+		Mox::GPU_V_ADDRESS m_NextGpuAddress = 0x10000;
+
+		Mox::MockTransientResourceAllocator m_TransientResourceAllocator;
+
+		std::deque<Mox::VertexBuffer> m_VertexBuffers;
+		std::deque<Mox::IndexBuffer> m_IndexBuffers;
+		std::vector<std::unique_ptr<Mox::ConstantBuffer>> m_ReleasedBuffers;
+		std::deque<std::unique_ptr<Mox::BufferResource>> m_BufferResources;
+		std::deque<std::vector<std::byte>> m_FrameData;
+
+		std::deque<Mox::MockVertexBufferView> m_VertexBufferViews;
+		std::deque<Mox::MockIndexBufferView> m_IndexBufferViews;
+		std::deque<Mox::MockConstantBufferView> m_ConstantBufferViews;
+
+		std::deque<Mox::MockShader> m_Shaders;
+		std::deque<Mox::MockPipelineState> m_PipelineStates;
+
+		std::vector<std::shared_ptr<Mox::RenderProxy>> m_RenderProxies;
+		std::vector<std::unique_ptr<Mox::Drawable>> m_Drawables;
+	};
+
+}
+
+#endif // MockGraphics_h__
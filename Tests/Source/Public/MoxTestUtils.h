@@ -0,0 +1,45 @@
+/*
+ MoxTestUtils.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef MoxTestUtils_h__
+#define MoxTestUtils_h__
+
+#include <iostream>
+
+namespace Mox {
+
+	// Number of failed TestCheck since the start of the test executable
+	inline int& GetTestFailuresNum()
+	{
+		static int failuresNum = 0;
+		return failuresNum;
+	}
+
+	// Runs a test case and reports whether it passed, tests go on after a failure to report all of them at once
+	template <typename FuncType>
+	void RunTestCase(const char* InCaseName, FuncType&& InCaseFunc)
+	{
+		const int failuresNumBefore = GetTestFailuresNum();
+
+		InCaseFunc();
+
+		std::cout << (GetTestFailuresNum() == failuresNumBefore ? "[PASSED] " : "[FAILED] ") << InCaseName << std::endl;
+	}
+
+	// Value to return from the main function of a test executable, so that ctest sees the failures
+	inline int GetTestExitCode()
+	{
+		return GetTestFailuresNum() == 0 ? 0 : 1;
+	}
+
+// Unlike Check, it is evaluated in every configuration and it does not stop the execution
+#define TestCheck(X) if(!(X)) { Mox::GetTestFailuresNum()++; std::cout << "  Check failed: " << #X << " (" << __FILE__ << ":" << __LINE__ << ")" << std::endl; }
+
+}
+
+#endif // MoxTestUtils_h__
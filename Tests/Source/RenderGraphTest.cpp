@@ -0,0 +1,226 @@
+/*
+ RenderGraphTest.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include "MoxTestUtils.h"
+#include "MockGraphics.h"
+#include "RenderGraph.h"
+
+// Compiles render graphs and executes them on a recording command list, checking the order of the passes,
+// the transitions recorded around them and the memory shared by transient textures.
+
+namespace
+{
+	constexpr Mox::RgTextureDesc ColorDesc{ 256, 256, Mox::BUFFER_FORMAT::R8G8B8A8_UNORM, Mox::RESOURCE_FLAGS::ALLOW_RENDER_TARGET };
+	constexpr Mox::RgTextureDesc OtherColorDesc{ 256, 256, Mox::BUFFER_FORMAT::B8G8R8A8_UNORM, Mox::RESOURCE_FLAGS::ALLOW_RENDER_TARGET };
+
+	struct GraphTestContext
+	{
+		Mox::MockDevice m_Device;
+		Mox::MockCommandList m_CmdList{ m_Device };
+		Mox::MockTransientResourceAllocator m_Allocator;
+
+		Mox::MockResource m_BackBuffer{ 1, Mox::RESOURCE_STATE::PRESENT };
+		Mox::MockResource m_DepthBuffer{ 1, Mox::RESOURCE_STATE::DEPTH_WRITE };
+
+		Mox::RenderGraph m_Graph;
+
+		// Names of the passes, in the order they were executed
+		std::vector<std::string> m_ExecutedPasses;
+
+		// Flushing transitions stands for the first command of the pass
+		Mox::RenderGraph::PassExecuteFunction MakePass(const char* InName)
+		{
+			return [this, InName](Mox::CommandList& InCmdList)
+			{
+				InCmdList.FlushResourceBarriers();
+				m_ExecutedPasses.push_back(InName);
+			};
+		}
+
+		void CompileAndExecute()
+		{
+			m_Graph.Compile(m_Allocator);
+			m_Graph.Execute(m_CmdList, m_Allocator);
+		}
+	};
+
+	bool IsTransitionRecorded(const Mox::MockCall& InCall, const Mox::Resource& InResource, Mox::RESOURCE_STATE InBefore, Mox::RESOURCE_STATE InAfter)
+	{
+		return std::any_of(InCall.m_Transitions.begin(), InCall.m_Transitions.end(), [&](const Mox::ResourceTransition& InTransition)
+			{
+				return InTransition.m_Resource == &InResource && InTransition.m_Before == InBefore && InTransition.m_After == InAfter;
+			});
+	}
+
+	void TestPassesOrderedByAccesses()
+	{
+		GraphTestContext context;
+
+		const Mox::RgResourceHandle backBuffer = context.m_Graph.ImportResource("BackBuffer", context.m_BackBuffer, Mox::RESOURCE_STATE::PRESENT, Mox::RESOURCE_STATE::PRESENT);
+		const Mox::RgResourceHandle sceneColor = context.m_Graph.CreateTexture("SceneColor", ColorDesc);
+		const Mox::RgResourceHandle unusedColor = context.m_Graph.CreateTexture("UnusedColor", ColorDesc);
+
+		// The pass reading the scene color is added before the one writing it
+		context.m_Graph.AddPass("Compose", { {sceneColor, Mox::RESOURCE_STATE::GEN_READ} }, { {backBuffer, Mox::RESOURCE_STATE::RENDER_TARGET} }, context.MakePass("Compose"));
+		context.m_Graph.AddPass("Scene", {}, { {sceneColor, Mox::RESOURCE_STATE::RENDER_TARGET} }, context.MakePass("Scene"));
+		context.m_Graph.AddPass("Unused", {}, { {unusedColor, Mox::RESOURCE_STATE::RENDER_TARGET} }, context.MakePass("Unused"));
+
+		context.CompileAndExecute();
+
+		TestCheck(context.m_Graph.GetExecutionOrder() == std::vector<uint32_t>({ 1, 0, 2 }))
+
+		// Nothing reads what the last pass writes
+		TestCheck(!context.m_Graph.IsPassCulled(0) && !context.m_Graph.IsPassCulled(1) && context.m_Graph.IsPassCulled(2))
+
+		TestCheck(context.m_ExecutedPasses == std::vector<std::string>({ "Scene", "Compose" }))
+	}
+
+	void TestWritersKeepTheirOrder()
+	{
+		GraphTestContext context;
+
+		const Mox::RgResourceHandle backBuffer = context.m_Graph.ImportResource("BackBuffer", context.m_BackBuffer, Mox::RESOURCE_STATE::PRESENT, Mox::RESOURCE_STATE::PRESENT);
+		const Mox::RgResourceHandle depthBuffer = context.m_Graph.ImportResource("DepthBuffer", context.m_DepthBuffer, Mox::RESOURCE_STATE::DEPTH_WRITE, Mox::RESOURCE_STATE::DEPTH_WRITE);
+
+		// As declared by the renderer: the targets are cleared first, then the registered passes draw on them
+		context.m_Graph.AddPass("Clear", {}, { {backBuffer, Mox::RESOURCE_STATE::RENDER_TARGET}, {depthBuffer, Mox::RESOURCE_STATE::DEPTH_WRITE} }, context.MakePass("Clear"));
+		context.m_Graph.AddPass("Opaque", {}, { {backBuffer, Mox::RESOURCE_STATE::RENDER_TARGET}, {depthBuffer, Mox::RESOURCE_STATE::DEPTH_WRITE} }, context.MakePass("Opaque"));
+		context.m_Graph.AddPass("Translucent", { {depthBuffer, Mox::RESOURCE_STATE::GEN_READ} }, { {backBuffer, Mox::RESOURCE_STATE::RENDER_TARGET} }, context.MakePass("Translucent"));
+
+		context.CompileAndExecute();
+
+		TestCheck(context.m_ExecutedPasses == std::vector<std::string>({ "Clear", "Opaque", "Translucent" }))
+	}
+
+	void TestTransitionsAroundPasses()
+	{
+		GraphTestContext context;
+
+		const Mox::RgResourceHandle backBuffer = context.m_Graph.ImportResource("BackBuffer", context.m_BackBuffer, Mox::RESOURCE_STATE::PRESENT, Mox::RESOURCE_STATE::PRESENT);
+		const Mox::RgResourceHandle depthBuffer = context.m_Graph.ImportResource("DepthBuffer", context.m_DepthBuffer, Mox::RESOURCE_STATE::DEPTH_WRITE, Mox::RESOURCE_STATE::DEPTH_WRITE);
+
+		context.m_Graph.AddPass("Opaque", {}, { {backBuffer, Mox::RESOURCE_STATE::RENDER_TARGET}, {depthBuffer, Mox::RESOURCE_STATE::DEPTH_WRITE} }, context.MakePass("Opaque"));
+		context.m_Graph.AddPass("Fog", { {depthBuffer, Mox::RESOURCE_STATE::GEN_READ} }, { {backBuffer, Mox::RESOURCE_STATE::RENDER_TARGET} }, context.MakePass("Fog"));
+
+		context.CompileAndExecute();
+
+		// Compiled transitions: the depth buffer is already in depth write state, and stays in render target state between the passes
+		TestCheck(context.m_Graph.GetPassTransitions(0).size() == 1 && context.m_Graph.GetPassTransitions(0)[0].m_Resource == backBuffer)
+		TestCheck(context.m_Graph.GetPassTransitions(1).size() == 1 && context.m_Graph.GetPassTransitions(1)[0].m_Resource == depthBuffer)
+		TestCheck(context.m_Graph.GetFinalTransitions().size() == 2)
+
+		// Recorded transitions: one batch before each pass and one at the end
+		const std::vector<Mox::MockCall>& recordedCalls = context.m_CmdList.GetRecordedCalls();
+		TestCheck(recordedCalls.size() == 3 && context.m_CmdList.GetCallsNum(Mox::MOCK_CALL::RESOURCE_BARRIERS) == 3)
+		if (recordedCalls.size() == 3)
+		{
+			TestCheck(recordedCalls[0].m_Transitions.size() == 1 && IsTransitionRecorded(recordedCalls[0], context.m_BackBuffer, Mox::RESOURCE_STATE::PRESENT, Mox::RESOURCE_STATE::RENDER_TARGET))
+			TestCheck(recordedCalls[1].m_Transitions.size() == 1 && IsTransitionRecorded(recordedCalls[1], context.m_DepthBuffer, Mox::RESOURCE_STATE::DEPTH_WRITE, Mox::RESOURCE_STATE::GEN_READ))
+			TestCheck(recordedCalls[2].m_Transitions.size() == 2
+				&& IsTransitionRecorded(recordedCalls[2], context.m_BackBuffer, Mox::RESOURCE_STATE::RENDER_TARGET, Mox::RESOURCE_STATE::PRESENT)
+				&& IsTransitionRecorded(recordedCalls[2], context.m_DepthBuffer, Mox::RESOURCE_STATE::GEN_READ, Mox::RESOURCE_STATE::DEPTH_WRITE))
+		}
+
+		TestCheck(context.m_BackBuffer.GetTrackedState() == Mox::RESOURCE_STATE::PRESENT && context.m_DepthBuffer.GetTrackedState() == Mox::RESOURCE_STATE::DEPTH_WRITE)
+	}
+
+	// Chain of transient textures, each one read by the pass writing the next, so that only consecutive ones are alive at the same time
+	void DeclareTransientChain(GraphTestContext& InOutContext, Mox::RgResourceHandle& OutFirst, Mox::RgResourceHandle& OutSecond, Mox::RgResourceHandle& OutThird)
+	{
+		const Mox::RgResourceHandle backBuffer = InOutContext.m_Graph.ImportResource("BackBuffer", InOutContext.m_BackBuffer, Mox::RESOURCE_STATE::PRESENT, Mox::RESOURCE_STATE::PRESENT);
+
+		OutFirst = InOutContext.m_Graph.CreateTexture("First", ColorDesc);
+		OutSecond = InOutContext.m_Graph.CreateTexture("Second", ColorDesc);
+		OutThird = InOutContext.m_Graph.CreateTexture("Third", OtherColorDesc);
+
+		InOutContext.m_Graph.AddPass("WriteFirst", {}, { {OutFirst, Mox::RESOURCE_STATE::RENDER_TARGET} }, InOutContext.MakePass("WriteFirst"));
+		InOutContext.m_Graph.AddPass("WriteSecond", { {OutFirst, Mox::RESOURCE_STATE::GEN_READ} }, { {OutSecond, Mox::RESOURCE_STATE::RENDER_TARGET} }, InOutContext.MakePass("WriteSecond"));
+		InOutContext.m_Graph.AddPass("WriteThird", { {OutSecond, Mox::RESOURCE_STATE::GEN_READ} }, { {OutThird, Mox::RESOURCE_STATE::RENDER_TARGET} }, InOutContext.MakePass("WriteThird"));
+		InOutContext.m_Graph.AddPass("Present", { {OutThird, Mox::RESOURCE_STATE::GEN_READ} }, { {backBuffer, Mox::RESOURCE_STATE::RENDER_TARGET} }, InOutContext.MakePass("Present"));
+	}
+
+	void TestTransientTexturesAliased()
+	{
+		GraphTestContext context;
+
+		Mox::RgResourceHandle firstTexture, secondTexture, thirdTexture;
+		DeclareTransientChain(context, firstTexture, secondTexture, thirdTexture);
+
+		context.CompileAndExecute();
+
+		uint64_t textureSize, textureAlignment;
+		context.m_Allocator.GetTextureAllocationInfo(ColorDesc, textureSize, textureAlignment);
+
+		// The first and third textures are never alive at the same time, so they share memory
+		TestCheck(context.m_Graph.GetTransientHeapOffset(firstTexture) == context.m_Graph.GetTransientHeapOffset(thirdTexture))
+		TestCheck(context.m_Graph.GetTransientHeapOffset(firstTexture) != context.m_Graph.GetTransientHeapOffset(secondTexture))
+		TestCheck(context.m_Graph.GetTransientMemorySize() == 2 * textureSize)
+		TestCheck(context.m_Graph.GetTransientMemorySizeWithoutAliasing() == 3 * textureSize)
+		TestCheck(context.m_Allocator.GetHeapSize() == 2 * textureSize)
+
+		// Each texture is acquired before its first pass with an aliasing barrier, followed by a discard of the same texture
+		const std::vector<Mox::MockCall>& recordedCalls = context.m_CmdList.GetRecordedCalls();
+		TestCheck(context.m_CmdList.GetCallsNum(Mox::MOCK_CALL::ALIASING_BARRIERS) == 3 && context.m_CmdList.GetCallsNum(Mox::MOCK_CALL::DISCARD_RESOURCES) == 3)
+
+		std::vector<Mox::Resource*> acquiredTextures;
+		for (size_t callIdx = 0; callIdx < recordedCalls.size(); ++callIdx)
+		{
+			if (recordedCalls[callIdx].m_Type != Mox::MOCK_CALL::ALIASING_BARRIERS)
+			{
+				continue;
+			}
+
+			// Textures are created in the state of their first access, which allows discarding them without transitions in between
+			TestCheck(callIdx + 1 < recordedCalls.size() && recordedCalls[callIdx + 1].m_Type == Mox::MOCK_CALL::DISCARD_RESOURCES
+				&& recordedCalls[callIdx + 1].m_Resources == recordedCalls[callIdx].m_Resources)
+
+			acquiredTextures.insert(acquiredTextures.end(), recordedCalls[callIdx].m_Resources.begin(), recordedCalls[callIdx].m_Resources.end());
+		}
+
+		TestCheck(acquiredTextures == std::vector<Mox::Resource*>({ &context.m_Graph.GetResource(firstTexture), &context.m_Graph.GetResource(secondTexture), &context.m_Graph.GetResource(thirdTexture) }))
+
+		TestCheck(context.m_ExecutedPasses == std::vector<std::string>({ "WriteFirst", "WriteSecond", "WriteThird", "Present" }))
+	}
+
+	void TestTransientTexturesReusedAcrossFrames()
+	{
+		GraphTestContext context;
+
+		Mox::RgResourceHandle firstTexture, secondTexture, thirdTexture;
+		for (uint32_t frameIdx = 0; frameIdx < 3; ++frameIdx)
+		{
+			context.m_Graph.Reset();
+			DeclareTransientChain(context, firstTexture, secondTexture, thirdTexture);
+
+			context.CompileAndExecute();
+		}
+
+		TestCheck(context.m_Allocator.GetCreatedTexturesNum() == 3)
+
+		// The first texture of a frame takes its memory back from the third texture of the previous frame, starting again from a discard
+		TestCheck(context.m_CmdList.GetCallsNum(Mox::MOCK_CALL::ALIASING_BARRIERS) == 9 && context.m_CmdList.GetCallsNum(Mox::MOCK_CALL::DISCARD_RESOURCES) == 9)
+	}
+}
+
+int main()
+{
+	Mox::RunTestCase("Passes run after the passes writing what they read", TestPassesOrderedByAccesses);
+
+	Mox::RunTestCase("Passes writing the same resource keep their order", TestWritersKeepTheirOrder);
+
+	Mox::RunTestCase("Transitions are recorded in a batch before each pass", TestTransitionsAroundPasses);
+
+	Mox::RunTestCase("Transient textures with disjoint lifetimes share memory", TestTransientTexturesAliased);
+
+	Mox::RunTestCase("Transient textures are kept across frames", TestTransientTexturesReusedAcrossFrames);
+
+	return Mox::GetTestExitCode();
+}
@@ -0,0 +1,140 @@
+/*
+ StaticMemoryChurnTest.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <random>
+#include <algorithm>
+#include "MoxTestUtils.h"
+#include "RangeAllocators.h"
+#include "DeferredReleaseQueue.h"
+
+// Spawning and destroying entities allocates and frees static buffer ranges in any order.
+// Freed ranges have to merge back with their neighbours, otherwise the pool fragments until nothing fits anymore.
+
+namespace
+{
+	constexpr uint32_t PoolSize = 65536;
+
+	struct AllocatedRange
+	{
+		uint32_t m_Offset;
+		uint32_t m_Size;
+	};
+
+	void TestFreedRangesMerge()
+	{
+		Mox::StaticRangeAllocator rangeAllocator(0, PoolSize);
+
+		const uint32_t first = static_cast<uint32_t>(rangeAllocator.AllocateRange(256));
+		const uint32_t second = static_cast<uint32_t>(rangeAllocator.AllocateRange(256));
+		const uint32_t third = static_cast<uint32_t>(rangeAllocator.AllocateRange(256));
+		TestCheck(first == 0 && second == 256 && third == 512)
+
+		// Freeing the first and then the second range merges them with each other, and the third with what follows
+		rangeAllocator.FreeAllocatedRange(first, 256);
+		rangeAllocator.FreeAllocatedRange(second, 256);
+		TestCheck(rangeAllocator.AllocateRange(512) == 0)
+
+		rangeAllocator.FreeAllocatedRange(0, 512);
+		rangeAllocator.FreeAllocatedRange(third, 256);
+		TestCheck(rangeAllocator.GetLargestFreeRangeSize() == PoolSize)
+	}
+
+	void TestChurnStaysBounded()
+	{
+		Mox::StaticRangeAllocator rangeAllocator(0, PoolSize);
+
+		std::mt19937 randomGenerator(7);
+		std::uniform_int_distribution<uint32_t> sizeDistribution(1, 4);
+
+		std::vector<AllocatedRange> liveRanges;
+
+		// Many more allocations than the pool could ever hold at once, with at most half of the pool alive at any time
+		int completedFramesNum = 0;
+		for (; completedFramesNum < 2000; ++completedFramesNum)
+		{
+			const uint32_t rangeSize = sizeDistribution(randomGenerator) * 256;
+			if (rangeAllocator.GetLargestFreeRangeSize() < rangeSize)
+			{
+				break;
+			}
+			liveRanges.push_back({ static_cast<uint32_t>(rangeAllocator.AllocateRange(rangeSize)), rangeSize });
+
+			if (liveRanges.size() > 32)
+			{
+				// Destroy a random one
+				const size_t releasedIdx = randomGenerator() % liveRanges.size();
+				rangeAllocator.FreeAllocatedRange(liveRanges[releasedIdx].m_Offset, liveRanges[releasedIdx].m_Size);
+				liveRanges.erase(liveRanges.begin() + releasedIdx);
+			}
+		}
+
+		// Live ranges never overlap
+		std::sort(liveRanges.begin(), liveRanges.end(), [](const AllocatedRange& InLeft, const AllocatedRange& InRight) { return InLeft.m_Offset < InRight.m_Offset; });
+		for (size_t rangeIdx = 1; rangeIdx < liveRanges.size(); ++rangeIdx)
+		{
+			TestCheck(liveRanges[rangeIdx - 1].m_Offset + liveRanges[rangeIdx - 1].m_Size <= liveRanges[rangeIdx].m_Offset)
+		}
+
+		TestCheck(completedFramesNum == 2000)
+
+		// Once everything is destroyed, the whole pool is a single free range again
+		for (const AllocatedRange& liveRange : liveRanges)
+		{
+			rangeAllocator.FreeAllocatedRange(liveRange.m_Offset, liveRange.m_Size);
+		}
+		TestCheck(rangeAllocator.GetLargestFreeRangeSize() == PoolSize)
+	}
+
+	void TestRangesComeBackAfterTheirFence()
+	{
+		Mox::StaticRangeAllocator rangeAllocator(0, PoolSize);
+		Mox::DeferredReleaseQueue releaseQueue;
+
+		// Same scheme as the static buffer allocator: the range goes back to the pool when the release queue destroys its owner
+		struct RangeRelease
+		{
+			RangeRelease(Mox::StaticRangeAllocator& InRangeAllocator, uint32_t InRangeOffset, uint32_t InRangeSize)
+				: m_RangeAllocator(InRangeAllocator), m_RangeOffset(InRangeOffset), m_RangeSize(InRangeSize) { }
+
+			~RangeRelease() { m_RangeAllocator.FreeAllocatedRange(m_RangeOffset, m_RangeSize); }
+
+			Mox::StaticRangeAllocator& m_RangeAllocator;
+			uint32_t m_RangeOffset;
+			uint32_t m_RangeSize;
+		};
+
+		const uint32_t releasedOffset = static_cast<uint32_t>(rangeAllocator.AllocateRange(PoolSize / 2));
+		rangeAllocator.AllocateRange(PoolSize / 2);
+
+		releaseQueue.Enqueue(std::make_shared<RangeRelease>(rangeAllocator, releasedOffset, PoolSize / 2));
+		releaseQueue.CloseBatch(5);
+
+		// The frame that could still read the buffer is in flight
+		releaseQueue.Reclaim(4);
+		TestCheck(rangeAllocator.GetLargestFreeRangeSize() == 0)
+
+		releaseQueue.Reclaim(5);
+		TestCheck(rangeAllocator.GetLargestFreeRangeSize() == PoolSize / 2)
+		TestCheck(releaseQueue.GetPendingObjectsNum() == 0)
+	}
+}
+
+int main()
+{
+	Mox::RunTestCase("Freed static ranges merge with their neighbours", TestFreedRangesMerge);
+
+	Mox::RunTestCase("Static memory stays bounded under allocation churn", TestChurnStaysBounded);
+
+	Mox::RunTestCase("Released ranges come back after their fence", TestRangesComeBackAfterTheirFence);
+
+	return Mox::GetTestExitCode();
+}
@@ -0,0 +1,83 @@
+/*
+ TaskSystemTest.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <set>
+#include "MoxTestUtils.h"
+#include "TaskSystem.h"
+
+// Parallel loops run on the worker threads of the engine task system, and have to complete every index exactly once
+// also when a loop is started from inside another one.
+
+namespace
+{
+	void TestEveryIndexRunsOnce()
+	{
+		constexpr size_t ItemsNum = 1000;
+		std::vector<std::atomic<uint32_t>> runsNum(ItemsNum);
+
+		Mox::ParallelFor(ItemsNum, [&runsNum](size_t InIndex) { runsNum[InIndex]++; });
+
+		bool isEveryIndexRunOnce = true;
+		for (const std::atomic<uint32_t>& indexRunsNum : runsNum)
+		{
+			isEveryIndexRunOnce &= indexRunsNum.load() == 1;
+		}
+		TestCheck(isEveryIndexRunOnce)
+	}
+
+	void TestWorkersAreReused()
+	{
+		std::mutex threadIdsMutex;
+		std::set<std::thread::id> threadIds;
+
+		// Loops run one after the other, with items slow enough to be spread over the workers
+		for (uint32_t loopIdx = 0; loopIdx < 20; ++loopIdx)
+		{
+			Mox::ParallelFor(16, [&threadIdsMutex, &threadIds](size_t InIndex)
+				{
+					std::this_thread::sleep_for(std::chrono::microseconds(200));
+
+					std::lock_guard<std::mutex> threadIdsLock(threadIdsMutex);
+					threadIds.insert(std::this_thread::get_id());
+				});
+		}
+
+		// No new threads are created per loop: only the workers and the calling thread ran items
+		TestCheck(threadIds.size() <= Mox::EngineTaskSystem::Get().GetWorkerThreadsNum() + 1)
+	}
+
+	void TestNestedLoopsComplete()
+	{
+		constexpr size_t OuterItemsNum = 32;
+		constexpr size_t InnerItemsNum = 64;
+		std::atomic<uint32_t> innerRunsNum{ 0 };
+
+		// Every worker can end up waiting for an inner loop, which only completes because waiting threads run queued tasks
+		Mox::ParallelFor(OuterItemsNum, [&innerRunsNum](size_t InOuterIndex)
+			{
+				Mox::ParallelFor(InnerItemsNum, [&innerRunsNum](size_t InInnerIndex) { innerRunsNum++; });
+			});
+
+		TestCheck(innerRunsNum.load() == OuterItemsNum * InnerItemsNum)
+	}
+}
+
+int main()
+{
+	Mox::RunTestCase("Parallel loop runs every index once", TestEveryIndexRunsOnce);
+
+	Mox::RunTestCase("Parallel loops reuse the task system workers", TestWorkersAreReused);
+
+	Mox::RunTestCase("Nested parallel loops complete", TestNestedLoopsComplete);
+
+	return Mox::GetTestExitCode();
+}
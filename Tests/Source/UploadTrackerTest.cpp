@@ -0,0 +1,182 @@
+/*
+ UploadTrackerTest.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <tuple>
+#include <unordered_set>
+#include <algorithm>
+#include "MoxTestUtils.h"
+#include "MockGraphics.h"
+#include "MoxRenderProxy.h"
+#include "RangeAllocators.h"
+#include "UploadTracker.h"
+
+// Drives staging memory, upload tracking and copy queue state tracking with a simulated queue,
+// where the test decides when the Gpu completes each submission.
+
+namespace
+{
+	void TestRingAllocatorRetire()
+	{
+		Mox::FencedRingAllocator ringAllocator(1024);
+
+		size_t firstOffset = 0, secondOffset = 0, thirdOffset = 0;
+		TestCheck(ringAllocator.TryAllocateRange(512, 256, firstOffset))
+		ringAllocator.CloseBatch(1);
+
+		TestCheck(ringAllocator.TryAllocateRange(300, 256, secondOffset))
+		ringAllocator.CloseBatch(2);
+		TestCheck(firstOffset == 0 && secondOffset == 512)
+
+		// Memory of both batches is still in flight
+		TestCheck(!ringAllocator.TryAllocateRange(300, 256, thirdOffset))
+		TestCheck(ringAllocator.GetOldestPendingFenceValue() == 1)
+
+		// Retiring the first batch lets the allocation wrap around to the start of the ring
+		ringAllocator.Retire(1);
+		TestCheck(ringAllocator.TryAllocateRange(300, 256, thirdOffset))
+		TestCheck(thirdOffset == 0)
+		ringAllocator.CloseBatch(3);
+
+		// A completed fence value retires every batch up to it, and memory goes back to unused
+		ringAllocator.Retire(3);
+		TestCheck(!ringAllocator.HasPendingBatches())
+		TestCheck(ringAllocator.GetUsedSize() == 0)
+	}
+
+	void TestStagingWaitsForOldestUpload()
+	{
+		Mox::MockDevice device;
+		Mox::MockCommandQueue uploadQueue(device, true);
+		Mox::FencedRingAllocator ringAllocator(1024);
+
+		// Three uploads in flight, each one taking a third of the ring
+		for (int uploadIdx = 0; uploadIdx < 3; ++uploadIdx)
+		{
+			Mox::AllocateStagingRange(ringAllocator, uploadQueue, 320, 64);
+			ringAllocator.CloseBatch(uploadQueue.ExecuteCmdList(uploadQueue.GetAvailableCommandList()));
+		}
+		TestCheck(uploadQueue.GetCpuWaitsNum() == 0)
+
+		// The Gpu did not complete anything yet: only the oldest upload is waited for, not the whole queue
+		const size_t stagingOffset = Mox::AllocateStagingRange(ringAllocator, uploadQueue, 320, 64);
+		TestCheck(uploadQueue.GetCpuWaitsNum() == 1)
+		TestCheck(uploadQueue.GetCompletedFenceValue() == 1)
+		TestCheck(stagingOffset == 0)
+		TestCheck(ringAllocator.GetOldestPendingFenceValue() == 2)
+
+		// With the Gpu ahead, allocations do not wait at all
+		ringAllocator.CloseBatch(uploadQueue.ExecuteCmdList(uploadQueue.GetAvailableCommandList()));
+		uploadQueue.CompleteUpTo(uploadQueue.GetLastSignaledFenceValue());
+		ringAllocator.Retire(uploadQueue.GetCompletedFenceValue());
+
+		Mox::AllocateStagingRange(ringAllocator, uploadQueue, 900, 64);
+		TestCheck(uploadQueue.GetCpuWaitsNum() == 1)
+	}
+
+	void TestTrackerReleasesWorkInFenceOrder()
+	{
+		Mox::MockResource firstTexture, secondTexture;
+		Mox::RenderProxy firstProxy, secondProxy, releasedProxy;
+
+		Mox::UploadTracker uploadTracker;
+		TestCheck(!uploadTracker.DeferUntilUploadsComplete({ &firstProxy }))
+
+		uploadTracker.TrackUpload(1, { { &firstTexture, Mox::RESOURCE_STATE::COPY_DEST, Mox::RESOURCE_STATE::GEN_READ } });
+		TestCheck(uploadTracker.DeferUntilUploadsComplete({ &firstProxy }))
+
+		uploadTracker.TrackUpload(2, { { &secondTexture, Mox::RESOURCE_STATE::COPY_DEST, Mox::RESOURCE_STATE::GEN_READ } });
+		TestCheck(uploadTracker.DeferUntilUploadsComplete({ &secondProxy, &releasedProxy }))
+
+		std::vector<Mox::RenderProxy*> readyProxies;
+		Mox::TransitionInfoVector readyTransitions;
+
+		// Nothing completed
+		uploadTracker.CollectCompleted(0, readyProxies, readyTransitions);
+		TestCheck(readyProxies.empty() && readyTransitions.empty())
+
+		uploadTracker.CollectCompleted(1, readyProxies, readyTransitions);
+		TestCheck(readyProxies.size() == 1 && readyProxies[0] == &firstProxy)
+		TestCheck(readyTransitions.size() == 1 && std::get<0>(readyTransitions[0]) == &firstTexture)
+
+		// A proxy released while its upload is in flight must never come back
+		uploadTracker.RemoveDependentProxies({ &releasedProxy });
+
+		readyProxies.clear();
+		readyTransitions.clear();
+		uploadTracker.CollectCompleted(2, readyProxies, readyTransitions);
+		TestCheck(readyProxies.size() == 1 && readyProxies[0] == &secondProxy)
+		TestCheck(readyTransitions.size() == 1 && std::get<0>(readyTransitions[0]) == &secondTexture)
+		TestCheck(!uploadTracker.HasPendingUploads())
+	}
+
+	void TestCopyQueueStates()
+	{
+		Mox::MockDevice device;
+		Mox::MockCommandQueue directQueue(device);
+		Mox::MockCommandQueue copyQueue(device, true);
+
+		// New textures start in copy state, buffers in neutral
+		Mox::MockResource texture(3, Mox::RESOURCE_STATE::COPY_DEST);
+		Mox::MockResource buffer;
+
+		Mox::MockCommandList& copyList = static_cast<Mox::MockCommandList&>(copyQueue.GetAvailableCommandList());
+		for (uint32_t subresourceIdx = 0; subresourceIdx < texture.GetSubresourcesNum(); ++subresourceIdx)
+		{
+			copyList.TransitionResource(texture, Mox::RESOURCE_STATE::COPY_DEST, subresourceIdx);
+		}
+		copyList.TransitionResource(buffer, Mox::RESOURCE_STATE::COPY_DEST);
+		copyList.TransitionResource(buffer, Mox::RESOURCE_STATE::GEN_READ);
+		const uint64_t uploadFenceValue = copyQueue.ExecuteCmdList(copyList);
+
+		// No barrier reaches a copy list, and resources are left in the state they decay to after copy queue work
+		TestCheck(copyList.GetCallsNum(Mox::MOCK_CALL::RESOURCE_BARRIERS) == 0)
+		TestCheck(texture.GetTrackedState(0) == Mox::RESOURCE_STATE::NEUTRAL)
+		TestCheck(buffer.GetTrackedState() == Mox::RESOURCE_STATE::NEUTRAL)
+
+		// Once the upload completed, the direct queue brings the texture to a read state starting from neutral
+		copyQueue.CompleteUpTo(uploadFenceValue);
+
+		Mox::MockCommandList& directList = static_cast<Mox::MockCommandList&>(directQueue.GetAvailableCommandList());
+		directList.TransitionResource(texture, Mox::RESOURCE_STATE::GEN_READ);
+		directList.DrawIndexed(3);
+
+		const std::vector<Mox::MockCall>& directCalls = directList.GetRecordedCalls();
+		TestCheck(directCalls.size() == 2 && directCalls[0].m_Type == Mox::MOCK_CALL::RESOURCE_BARRIERS)
+		if (directCalls.size() == 2)
+		{
+			const std::vector<Mox::ResourceTransition>& transitions = directCalls[0].m_Transitions;
+			TestCheck(!transitions.empty())
+			TestCheck(std::all_of(transitions.begin(), transitions.end(), [](const Mox::ResourceTransition& InTransition)
+				{ return InTransition.m_Before == Mox::RESOURCE_STATE::NEUTRAL && InTransition.m_After == Mox::RESOURCE_STATE::GEN_READ; }))
+		}
+
+		// A texture that draws are reading needs to be released on the direct queue before the copy queue can update it
+		Mox::MockCommandList& releaseList = static_cast<Mox::MockCommandList&>(directQueue.GetAvailableCommandList());
+		releaseList.TransitionResource(texture, Mox::RESOURCE_STATE::NEUTRAL);
+		copyQueue.GpuWaitForQueue(directQueue, directQueue.ExecuteCmdList(releaseList));
+
+		TestCheck(releaseList.GetCallsNum(Mox::MOCK_CALL::RESOURCE_BARRIERS) == 1)
+		TestCheck(texture.GetTrackedState() == Mox::RESOURCE_STATE::NEUTRAL)
+		TestCheck(copyQueue.GetGpuWaits().size() == 1 && std::get<1>(copyQueue.GetGpuWaits()[0]) == directQueue.GetLastSignaledFenceValue())
+	}
+}
+
+int main()
+{
+	Mox::RunTestCase("Ring allocator retires batches by fence value", TestRingAllocatorRetire);
+
+	Mox::RunTestCase("Staging allocation waits for the oldest upload only", TestStagingWaitsForOldestUpload);
+
+	Mox::RunTestCase("Upload tracker releases work in fence order", TestTrackerReleasesWorkInFenceOrder);
+
+	Mox::RunTestCase("Copy queue leaves resources in neutral state", TestCopyQueueStates);
+
+	return Mox::GetTestExitCode();
+}
@@ -6,10 +6,10 @@
  MIT License - Copyright (c) 2022 Riccardo Loggini
 */
 
-// To generate BasePass_PS.cso I will be using: fxc /Zi /T ps_5_1 /Fo BasePass_PS.cso BasePass_PS.hlsl
+// BasePass_PS.cso is generated by the build with: fxc /Zi /T ps_5_1 /Fo BasePass_PS.cso BasePass_PS.hlsl
 
 // Note: This shader shows a very basic implementation of multiple features
-// with the FeaturesFieldCB variable directing what features to use for the current draw.
+// with the FeaturesField of the instance directing what features to use for the current object.
 // It has to be stated through, that a more realistic implementation would see the
 // base pass generating shaders depending on its possibilities and requests
 // (e.g. a PSO that uses only the color modifier, another PSO with only the cubemap
@@ -30,30 +30,27 @@ struct PixelShaderInput
 {
     float3 PrimitiveColor : COLOR0;
     float3 TextureCoords : TEXCOORD0;
+    nointerpolation uint InstanceId : INSTANCEID0;
 };
 
-// Structs are required for ConstantBuffer type parameters..
-// Meanwhile, if I just try to define a base type with an associated register in space 1,
-// it just won't find it and somehow register a dependency to register c0 space 0, which we don't want.
-// So for this example, I will keep using ConstantBuffer variable type.
-struct UIntBuf
+// Per-object parameters, the same buffer read by the vertex shader. 
+// They are not bound for each draw, so that objects differing only in these can be drawn as instances of one.
+struct InstanceData
 {
-    uint value;
+    float4x4 Model_Matrix;
+    // Communicates the chosen features for this object
+    uint FeaturesField;
+    float ColorModifier;
+    // Indices of the textures in the descriptor heap
+    uint ColorTextureIndex;
+    uint ColorCubeIndex;
 };
 
-struct FloatBuf
-{
-    float value;
-};
+StructuredBuffer<InstanceData> Instances : register(t0, space0);
 
-// 32-bit unsigned integer
-// Communicates the chosen features for this draw call
-ConstantBuffer<UIntBuf> FeaturesFieldCB : register(b0, space1);
-// 32-bit floating point 
-ConstantBuffer<FloatBuf> ColorModifierCB : register(b1, space1);
-
-Texture2D ColorTexture : register(t0, space1);
-TextureCube ColorCube : register(t1, space1);
+// Both tables start from the beginning of the descriptor heap, each object indexes its own textures in them
+Texture2D ColorTextures[] : register(t0, space1);
+TextureCube ColorCubes[] : register(t0, space2);
 
 SamplerState TexSampler : register(s0); // Note: Since we are using a static sampler, we do not specify a register space
 
@@ -62,23 +59,26 @@ float4 main(PixelShaderInput IN) : SV_Target
 {
     float4 outColor = float4(0,0,0,0);
 
+    const InstanceData instance = Instances[IN.InstanceId];
+
+    // Instances of the same draw can index different textures, so the index is not uniform across the draw
     // If texture is active, start from color sampled from it
-    if (FeaturesFieldCB.value & DRAW_FEATURES_COLOR_TEX)
+    if (instance.FeaturesField & DRAW_FEATURES_COLOR_TEX)
     {
-        outColor = ColorTexture.Sample(TexSampler, IN.TextureCoords.xy);
+        outColor = ColorTextures[NonUniformResourceIndex(instance.ColorTextureIndex)].Sample(TexSampler, IN.TextureCoords.xy);
         // Sample function documentation at this page
         // https://docs.microsoft.com/en-us/windows/win32/direct3dhlsl/dx-graphics-hlsl-to-sample
 
     }
     // If cube is active, start from color sampled from it
-    else if (FeaturesFieldCB.value & DRAW_FEATURES_COLOR_CUBE)
+    else if (instance.FeaturesField & DRAW_FEATURES_COLOR_CUBE)
     {
-        outColor = ColorCube.Sample(TexSampler, IN.TextureCoords.xyz);
+        outColor = ColorCubes[NonUniformResourceIndex(instance.ColorCubeIndex)].Sample(TexSampler, IN.TextureCoords.xyz);
     }
 
-    if ((FeaturesFieldCB.value & DRAW_FEATURES_COLOR_MOD) && (outColor.x + outColor.y + outColor.z)/3.f > 0.1f)
+    if ((instance.FeaturesField & DRAW_FEATURES_COLOR_MOD) && (outColor.x + outColor.y + outColor.z)/3.f > 0.1f)
     {
-        outColor.xyz *= ColorModifierCB.value;
+        outColor.xyz *= instance.ColorModifier;
     }
 
     return outColor;
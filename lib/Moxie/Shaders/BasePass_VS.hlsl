@@ -6,26 +6,48 @@
  MIT License - Copyright (c) 2022 Riccardo Loggini
 */
 
-// To generate BasePass_VS.cso I will be using: fxc /Zi /T vs_5_1 /Fo BasePass_VS.cso BasePass_VS.hlsl
+// BasePass_VS.cso is generated by the build with: fxc /Zi /T vs_5_1 /Fo BasePass_VS.cso BasePass_VS.hlsl
 
 // HLSL language syntax at this page:
 // https://docs.microsoft.com/en-us/windows/win32/direct3dhlsl/dx-graphics-hlsl-language-syntax
 // And System Value Semantics at this page:
 // https://docs.microsoft.com/en-us/windows/win32/direct3dhlsl/dx-graphics-hlsl-semantics
 
-float4x4 MVP_Matrix : register(b0,space0); // Template Constructs require ShaderModel 5.1
+// Per-instance data, written every frame for the visible objects. 
+// Objects sharing mesh and pipeline state are drawn together, each instance reading its own element.
+// It needs to match the one in BasePass_PS.hlsl
+struct InstanceData
+{
+    float4x4 Model_Matrix;
+    uint FeaturesField;
+    float ColorModifier;
+    uint ColorTextureIndex;
+    uint ColorCubeIndex;
+};
+
+StructuredBuffer<InstanceData> Instances : register(t0,space0);
+
+// Per-view constants: view and projection combined, set once per view as root constants
+cbuffer ViewConstants : register(b1,space0)
+{
+    float4x4 ViewProj_Matrix;
+};
 
 struct VertexPosColor
 {
     float3 Position : POSITION;
     float3 Color : COLOR;
     float3 TextureCoords : TEXCOORD;
+    // Starts from 0 for each draw, the instances buffer is bound from the first instance of the draw
+    uint InstanceId : SV_InstanceID;
 };
 
 struct VertexShaderOutput
 {
     float3 Color : COLOR0;
     float3 TextureCoords : TEXCOORD0;
+    // The pixel shader reads the parameters of the instance from the same buffer
+    nointerpolation uint InstanceId : INSTANCEID0;
     // Note: Position is the last one since in pixel shader we just need Color and TextureCoords 
     // so we can just define a smaller pixel input struct.
     float4 Position : SV_POSITION; // Every vertex shader must write out a parameter with this semantic.
@@ -38,8 +60,12 @@ VertexShaderOutput main(VertexPosColor IN)
     OUT.Color = IN.Color;
 	
     OUT.TextureCoords = IN.TextureCoords;
+
+    OUT.InstanceId = IN.InstanceId;
     
-    OUT.Position = mul(MVP_Matrix, float4(IN.Position, 1.0f));
+    const float4x4 modelMatrix = Instances[IN.InstanceId].Model_Matrix;
+
+    OUT.Position = mul(ViewProj_Matrix, mul(modelMatrix, float4(IN.Position, 1.0f)));
 	
 	return OUT;
 }
\ No newline at end of file
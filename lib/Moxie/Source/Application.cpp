@@ -10,6 +10,7 @@
 #include "MoxGeometry.h"
 #include "Simulator.h"
 #include "Renderer.h"
+#include "FrameScheduler.h"
 #include "Graphics/Public/Window.h"
 #include "Graphics/Public/GraphicsAllocator.h"
 
@@ -46,7 +47,7 @@ namespace Mox
 	Application::Application()
 		: m_DoneSimFrameNum(0), m_DoneRenderFrameNum(0)
 	{
-
+		m_FrameScheduler = std::make_unique<Mox::FrameScheduler>(Mox::Constants::g_DefaultTargetFrameRate);
 	}
 
 	Application::~Application() = default;
@@ -108,23 +109,32 @@ namespace Mox
 
 		m_Renderer->Run();
 
-		// Application's main loop is based on received window messages, specifically WM_PAINT will trigger Update() and Render()
-		MSG windowMessage = {};
-		while (windowMessage.message != WM_QUIT)
+		// Application's main loop is paced by the frame scheduler, and window messages are serviced only when they are pending.
+		// The first WM_PAINT will allow frames to be computed.
+		bool isRunning = true;
+		while (isRunning)
 		{
 			static double elapsedSeconds = 0;
 			static uint32_t perSecondFrameNum = 0;
 			static std::chrono::steady_clock clock;
-			auto t0 = clock.now();
+			static auto t0 = clock.now();
 
-			if (::PeekMessage(&windowMessage, NULL, 0, 0, PM_REMOVE))
+			if (!CanComputeFrame())
 			{
-				::TranslateMessage(&windowMessage);
-				::DispatchMessage(&windowMessage);
+				// Nothing to compute yet, sleep until the OS sends a message
+				::WaitMessage();
+				isRunning = PumpWindowMessages();
+				continue;
 			}
 
-			if (!CanComputeFrame())
+			// Sleep until the next frame deadline, waking up earlier only to service window messages
+			if (m_FrameScheduler->WaitForNextFrame() == FRAME_WAIT_RESULT::MESSAGES_PENDING)
+			{
+				isRunning = PumpWindowMessages();
 				continue;
+			}
+
+			m_FrameScheduler->OnFrameStarted();
 
 			m_Simulator->Update();
 
@@ -163,11 +173,48 @@ namespace Mox
 		return m_PaintStarted;
 	}
 
-	Mox::Entity& Application::AddEntity(const Mox::EntityCreationInfo& InInfo)
+	bool Application::PumpWindowMessages()
+	{
+		MSG windowMessage = {};
+		while (::PeekMessage(&windowMessage, NULL, 0, 0, PM_REMOVE))
+		{
+			if (windowMessage.message == WM_QUIT)
+			{
+				return false;
+			}
+
+			::TranslateMessage(&windowMessage);
+			::DispatchMessage(&windowMessage);
+		}
+
+		return true;
+	}
+
+	void Application::SetTargetFrameRate(uint32_t InTargetFrameRate)
+	{
+		m_FrameScheduler->SetTargetFrameRate(InTargetFrameRate);
+	}
+
+	Mox::EntityHandle Application::AddEntity(const Mox::EntityCreationInfo& InInfo)
 	{
 		return m_Simulator->CreateEntity(InInfo);
 	}
 
+	std::vector<Mox::EntityHandle> Application::SpawnEntities(size_t InCount, const Mox::EntitySpawnTemplate& InTemplate)
+	{
+		return m_Simulator->SpawnEntities(InCount, InTemplate);
+	}
+
+	bool Application::RemoveEntity(Mox::EntityHandle InHandle)
+	{
+		return m_Simulator->DestroyEntity(InHandle);
+	}
+
+	Mox::Entity* Application::GetEntity(Mox::EntityHandle InHandle)
+	{
+		return m_Simulator->GetEntity(InHandle);
+	}
+
 	void Application::OnQuitApplication()
 	{
 
@@ -204,7 +251,7 @@ namespace Mox
 		// 
 		// TODO find a better way to move updates from the simulation to the render thread
 
-		m_Renderer->m_RenderUpdatesToProcess = m_StagedRenderUpdates;
+		m_Renderer->m_RenderUpdatesToProcess = std::move(m_StagedRenderUpdates);
 		m_StagedRenderUpdates = Mox::FrameRenderUpdates();
 
 		return true;
@@ -220,14 +267,19 @@ namespace Mox
 			std::lock_guard<std::mutex> simFrameLock(m_FramesMutex);
 
 			// Stage changes requested from the simulation
-			const auto& newUpdates = Mox::GetSimThreadUpdatesForRenderer();
+			auto& newUpdates = Mox::GetSimThreadUpdatesForRenderer();
 			MOVE_VEC(m_StagedRenderUpdates.m_BufferResourceRequests, newUpdates.m_BufferResourceRequests)
 			MOVE_VEC(m_StagedRenderUpdates.m_DynamicBufferUpdates, newUpdates.m_DynamicBufferUpdates)
 			MOVE_VEC(m_StagedRenderUpdates.m_StaticBufferUpdates, newUpdates.m_StaticBufferUpdates)
+			MOVE_VEC(m_StagedRenderUpdates.m_ProxyTransformUpdates, newUpdates.m_ProxyTransformUpdates)
+			MOVE_VEC(m_StagedRenderUpdates.m_DrawableParametersUpdates, newUpdates.m_DrawableParametersUpdates)
 			MOVE_VEC(m_StagedRenderUpdates.m_ProxyRequests, newUpdates.m_ProxyRequests)
 			MOVE_VEC(m_StagedRenderUpdates.m_DrawableRequests, newUpdates.m_DrawableRequests)
+			MOVE_VEC(m_StagedRenderUpdates.m_SpawnBatchRequests, newUpdates.m_SpawnBatchRequests)
 			MOVE_VEC(m_StagedRenderUpdates.m_TextureResourceRequests, newUpdates.m_TextureResourceRequests)
 			MOVE_VEC(m_StagedRenderUpdates.m_TextureUpdates, newUpdates.m_TextureUpdates)
+			MOVE_VEC(m_StagedRenderUpdates.m_ProxyReleases, newUpdates.m_ProxyReleases)
+			MOVE_VEC(m_StagedRenderUpdates.m_BufferReleases, newUpdates.m_BufferReleases)
 
 			Mox::GetSimThreadUpdatesForRenderer() = Mox::FrameRenderUpdates();
 
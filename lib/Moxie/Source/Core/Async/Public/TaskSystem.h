@@ -11,6 +11,7 @@
 
 #include <thread>
 #include <queue>
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 
@@ -25,6 +26,27 @@
 
 namespace Mox {
 
+	// Runs the function for every index in [0, InCount) concurrently on the engine task system, and returns once all of them are done.
+	// Worker threads, including the calling one, pick the next index as soon as they are free, 
+	// so it is meant for coarse grained work items that can have different costs.
+	// It can be called from a task, since the calling thread runs queued tasks while waiting.
+	void ParallelFor(size_t InCount, const std::function<void(size_t InIndex)>& InFunction);
+
+	// Number of tasks of a group that did not complete yet, used to wait for the whole group
+	class TaskCounter
+	{
+	public:
+		TaskCounter(uint32_t InTasksNum) : m_PendingTasksNum(InTasksNum) {}
+
+		// To be called by each task of the group as the last thing it does, since the counter can be destroyed right after
+		void SignalTaskDone() { m_PendingTasksNum.fetch_sub(1, std::memory_order_acq_rel); }
+
+		bool IsDone() const { return m_PendingTasksNum.load(std::memory_order_acquire) == 0; }
+
+	private:
+		std::atomic<uint32_t> m_PendingTasksNum;
+	};
+
 	// Abstact class that acts as interface for a task system implementation
 	class TaskSystem
 	{
@@ -43,8 +65,17 @@ namespace Mox {
 		// Shuts down the system and joins the worker threads
 		~EngineTaskSystem();
 
+		// Task system shared by the engine systems, its worker threads are started on first use
+		static EngineTaskSystem& Get();
+
 		void RunSystem();
 
+		uint32_t GetWorkerThreadsNum() const { return m_WorkerThreadsNum; }
+
+		// Runs queued tasks on the calling thread until all the tasks of the counter completed.
+		// Tasks are never waited for by just blocking, which would deadlock when called from a worker thread.
+		void WaitForCounter(const Mox::TaskCounter& InCounter);
+
 		template<typename TFunc>
 		void Enqueue(TFunc&& InFunction)
 		{
@@ -8,9 +8,55 @@
  
 #include "TaskSystem.h"
 #include "../../Public/MoxUtils.h"
+#include <atomic>
+#include <mutex>
+#include <algorithm>
 
 namespace Mox {
 
+	void ParallelFor(size_t InCount, const std::function<void(size_t InIndex)>& InFunction)
+	{
+		Mox::EngineTaskSystem& taskSystem = Mox::EngineTaskSystem::Get();
+
+		// One task for each worker, the calling thread takes part as well
+		const size_t tasksNum = std::min<size_t>(taskSystem.GetWorkerThreadsNum() + 1, InCount);
+
+		if (tasksNum <= 1)
+		{
+			for (size_t itemIdx = 0; itemIdx < InCount; ++itemIdx)
+			{
+				InFunction(itemIdx);
+			}
+			return;
+		}
+
+		std::atomic<size_t> nextItemIdx{ 0 };
+
+		auto runItems = [&]
+		{
+			for (size_t itemIdx = nextItemIdx++; itemIdx < InCount; itemIdx = nextItemIdx++)
+			{
+				InFunction(itemIdx);
+			}
+		};
+
+		// Everything referenced by the tasks lives on this stack frame, which is safe since the function does not return before all of them completed
+		Mox::TaskCounter tasksCounter(static_cast<uint32_t>(tasksNum - 1));
+		for (size_t taskIdx = 1; taskIdx < tasksNum; ++taskIdx)
+		{
+			taskSystem.Enqueue([&runItems, &tasksCounter]
+				{
+					runItems();
+					tasksCounter.SignalTaskDone();
+				});
+		}
+
+		runItems();
+
+		// Tasks not picked up by a worker yet are run here, and find no items left
+		taskSystem.WaitForCounter(tasksCounter);
+	}
+
 
 	EngineTaskSystem::EngineTaskSystem()
 	{
@@ -31,6 +77,34 @@ namespace Mox {
 			currentThread.join(); // TODO what happens when we call join on a thread which is executing an infinite loop??
 	}
 
+	EngineTaskSystem& EngineTaskSystem::Get()
+	{
+		static EngineTaskSystem engineTaskSystem;
+
+		static std::once_flag runSystemFlag;
+		std::call_once(runSystemFlag, [] { engineTaskSystem.RunSystem(); });
+
+		return engineTaskSystem;
+	}
+
+	void EngineTaskSystem::WaitForCounter(const Mox::TaskCounter& InCounter)
+	{
+		while (!InCounter.IsDone())
+		{
+			std::function<void()> functionToExecute;
+			for (uint32_t i = 0; i < m_WorkerThreadsNum; ++i)
+			{
+				if (m_TaskQueues[i].TryPop(functionToExecute))
+					break;
+			}
+
+			if (functionToExecute)
+				functionToExecute();
+			else
+				std::this_thread::yield(); // Remaining tasks are running on other threads
+		}
+	}
+
 	void EngineTaskSystem::RunSystem()
 	{
 		for (uint32_t i = 0; i < m_WorkerThreadsNum; i++)
@@ -60,9 +134,9 @@ namespace Mox {
 			}
 
 			// If we did not manage to acquire the lock and pop a task from any queue, 
-			// try waiting for the current thread queue to be available to and pop a task.
-			// If also this fails, exit the thread loop.								// TODO is this an optimal behavior? What happens if we later want to push more stuff for this thread instead?
-			if(!functionToExecute && m_TaskQueues[InThreadId].BlockingPop(functionToExecute))
+			// wait for a task to be pushed to the queue of the current thread.
+			// The pop only fails once the system is shut down, and then the thread loop exits.
+			if(!functionToExecute && !m_TaskQueues[InThreadId].BlockingPop(functionToExecute))
 				break;
 
 			functionToExecute();
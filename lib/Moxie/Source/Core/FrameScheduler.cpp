@@ -0,0 +1,92 @@
+/*
+ FrameScheduler.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#include "FrameScheduler.h"
+#include "MoxUtils.h"
+
+// Only defined by recent Windows SDKs
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+namespace Mox {
+
+	FrameScheduler::FrameScheduler(uint32_t InTargetFrameRate)
+	{
+		// High resolution timers are available from Windows 10 version 1803, older versions will fail the creation
+		m_WaitableTimer = ::CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+		if (m_WaitableTimer == NULL)
+		{
+			m_WaitableTimer = ::CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+		}
+
+		Check(m_WaitableTimer != NULL)
+
+		SetTargetFrameRate(InTargetFrameRate);
+	}
+
+	FrameScheduler::~FrameScheduler()
+	{
+		::CloseHandle(m_WaitableTimer);
+	}
+
+	void FrameScheduler::SetTargetFrameRate(uint32_t InTargetFrameRate)
+	{
+		m_TargetFrameRate = InTargetFrameRate;
+
+		m_FramePeriod = m_TargetFrameRate > 0 ?
+			std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / m_TargetFrameRate))
+			: std::chrono::steady_clock::duration::zero();
+
+		// The new frame rate applies starting from the next frame
+		m_NextFrameDeadline = std::chrono::steady_clock::now();
+	}
+
+	Mox::FRAME_WAIT_RESULT FrameScheduler::WaitForNextFrame()
+	{
+		const std::chrono::steady_clock::duration timeToDeadline = m_NextFrameDeadline - std::chrono::steady_clock::now();
+
+		if (timeToDeadline <= std::chrono::steady_clock::duration::zero())
+		{
+			// Frame is already due, only check (without waiting) if some input needs to be serviced first
+			const DWORD pollResult = ::MsgWaitForMultipleObjectsEx(0, NULL, 0, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+			return pollResult == WAIT_OBJECT_0 ? FRAME_WAIT_RESULT::MESSAGES_PENDING : FRAME_WAIT_RESULT::FRAME_DUE;
+		}
+
+		// Waitable timers take relative due times as negative values, expressed in 100 nanoseconds units
+		LARGE_INTEGER dueTime;
+		dueTime.QuadPart = -std::max<int64_t>(1, std::chrono::duration_cast<std::chrono::nanoseconds>(timeToDeadline).count() / 100);
+		::SetWaitableTimerEx(m_WaitableTimer, &dueTime, 0, NULL, NULL, NULL, 0);
+
+		// Sleep until either the timer fires or new input is available for the calling thread
+		const DWORD waitResult = ::MsgWaitForMultipleObjectsEx(1, &m_WaitableTimer, INFINITE, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+
+		if (waitResult == WAIT_OBJECT_0 + 1)
+		{
+			// Disarm the timer, it will be set again with the remaining time on the next wait
+			::CancelWaitableTimer(m_WaitableTimer);
+			return FRAME_WAIT_RESULT::MESSAGES_PENDING;
+		}
+
+		return FRAME_WAIT_RESULT::FRAME_DUE;
+	}
+
+	void FrameScheduler::OnFrameStarted()
+	{
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+		m_NextFrameDeadline += m_FramePeriod;
+
+		// If we fell behind by more than a whole frame, do not try to catch up with a burst of frames
+		if (m_NextFrameDeadline < now)
+		{
+			m_NextFrameDeadline = now + m_FramePeriod;
+		}
+	}
+
+}
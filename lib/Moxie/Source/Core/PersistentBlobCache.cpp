@@ -0,0 +1,118 @@
+/*
+ PersistentBlobCache.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#include "PersistentBlobCache.h"
+#include "MoxUtils.h"
+#include <fstream>
+#include <cstdio>
+
+namespace Mox {
+
+	namespace
+	{
+		// "MOXC" read as a little endian integer
+		constexpr uint32_t EntryMagic = 0x43584F4D;
+	}
+
+	PersistentBlobCache::PersistentBlobCache(const std::filesystem::path& InDirectory, uint64_t InContextHash)
+		: m_Directory(InDirectory), m_ContextHash(InContextHash)
+	{
+		std::error_code errorCode;
+		std::filesystem::create_directories(m_Directory, errorCode);
+	}
+
+	bool PersistentBlobCache::Load(const char* InCategory, uint64_t InKey, std::vector<uint8_t>& OutData) const
+	{
+		const std::filesystem::path entryPath = GetEntryPath(InCategory, InKey);
+
+		std::ifstream entryFile(entryPath, std::ios::binary);
+		if (!entryFile)
+		{
+			return false;
+		}
+
+		EntryHeader header;
+		bool isValid = static_cast<bool>(entryFile.read(reinterpret_cast<char*>(&header), sizeof(header)))
+			&& header.m_Magic == EntryMagic
+			&& header.m_FormatVersion == FormatVersion
+			&& header.m_ContextHash == m_ContextHash
+			&& header.m_Key == InKey;
+
+		if (isValid)
+		{
+			// The size is checked against the file before allocating, a corrupted header could ask for any amount of memory
+			std::error_code errorCode;
+			const uintmax_t fileSize = std::filesystem::file_size(entryPath, errorCode);
+			isValid = !errorCode && fileSize == sizeof(header) + header.m_DataSize;
+		}
+
+		if (isValid)
+		{
+			OutData.resize(static_cast<size_t>(header.m_DataSize));
+			isValid = static_cast<bool>(entryFile.read(reinterpret_cast<char*>(OutData.data()), OutData.size()))
+				&& Mox::HashBytes(OutData.data(), OutData.size()) == header.m_DataHash;
+		}
+
+		if (!isValid)
+		{
+			OutData.clear();
+
+			entryFile.close();
+			Remove(InCategory, InKey);
+		}
+
+		return isValid;
+	}
+
+	bool PersistentBlobCache::Store(const char* InCategory, uint64_t InKey, const void* InData, size_t InSize) const
+	{
+		const std::filesystem::path entryPath = GetEntryPath(InCategory, InKey);
+		std::filesystem::path tempPath = entryPath;
+		tempPath += ".tmp";
+
+		const EntryHeader header{ EntryMagic, FormatVersion, m_ContextHash, InKey, InSize, Mox::HashBytes(InData, InSize) };
+
+		{
+			std::ofstream tempFile(tempPath, std::ios::binary | std::ios::trunc);
+			tempFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			tempFile.write(static_cast<const char*>(InData), InSize);
+
+			if (!tempFile)
+			{
+				tempFile.close();
+				std::error_code errorCode;
+				std::filesystem::remove(tempPath, errorCode);
+				return false;
+			}
+		}
+
+		std::error_code errorCode;
+		std::filesystem::rename(tempPath, entryPath, errorCode);
+		if (errorCode)
+		{
+			std::filesystem::remove(tempPath, errorCode);
+			return false;
+		}
+
+		return true;
+	}
+
+	void PersistentBlobCache::Remove(const char* InCategory, uint64_t InKey) const
+	{
+		std::error_code errorCode;
+		std::filesystem::remove(GetEntryPath(InCategory, InKey), errorCode);
+	}
+
+	std::filesystem::path PersistentBlobCache::GetEntryPath(const char* InCategory, uint64_t InKey) const
+	{
+		char fileName[96];
+		snprintf(fileName, sizeof(fileName), "%s_%016llx.bin", InCategory, static_cast<unsigned long long>(InKey));
+		return m_Directory / fileName;
+	}
+
+}
@@ -0,0 +1,60 @@
+/*
+ FrameScheduler.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef FrameScheduler_h__
+#define FrameScheduler_h__
+
+namespace Mox {
+
+	enum class FRAME_WAIT_RESULT : int {
+		FRAME_DUE,
+		MESSAGES_PENDING
+	};
+
+	/*
+	* Paces the application main loop to a target frame rate.
+	* Instead of spinning, the calling thread sleeps on a high resolution waitable timer until the next frame deadline,
+	* and wakes up earlier only when window messages are waiting to be serviced.
+	* A target frame rate of 0 means no limit: the main loop will only be paced by the simulation and render threads sync.
+	*/
+	class FrameScheduler
+	{
+	public:
+		FrameScheduler(uint32_t InTargetFrameRate);
+
+		~FrameScheduler();
+
+		void SetTargetFrameRate(uint32_t InTargetFrameRate);
+
+		uint32_t GetTargetFrameRate() const { return m_TargetFrameRate; }
+
+		// Blocks the calling thread until either the next frame deadline is reached or window messages are pending
+		Mox::FRAME_WAIT_RESULT WaitForNextFrame();
+
+		// Sets the deadline for the frame after the one that is starting now
+		void OnFrameStarted();
+
+		FrameScheduler(const FrameScheduler&) = delete;
+		FrameScheduler& operator=(const FrameScheduler&) = delete;
+
+	private:
+
+		uint32_t m_TargetFrameRate = 0;
+
+		std::chrono::steady_clock::duration m_FramePeriod = std::chrono::steady_clock::duration::zero();
+
+		std::chrono::steady_clock::time_point m_NextFrameDeadline;
+
+		// Waitable timer used to sleep until the next deadline. 
+		// High resolution when supported by the OS, otherwise a regular one with millisecond precision.
+		HANDLE m_WaitableTimer = NULL;
+	};
+
+}
+
+#endif // FrameScheduler_h__
@@ -0,0 +1,67 @@
+/*
+ PersistentBlobCache.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef PersistentBlobCache_h__
+#define PersistentBlobCache_h__
+
+#include <filesystem>
+#include <vector>
+#include <cstdint>
+
+namespace Mox {
+
+	/*
+	* Stores blobs of data in a directory, so that results that are expensive to compute (e.g. compiled pipeline states)
+	* can be reused by later runs of the application.
+	* - Each blob is a file named after its category and its 64-bit key.
+	* - Every file starts with a header holding the format version, the context hash, the key and a hash of the data.
+	*   Files that do not match on any of them are treated as missing and deleted, so stale or corrupted entries get replaced.
+	* - Writes go to a temporary file that is then renamed, so an interrupted run never leaves a partially written entry.
+	* Errors from the file system are never fatal: they only make the cache miss.
+	*/
+	class PersistentBlobCache
+	{
+	public:
+		// Increased whenever the layout of the files changes
+		static constexpr uint32_t FormatVersion = 1;
+
+		// The context hash identifies anything external that makes stored blobs unusable when it changes, 
+		// such as the graphics adapter and driver for pipeline states.
+		PersistentBlobCache(const std::filesystem::path& InDirectory, uint64_t InContextHash);
+
+		// Fills OutData with the stored blob and returns true, or returns false if there is no valid blob for the key
+		bool Load(const char* InCategory, uint64_t InKey, std::vector<uint8_t>& OutData) const;
+
+		// Stores the blob replacing any previous one with the same key, returns false if it could not be written
+		bool Store(const char* InCategory, uint64_t InKey, const void* InData, size_t InSize) const;
+
+		void Remove(const char* InCategory, uint64_t InKey) const;
+
+		std::filesystem::path GetEntryPath(const char* InCategory, uint64_t InKey) const;
+
+		const std::filesystem::path& GetDirectory() const { return m_Directory; }
+
+	private:
+		struct EntryHeader
+		{
+			uint32_t m_Magic;
+			uint32_t m_FormatVersion;
+			uint64_t m_ContextHash;
+			uint64_t m_Key;
+			uint64_t m_DataSize;
+			uint64_t m_DataHash;
+		};
+
+		std::filesystem::path m_Directory;
+
+		uint64_t m_ContextHash;
+	};
+
+}
+
+#endif // PersistentBlobCache_h__
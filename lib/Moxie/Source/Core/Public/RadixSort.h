@@ -0,0 +1,31 @@
+/*
+ RadixSort.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef RadixSort_h__
+#define RadixSort_h__
+
+#include <vector>
+#include <cstdint>
+
+namespace Mox {
+
+	// Buffers used by RadixSortPairs while sorting, kept by the caller to avoid allocations on every sort
+	struct RadixSortScratch
+	{
+		std::vector<uint64_t> m_Keys;
+		std::vector<uint32_t> m_Values;
+	};
+
+	// Sorts the keys in increasing order, moving each value together with its key.
+	// The sort is stable, so values with equal keys keep their relative order.
+	// It runs one counting pass per byte of the keys, and bytes that are the same in all the keys are skipped.
+	void RadixSortPairs(std::vector<uint64_t>& InOutKeys, std::vector<uint32_t>& InOutValues, Mox::RadixSortScratch& InOutScratch);
+
+}
+
+#endif // RadixSort_h__
@@ -0,0 +1,169 @@
+/*
+ SlotMap.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef SlotMap_h__
+#define SlotMap_h__
+
+#include <vector>
+#include <limits>
+#include "MoxUtils.h"
+
+namespace Mox {
+
+	// Identifies an element stored in a SlotMap.
+	// The generation makes it possible to detect handles that refer to an element that was removed, even if its slot got reused.
+	struct SlotMapHandle
+	{
+		static constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+		uint32_t m_Index = InvalidIndex;
+		uint32_t m_Generation = 0;
+
+		bool IsValid() const { return m_Index != InvalidIndex; }
+
+		bool operator==(const SlotMapHandle& InOther) const { return m_Index == InOther.m_Index && m_Generation == InOther.m_Generation; }
+		bool operator!=(const SlotMapHandle& InOther) const { return !(*this == InOther); }
+	};
+
+	/*
+	* Container that hands out stable handles to its elements, while keeping the elements densely packed in memory.
+	* - Insertion and removal are O(1), removed slots are reused through a free list.
+	* - Elements are stored contiguously and can be iterated as a plain array.
+	* - Removing an element moves the last one in its place, so pointers and references to elements
+	*   are NOT stable across removals or insertions: keep handles and resolve them with Get() when needed.
+	*/
+	template<typename T>
+	class SlotMap
+	{
+	public:
+		using Handle = Mox::SlotMapHandle;
+
+		void Reserve(size_t InCapacity)
+		{
+			m_Slots.reserve(InCapacity);
+			m_DenseValues.reserve(InCapacity);
+			m_DenseToSlot.reserve(InCapacity);
+		}
+
+		template<typename... TArgs>
+		Handle Emplace(TArgs&&... InArgs)
+		{
+			uint32_t slotIndex;
+			if (m_FreeListHead != Handle::InvalidIndex)
+			{
+				// Reuse a free slot, it keeps the generation increased when it was freed
+				slotIndex = m_FreeListHead;
+				m_FreeListHead = m_Slots[slotIndex].m_DenseIndexOrNextFree;
+			}
+			else
+			{
+				slotIndex = static_cast<uint32_t>(m_Slots.size());
+				m_Slots.push_back(Slot{ 1, 0 });
+			}
+
+			Slot& targetSlot = m_Slots[slotIndex];
+			targetSlot.m_DenseIndexOrNextFree = static_cast<uint32_t>(m_DenseValues.size());
+
+			m_DenseValues.emplace_back(std::forward<TArgs>(InArgs)...);
+			m_DenseToSlot.push_back(slotIndex);
+
+			return Handle{ slotIndex, targetSlot.m_Generation };
+		}
+
+		// Returns false if the handle does not refer to a live element
+		bool Remove(Handle InHandle)
+		{
+			if (!Contains(InHandle))
+			{
+				return false;
+			}
+
+			Slot& removedSlot = m_Slots[InHandle.m_Index];
+			const uint32_t removedDenseIndex = removedSlot.m_DenseIndexOrNextFree;
+			const uint32_t lastDenseIndex = static_cast<uint32_t>(m_DenseValues.size()) - 1;
+
+			// Keep the dense array packed by moving the last element in place of the removed one
+			if (removedDenseIndex != lastDenseIndex)
+			{
+				m_DenseValues[removedDenseIndex] = std::move(m_DenseValues[lastDenseIndex]);
+				m_DenseToSlot[removedDenseIndex] = m_DenseToSlot[lastDenseIndex];
+				m_Slots[m_DenseToSlot[removedDenseIndex]].m_DenseIndexOrNextFree = removedDenseIndex;
+			}
+
+			m_DenseValues.pop_back();
+			m_DenseToSlot.pop_back();
+
+			// Invalidate all the outstanding handles to this slot and put it in the free list
+			removedSlot.m_Generation++;
+			removedSlot.m_DenseIndexOrNextFree = m_FreeListHead;
+			m_FreeListHead = InHandle.m_Index;
+
+			return true;
+		}
+
+		bool Contains(Handle InHandle) const
+		{
+			return InHandle.m_Index < m_Slots.size() && m_Slots[InHandle.m_Index].m_Generation == InHandle.m_Generation;
+		}
+
+		// Returns nullptr if the handle does not refer to a live element
+		T* Get(Handle InHandle)
+		{
+			return Contains(InHandle) ? &m_DenseValues[m_Slots[InHandle.m_Index].m_DenseIndexOrNextFree] : nullptr;
+		}
+
+		const T* Get(Handle InHandle) const
+		{
+			return Contains(InHandle) ? &m_DenseValues[m_Slots[InHandle.m_Index].m_DenseIndexOrNextFree] : nullptr;
+		}
+
+		// Handle of the element currently at the given position of the dense array
+		Handle GetHandleAt(size_t InDenseIndex) const
+		{
+			const uint32_t slotIndex = m_DenseToSlot[InDenseIndex];
+			return Handle{ slotIndex, m_Slots[slotIndex].m_Generation };
+		}
+
+		// Position in the dense array of the live element stored in the given slot, for code that keeps slot indices alone (see Handle::m_Index)
+		uint32_t GetDenseIndex(uint32_t InSlotIndex) const { return m_Slots[InSlotIndex].m_DenseIndexOrNextFree; }
+
+		// Element currently at the given position of the dense array
+		T& operator[](size_t InDenseIndex) { return m_DenseValues[InDenseIndex]; }
+		const T& operator[](size_t InDenseIndex) const { return m_DenseValues[InDenseIndex]; }
+
+		size_t Size() const { return m_DenseValues.size(); }
+
+		bool IsEmpty() const { return m_DenseValues.empty(); }
+
+		// Dense iteration over the stored elements, in no particular order
+		typename std::vector<T>::iterator begin() { return m_DenseValues.begin(); }
+		typename std::vector<T>::iterator end() { return m_DenseValues.end(); }
+		typename std::vector<T>::const_iterator begin() const { return m_DenseValues.begin(); }
+		typename std::vector<T>::const_iterator end() const { return m_DenseValues.end(); }
+
+	private:
+		struct Slot
+		{
+			uint32_t m_Generation;
+			// When the slot is used, it is the position of the element in the dense array.
+			// When the slot is free, it is the index of the next free slot.
+			uint32_t m_DenseIndexOrNextFree;
+		};
+
+		std::vector<Slot> m_Slots;
+
+		std::vector<T> m_DenseValues;
+		// Slot index of each element in the dense array, needed to fix up the slot when an element gets moved
+		std::vector<uint32_t> m_DenseToSlot;
+
+		uint32_t m_FreeListHead = Handle::InvalidIndex;
+	};
+
+}
+
+#endif // SlotMap_h__
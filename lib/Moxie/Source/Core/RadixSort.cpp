@@ -0,0 +1,73 @@
+/*
+ RadixSort.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#include "RadixSort.h"
+#include "MoxUtils.h"
+#include <array>
+
+namespace Mox {
+
+	void RadixSortPairs(std::vector<uint64_t>& InOutKeys, std::vector<uint32_t>& InOutValues, Mox::RadixSortScratch& InOutScratch)
+	{
+		Check(InOutKeys.size() == InOutValues.size())
+
+		constexpr uint32_t digitsNum = sizeof(uint64_t);
+		const size_t elementsNum = InOutKeys.size();
+
+		if (elementsNum < 2)
+		{
+			return;
+		}
+
+		// Histograms of all the digits are gathered in a single pass over the keys
+		std::array<std::array<uint32_t, 256>, digitsNum> digitCounts{};
+		for (uint64_t key : InOutKeys)
+		{
+			for (uint32_t digitIdx = 0; digitIdx < digitsNum; ++digitIdx)
+			{
+				++digitCounts[digitIdx][(key >> (digitIdx * 8)) & 0xFF];
+			}
+		}
+
+		InOutScratch.m_Keys.resize(elementsNum);
+		InOutScratch.m_Values.resize(elementsNum);
+
+		// Least significant digit first: each pass is stable, so the order given by lower digits is kept among equal higher digits
+		for (uint32_t digitIdx = 0; digitIdx < digitsNum; ++digitIdx)
+		{
+			std::array<uint32_t, 256>& counts = digitCounts[digitIdx];
+			const uint32_t shift = digitIdx * 8;
+
+			// When all the keys have the same digit, the pass would not change the order
+			if (counts[(InOutKeys[0] >> shift) & 0xFF] == elementsNum)
+			{
+				continue;
+			}
+
+			// Counts become the first destination of each digit value
+			uint32_t digitOffset = 0;
+			for (uint32_t& digitCount : counts)
+			{
+				const uint32_t count = digitCount;
+				digitCount = digitOffset;
+				digitOffset += count;
+			}
+
+			for (size_t elementIdx = 0; elementIdx < elementsNum; ++elementIdx)
+			{
+				const uint32_t destination = counts[(InOutKeys[elementIdx] >> shift) & 0xFF]++;
+				InOutScratch.m_Keys[destination] = InOutKeys[elementIdx];
+				InOutScratch.m_Values[destination] = InOutValues[elementIdx];
+			}
+
+			InOutKeys.swap(InOutScratch.m_Keys);
+			InOutValues.swap(InOutScratch.m_Values);
+		}
+	}
+
+}
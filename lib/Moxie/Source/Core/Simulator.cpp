@@ -21,10 +21,7 @@ namespace Mox {
 
 	SimulatonThread::SimulatonThread()
 	{
-		// Note: At the moment it is very important for the array to not resize
-		// as otherwise all the memory addresses will change, and that will invalidate
-		// all the previous pointers and references to entities..
-		m_WorldEntities.reserve(50);
+
 	}
 
 	void SimulatonThread::Run()
@@ -45,6 +42,9 @@ namespace Mox {
 
 			Application::Get()->UpdateContent(m_DeltaTime);
 
+			// Apply all the changes made to the world during this frame
+			m_World.Update();
+
 		}
 		auto t1 = clock.now();
 		auto deltaTime = t1 - t0;
@@ -75,11 +75,39 @@ namespace Mox {
 
 	}
 
-	Mox::Entity& SimulatonThread::CreateEntity(const Mox::EntityCreationInfo& InInfo)
-{
-		Mox::Entity& newEntity = m_WorldEntities.emplace_back(InInfo);
+	Mox::EntityHandle SimulatonThread::CreateEntity(const Mox::EntityCreationInfo& InInfo)
+	{
+		return m_WorldEntities.Emplace(InInfo, m_World);
+	}
+
+	std::vector<Mox::EntityHandle> SimulatonThread::SpawnEntities(size_t InCount, const Mox::EntitySpawnTemplate& InTemplate)
+	{
+		const std::vector<entt::entity> worldIds = m_World.SpawnEntities(InCount, InTemplate);
+
+		m_WorldEntities.Reserve(m_WorldEntities.Size() + InCount);
+
+		std::vector<Mox::EntityHandle> outHandles;  outHandles.reserve(InCount);
+		for (entt::entity worldId : worldIds)
+		{
+			outHandles.push_back(m_WorldEntities.Emplace(worldId, m_World));
+		}
+
+		return outHandles;
+	}
+
+	bool SimulatonThread::DestroyEntity(Mox::EntityHandle InHandle)
+	{
+		Mox::Entity* targetEntity = m_WorldEntities.Get(InHandle);
+		if (!targetEntity)
+		{
+			return false;
+		}
+
+		Mox::ReleaseRenderProxyForEntity(*targetEntity);
+
+		m_World.DestroyEntity(targetEntity->GetWorldId());
 
-		return m_WorldEntities.back();
+		return m_WorldEntities.Remove(InHandle);
 	}
 
 }
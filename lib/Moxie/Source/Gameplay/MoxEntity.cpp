@@ -9,33 +9,49 @@
 #include "MoxEntity.h"
 #include "MoxRenderProxy.h"
 #include "MoxDrawable.h"
-#include "MoxComponent.h"
 #include "MoxGeometry.h"
+#include "MoxWorld.h"
 
 namespace Mox {
 
 
-Entity::Entity(const Mox::EntityCreationInfo& InInfo)
-	: m_WorldMatrix(Mox::ModelMatrix(InInfo.WorldPosition, InInfo.WorldScale, InInfo.WorldRotation)),
-	m_WorldPos(InInfo.WorldPosition),m_WorldScale(Mox::Matrix3f::Identity()),m_WorldRot(Mox::Matrix3f::Identity())
+Entity::Entity(const Mox::EntityCreationInfo& InInfo, Mox::World& InWorld)
+	: m_World(&InWorld), m_WorldId(InWorld.CreateEntity(InInfo))
 {
-	SetScale(InInfo.WorldScale.x(), InInfo.WorldScale.y(), InInfo.WorldScale.z());
-	Rotate(InInfo.WorldRotation.x(), InInfo.WorldRotation.y());
-
-	m_RenderProxy = std::make_shared<Mox::RenderProxy>();
-
 	Mox::RequestRenderProxyForEntity(*this);
 }
 
-void Entity::AddComponent(std::shared_ptr<Mox::Component> InComponent)
+Entity::Entity(entt::entity InWorldId, Mox::World& InWorld)
+	: m_World(&InWorld), m_WorldId(InWorldId)
 {
-	InComponent->OnPossessedBy(*this);
 
-	m_Components.push_back(InComponent);
 }
 
+// Note: The world data of the entity is released by whoever destroys the entity in the world (see SimulatonThread::DestroyEntity),
+// because entities get moved and destructed when the dense entity storage is reorganized.
 Entity::~Entity() = default;
 Entity::Entity(Entity&&) noexcept = default;
+Entity& Entity::operator=(Entity&&) noexcept = default;
+
+std::shared_ptr<Mox::RenderProxy> Entity::GetRenderProxy() const
+{
+	return m_World->GetRegistry().get<Mox::RenderProxyLinkComponent>(m_WorldId).m_RenderProxy;
+}
+
+Mox::Matrix4f Entity::GetModelMatrix() const
+{
+	return m_World->GetTransforms().GetWorldMatrix(m_World->GetTransformNode(m_WorldId));
+}
+
+void Entity::AttachTo(const Entity& InParent)
+{
+	m_World->SetParent(m_WorldId, InParent.m_WorldId);
+}
+
+void Entity::Detach()
+{
+	m_World->SetParent(m_WorldId, entt::null);
+}
 
 void Entity::Rotate(float InAngleX, float InAngleY)
 {
@@ -45,45 +61,25 @@ void Entity::Rotate(float InAngleX, float InAngleY)
 		.rotate(Mox::AngleAxisf(InAngleY, Mox::Vector3f::UnitX()))
 		.rotate(Mox::AngleAxisf(InAngleX, Mox::Vector3f::UnitY()));
 
-	m_WorldRot = rotationTransform.linear() * m_WorldRot;
-
 	// Note: Order of rotations is important (and not commutative). 
 	// Multiplication goes from right to left (because transforming points in form of column vectors) and 
 	// we always want to start from the previous rotation and adding the new rotation on top of it.
-	m_WorldMatrix.topLeftCorner<3, 3>() = m_WorldRot;
-
-	// Re-apply scale
-	m_WorldMatrix.topLeftCorner<3, 3>() *= m_WorldScale;
-
-	OnTransformChanged();
+	m_World->GetTransforms().Rotate(m_World->GetTransformNode(m_WorldId), rotationTransform.linear());
 }
 
 void Entity::Translate(float InX, float InY, float InZ)
 {
-	m_WorldPos += Mox::Vector3f(InX, InY, InZ);
-
-	m_WorldMatrix.topRightCorner<3, 1>() = m_WorldPos;
-
-	OnTransformChanged();
+	m_World->GetTransforms().Translate(m_World->GetTransformNode(m_WorldId), Mox::Vector3f(InX, InY, InZ));
 }
 
 void Entity::SetScale(float InX, float InY, float InZ)
 {
-	m_WorldScale.diagonal() = Mox::Vector3f(InX, InY, InZ);
-
-	m_WorldMatrix.topLeftCorner<3, 3>() = m_WorldRot;
-
-	m_WorldMatrix.topLeftCorner<3, 3>() *= m_WorldScale;
-
-	OnTransformChanged();
+	m_World->GetTransforms().SetLocalScale(m_World->GetTransformNode(m_WorldId), Mox::Vector3f(InX, InY, InZ));
 }
 
-void Entity::OnTransformChanged()
+void Entity::SetLocalBounds(const Mox::Aabb& InLocalBounds)
 {
-	for (std::shared_ptr<class Mox::Component>& curComponent : m_Components)
-	{
-		curComponent->OnEntityTransformChanged(m_WorldMatrix);
-	}
+	m_World->SetLocalBounds(m_WorldId, InLocalBounds);
 }
 
 }
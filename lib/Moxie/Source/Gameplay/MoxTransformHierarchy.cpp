@@ -0,0 +1,313 @@
+/*
+ MoxTransformHierarchy.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#include "MoxTransformHierarchy.h"
+#include "MoxMatrixKernels.h"
+#include <algorithm>
+#include <numeric>
+
+namespace Mox {
+
+	namespace
+	{
+		constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+		// Local matrix from translation, rotation and scale: scale is applied first, then rotation, then translation
+		inline void ComposeLocalMatrix(const Mox::Vector3f& InPosition, const Mox::Matrix3f& InRotation, const Mox::Vector3f& InScale, Mox::Matrix4f& OutMatrix)
+		{
+			OutMatrix.col(0) << InRotation.col(0) * InScale.x(), 0.f;
+			OutMatrix.col(1) << InRotation.col(1) * InScale.y(), 0.f;
+			OutMatrix.col(2) << InRotation.col(2) * InScale.z(), 0.f;
+			OutMatrix.col(3) << InPosition, 1.f;
+		}
+	}
+
+	TransformNodeId TransformHierarchy::CreateNode(const Mox::Vector3f& InLocalPosition, const Mox::Matrix3f& InLocalRotation, const Mox::Vector3f& InLocalScale, 
+		TransformNodeId InParent /*= InvalidNode*/)
+	{
+		TransformNodeId newId;
+		if (!m_FreeIds.empty())
+		{
+			newId = m_FreeIds.back();
+			m_FreeIds.pop_back();
+		}
+		else
+		{
+			newId = static_cast<TransformNodeId>(m_IdToIndex.size());
+			m_IdToIndex.push_back(InvalidIndex);
+		}
+
+		const uint32_t newIndex = static_cast<uint32_t>(m_NodeIds.size());
+		m_IdToIndex[newId] = newIndex;
+
+		// Appending keeps parents before children, since the parent is already in the arrays
+		const uint32_t parentIndex = InParent != InvalidNode ? m_IdToIndex[InParent] : InvalidIndex;
+
+		m_NodeIds.push_back(newId);
+		m_ParentIds.push_back(InParent);
+		m_ParentIndices.push_back(parentIndex);
+		m_Depths.push_back(parentIndex != InvalidIndex ? m_Depths[parentIndex] + 1 : 0);
+		m_LocalPositions.push_back(InLocalPosition);
+		m_LocalRotations.push_back(InLocalRotation);
+		m_LocalScales.push_back(InLocalScale);
+		m_DirtyFlags.push_back(0);
+
+		Mox::Matrix4f& newWorldMatrix = m_WorldMatrices.emplace_back();
+		ComposeLocalMatrix(InLocalPosition, InLocalRotation, InLocalScale, newWorldMatrix);
+		if (parentIndex != InvalidIndex)
+		{
+			newWorldMatrix = m_WorldMatrices[parentIndex] * newWorldMatrix;
+		}
+
+		return newId;
+	}
+
+	void TransformHierarchy::ReserveNewNodes(size_t InNewNodesNum)
+	{
+		// Destroyed nodes are still in the arrays until the next reorder, so they are counted as well
+		const size_t requiredSize = m_NodeIds.size() + InNewNodesNum;
+
+		m_NodeIds.reserve(requiredSize);
+		m_ParentIds.reserve(requiredSize);
+		m_ParentIndices.reserve(requiredSize);
+		m_Depths.reserve(requiredSize);
+		m_LocalPositions.reserve(requiredSize);
+		m_LocalRotations.reserve(requiredSize);
+		m_LocalScales.reserve(requiredSize);
+		m_WorldMatrices.reserve(requiredSize);
+		m_DirtyFlags.reserve(requiredSize);
+		m_IdToIndex.reserve(m_IdToIndex.size() + InNewNodesNum);
+	}
+
+	void TransformHierarchy::DestroyNode(TransformNodeId InNode)
+	{
+		const uint32_t nodeIndex = m_IdToIndex[InNode];
+		Check(nodeIndex != InvalidIndex)
+
+		// The node data is removed, and its children detached, on the next reorder
+		m_NodeIds[nodeIndex] = InvalidNode;
+		m_DirtyFlags[nodeIndex] = 0;
+		m_IdToIndex[InNode] = InvalidIndex;
+
+		m_DestroyedIds.push_back(InNode);
+		m_NeedsReorder = true;
+	}
+
+	void TransformHierarchy::SetParent(TransformNodeId InNode, TransformNodeId InNewParent)
+	{
+		const uint32_t nodeIndex = m_IdToIndex[InNode];
+
+		if (m_ParentIds[nodeIndex] == InNewParent)
+		{
+			return;
+		}
+
+		// A node cannot become a child of its own subtree
+		Check(InNewParent == InvalidNode || (InNewParent != InNode && !IsDescendantOf(InNewParent, InNode)))
+
+		m_ParentIds[nodeIndex] = InNewParent;
+		m_ParentIndices[nodeIndex] = InNewParent != InvalidNode ? m_IdToIndex[InNewParent] : InvalidIndex;
+
+		// The whole subtree changes depth and may now come before its new parent
+		m_NeedsReorder = true;
+
+		MarkDirty(InNode);
+	}
+
+	void TransformHierarchy::SetLocalPosition(TransformNodeId InNode, const Mox::Vector3f& InPosition)
+	{
+		m_LocalPositions[m_IdToIndex[InNode]] = InPosition;
+		MarkDirty(InNode);
+	}
+
+	void TransformHierarchy::Translate(TransformNodeId InNode, const Mox::Vector3f& InOffset)
+	{
+		m_LocalPositions[m_IdToIndex[InNode]] += InOffset;
+		MarkDirty(InNode);
+	}
+
+	void TransformHierarchy::Rotate(TransformNodeId InNode, const Mox::Matrix3f& InRotation)
+	{
+		Mox::Matrix3f& localRotation = m_LocalRotations[m_IdToIndex[InNode]];
+		localRotation = InRotation * localRotation;
+		MarkDirty(InNode);
+	}
+
+	void TransformHierarchy::SetLocalScale(TransformNodeId InNode, const Mox::Vector3f& InScale)
+	{
+		m_LocalScales[m_IdToIndex[InNode]] = InScale;
+		MarkDirty(InNode);
+	}
+
+	void TransformHierarchy::Update()
+	{
+		m_ChangedNodes.clear();
+
+		if (m_NeedsReorder)
+		{
+			Reorder();
+		}
+
+		const size_t nodesNum = m_NodeIds.size();
+
+		// Parents come before children, so a single forward pass propagates the dirty flag to entire subtrees
+		for (uint32_t nodeIdx = 0; nodeIdx < nodesNum; ++nodeIdx)
+		{
+			const uint32_t parentIndex = m_ParentIndices[nodeIdx];
+			if (parentIndex != InvalidIndex)
+			{
+				m_DirtyFlags[nodeIdx] |= m_DirtyFlags[parentIndex];
+			}
+		}
+
+		// Build local matrices of the dirty nodes.
+		// Only touching the SoA arrays of positions, rotations and scales, the loop stays cache friendly and gets vectorized.
+		for (uint32_t nodeIdx = 0; nodeIdx < nodesNum; ++nodeIdx)
+		{
+			if (m_DirtyFlags[nodeIdx])
+			{
+				ComposeLocalMatrix(m_LocalPositions[nodeIdx], m_LocalRotations[nodeIdx], m_LocalScales[nodeIdx], m_WorldMatrices[nodeIdx]);
+			}
+		}
+
+		// Gather the dirty child nodes, in order, to concatenate them with their parent world matrix in a single batch
+		m_ConcatTargets.clear();
+		m_ConcatParents.clear();
+		for (uint32_t nodeIdx = 0; nodeIdx < nodesNum; ++nodeIdx)
+		{
+			if (!m_DirtyFlags[nodeIdx])
+			{
+				continue;
+			}
+
+			const uint32_t parentIndex = m_ParentIndices[nodeIdx];
+			if (parentIndex != InvalidIndex)
+			{
+				m_ConcatTargets.push_back(nodeIdx);
+				m_ConcatParents.push_back(parentIndex);
+			}
+
+			m_ChangedNodes.push_back(m_NodeIds[nodeIdx]);
+			m_DirtyFlags[nodeIdx] = 0;
+		}
+
+		// Entries are in depth order, so each parent world matrix is final by the time its children use it
+		Mox::ConcatenateMatrices(m_WorldMatrices.data(), m_ConcatTargets.data(), m_ConcatParents.data(), m_ConcatTargets.size());
+	}
+
+	bool TransformHierarchy::IsDescendantOf(TransformNodeId InNode, TransformNodeId InAncestor) const
+	{
+		TransformNodeId curNode = m_ParentIds[m_IdToIndex[InNode]];
+		while (curNode != InvalidNode && m_IdToIndex[curNode] != InvalidIndex)
+		{
+			if (curNode == InAncestor)
+			{
+				return true;
+			}
+			curNode = m_ParentIds[m_IdToIndex[curNode]];
+		}
+		return false;
+	}
+
+	void TransformHierarchy::Reorder()
+	{
+		const size_t oldNodesNum = m_NodeIds.size();
+
+		std::vector<uint32_t> liveIndices;
+		liveIndices.reserve(oldNodesNum - m_DestroyedIds.size());
+
+		for (uint32_t nodeIdx = 0; nodeIdx < oldNodesNum; ++nodeIdx)
+		{
+			if (m_NodeIds[nodeIdx] == InvalidNode)
+			{
+				continue;
+			}
+
+			// Children of destroyed nodes become roots
+			const TransformNodeId parentId = m_ParentIds[nodeIdx];
+			if (parentId != InvalidNode && m_IdToIndex[parentId] == InvalidIndex)
+			{
+				m_ParentIds[nodeIdx] = InvalidNode;
+				m_DirtyFlags[nodeIdx] = 1;
+			}
+
+			liveIndices.push_back(nodeIdx);
+		}
+
+		// Ids of destroyed nodes can be reused only now that nothing refers to them anymore
+		m_FreeIds.insert(m_FreeIds.end(), m_DestroyedIds.begin(), m_DestroyedIds.end());
+		m_DestroyedIds.clear();
+
+		// Compute depths walking up the parent chain, reusing the depths already found for the ancestors
+		std::vector<uint32_t> newDepths(oldNodesNum, InvalidIndex);
+		std::vector<uint32_t> pendingChain;
+		for (uint32_t nodeIdx : liveIndices)
+		{
+			uint32_t curIdx = nodeIdx;
+			while (newDepths[curIdx] == InvalidIndex)
+			{
+				pendingChain.push_back(curIdx);
+				const TransformNodeId parentId = m_ParentIds[curIdx];
+				if (parentId == InvalidNode)
+				{
+					newDepths[curIdx] = 0;
+					pendingChain.pop_back();
+					break;
+				}
+				curIdx = m_IdToIndex[parentId];
+			}
+
+			uint32_t curDepth = newDepths[curIdx];
+			while (!pendingChain.empty())
+			{
+				newDepths[pendingChain.back()] = ++curDepth;
+				pendingChain.pop_back();
+			}
+		}
+
+		// Stable sort keeps the current order within each depth level
+		std::stable_sort(liveIndices.begin(), liveIndices.end(), [&newDepths](uint32_t InLeft, uint32_t InRight) { return newDepths[InLeft] < newDepths[InRight]; });
+
+		auto permute = [&liveIndices](auto& InOutArray)
+		{
+			std::remove_reference_t<decltype(InOutArray)> reorderedArray;
+			reorderedArray.reserve(liveIndices.size());
+			for (uint32_t oldIdx : liveIndices)
+			{
+				reorderedArray.push_back(std::move(InOutArray[oldIdx]));
+			}
+			InOutArray = std::move(reorderedArray);
+		};
+
+		permute(m_NodeIds);
+		permute(m_ParentIds);
+		permute(m_LocalPositions);
+		permute(m_LocalRotations);
+		permute(m_LocalScales);
+		permute(m_WorldMatrices);
+		permute(m_DirtyFlags);
+		permute(newDepths);
+		m_Depths = std::move(newDepths);
+
+		const uint32_t newNodesNum = static_cast<uint32_t>(m_NodeIds.size());
+		for (uint32_t nodeIdx = 0; nodeIdx < newNodesNum; ++nodeIdx)
+		{
+			m_IdToIndex[m_NodeIds[nodeIdx]] = nodeIdx;
+		}
+
+		m_ParentIndices.resize(newNodesNum);
+		for (uint32_t nodeIdx = 0; nodeIdx < newNodesNum; ++nodeIdx)
+		{
+			const TransformNodeId parentId = m_ParentIds[nodeIdx];
+			m_ParentIndices[nodeIdx] = parentId != InvalidNode ? m_IdToIndex[parentId] : InvalidIndex;
+		}
+
+		m_NeedsReorder = false;
+	}
+
+}
@@ -0,0 +1,234 @@
+/*
+ MoxWorld.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#include "MoxWorld.h"
+#include "MoxEntity.h"
+#include "MoxRenderProxy.h"
+#include "MoxGeometry.h"
+#include "MoxMeshComponent.h"
+
+namespace Mox {
+
+	// Spatial index leaves store the entity ids as plain values
+	inline uint32_t ToSpatialUserValue(entt::entity InEntity) { return static_cast<uint32_t>(InEntity); }
+
+	template<typename QueryFunc>
+	void QueryEntities(QueryFunc&& InQuery, std::vector<entt::entity>& OutEntities)
+	{
+		std::vector<uint32_t> foundValues;
+		InQuery(foundValues);
+
+		OutEntities.reserve(OutEntities.size() + foundValues.size());
+		for (uint32_t currentValue : foundValues)
+		{
+			OutEntities.push_back(static_cast<entt::entity>(currentValue));
+		}
+	}
+
+	entt::entity World::CreateEntity(const Mox::EntityCreationInfo& InInfo)
+	{
+		const entt::entity newEntity = m_Registry.create();
+
+		CreateTransformNode(newEntity, InInfo);
+
+		m_Registry.emplace<Mox::RenderProxyLinkComponent>(newEntity, std::make_shared<Mox::RenderProxy>());
+
+		return newEntity;
+	}
+
+	std::vector<entt::entity> World::SpawnEntities(size_t InCount, const Mox::EntitySpawnTemplate& InTemplate)
+	{
+		Check(InTemplate.m_InstanceCreationInfos.empty() || InTemplate.m_InstanceCreationInfos.size() == InCount)
+
+		std::vector<entt::entity> newEntities(InCount);
+		m_Registry.create(newEntities.begin(), newEntities.end());
+
+		const bool hasMesh = InTemplate.m_Mesh.m_VertexBuffer != nullptr;
+
+		Mox::SpawnBatchRequest spawnBatch;
+		spawnBatch.m_Proxies.reserve(InCount);
+		if (hasMesh)
+		{
+			spawnBatch.m_DrawableTemplate = InTemplate.m_Mesh;
+			spawnBatch.m_InitialModelMatrices.reserve(InCount);
+		}
+
+		// Room for the new nodes in the worst case, where none of the free node ids gets reused
+		m_Transforms.ReserveNewNodes(InCount);
+		m_NodeOwners.reserve(m_NodeOwners.size() + InCount);
+
+		for (size_t entityIdx = 0; entityIdx < InCount; ++entityIdx)
+		{
+			const entt::entity newEntity = newEntities[entityIdx];
+
+			const Mox::EntityCreationInfo& creationInfo = InTemplate.m_InstanceCreationInfos.empty() ? 
+				InTemplate.m_CreationInfo : InTemplate.m_InstanceCreationInfos[entityIdx];
+
+			const Mox::TransformNodeId newNode = CreateTransformNode(newEntity, creationInfo);
+
+			Mox::RenderProxyLinkComponent& proxyLink = m_Registry.emplace<Mox::RenderProxyLinkComponent>(newEntity, std::make_shared<Mox::RenderProxy>());
+			spawnBatch.m_Proxies.push_back(proxyLink.m_RenderProxy);
+
+			if (hasMesh)
+			{
+				// Not tagged as changed: the initial model matrix travels with the batch instead of a transform update for each entity
+				m_Registry.emplace<Mox::MeshComponent>(newEntity, InTemplate.m_Mesh.m_VertexBuffer, InTemplate.m_Mesh.m_IndexBuffer);
+
+				spawnBatch.m_InitialModelMatrices.push_back(m_Transforms.GetWorldMatrix(newNode));
+			}
+		}
+
+		Mox::RequestSpawnBatch(std::move(spawnBatch));
+
+		// Added to the spatial index all together, which lets the index rebuild in parallel instead of inserting entities one by one
+		if (InTemplate.m_LocalBounds.IsValid())
+		{
+			std::vector<Mox::Aabb> worldBounds(InCount);
+			std::vector<uint32_t> userValues(InCount);
+			for (size_t entityIdx = 0; entityIdx < InCount; ++entityIdx)
+			{
+				worldBounds[entityIdx] = InTemplate.m_LocalBounds.Transformed(m_Transforms.GetWorldMatrix(GetTransformNode(newEntities[entityIdx])));
+				userValues[entityIdx] = ToSpatialUserValue(newEntities[entityIdx]);
+			}
+
+			std::vector<Mox::BvhProxyId> newProxies(InCount);
+			m_SpatialIndex.CreateProxies(worldBounds.data(), userValues.data(), InCount, newProxies.data());
+
+			for (size_t entityIdx = 0; entityIdx < InCount; ++entityIdx)
+			{
+				m_Registry.emplace<Mox::SpatialProxyComponent>(newEntities[entityIdx], Mox::SpatialProxyComponent{ newProxies[entityIdx], InTemplate.m_LocalBounds });
+			}
+		}
+
+		return newEntities;
+	}
+
+	Mox::TransformNodeId World::CreateTransformNode(entt::entity InEntity, const Mox::EntityCreationInfo& InInfo)
+	{
+		// Same rotation convention as Entity::Rotate: X angle around the Y axis, Y angle around the X axis
+		Mox::Affine3f rotationTransform = Mox::Affine3f::Identity();
+		rotationTransform
+			.rotate(Mox::AngleAxisf(InInfo.WorldRotation.y(), Mox::Vector3f::UnitX()))
+			.rotate(Mox::AngleAxisf(InInfo.WorldRotation.x(), Mox::Vector3f::UnitY()));
+
+		// The model matrix is valid straight away, so that components created in the same frame can use it
+		const Mox::TransformNodeId newNode = m_Transforms.CreateNode(InInfo.WorldPosition, rotationTransform.linear(), InInfo.WorldScale);
+
+		m_Registry.emplace<Mox::TransformNodeComponent>(InEntity, Mox::TransformNodeComponent{ newNode });
+
+		if (newNode >= m_NodeOwners.size())
+		{
+			m_NodeOwners.resize(newNode + 1, entt::null);
+		}
+		m_NodeOwners[newNode] = InEntity;
+
+		return newNode;
+	}
+
+	void World::DestroyEntity(entt::entity InEntity)
+	{
+		const Mox::TransformNodeId destroyedNode = GetTransformNode(InEntity);
+
+		m_Transforms.DestroyNode(destroyedNode);
+		m_NodeOwners[destroyedNode] = entt::null;
+
+		if (const Mox::SpatialProxyComponent* spatialProxy = m_Registry.try_get<Mox::SpatialProxyComponent>(InEntity))
+		{
+			m_SpatialIndex.DestroyProxy(spatialProxy->m_Proxy);
+		}
+
+		m_Registry.destroy(InEntity);
+	}
+
+	void World::SetLocalBounds(entt::entity InEntity, const Mox::Aabb& InLocalBounds)
+	{
+		const Mox::Aabb worldBounds = InLocalBounds.Transformed(m_Transforms.GetWorldMatrix(GetTransformNode(InEntity)));
+
+		if (Mox::SpatialProxyComponent* spatialProxy = m_Registry.try_get<Mox::SpatialProxyComponent>(InEntity))
+		{
+			spatialProxy->m_LocalBounds = InLocalBounds;
+			m_SpatialIndex.MoveProxy(spatialProxy->m_Proxy, worldBounds);
+		}
+		else
+		{
+			m_Registry.emplace<Mox::SpatialProxyComponent>(InEntity, 
+				Mox::SpatialProxyComponent{ m_SpatialIndex.CreateProxy(worldBounds, ToSpatialUserValue(InEntity)), InLocalBounds });
+		}
+	}
+
+	void World::SetParent(entt::entity InEntity, entt::entity InParent)
+	{
+		m_Transforms.SetParent(GetTransformNode(InEntity), InParent != entt::null ? GetTransformNode(InParent) : Mox::TransformHierarchy::InvalidNode);
+	}
+
+	void World::Update()
+	{
+		UpdateTransforms();
+
+		UpdateMeshComponents();
+
+		UpdateSpatialIndex();
+
+		m_Registry.clear<Mox::TransformChangedTag>();
+	}
+
+	void World::UpdateTransforms()
+	{
+		m_Transforms.Update();
+
+		// Tags have no data, so marking entities only affects the tag pool.
+		// Each component type then processes all of its changed entities in one go.
+		for (Mox::TransformNodeId changedNode : m_Transforms.GetChangedNodes())
+		{
+			m_Registry.emplace_or_replace<Mox::TransformChangedTag>(m_NodeOwners[changedNode]);
+		}
+	}
+
+	void World::UpdateMeshComponents()
+	{
+		auto changedMeshes = m_Registry.view<const Mox::TransformNodeComponent, const Mox::MeshComponent, const Mox::RenderProxyLinkComponent, const Mox::TransformChangedTag>();
+
+		changedMeshes.each([this](const Mox::TransformNodeComponent& InTransformNode, const Mox::MeshComponent&, const Mox::RenderProxyLinkComponent& InProxyLink)
+		{
+			// The render thread uses the matrix to cull the drawables of the proxy and writes it in the per-instance data of the draws
+			Mox::UpdateRenderProxyTransform(*InProxyLink.m_RenderProxy, m_Transforms.GetWorldMatrix(InTransformNode.m_Node));
+		});
+	}
+
+	void World::UpdateSpatialIndex()
+	{
+		auto changedProxies = m_Registry.view<const Mox::TransformNodeComponent, const Mox::SpatialProxyComponent, const Mox::TransformChangedTag>();
+
+		// Most movements stay inside the fat bounds of the proxies and leave the index untouched
+		changedProxies.each([this](const Mox::TransformNodeComponent& InTransformNode, const Mox::SpatialProxyComponent& InSpatialProxy)
+		{
+			m_SpatialIndex.MoveProxy(InSpatialProxy.m_Proxy, InSpatialProxy.m_LocalBounds.Transformed(m_Transforms.GetWorldMatrix(InTransformNode.m_Node)));
+		});
+	}
+
+	void World::QueryFrustum(const Mox::Frustum& InFrustum, std::vector<entt::entity>& OutEntities) const
+	{
+		Mox::QueryEntities([this, &InFrustum](std::vector<uint32_t>& OutValues) { m_SpatialIndex.QueryFrustum(InFrustum, OutValues); }, OutEntities);
+	}
+
+	void World::QuerySphere(const Mox::BoundingSphere& InSphere, std::vector<entt::entity>& OutEntities) const
+	{
+		Mox::QueryEntities([this, &InSphere](std::vector<uint32_t>& OutValues) { m_SpatialIndex.QuerySphere(InSphere, OutValues); }, OutEntities);
+	}
+
+	void World::QueryAabb(const Mox::Aabb& InBox, std::vector<entt::entity>& OutEntities) const
+	{
+		Mox::QueryEntities([this, &InBox](std::vector<uint32_t>& OutValues) { m_SpatialIndex.QueryAabb(InBox, OutValues); }, OutEntities);
+	}
+
+	void World::QueryRay(const Mox::Ray& InRay, std::vector<entt::entity>& OutEntities) const
+	{
+		Mox::QueryEntities([this, &InRay](std::vector<uint32_t>& OutValues) { m_SpatialIndex.QueryRay(InRay, OutValues); }, OutEntities);
+	}
+
+}
@@ -1,15 +0,0 @@
-/*
- MoxComponent.cpp
-
- Moxie Engine - https://github.com/logins/MoxieEngine
-
- MIT License - Copyright (c) 2022 Riccardo Loggini
-*/
-
-#include "MoxComponent.h"
-
-namespace Mox {
-
-	Component::~Component() = default;
-
-}
@@ -8,44 +8,19 @@
 
 #include "MoxMeshComponent.h"
 #include "MoxGeometry.h"
-#include "Application.h"
-#include "MoxEntity.h"
 
 namespace Mox {
 
-
-
-	MeshComponent::~MeshComponent() = default;
-
-	MeshComponent::MeshComponent(DrawableCreationInfo&& InCreationInfo, Mox::Entity& InOwningEntity)
-		: m_VertexBuffer(*InCreationInfo.m_VertexBuffer), m_IndexBuffer(*InCreationInfo.m_IndexBuffer), 
-		m_OwnerEntity(InOwningEntity),
-		m_MvpBuffer(std::make_unique<Mox::ConstantBuffer>(Mox::BUFFER_ALLOC_TYPE::DYNAMIC, sizeof(Mox::Matrix4f)))
+	MeshComponent::MeshComponent(DrawableCreationInfo&& InCreationInfo)
+		: m_VertexBuffer(InCreationInfo.m_VertexBuffer), m_IndexBuffer(InCreationInfo.m_IndexBuffer)
 	{
-
-		InCreationInfo.m_BufferShaderParameters.emplace_back(Mox::HashSpName("mvp"), m_MvpBuffer.get());
-
-		m_ShaderParameters = InCreationInfo.m_BufferShaderParameters;
-		
-		Matrix4f newMvpMatrix = Application::Get()->GetViewProjectionMatrix() * m_OwnerEntity.GetModelMatrix();
-
-		m_MvpBuffer->SetData(newMvpMatrix.data(), sizeof(newMvpMatrix));
-
 		Mox::RequestDrawable(InCreationInfo);
 	}
 
-	void MeshComponent::OnPossessedBy(Mox::Entity& InEntity)
+	MeshComponent::MeshComponent(Mox::VertexBuffer* InVertexBuffer, Mox::IndexBuffer* InIndexBuffer)
+		: m_VertexBuffer(InVertexBuffer), m_IndexBuffer(InIndexBuffer)
 	{
-		
-	}
-
-	void MeshComponent::OnEntityTransformChanged(const Mox::Matrix4f& InNewModelMat)
-	{
-		// Here eventually we can have a local transform for the mesh that offsets the entity transform.
-
-		Matrix4f newMvpMatrix = Application::Get()->GetViewProjectionMatrix() * m_OwnerEntity.GetModelMatrix();
 
-		m_MvpBuffer->SetData(newMvpMatrix.data(), sizeof(newMvpMatrix));
 	}
 
 }
@@ -10,12 +10,18 @@
 #define Entity_h__
 
 #include "MoxMath.h"
+#include "SlotMap.h"
+#include "MoxWorld.h"
+#include "GraphicsUtils.h"
 
 namespace Mox {
 
 class Drawable;
 class RenderProxy;
-class Component;
+
+// Stable reference to an entity living in the simulation world.
+// Unlike Entity& it stays valid when other entities are created or destroyed, and it can tell when its entity is gone.
+using EntityHandle = Mox::SlotMapHandle;
 
 // Defines all the possible input parameters for the creation of an entity
 struct EntityCreationInfo {
@@ -33,46 +39,81 @@ struct EntityCreationInfo {
 	Mox::Vector3f WorldScale;
 };
 
-// Object existing into a World
+// Defines a group of entities to be spawned all at once (see SimulatonThread::SpawnEntities).
+// All their render data is requested to the render thread in a single batch.
+struct EntitySpawnTemplate {
+	// Transform of every spawned entity, used when no per-instance transforms are given
+	Mox::EntityCreationInfo m_CreationInfo;
+	// Per-instance transforms, when not empty it needs to contain one entry for each spawned entity
+	std::vector<Mox::EntityCreationInfo> m_InstanceCreationInfos;
+	// Mesh given to every spawned entity, entities get no mesh if the vertex buffer is null.
+	// The owning proxy is ignored, each entity gets its own drawable.
+	Mox::DrawableCreationInfo m_Mesh{};
+	// Bounds in entity space given to every spawned entity, entities are not added to the spatial index if the bounds are empty
+	Mox::Aabb m_LocalBounds;
+};
+
+// Object existing into a World.
+// Transform and render data live in the World component pools, the entity only refers to them through its id.
 class Entity
 {
 public:
 	
-	Entity(const Mox::EntityCreationInfo& InInfo);
+	Entity(const Mox::EntityCreationInfo& InInfo, Mox::World& InWorld);
+
+	// Refers to an entity that already exists in the world, whose render proxy has been requested by its creator
+	Entity(entt::entity InWorldId, Mox::World& InWorld);
 
-	// Note: I needed to define both destructor AND move constructor
-	// in the implementation file to avoid having a compile error given
-	// by forward declaring the template parameter of the unique_ptr 
-	// we are using in the member variables!
-	virtual ~Entity();
+	~Entity();
 	Entity(Entity&&) noexcept;
+	// Needed for the entity to be moved around in dense storage
+	Entity& operator=(Entity&&) noexcept;
+
+	// Components are stored by the World, in a contiguous pool for each component type
+	template<typename ComponentType, typename... ArgTypes>
+	ComponentType& AddComponent(ArgTypes&&... InArgs)
+	{
+		return m_World->AddComponent<ComponentType>(m_WorldId, std::forward<ArgTypes>(InArgs)...);
+	}
+
+	// Returns nullptr if the entity does not hold a component of the given type
+	template<typename ComponentType>
+	ComponentType* GetComponent() const
+	{
+		return m_World->GetRegistry().try_get<ComponentType>(m_WorldId);
+	}
+
+	std::shared_ptr<Mox::RenderProxy> GetRenderProxy() const;
 
-	// The entity is will take ownership of the component
-	void AddComponent(std::shared_ptr<class Mox::Component> InComponent);
+	// Note: Transform changes are applied to the model matrix when the World updates, at the end of the simulation frame
+	Mox::Matrix4f GetModelMatrix() const;
 
-	std::shared_ptr<Mox::RenderProxy> GetRenderProxy() const { return m_RenderProxy; };
+	Mox::World& GetWorld() const { return *m_World; }
 
-	inline Mox::Matrix4f GetModelMatrix() const { return m_WorldMatrix; }
+	entt::entity GetWorldId() const { return m_WorldId; }
 
+	// Makes the entity transform relative to the parent one.
+	// The local transform is kept, so the entity will move to the same offset from the new parent.
+	void AttachTo(const Entity& InParent);
+
+	// The entity transform becomes relative to the world origin
+	void Detach();
+
+	// Transform changes are relative to the parent entity, if any
 	void Rotate(float InAngleX, float InAngleY);
 
 	void Translate(float InX, float InY, float InZ);
 
 	void SetScale(float InX, float InY, float InZ);
 
-private:
-
-	void OnTransformChanged();
-
-	std::vector<std::shared_ptr<class Mox::Component>> m_Components;
+	// Bounds in entity space, used to find the entity with the world spatial queries
+	void SetLocalBounds(const Mox::Aabb& InLocalBounds);
 
-	Mox::Matrix4f m_WorldMatrix;
+private:
 
-	Mox::Vector3f m_WorldPos;
-	Mox::Matrix3f m_WorldRot;
-	Mox::Matrix3f m_WorldScale;
+	Mox::World* m_World;
 
-	std::shared_ptr<Mox::RenderProxy> m_RenderProxy;
+	entt::entity m_WorldId;
 };
 
 }
@@ -9,35 +9,30 @@
 #ifndef MoxMeshComponent_h__
 #define MoxMeshComponent_h__
 
-#include "MoxComponent.h"
-
+#include "MoxMath.h"
+#include "GraphicsUtils.h"
 
 namespace Mox {
 
 struct DrawableCreationInfo;
 
-class MeshComponent : public Component
+// Renderable geometry attached to an entity.
+// Mesh components are stored contiguously in the World pool of their type and, being plain data without virtual functions,
+// all the ones whose entity moved are updated in a single pass by the World.
+class MeshComponent
 {
 public:
-	MeshComponent(DrawableCreationInfo&& InCreationInfo, Mox::Entity& InOwningEntity);
-
-	virtual ~MeshComponent();
-
-	void OnPossessedBy(class Mox::Entity& InEntity) override;
-
+	MeshComponent(DrawableCreationInfo&& InCreationInfo);
 
-	void OnEntityTransformChanged(const Mox::Matrix4f& InNewModelMat) override;
+	// The drawable is not requested here, 
+	// the creator of the component is expected to request it in a batch together with other components (see World::SpawnEntities)
+	MeshComponent(Mox::VertexBuffer* InVertexBuffer, Mox::IndexBuffer* InIndexBuffer);
 
 private:
-	Mox::VertexBuffer& m_VertexBuffer;
-	Mox::IndexBuffer& m_IndexBuffer;
-
-	BufferMeshParams m_ShaderParameters;
-
-	std::unique_ptr<Mox::ConstantBuffer> m_MvpBuffer;
-
-
-	Mox::Entity& m_OwnerEntity;
+	// Note: The model matrix is not stored in a buffer of the component, the render proxy keeps it and the render passes
+	// write it in their per-instance data
+	Mox::VertexBuffer* m_VertexBuffer;
+	Mox::IndexBuffer* m_IndexBuffer;
 
 	MeshComponent() = delete;
 };
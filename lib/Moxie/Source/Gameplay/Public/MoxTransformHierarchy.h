@@ -0,0 +1,116 @@
+/*
+ MoxTransformHierarchy.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef MoxTransformHierarchy_h__
+#define MoxTransformHierarchy_h__
+
+#include <vector>
+#include <limits>
+#include "MoxMath.h"
+
+namespace Mox {
+
+	// Stable identifier of a node in a TransformHierarchy, it does not change when nodes get reordered
+	using TransformNodeId = uint32_t;
+
+	/*
+	* Parent/child hierarchy of transforms, stored in structure-of-arrays form.
+	* - Each node property lives in its own contiguous array, indexed by the node position.
+	* - Nodes are kept sorted by depth, so parents always come before their children and a single
+	*   forward pass over the arrays is enough to propagate transforms down the hierarchy.
+	* - Setting a transform only flags the node as dirty. World matrices are computed once per frame by Update(),
+	*   only for the dirty nodes and their subtrees, no matter how many times a node was changed in the meantime.
+	*/
+	class TransformHierarchy
+	{
+	public:
+		static constexpr TransformNodeId InvalidNode = std::numeric_limits<TransformNodeId>::max();
+
+		// The world matrix of the new node is computed straight away, from the current world matrix of the parent
+		TransformNodeId CreateNode(const Mox::Vector3f& InLocalPosition, const Mox::Matrix3f& InLocalRotation, const Mox::Vector3f& InLocalScale,
+			TransformNodeId InParent = InvalidNode);
+
+		// Makes room for the given number of nodes on top of the current ones, so they can be created without reallocations
+		void ReserveNewNodes(size_t InNewNodesNum);
+
+		// Children of the destroyed node become roots, keeping their local transform
+		void DestroyNode(TransformNodeId InNode);
+
+		// Use InvalidNode as parent to make the node a root
+		void SetParent(TransformNodeId InNode, TransformNodeId InNewParent);
+
+		TransformNodeId GetParent(TransformNodeId InNode) const { return m_ParentIds[m_IdToIndex[InNode]]; }
+
+		void SetLocalPosition(TransformNodeId InNode, const Mox::Vector3f& InPosition);
+
+		void Translate(TransformNodeId InNode, const Mox::Vector3f& InOffset);
+
+		// The given rotation is applied on top of the current local rotation
+		void Rotate(TransformNodeId InNode, const Mox::Matrix3f& InRotation);
+
+		void SetLocalScale(TransformNodeId InNode, const Mox::Vector3f& InScale);
+
+		const Mox::Vector3f& GetLocalPosition(TransformNodeId InNode) const { return m_LocalPositions[m_IdToIndex[InNode]]; }
+
+		const Mox::Matrix3f& GetLocalRotation(TransformNodeId InNode) const { return m_LocalRotations[m_IdToIndex[InNode]]; }
+
+		const Mox::Vector3f& GetLocalScale(TransformNodeId InNode) const { return m_LocalScales[m_IdToIndex[InNode]]; }
+
+		// Note: It reflects the changes made to the hierarchy only after the next Update()
+		const Mox::Matrix4f& GetWorldMatrix(TransformNodeId InNode) const { return m_WorldMatrices[m_IdToIndex[InNode]]; }
+
+		// Computes the world matrices of all the nodes changed since the last update, together with their subtrees
+		void Update();
+
+		// Nodes which world matrix got recomputed by the last Update()
+		const std::vector<TransformNodeId>& GetChangedNodes() const { return m_ChangedNodes; }
+
+		size_t GetNodesNum() const { return m_NodeIds.size() - m_DestroyedIds.size(); }
+
+	private:
+
+		void MarkDirty(TransformNodeId InNode) { m_DirtyFlags[m_IdToIndex[InNode]] = 1; }
+
+		bool IsDescendantOf(TransformNodeId InNode, TransformNodeId InAncestor) const;
+
+		// Removes destroyed nodes and restores the depth order after reparenting
+		void Reorder();
+
+		// ----- Per node data, indexed by node position -----
+
+		std::vector<TransformNodeId> m_NodeIds;
+		std::vector<TransformNodeId> m_ParentIds;
+		// Position of the parent node in these arrays, used by the update pass to avoid going through the id table
+		std::vector<uint32_t> m_ParentIndices;
+		std::vector<uint32_t> m_Depths;
+		std::vector<Mox::Vector3f> m_LocalPositions;
+		std::vector<Mox::Matrix3f> m_LocalRotations;
+		std::vector<Mox::Vector3f> m_LocalScales;
+		std::vector<Mox::Matrix4f> m_WorldMatrices;
+		std::vector<uint8_t> m_DirtyFlags;
+
+		// ----- Id bookkeeping -----
+
+		std::vector<uint32_t> m_IdToIndex;
+		std::vector<TransformNodeId> m_FreeIds;
+
+		// Destroyed nodes stay in the arrays, flagged with an invalid id, until the next reorder.
+		// Only then their ids can be reused.
+		std::vector<TransformNodeId> m_DestroyedIds;
+		bool m_NeedsReorder = false;
+
+		std::vector<TransformNodeId> m_ChangedNodes;
+
+		// Scratch arrays for the world matrices concatenation, kept to avoid reallocating them every update
+		std::vector<uint32_t> m_ConcatTargets;
+		std::vector<uint32_t> m_ConcatParents;
+	};
+
+}
+
+#endif // MoxTransformHierarchy_h__
@@ -0,0 +1,136 @@
+/*
+ MoxWorld.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef MoxWorld_h__
+#define MoxWorld_h__
+
+#include <entt/entity/registry.hpp>
+#include "MoxMath.h"
+#include "MoxTransformHierarchy.h"
+#include "MoxDynamicBvh.h"
+
+namespace Mox {
+
+	class RenderProxy;
+	class ConstantBuffer;
+	struct EntityCreationInfo;
+	struct EntitySpawnTemplate;
+
+	// ----- World Components -----
+	// Plain data stored in EnTT pools, each type in its own contiguous array.
+
+	// Node of the entity in the world transform hierarchy, which holds the actual transform data
+	struct TransformNodeComponent
+	{
+		Mox::TransformNodeId m_Node;
+	};
+
+	// Marks entities whose world matrix changed during the current frame, either directly or because of a parent
+	struct TransformChangedTag { };
+
+	// Link to the render thread representation of the entity
+	struct RenderProxyLinkComponent
+	{
+		std::shared_ptr<Mox::RenderProxy> m_RenderProxy;
+	};
+
+	// Entry of the entity in the world spatial index. Entities without it are not found by spatial queries.
+	struct SpatialProxyComponent
+	{
+		Mox::BvhProxyId m_Proxy;
+		// Bounds in entity space, the index stores them transformed by the world matrix
+		Mox::Aabb m_LocalBounds;
+	};
+
+	/*
+	* Holds the data of all the entities in the simulation, in data-oriented form.
+	* Entity data is stored by component type in EnTT pools, and the world systems iterate them as views.
+	* Transforms are stored in a TransformHierarchy: changes only mark nodes as dirty,
+	* the resulting matrices and buffers are computed once per frame by Update().
+	* Entities with bounds are kept in a bounding volume hierarchy, so that spatial queries do not need to scan all the entities.
+	*/
+	class World
+	{
+	public:
+
+		entt::entity CreateEntity(const Mox::EntityCreationInfo& InInfo);
+
+		// Creates all the entities described by the template, with their components, 
+		// and requests their render data to the render thread as a single batch.
+		std::vector<entt::entity> SpawnEntities(size_t InCount, const Mox::EntitySpawnTemplate& InTemplate);
+
+		void DestroyEntity(entt::entity InEntity);
+
+		// Use entt::null as parent to detach the entity
+		void SetParent(entt::entity InEntity, entt::entity InParent);
+
+		// Constructs the component in the pool of its type. An entity can hold at most one component of each type.
+		// The new component is notified of the entity transform together with the others of its type, on the next Update().
+		template<typename ComponentType, typename... ArgTypes>
+		ComponentType& AddComponent(entt::entity InEntity, ArgTypes&&... InArgs)
+		{
+			m_Registry.emplace_or_replace<Mox::TransformChangedTag>(InEntity);
+
+			return m_Registry.emplace<ComponentType>(InEntity, std::forward<ArgTypes>(InArgs)...);
+		}
+
+		// Adds the entity to the spatial index, or updates its bounds if it was already there
+		void SetLocalBounds(entt::entity InEntity, const Mox::Aabb& InLocalBounds);
+
+		// Runs the world systems, meant to be called once per simulation frame
+		void Update();
+
+		// ----- Spatial Queries -----
+		// Append the entities whose bounds overlap the query volume, in no particular order.
+		// Bounds are the ones computed by the last Update() and they are enlarged by a small margin, so results are conservative.
+
+		void QueryFrustum(const Mox::Frustum& InFrustum, std::vector<entt::entity>& OutEntities) const;
+
+		void QuerySphere(const Mox::BoundingSphere& InSphere, std::vector<entt::entity>& OutEntities) const;
+
+		void QueryAabb(const Mox::Aabb& InBox, std::vector<entt::entity>& OutEntities) const;
+
+		void QueryRay(const Mox::Ray& InRay, std::vector<entt::entity>& OutEntities) const;
+
+		const Mox::DynamicBvh& GetSpatialIndex() const { return m_SpatialIndex; }
+
+		entt::registry& GetRegistry() { return m_Registry; }
+		const entt::registry& GetRegistry() const { return m_Registry; }
+
+		Mox::TransformHierarchy& GetTransforms() { return m_Transforms; }
+		const Mox::TransformHierarchy& GetTransforms() const { return m_Transforms; }
+
+		Mox::TransformNodeId GetTransformNode(entt::entity InEntity) const { return m_Registry.get<Mox::TransformNodeComponent>(InEntity).m_Node; }
+
+	private:
+
+		// Returns the node of the new transform, with the world matrix already computed
+		Mox::TransformNodeId CreateTransformNode(entt::entity InEntity, const Mox::EntityCreationInfo& InInfo);
+
+		// ----- Systems -----
+
+		void UpdateTransforms();
+
+		void UpdateMeshComponents();
+
+		void UpdateSpatialIndex();
+
+		entt::registry m_Registry;
+
+		Mox::TransformHierarchy m_Transforms;
+
+		// Entity owning each transform node, indexed by node id
+		std::vector<entt::entity> m_NodeOwners;
+
+		// Spatial index of the entities with bounds, leaves store the entity id
+		Mox::DynamicBvh m_SpatialIndex;
+	};
+
+}
+
+#endif // MoxWorld_h__
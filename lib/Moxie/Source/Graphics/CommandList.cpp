@@ -8,6 +8,8 @@
  
 #include "CommandList.h"
 #include "Public/GraphicsTypes.h"
+#include "PipelineState.h"
+#include "MoxUtils.h"
 
 namespace Mox { 
 
@@ -18,4 +20,328 @@ namespace Mox {
 
 	}
 
+	void CommandList::Close()
+	{
+		FlushResourceBarriers();
+
+		Close_Internal();
+	}
+
+	void CommandList::TransitionResource(Mox::Resource& InResource, Mox::RESOURCE_STATE InState, uint32_t InSubresource /*= Mox::ALL_SUBRESOURCES*/)
+	{
+		if (InSubresource == Mox::ALL_SUBRESOURCES && !InResource.HasUniformTrackedState())
+		{
+			// A single transition for the whole resource requires every subresource to be in the same state, so each one is transitioned on its own
+			for (uint32_t subresourceIdx = 0; subresourceIdx < InResource.GetSubresourcesNum(); ++subresourceIdx)
+			{
+				if (m_CanTransitionResources)
+				{
+					RequestTransition(InResource, subresourceIdx, InState);
+				}
+				else
+				{
+					DecayOnCopyQueue(InResource, subresourceIdx);
+				}
+			}
+
+			return;
+		}
+
+		if (m_CanTransitionResources)
+		{
+			RequestTransition(InResource, InSubresource, InState);
+		}
+		else
+		{
+			DecayOnCopyQueue(InResource, InSubresource);
+		}
+	}
+
+	void CommandList::DecayOnCopyQueue(Mox::Resource& InResource, uint32_t InSubresource)
+	{
+		// Resources left in a read or write state by another queue need to be brought back to neutral there, before the copy queue can use them
+		const Mox::RESOURCE_STATE currentState = InResource.GetTrackedState(InSubresource);
+		Check(currentState == Mox::RESOURCE_STATE::NEUTRAL || currentState == Mox::RESOURCE_STATE::COPY_DEST || currentState == Mox::RESOURCE_STATE::COPY_SOURCE)
+
+		InResource.SetTrackedState(Mox::RESOURCE_STATE::NEUTRAL, InSubresource);
+	}
+
+	void CommandList::RequestTransition(Mox::Resource& InResource, uint32_t InSubresource, Mox::RESOURCE_STATE InState)
+	{
+		const Mox::RESOURCE_STATE currentState = InResource.GetTrackedState(InSubresource);
+		if (currentState == InState)
+		{
+			m_SkippedTransitionsNum++;
+			return;
+		}
+
+		InResource.SetTrackedState(InState, InSubresource);
+
+		// No command used the resource since the pending transition was requested, so the two can be merged in one
+		for (auto pendingIt = m_PendingTransitions.begin(); pendingIt != m_PendingTransitions.end(); ++pendingIt)
+		{
+			if (pendingIt->m_Resource == &InResource && pendingIt->m_Subresource == InSubresource)
+			{
+				pendingIt->m_After = InState;
+				if (pendingIt->m_Before == pendingIt->m_After)
+				{
+					m_PendingTransitions.erase(pendingIt);
+				}
+
+				m_SkippedTransitionsNum++;
+				return;
+			}
+		}
+
+		m_PendingTransitions.push_back({ &InResource, InSubresource, currentState, InState });
+	}
+
+	void CommandList::FlushResourceBarriers()
+	{
+		if (!m_PendingTransitions.empty())
+		{
+			ResourceBarriers_Internal(m_PendingTransitions);
+			m_PendingTransitions.clear();
+		}
+	}
+
+	void CommandList::AliasingBarriers(const std::vector<Mox::Resource*>& InResources)
+	{
+		// Transitions requested before refer to the resources that were using the memory until now
+		FlushResourceBarriers();
+
+		AliasingBarriers_Internal(InResources);
+	}
+
+	void CommandList::DiscardResources(const std::vector<Mox::Resource*>& InResources)
+	{
+		FlushResourceBarriers();
+
+		DiscardResources_Internal(InResources);
+	}
+
+	void CommandList::ClearRTV(Mox::CpuDescHandle& InDescHandle, float* InColor)
+	{
+		FlushResourceBarriers();
+
+		ClearRTV_Internal(InDescHandle, InColor);
+	}
+
+	void CommandList::ClearDepth(Mox::CpuDescHandle& InDescHandle)
+	{
+		FlushResourceBarriers();
+
+		ClearDepth_Internal(InDescHandle);
+	}
+
+	void CommandList::DrawIndexed(uint64_t InIndexCountPerInstance, uint32_t InInstancesNum /*= 1*/)
+	{
+		FlushResourceBarriers();
+
+		DrawIndexed_Internal(InIndexCountPerInstance, InInstancesNum);
+	}
+
+	void CommandList::Dispatch(uint32_t InGroupsNumX, uint32_t InGroupsNumY, uint32_t InGroupsNumZ)
+	{
+		FlushResourceBarriers();
+
+		Dispatch_Internal(InGroupsNumX, InGroupsNumY, InGroupsNumZ);
+	}
+
+	void CommandList::UploadBufferData(Mox::BufferResource& DestinationBuffer, Mox::BufferResource& IntermediateBuffer, const void* InBufferData, size_t InDataSize)
+	{
+		FlushResourceBarriers();
+
+		UploadBufferData_Internal(DestinationBuffer, IntermediateBuffer, InBufferData, InDataSize);
+	}
+
+	void CommandList::SetPipelineStateAndResourceBinder(Mox::PipelineState& InPipelineState)
+	{
+		if (&InPipelineState != m_BoundPipelineState)
+		{
+			SetPipelineState_Internal(InPipelineState);
+			m_BoundPipelineState = &InPipelineState;
+		}
+		else
+		{
+			m_SkippedBindsNum++;
+		}
+
+		// Different pipeline states can share the same resource binder, in which case the root arguments stay valid
+		const void* resourceBinder = InPipelineState.GetResourceBinderHandle();
+		const void*& boundResourceBinder = InPipelineState.IsGraphics() ? m_BoundGraphicsResourceBinder : m_BoundComputeResourceBinder;
+		if (resourceBinder != boundResourceBinder)
+		{
+			SetResourceBinder_Internal(InPipelineState);
+			boundResourceBinder = resourceBinder;
+
+			if (InPipelineState.IsGraphics())
+			{
+				InvalidateGraphicsRootArguments();
+			}
+		}
+		else
+		{
+			m_SkippedBindsNum++;
+		}
+
+		// Descriptor heaps are the same for every pipeline state, they only need to be bound once per recording
+		if (!m_AreDescriptorHeapsBound)
+		{
+			SetDescriptorHeaps_Internal();
+			m_AreDescriptorHeapsBound = true;
+		}
+		else
+		{
+			m_SkippedBindsNum++;
+		}
+	}
+
+	void CommandList::SetInputAssemblerData(Mox::PRIMITIVE_TOPOLOGY InPrimTopology, Mox::VertexBufferView& InVertexBufView, Mox::IndexBufferView& InIndexBufView)
+	{
+		if (InPrimTopology != m_BoundTopology)
+		{
+			SetPrimitiveTopology_Internal(InPrimTopology);
+			m_BoundTopology = InPrimTopology;
+		}
+		else
+		{
+			m_SkippedBindsNum++;
+		}
+
+		if (&InVertexBufView != m_BoundVertexBufferView)
+		{
+			SetVertexBuffer_Internal(InVertexBufView);
+			m_BoundVertexBufferView = &InVertexBufView;
+		}
+		else
+		{
+			m_SkippedBindsNum++;
+		}
+
+		if (&InIndexBufView != m_BoundIndexBufferView)
+		{
+			SetIndexBuffer_Internal(InIndexBufView);
+			m_BoundIndexBufferView = &InIndexBufView;
+		}
+		else
+		{
+			m_SkippedBindsNum++;
+		}
+	}
+
+	void CommandList::SetGraphicsRootConstants(uint64_t InRootParameterIndex, uint64_t InNum32BitValuesToSet, const void* InSrcData, uint64_t InDestOffsetIn32BitValues)
+	{
+		Check(InRootParameterIndex < MaxRootArgumentsNum)
+
+		const uint32_t* srcValues = static_cast<const uint32_t*>(InSrcData);
+		std::vector<uint32_t>& boundValues = m_BoundGraphicsRootConstants[InRootParameterIndex];
+
+		if (!boundValues.empty() && m_BoundGraphicsRootConstantsOffsets[InRootParameterIndex] == InDestOffsetIn32BitValues
+			&& boundValues.size() == InNum32BitValuesToSet && std::equal(boundValues.begin(), boundValues.end(), srcValues))
+		{
+			m_SkippedBindsNum++;
+			return;
+		}
+
+		boundValues.assign(srcValues, srcValues + InNum32BitValuesToSet);
+		m_BoundGraphicsRootConstantsOffsets[InRootParameterIndex] = InDestOffsetIn32BitValues;
+
+		SetGraphicsRootConstants_Internal(InRootParameterIndex, InNum32BitValuesToSet, InSrcData, InDestOffsetIn32BitValues);
+	}
+
+	void CommandList::SetGraphicsRootTable(uint32_t InRootIndex, Mox::ConstantBufferView& InView)
+	{
+		if (BindGraphicsRootArgument(InRootIndex, reinterpret_cast<uint64_t>(&InView)))
+		{
+			SetGraphicsRootTable_Internal(InRootIndex, InView);
+		}
+	}
+
+	void CommandList::SetGraphicsRootShaderResource(uint32_t InRootIndex, Mox::GPU_V_ADDRESS InBufferLocation)
+	{
+		if (BindGraphicsRootArgument(InRootIndex, InBufferLocation))
+		{
+			SetGraphicsRootShaderResource_Internal(InRootIndex, InBufferLocation);
+		}
+	}
+
+	void CommandList::StageDynamicCbv(uint32_t InRootIndex, Mox::ConstantBufferView& InCbv)
+	{
+		Check(InRootIndex < MaxRootArgumentsNum)
+
+		// Dynamic descriptors are copied to a new location on commit, so the table will not match any previously bound one
+		m_BoundGraphicsRootArguments[InRootIndex] = 0;
+
+		StageDynamicCbv_Internal(InRootIndex, InCbv);
+	}
+
+	void CommandList::ReferenceSRV(uint32_t InRootIdx, Mox::ShaderResourceView& InSRV)
+	{
+		if (BindGraphicsRootArgument(InRootIdx, reinterpret_cast<uint64_t>(&InSRV)))
+		{
+			ReferenceSRV_Internal(InRootIdx, InSRV);
+		}
+	}
+
+	void CommandList::ReferenceCBV(uint32_t InRootIdx, Mox::ConstantBufferView& InCBV)
+	{
+		if (BindGraphicsRootArgument(InRootIdx, reinterpret_cast<uint64_t>(&InCBV)))
+		{
+			ReferenceCBV_Internal(InRootIdx, InCBV);
+		}
+	}
+
+	void CommandList::ReferenceViewsHeap(uint32_t InRootIdx)
+	{
+		if (BindGraphicsRootArgument(InRootIdx, ViewsHeapRootArgument))
+		{
+			ReferenceViewsHeap_Internal(InRootIdx);
+		}
+	}
+
+	void CommandList::ResetBoundState()
+	{
+		m_BoundPipelineState = nullptr;
+		m_BoundGraphicsResourceBinder = nullptr;
+		m_BoundComputeResourceBinder = nullptr;
+		m_AreDescriptorHeapsBound = false;
+
+		m_BoundTopology = Mox::PRIMITIVE_TOPOLOGY::PT_UNDEFINED;
+		m_BoundVertexBufferView = nullptr;
+		m_BoundIndexBufferView = nullptr;
+
+		InvalidateGraphicsRootArguments();
+
+		m_SkippedBindsNum = 0;
+
+		// Tracked states already account for pending transitions, so they are expected to be recorded before closing the list
+		Check(m_PendingTransitions.empty())
+		m_SkippedTransitionsNum = 0;
+	}
+
+	bool CommandList::BindGraphicsRootArgument(uint32_t InRootIdx, uint64_t InValue)
+	{
+		Check(InRootIdx < MaxRootArgumentsNum)
+
+		if (m_BoundGraphicsRootArguments[InRootIdx] == InValue)
+		{
+			m_SkippedBindsNum++;
+			return false;
+		}
+
+		m_BoundGraphicsRootArguments[InRootIdx] = InValue;
+		return true;
+	}
+
+	void CommandList::InvalidateGraphicsRootArguments()
+	{
+		m_BoundGraphicsRootArguments.fill(0);
+
+		for (std::vector<uint32_t>& rootConstants : m_BoundGraphicsRootConstants)
+		{
+			rootConstants.clear();
+		}
+	}
+
 }
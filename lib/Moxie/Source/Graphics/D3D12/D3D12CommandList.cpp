@@ -22,63 +22,98 @@ namespace Mox {
 	D3D12CommandList::D3D12CommandList(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> InCmdList, Mox::Device& InOwningDevice) 
 		: CommandList(InOwningDevice), m_D3D12CmdList(InCmdList)
 	{
+		m_CanTransitionResources = m_D3D12CmdList->GetType() != D3D12_COMMAND_LIST_TYPE_COPY;
 	}
 
-	void D3D12CommandList::ResourceBarriers(const TransitionInfoVector& InTransitions)
+	void D3D12CommandList::ResourceBarriers_Internal(const std::vector<Mox::ResourceTransition>& InTransitions)
 	{
 		std::vector<D3D12_RESOURCE_BARRIER> transitionBarriers; transitionBarriers.reserve(InTransitions.size());
-		Mox::Resource* targetResource; Mox::RESOURCE_STATE beforeState; Mox::RESOURCE_STATE afterState;
-		for (const auto& curTransition : InTransitions)
+		for (const Mox::ResourceTransition& curTransition : InTransitions)
 		{
-			auto [targetResource, beforeState, afterState] = curTransition;
+			const UINT subresource = curTransition.m_Subresource == Mox::ALL_SUBRESOURCES ? D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES : curTransition.m_Subresource;
 			transitionBarriers.emplace_back(
 				CD3DX12_RESOURCE_BARRIER::Transition(
-					static_cast<Mox::D3D12Resource*>(targetResource)->GetInner().Get(),
-					Mox::ResStateTypeToD3D12(beforeState), Mox::ResStateTypeToD3D12(afterState))
+					static_cast<Mox::D3D12Resource*>(curTransition.m_Resource)->GetInner().Get(),
+					Mox::ResStateTypeToD3D12(curTransition.m_Before), Mox::ResStateTypeToD3D12(curTransition.m_After), subresource)
 			);
 		}
 
 		m_D3D12CmdList->ResourceBarrier(transitionBarriers.size(), static_cast<D3D12_RESOURCE_BARRIER*>(transitionBarriers.data()));
 	}
 
-	void D3D12CommandList::ClearRTV(Mox::CpuDescHandle& InDescHandle, float* InColor)
+	void D3D12CommandList::AliasingBarriers_Internal(const std::vector<Mox::Resource*>& InResources)
+	{
+		std::vector<D3D12_RESOURCE_BARRIER> aliasingBarriers; aliasingBarriers.reserve(InResources.size());
+		for (Mox::Resource* curResource : InResources)
+		{
+			// Null before resource: any resource that was using the same memory
+			aliasingBarriers.emplace_back(
+				CD3DX12_RESOURCE_BARRIER::Aliasing(nullptr, static_cast<Mox::D3D12Resource*>(curResource)->GetInner().Get())
+			);
+		}
+
+		m_D3D12CmdList->ResourceBarrier(aliasingBarriers.size(), aliasingBarriers.data());
+	}
+
+	void D3D12CommandList::DiscardResources_Internal(const std::vector<Mox::Resource*>& InResources)
+	{
+		for (Mox::Resource* curResource : InResources)
+		{
+			// Null region: the whole resource
+			m_D3D12CmdList->DiscardResource(static_cast<Mox::D3D12Resource*>(curResource)->GetInner().Get(), nullptr);
+		}
+	}
+
+	void D3D12CommandList::ClearRTV_Internal(Mox::CpuDescHandle& InDescHandle, float* InColor)
 	{
 		m_D3D12CmdList->ClearRenderTargetView(static_cast<Mox::D3D12CpuDescriptorHandle&>(InDescHandle).GetInner(), InColor, 0, nullptr);
 	}
 
-	void D3D12CommandList::ClearDepth(Mox::CpuDescHandle& InDescHandle)
+	void D3D12CommandList::ClearDepth_Internal(Mox::CpuDescHandle& InDescHandle)
 	{
 		m_D3D12CmdList->ClearDepthStencilView(static_cast<Mox::D3D12CpuDescriptorHandle&>(InDescHandle).GetInner(), D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
 
 	}
 
-	void D3D12CommandList::Close()
+	void D3D12CommandList::Close_Internal()
 	{
 		m_D3D12CmdList->Close();
 	}
 
-	void D3D12CommandList::SetPipelineStateAndResourceBinder(Mox::PipelineState& InPipelineState)
+	void D3D12CommandList::SetPipelineState_Internal(Mox::PipelineState& InPipelineState)
 	{
-		Mox::D3D12PipelineState& d3d12PSO = static_cast<Mox::D3D12PipelineState&>(InPipelineState);
+		m_D3D12CmdList->SetPipelineState(static_cast<Mox::D3D12PipelineState&>(InPipelineState).GetInnerPSO().Get());
+	}
 
-		// Set PSO
-		m_D3D12CmdList->SetPipelineState(d3d12PSO.GetInnerPSO().Get());
+	void D3D12CommandList::SetResourceBinder_Internal(Mox::PipelineState& InPipelineState)
+	{
+		Mox::D3D12PipelineState& d3d12PSO = static_cast<Mox::D3D12PipelineState&>(InPipelineState);
 
 		// Set root signature
 		if(InPipelineState.IsGraphics())
 			m_D3D12CmdList->SetGraphicsRootSignature(d3d12PSO.GetInnerRootSignature().Get());
 		else
 			m_D3D12CmdList->SetComputeRootSignature(d3d12PSO.GetInnerRootSignature().Get());
+	}
 
+	void D3D12CommandList::SetDescriptorHeaps_Internal()
+	{
 		// Bind descriptor heap(s)
 		m_D3D12CmdList->SetDescriptorHeaps(1, static_cast<Mox::D3D12GraphicsAllocator*>(Mox::GraphicsAllocator::Get())->GetDescriptorsGpuHeap().GetInner().GetAddressOf());
-
 	}
 
-	void D3D12CommandList::SetInputAssemblerData(Mox::PRIMITIVE_TOPOLOGY InPrimTopology, Mox::VertexBufferView& InVertexBufView, Mox::IndexBufferView& InIndexBufView)
+	void D3D12CommandList::SetPrimitiveTopology_Internal(Mox::PRIMITIVE_TOPOLOGY InPrimTopology)
 	{
 		m_D3D12CmdList->IASetPrimitiveTopology(Mox::PrimitiveTopoToD3D12(InPrimTopology));
+	}
+
+	void D3D12CommandList::SetVertexBuffer_Internal(Mox::VertexBufferView& InVertexBufView)
+	{
 		m_D3D12CmdList->IASetVertexBuffers(0, 1, &static_cast<Mox::D3D12VertexBufferView&>(InVertexBufView).m_VertexBufferView);
+	}
+
+	void D3D12CommandList::SetIndexBuffer_Internal(Mox::IndexBufferView& InIndexBufView)
+	{
 		m_D3D12CmdList->IASetIndexBuffer(&static_cast<Mox::D3D12IndexBufferView&>(InIndexBufView).m_IndexBufferView);
 	}
 
@@ -95,7 +130,7 @@ namespace Mox {
 		m_D3D12CmdList->OMSetRenderTargets(1, &d3d12Window.GetCurrentRTVDescHandle(), FALSE, &d3d12Window.GetCuttentDSVDescHandle());
 	}
 
-	void D3D12CommandList::SetGraphicsRootConstants(uint64_t InRootParameterIndex, uint64_t InNum32BitValuesToSet, const void* InSrcData, uint64_t InDestOffsetIn32BitValues)
+	void D3D12CommandList::SetGraphicsRootConstants_Internal(uint64_t InRootParameterIndex, uint64_t InNum32BitValuesToSet, const void* InSrcData, uint64_t InDestOffsetIn32BitValues)
 	{
 		m_D3D12CmdList->SetGraphicsRoot32BitConstants(InRootParameterIndex, InNum32BitValuesToSet, InSrcData, InDestOffsetIn32BitValues);
 	}
@@ -105,26 +140,31 @@ namespace Mox {
 		m_D3D12CmdList->SetComputeRoot32BitConstants(InRootParameterIndex, InNum32BitValuesToSet, InSrcData, InDestOffsetIn32BitValues);
 	}
 
-	void D3D12CommandList::DrawIndexed(uint64_t InIndexCountPerInstance)
+	void D3D12CommandList::DrawIndexed_Internal(uint64_t InIndexCountPerInstance, uint32_t InInstancesNum)
 	{
 
 		// Now that the descriptors are in GPU we can reference the relative views in the pipeline
-		m_D3D12CmdList->DrawIndexedInstanced(InIndexCountPerInstance, 1, 0, 0, 0);
+		m_D3D12CmdList->DrawIndexedInstanced(InIndexCountPerInstance, InInstancesNum, 0, 0, 0);
 	}
 
-	void D3D12CommandList::Dispatch(uint32_t InGroupsNumX, uint32_t InGroupsNumY, uint32_t InGroupsNumZ)
+	void D3D12CommandList::Dispatch_Internal(uint32_t InGroupsNumX, uint32_t InGroupsNumY, uint32_t InGroupsNumZ)
 	{
 		// TODO commit staged descriptors for compute (but in this series of examples we are not using them)
 
 		m_D3D12CmdList->Dispatch(InGroupsNumX, InGroupsNumY, InGroupsNumZ);
 	}
 
-	void D3D12CommandList::SetGraphicsRootTable(uint32_t InRootIndex, Mox::ConstantBufferView& InView)
+	void D3D12CommandList::SetGraphicsRootTable_Internal(uint32_t InRootIndex, Mox::ConstantBufferView& InView)
 	{
 		m_D3D12CmdList->SetGraphicsRootDescriptorTable(InRootIndex, static_cast<Mox::D3D12ConstantBufferView&>(InView).m_GpuAllocatedRange->m_FirstGpuHandle);
 	}
 
-	void D3D12CommandList::UploadBufferData(Mox::BufferResource& DestinationBuffer, Mox::BufferResource& IntermediateBuffer, const void* InBufferData, size_t InDataSize)
+	void D3D12CommandList::SetGraphicsRootShaderResource_Internal(uint32_t InRootIndex, Mox::GPU_V_ADDRESS InBufferLocation)
+	{
+		m_D3D12CmdList->SetGraphicsRootShaderResourceView(InRootIndex, InBufferLocation);
+	}
+
+	void D3D12CommandList::UploadBufferData_Internal(Mox::BufferResource& DestinationBuffer, Mox::BufferResource& IntermediateBuffer, const void* InBufferData, size_t InDataSize)
 	{
 		// Now that both copy and dest resource are created on CPU, we can use them to update the corresponding GPU SubResource
 		D3D12_SUBRESOURCE_DATA subresourceData = {};
@@ -152,20 +192,25 @@ namespace Mox {
 		d3d12Uav.m_GpuAllocatedRange = static_cast<Mox::D3D12GraphicsAllocator*>(Mox::GraphicsAllocator::Get())->GetDescriptorsGpuHeap().AllocateStaticRange(1, d3d12Uav.GetCPUDescHandle()); // Note: we are assuming Uav too always reference a range of 1 descriptors
 	}
 
-	void D3D12CommandList::ReferenceSRV(uint32_t InRootIdx, Mox::ShaderResourceView& InSRV)
+	void D3D12CommandList::ReferenceSRV_Internal(uint32_t InRootIdx, Mox::ShaderResourceView& InSRV)
 	{
 		// TODO this will work for graphics command list only, it would also need to work for compute... so we would need to know the type of operation we are executing...
 
 		m_D3D12CmdList->SetGraphicsRootDescriptorTable(InRootIdx, static_cast<Mox::D3D12ShaderResourceView&>(InSRV).GetGPUDescHandle());
 	}
 
-	void D3D12CommandList::ReferenceCBV(uint32_t InRootIdx, Mox::ConstantBufferView& InCBV)
+	void D3D12CommandList::ReferenceCBV_Internal(uint32_t InRootIdx, Mox::ConstantBufferView& InCBV)
 	{
 		// TODO this is the same operation done in ReferenceSRV .. would it be worth to merge them as ReferenceResource(..) function?
 
 		m_D3D12CmdList->SetGraphicsRootDescriptorTable(InRootIdx, static_cast<Mox::D3D12ConstantBufferView&>(InCBV).GetGpuDescHandle());
 	}
 
+	void D3D12CommandList::ReferenceViewsHeap_Internal(uint32_t InRootIdx)
+	{
+		m_D3D12CmdList->SetGraphicsRootDescriptorTable(InRootIdx, static_cast<Mox::D3D12GraphicsAllocator*>(Mox::GraphicsAllocator::Get())->GetDescriptorsGpuHeap().GetFirstGpuHandle());
+	}
+
 	void D3D12CommandList::ReferenceComputeTable(uint32_t InRootIdx, Mox::UnorderedAccessView& InUav)
 	{
 		m_D3D12CmdList->SetComputeRootDescriptorTable(InRootIdx, static_cast<Mox::D3D12UnorderedAccessView&>(InUav).GetGPUDescHandle());
@@ -183,7 +228,7 @@ namespace Mox {
 		return static_cast<Mox::D3D12GraphicsAllocator*>(Mox::GraphicsAllocator::Get())->GetDescriptorsGpuHeap().CopyDynamicDescriptors(InRangesNum, InDescHandleArray, InRageSizeArray);
 	}
 
-	void D3D12CommandList::StageDynamicCbv(uint32_t InRootIndex, Mox::ConstantBufferView& InCbv)
+	void D3D12CommandList::StageDynamicCbv_Internal(uint32_t InRootIndex, Mox::ConstantBufferView& InCbv)
 	{
 		m_StagedDescriptorManager.StageDynamicDescriptors(InRootIndex, static_cast<Mox::D3D12ConstantBufferView&>(InCbv).GetCPUDescHandle(), 1); // TODO At the moment range size hardcoded to 1
 	}
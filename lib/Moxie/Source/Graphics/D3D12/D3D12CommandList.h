@@ -25,66 +25,76 @@ namespace Mox {
 		
 		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>& GetInner() { return m_D3D12CmdList; }
 
-		virtual void ResourceBarriers(const TransitionInfoVector& InTransitions) override;
+		virtual void SetViewportAndScissorRect(Mox::ViewPort& InViewport, Mox::Rect& InScissorRect) override;
 
 
-		virtual void ClearRTV(Mox::CpuDescHandle& InDescHandle, float* InColor) override;
+		virtual void SetRenderTargetFromWindow(Mox::Window& InWindow) override;
 
 
-		virtual void ClearDepth(Mox::CpuDescHandle& InDescHandle) override;
+		virtual void SetComputeRootConstants(uint64_t InRootParameterIndex, uint64_t InNum32BitValuesToSet, const void* InSrcData, uint64_t InDestOffsetIn32BitValues) override;
 
 
-		virtual void Close() override;
+		virtual void UploadViewToGPU(Mox::ShaderResourceView& InSRV) override;
 
-		virtual void SetPipelineStateAndResourceBinder(Mox::PipelineState& InPipelineState) override;
+		virtual void UploadUavToGpu(Mox::UnorderedAccessView& InUav) override;
 
+		virtual void ReferenceComputeTable(uint32_t InRootIdx, Mox::ShaderResourceView& InUav) override;
 
-		virtual void SetInputAssemblerData(Mox::PRIMITIVE_TOPOLOGY InPrimTopology, Mox::VertexBufferView& InVertexBufView, Mox::IndexBufferView& InIndexBufView) override;
+		virtual void ReferenceComputeTable(uint32_t InRootIdx, Mox::UnorderedAccessView& InUav) override;
 
 
-		virtual void SetViewportAndScissorRect(Mox::ViewPort& InViewport, Mox::Rect& InScissorRect) override;
+		void SetGraphicsRootDescriptorTable(uint32_t InRootIdx, D3D12_GPU_DESCRIPTOR_HANDLE InGpuDescHandle);
 
+		CD3DX12_GPU_DESCRIPTOR_HANDLE CopyDynamicDescriptorsToBoundHeap(uint32_t InTablesNum, D3D12_CPU_DESCRIPTOR_HANDLE* InDescHandleArray, uint32_t* InRageSizeArray);
 
-		virtual void SetRenderTargetFromWindow(Mox::Window& InWindow) override;
 
+		void CommitStagedViews() override;
 
-		virtual void SetGraphicsRootConstants(uint64_t InRootParameterIndex, uint64_t InNum32BitValuesToSet, const void* InSrcData, uint64_t InDestOffsetIn32BitValues) override;
+	protected:
 
-		virtual void SetComputeRootConstants(uint64_t InRootParameterIndex, uint64_t InNum32BitValuesToSet, const void* InSrcData, uint64_t InDestOffsetIn32BitValues) override;
+		virtual void Close_Internal() override;
 
+		virtual void ResourceBarriers_Internal(const std::vector<Mox::ResourceTransition>& InTransitions) override;
 
-		virtual void DrawIndexed(uint64_t InIndexCountPerInstance) override;
+		virtual void AliasingBarriers_Internal(const std::vector<Mox::Resource*>& InResources) override;
 
-		virtual void Dispatch(uint32_t InGroupsNumX, uint32_t InGroupsNumY, uint32_t InGroupsNumZ) override;
+		virtual void DiscardResources_Internal(const std::vector<Mox::Resource*>& InResources) override;
 
-		virtual void SetGraphicsRootTable(uint32_t InRootIndex, Mox::ConstantBufferView& InView) override;
+		virtual void ClearRTV_Internal(Mox::CpuDescHandle& InDescHandle, float* InColor) override;
 
-	
-		virtual void UploadBufferData(Mox::BufferResource& DestinationBuffer, Mox::BufferResource& IntermediateBuffer, const void* InBufferData, size_t InDataSize) override;
+		virtual void ClearDepth_Internal(Mox::CpuDescHandle& InDescHandle) override;
 
+		virtual void DrawIndexed_Internal(uint64_t InIndexCountPerInstance, uint32_t InInstancesNum) override;
 
-		virtual void UploadViewToGPU(Mox::ShaderResourceView& InSRV) override;
+		virtual void Dispatch_Internal(uint32_t InGroupsNumX, uint32_t InGroupsNumY, uint32_t InGroupsNumZ) override;
 
-		virtual void UploadUavToGpu(Mox::UnorderedAccessView& InUav) override;
+		virtual void UploadBufferData_Internal(Mox::BufferResource& DestinationBuffer, Mox::BufferResource& IntermediateBuffer, const void* InBufferData, size_t InDataSize) override;
 
-		virtual void ReferenceSRV(uint32_t InRootIdx, Mox::ShaderResourceView& InSRV) override;
+		virtual void SetPipelineState_Internal(Mox::PipelineState& InPipelineState) override;
 
-		virtual void ReferenceCBV(uint32_t InRootIdx, Mox::ConstantBufferView& InCBV) override;
+		virtual void SetResourceBinder_Internal(Mox::PipelineState& InPipelineState) override;
 
-		virtual void ReferenceComputeTable(uint32_t InRootIdx, Mox::ShaderResourceView& InUav) override;
+		virtual void SetDescriptorHeaps_Internal() override;
 
-		virtual void ReferenceComputeTable(uint32_t InRootIdx, Mox::UnorderedAccessView& InUav) override;
+		virtual void SetPrimitiveTopology_Internal(Mox::PRIMITIVE_TOPOLOGY InPrimTopology) override;
 
+		virtual void SetVertexBuffer_Internal(Mox::VertexBufferView& InVertexBufView) override;
 
-		void SetGraphicsRootDescriptorTable(uint32_t InRootIdx, D3D12_GPU_DESCRIPTOR_HANDLE InGpuDescHandle);
+		virtual void SetIndexBuffer_Internal(Mox::IndexBufferView& InIndexBufView) override;
 
-		CD3DX12_GPU_DESCRIPTOR_HANDLE CopyDynamicDescriptorsToBoundHeap(uint32_t InTablesNum, D3D12_CPU_DESCRIPTOR_HANDLE* InDescHandleArray, uint32_t* InRageSizeArray);
+		virtual void SetGraphicsRootConstants_Internal(uint64_t InRootParameterIndex, uint64_t InNum32BitValuesToSet, const void* InSrcData, uint64_t InDestOffsetIn32BitValues) override;
 
+		virtual void SetGraphicsRootTable_Internal(uint32_t InRootIndex, Mox::ConstantBufferView& InView) override;
 
-		void StageDynamicCbv(uint32_t InRootIndex, Mox::ConstantBufferView& InCbv) override;
+		virtual void SetGraphicsRootShaderResource_Internal(uint32_t InRootIndex, Mox::GPU_V_ADDRESS InBufferLocation) override;
 
+		virtual void StageDynamicCbv_Internal(uint32_t InRootIndex, Mox::ConstantBufferView& InCbv) override;
 
-		void CommitStagedViews() override;
+		virtual void ReferenceSRV_Internal(uint32_t InRootIdx, Mox::ShaderResourceView& InSRV) override;
+
+		virtual void ReferenceCBV_Internal(uint32_t InRootIdx, Mox::ConstantBufferView& InCBV) override;
+
+		virtual void ReferenceViewsHeap_Internal(uint32_t InRootIdx) override;
 
 	private:
 		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> m_D3D12CmdList;
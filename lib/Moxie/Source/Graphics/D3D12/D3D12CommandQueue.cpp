@@ -115,6 +115,8 @@ namespace Mox {
 			m_CmdListsAvailable.pop();
 			// Resetting the command list with the previously selected command allocator (so binding the two together)
 			cmdList->Reset(cmdAllocator.Get(), nullptr);
+			// Nothing is bound on a list that was just reset
+			outObj->ResetBoundState();
 			// Reference the chosen command allocator in the command list's private data, so we can retrieve it on the fly when we need it
 			Mox::ThrowIfFailed(outObj->GetInner()->SetPrivateDataInterface(__uuidof(cmdAllocator), cmdAllocator.Get()));
 			// Note: setting a ComPtr as private data Does increment the reference count of that ComPtr !!
@@ -179,6 +181,11 @@ namespace Mox {
 		return m_LastSeenFenceValue;
 	}
 
+	uint64_t D3D12CommandQueue::GetCompletedFenceValue()
+	{
+		return m_Fence->GetCompletedValue();
+	}
+
 	bool D3D12CommandQueue::IsFenceComplete(uint64_t InFenceValue)
 	{
 		return m_Fence->GetCompletedValue() >= InFenceValue;
@@ -189,6 +196,11 @@ namespace Mox {
 		Mox::WaitForFenceValue(m_Fence, InFenceValue, m_FenceEvent);
 	}
 
+	void D3D12CommandQueue::GpuWaitForQueue(Mox::CommandQueue& InOtherQueue, uint64_t InFenceValue)
+	{
+		Mox::ThrowIfFailed(m_CmdQueue->Wait(static_cast<Mox::D3D12CommandQueue&>(InOtherQueue).m_Fence.Get(), InFenceValue));
+	}
+
 	void D3D12CommandQueue::Flush()
 	{
 		Mox::FlushCmdQueue(m_CmdQueue, m_Fence, m_FenceEvent, m_LastSeenFenceValue);
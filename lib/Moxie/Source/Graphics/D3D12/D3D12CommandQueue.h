@@ -39,8 +39,10 @@ namespace Mox {
 
 
 		uint64_t Signal();
-		bool IsFenceComplete(uint64_t InFenceValue);
-		void WaitForFenceValue(uint64_t InFenceValue);
+		virtual uint64_t GetCompletedFenceValue() override;
+		virtual bool IsFenceComplete(uint64_t InFenceValue) override;
+		virtual void WaitForFenceValue(uint64_t InFenceValue) override;
+		virtual void GpuWaitForQueue(Mox::CommandQueue& InOtherQueue, uint64_t InFenceValue) override;
 		// Signals the fence and stalls the thread it is invoked on to wait for the just signaled fence value
 		virtual void Flush();
 
@@ -10,6 +10,7 @@
 #include "D3D12Device.h"
 #include "RangeAllocators.h"
 #include "D3D12MoxUtils.h"
+#include "DeferredReleaseQueue.h"
 
 namespace Mox { 
 
@@ -143,6 +144,11 @@ namespace Mox {
 		return *m_ResourceViewArray.back();
 	}
 
+	void D3D12DescHeapFactory::ReleaseViewObjects(const std::unordered_set<const Mox::ResourceView*>& InViews, Mox::DeferredReleaseQueue& InOutReleaseQueue)
+	{
+		InOutReleaseQueue.EnqueueFrom(m_ResourceViewArray, InViews);
+	}
+
 	StaticDescAllocation::~StaticDescAllocation()
 	{
 		m_DescHeap.FreeAllocatedStaticRange(m_FirstCpuHandle, m_RangeSize);
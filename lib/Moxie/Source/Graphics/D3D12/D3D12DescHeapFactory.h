@@ -12,6 +12,7 @@
 #include "d3dx12.h"
 #include "GraphicsTypes.h"
 #include <deque>
+#include <unordered_set>
 
 namespace Mox { 
 
@@ -22,6 +23,7 @@ namespace Mox {
 
 	class D3D12DescriptorHeap;
 	class RangeAllocator;
+	class DeferredReleaseQueue;
 
 	struct DescAllocation {
 		DescAllocation(D3D12_CPU_DESCRIPTOR_HANDLE InCPUHandle, uint32_t InRangeSize) : m_FirstCpuHandle(InCPUHandle), m_RangeSize(InRangeSize) { }
@@ -63,6 +65,12 @@ namespace Mox {
 
 		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> GetInner() const { return m_D3D12DescHeap; }
 
+		// Start of a shader visible heap, where tables indexing all of its descriptors are set
+		D3D12_GPU_DESCRIPTOR_HANDLE GetFirstGpuHandle() const { return m_FirstGpuDesc; }
+
+		// Position of the descriptor in a shader visible heap, used by shaders to index it from the start of the heap
+		uint32_t GetDescriptorIndex(const D3D12_GPU_DESCRIPTOR_HANDLE& InGpuHandle) const { return static_cast<uint32_t>((InGpuHandle.ptr - m_FirstGpuDesc.ptr) / m_DescSize); }
+
 		CD3DX12_GPU_DESCRIPTOR_HANDLE CopyDynamicDescriptors(uint32_t InRangesNum, D3D12_CPU_DESCRIPTOR_HANDLE* InDescHandleArray, uint32_t InRageSizeArray[]);
 
 	private:
@@ -99,6 +107,9 @@ namespace Mox {
 
 		Mox::ResourceView& AddViewObject(std::unique_ptr<Mox::ResourceView> InResourceView);
 
+		// Hands the given views over to the release queue. Their descriptors are freed when the view objects get destroyed.
+		void ReleaseViewObjects(const std::unordered_set<const Mox::ResourceView*>& InViews, Mox::DeferredReleaseQueue& InOutReleaseQueue);
+
 	private:
 
 		// The desc heap factory owns view objects since views are stored in desc heaps
@@ -19,6 +19,16 @@ D3D12Device::D3D12Device()
 
 	m_D3d12Device = Mox::CreateDevice(adapter);
 
+	// Cached pipeline states are specific to the adapter and to the driver version
+	DXGI_ADAPTER_DESC1 adapterDesc;
+	Mox::ThrowIfFailed(adapter->GetDesc1(&adapterDesc));
+	LARGE_INTEGER driverVersion = {};
+	adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &driverVersion);
+
+	const uint32_t adapterIds[] = { adapterDesc.VendorId, adapterDesc.DeviceId, adapterDesc.SubSysId, adapterDesc.Revision };
+	m_PipelineCacheContextHash = Mox::HashBytes(adapterIds, sizeof(adapterIds));
+	m_PipelineCacheContextHash = Mox::HashBytes(&driverVersion.QuadPart, sizeof(driverVersion.QuadPart), m_PipelineCacheContextHash);
+
 #if _DEBUG
 	Mox::ThrowIfFailed(DXGIGetDebugInterface1(0, IID_PPV_ARGS(&m_DxgiDebug)));
 
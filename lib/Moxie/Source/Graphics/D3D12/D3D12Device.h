@@ -38,11 +38,15 @@ public:
 
 	virtual void ShutDown() override;
 
+	virtual uint64_t GetPipelineCacheContextHash() const override { return m_PipelineCacheContextHash; }
+
 private:
 
 	void SetMessageBreaksOnSeverity();
 
 	Microsoft::WRL::ComPtr<ID3D12Device2> m_D3d12Device;
+
+	uint64_t m_PipelineCacheContextHash = 0;
 #if _DEBUG
 	Microsoft::WRL::ComPtr<IDXGIDebug1> m_DxgiDebug;
 #endif
@@ -12,6 +12,7 @@
 #include "D3D12Device.h"
 #include "MoxUtils.h"
 #include "RangeAllocators.h"
+#include "DeferredReleaseQueue.h"
 
 namespace Mox{ 
 
@@ -60,6 +61,18 @@ namespace Mox{
 		return *m_AllocatedBufferResources.back().get();
 	}
 
+	void D3D12DynamicBufferAllocator::AllocateFrameData(uint32_t InSize, void*& OutCpuPtr, D3D12_GPU_VIRTUAL_ADDRESS& OutGpuPtr)
+	{
+		AllocateMemoryForBuffer(Mox::Align(InSize, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT), OutCpuPtr, OutGpuPtr);
+	}
+
+	void D3D12DynamicBufferAllocator::Release(const std::unordered_set<const Mox::BufferResource*>& InBuffers, Mox::DeferredReleaseQueue& InOutReleaseQueue)
+	{
+		// Memory in the ring buffer does not need to be given back: 
+		// once a buffer is not copied anymore, its last allocation gets overwritten when the ring wraps around.
+		InOutReleaseQueue.EnqueueFrom(m_AllocatedBufferResources, InBuffers);
+	}
+
 	void D3D12DynamicBufferAllocator::OnFrameStarted()
 	{
 		// When frame starts, update the relative offset and copy in all the current active dynamic buffers 
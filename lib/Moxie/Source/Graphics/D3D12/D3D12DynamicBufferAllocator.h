@@ -11,6 +11,7 @@
 
 #include <deque>
 #include "d3dx12.h"
+#include <unordered_set>
 
 
 namespace Mox{ 
@@ -18,6 +19,7 @@ namespace Mox{
 	struct D3D12Resource;
 	struct BufferResource;
 	struct D3D12BufferResource;
+	class DeferredReleaseQueue;
 
 	/*
 	D3D12LinearBufferAllocator performs constant buffer sub-allocations in a single buffer resource.
@@ -37,6 +39,11 @@ namespace Mox{
 		// Note: We do not need to pass the alignment since it is decided by the hosting resource
 		Mox::BufferResource& Allocate(uint32_t InSize);
 
+		// Sub-allocates memory for the current frame only: no buffer is created, so its content is not carried over to the next frames
+		void AllocateFrameData(uint32_t InSize, void*& OutCpuPtr, D3D12_GPU_VIRTUAL_ADDRESS& OutGpuPtr);
+
+		// Stops updating the given buffers on each frame and hands them over to the release queue
+		void Release(const std::unordered_set<const Mox::BufferResource*>& InBuffers, Mox::DeferredReleaseQueue& InOutReleaseQueue);
 
 
 		// When frame starts, update the relative offset and copy in all the current active dynamic buffers 
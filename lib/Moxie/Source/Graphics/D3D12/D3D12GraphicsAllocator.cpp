@@ -22,6 +22,7 @@
 #include "MoxRenderProxy.h"
 #include "D3D12StaticBufferAllocator.h"
 #include "D3D12TextureAllocator.h"
+#include "D3D12TransientResourceAllocator.h"
 #include "MoxDrawable.h"
 
 namespace Mox { 
@@ -38,9 +39,14 @@ namespace Mox {
 
 		m_DynamicBufferAllocator = std::make_unique<Mox::D3D12DynamicBufferAllocator>(dynamicBufferResource);
 
+		Mox::D3D12Resource& frameDataResource = AllocateD3D12Resource(D3D12_RES_TYPE::Buffer, RESOURCE_HEAP_TYPE::UPLOAD, Mox::Constants::g_FrameDataRingSize);
+
+		m_FrameDataAllocator = std::make_unique<Mox::D3D12DynamicBufferAllocator>(frameDataResource);
+
 
 		Mox::D3D12Resource& targetBufferResource = AllocateD3D12Resource(D3D12_RES_TYPE::Buffer, RESOURCE_HEAP_TYPE::DEFAULT);
-		Mox::D3D12Resource& stagingBufferResource = AllocateD3D12Resource(D3D12_RES_TYPE::Buffer, RESOURCE_HEAP_TYPE::UPLOAD);
+		// Staging memory is sub-allocated between the uploads in flight, so it needs room for more than a single frame of updates
+		Mox::D3D12Resource& stagingBufferResource = AllocateD3D12Resource(D3D12_RES_TYPE::Buffer, RESOURCE_HEAP_TYPE::UPLOAD, 1048576);
 
 		m_StaticBufferAllocator = std::make_unique<Mox::D3D12StaticBufferAllocator>(targetBufferResource, stagingBufferResource);
 
@@ -48,18 +54,30 @@ namespace Mox {
 		Mox::D3D12Resource& stagingBufferResourceForTextures = AllocateD3D12Resource(D3D12_RES_TYPE::Buffer, RESOURCE_HEAP_TYPE::UPLOAD, 4194304);
 
 		m_TextureAllocator = std::make_unique<Mox::D3D12TextureAllocator>(4194304, stagingBufferResourceForTextures);
+
+		m_TransientResourceAllocator = std::make_unique<Mox::D3D12TransientResourceAllocator>(m_DeferredReleases);
 	}
 
 	D3D12GraphicsAllocator::~D3D12GraphicsAllocator()
 	{
+		// Released views still need their descriptor heaps to free their descriptors
+		m_DeferredReleases.ReleaseAll();
+
 		m_StaticBufferAllocator.reset();
 		m_DynamicBufferAllocator.reset();
+		m_FrameDataAllocator.reset();
 		m_TextureAllocator.reset();
+		m_TransientResourceAllocator.reset();
 
 		m_DescHeapFactory.reset();
 
 	}
 
+	Mox::TransientResourceAllocator& D3D12GraphicsAllocator::GetTransientResourceAllocator()
+	{
+		return *m_TransientResourceAllocator;
+	}
+
 	void D3D12GraphicsAllocator::AllocateResourceForBuffer(const Mox::BufferResourceRequest& InResourceRequest)
 	{
 		// TODO replace BufferResourceRequest with a single buffer reference, 
@@ -99,9 +117,9 @@ namespace Mox {
 	}
 
 	Mox::D3D12Resource& D3D12GraphicsAllocator::AllocateD3D12Resource(
-		Microsoft::WRL::ComPtr<ID3D12Resource> InD3D12Res, Mox::D3D12_RES_TYPE InResType, size_t InSize /*= 1*/)
+		Microsoft::WRL::ComPtr<ID3D12Resource> InD3D12Res, Mox::D3D12_RES_TYPE InResType, size_t InSize /*= 1*/, Mox::RESOURCE_STATE InState /*= NEUTRAL*/)
 	{
-		m_GraphicsResources.emplace_back(Mox::D3D12Resource(InD3D12Res, InResType, InSize));
+		m_GraphicsResources.emplace_back(Mox::D3D12Resource(InD3D12Res, InResType, InSize, InState));
 
 		return m_GraphicsResources.back();
 	}
@@ -111,6 +129,11 @@ namespace Mox {
 		return m_DynamicBufferAllocator->Allocate(InSize);
 	}
 
+	void D3D12GraphicsAllocator::AllocateFrameData(uint32_t InSize, void*& OutCpuPtr, Mox::GPU_V_ADDRESS& OutGpuPtr)
+	{
+		m_FrameDataAllocator->AllocateFrameData(InSize, OutCpuPtr, OutGpuPtr);
+	}
+
 	void D3D12GraphicsAllocator::AllocateResourceForTexture(const Mox::TextureResourceRequest& InTexResRequest)
 	{
 		Mox::TextureResource& tesRes = m_TextureAllocator->Allocate(InTexResRequest.m_Desc);
@@ -171,11 +194,27 @@ namespace Mox {
 
 	Mox::Shader& D3D12GraphicsAllocator::AllocateShader(wchar_t const* InShaderPath)
 	{
+		auto pathIt = m_ShadersByPath.find(InShaderPath);
+		if (pathIt != m_ShadersByPath.end())
+		{
+			return *pathIt->second;
+		}
+
 		Microsoft::WRL::ComPtr<ID3DBlob> OutFileBlob;
 		Mox::ThrowIfFailed(::D3DReadFileToBlob(InShaderPath, &OutFileBlob));
-		m_ShaderArray.push_back(std::make_unique<Mox::D3D12Shader>(OutFileBlob));
+		std::unique_ptr<Mox::D3D12Shader> newShader = std::make_unique<Mox::D3D12Shader>(OutFileBlob);
 
-		return *m_ShaderArray.back();
+		// Note: a hash collision would need the same 64bit hash from different bytecode, which is not accounted for
+		auto hashIt = m_ShadersByBytecodeHash.find(newShader->GetBytecodeHash());
+		if (hashIt == m_ShadersByBytecodeHash.end())
+		{
+			m_ShaderArray.push_back(std::move(newShader));
+			hashIt = m_ShadersByBytecodeHash.emplace(m_ShaderArray.back()->GetBytecodeHash(), m_ShaderArray.back().get()).first;
+		}
+
+		m_ShadersByPath.emplace(InShaderPath, hashIt->second);
+
+		return *hashIt->second;
 	}
 
 	Mox::PipelineState& D3D12GraphicsAllocator::AllocatePipelineState()
@@ -240,6 +279,42 @@ namespace Mox {
 		}
 	}
 
+	std::vector<Mox::RenderProxy*> D3D12GraphicsAllocator::CreateSpawnBatch(const Mox::SpawnBatchRequest& InSpawnBatch)
+	{
+		const size_t proxiesNum = InSpawnBatch.m_Proxies.size();
+
+		std::vector<Mox::RenderProxy*> outProxies;  outProxies.reserve(proxiesNum);
+		for (const std::shared_ptr<Mox::RenderProxy>& proxy : InSpawnBatch.m_Proxies)
+		{
+			m_RenderProxyArray.emplace_back(proxy);
+
+			outProxies.push_back(proxy.get());
+		}
+
+		if (InSpawnBatch.m_InitialModelMatrices.empty())
+		{
+			return outProxies;
+		}
+
+		Check(InSpawnBatch.m_InitialModelMatrices.size() == proxiesNum)
+
+		// The same creation info is reused for every drawable, only the owning proxy changes.
+		// Model matrices are kept by the proxies, no per-entity buffer is needed since the render passes write them in their per-instance data.
+		Mox::DrawableCreationInfo drawableInfo = InSpawnBatch.m_DrawableTemplate;
+
+		for (size_t proxyIdx = 0; proxyIdx < proxiesNum; ++proxyIdx)
+		{
+			drawableInfo.m_OwningProxy = outProxies[proxyIdx];
+
+			m_DrawableArray.emplace_back(std::make_unique<Mox::Drawable>(drawableInfo));
+
+			outProxies[proxyIdx]->SetModelMatrix(InSpawnBatch.m_InitialModelMatrices[proxyIdx]);
+			outProxies[proxyIdx]->AddDrawable(m_DrawableArray.back().get());
+		}
+
+		return outProxies;
+	}
+
 	Mox::VertexBuffer& D3D12GraphicsAllocator::AllocateVertexBuffer(const Mox::INPUT_LAYOUT_DESC& InLayoutDesc, 
 		const void* InData, uint32_t InStride, uint32_t InSize)
 	{
@@ -262,6 +337,7 @@ namespace Mox {
 		static const float fractionSize = 1.0f / totalPartitionsNum;
 
 		m_DynamicBufferAllocator->OnFrameStarted();
+		m_FrameDataAllocator->OnFrameStarted();
 
 		// TODO change descriptor handling the way we do with dynamic buffer allocator
 		GetDescriptorsGpuHeap().SetAllowedDynamicAllocationRegion(currentFramePartition, currentFramePartition + fractionSize);
@@ -272,17 +348,101 @@ namespace Mox {
 	void D3D12GraphicsAllocator::OnNewFrameEnded()
 	{
 		m_DynamicBufferAllocator->OnFrameEnded();
+		m_FrameDataAllocator->OnFrameEnded();
 	}
 
 	void D3D12GraphicsAllocator::UpdateStaticBufferResources(Mox::CommandList& InCmdList, const std::vector<Mox::BufferResourceUpdate>& InUpdates)
 	{
-		m_StaticBufferAllocator->UploadContentUpdates(InCmdList, InUpdates);
+		Check(m_UploadQueue)
+
+		m_StaticBufferAllocator->UploadContentUpdates(InCmdList, *m_UploadQueue, InUpdates);
 
 	}
 
 	void D3D12GraphicsAllocator::UpdateTextureResources(Mox::CommandList& InCmdList, const std::vector<Mox::TextureResourceUpdate>& InTextureUpdates)
 	{
-		m_TextureAllocator->UpdateContent(InCmdList, InTextureUpdates);
+		Check(m_UploadQueue)
+
+		m_TextureAllocator->UpdateContent(InCmdList, *m_UploadQueue, InTextureUpdates);
+	}
+
+	void D3D12GraphicsAllocator::OnUploadSubmitted(uint64_t InFenceValue)
+	{
+		m_StaticBufferAllocator->OnUploadSubmitted(InFenceValue);
+
+		m_TextureAllocator->OnUploadSubmitted(InFenceValue);
+	}
+
+	void D3D12GraphicsAllocator::RetireUploads(uint64_t InCompletedFenceValue)
+	{
+		m_StaticBufferAllocator->RetireStagingMemory(InCompletedFenceValue);
+
+		m_TextureAllocator->RetireStagingMemory(InCompletedFenceValue);
+	}
+
+	void D3D12GraphicsAllocator::OnFrameSubmitted(uint64_t InFenceValue)
+	{
+		m_DeferredReleases.CloseBatch(InFenceValue);
+	}
+
+	void D3D12GraphicsAllocator::ReclaimReleasedObjects(uint64_t InCompletedFenceValue)
+	{
+		m_DeferredReleases.Reclaim(InCompletedFenceValue);
+	}
+
+	void D3D12GraphicsAllocator::ReleaseRenderProxies(const std::vector<std::shared_ptr<Mox::RenderProxy>>& InProxies)
+	{
+		std::unordered_set<const Mox::RenderProxy*> releasedProxies;
+		std::unordered_set<const Mox::Drawable*> releasedDrawables;
+
+		for (const std::shared_ptr<Mox::RenderProxy>& proxy : InProxies)
+		{
+			releasedProxies.insert(proxy.get());
+			releasedDrawables.insert(proxy->m_Meshes.begin(), proxy->m_Meshes.end());
+		}
+
+		// Drawables and proxies are only read by the render thread, but they are deferred as well 
+		// so that everything released in a frame goes away at the same time
+		m_DeferredReleases.EnqueueFrom(m_DrawableArray, releasedDrawables);
+
+		m_DeferredReleases.EnqueueFrom(m_RenderProxyArray, releasedProxies);
+	}
+
+	void D3D12GraphicsAllocator::ReleaseBuffers(std::vector<std::unique_ptr<Mox::ConstantBuffer>>&& InBuffers)
+	{
+		std::unordered_set<const Mox::BufferResource*> releasedDynamicResources;
+		std::unordered_set<const Mox::BufferResource*> releasedStaticResources;
+		std::unordered_set<const Mox::ResourceView*> releasedViews;
+
+		for (std::unique_ptr<Mox::ConstantBuffer>& buffer : InBuffers)
+		{
+			Mox::BufferResource* bufferResource = buffer->GetResource();
+
+			if (bufferResource)
+			{
+				if (bufferResource->GetType() == Mox::BUFFER_ALLOC_TYPE::DYNAMIC)
+				{
+					releasedDynamicResources.insert(bufferResource);
+				}
+				else
+				{
+					releasedStaticResources.insert(bufferResource);
+				}
+				releasedViews.insert(bufferResource->GetView());
+			}
+
+			m_DeferredReleases.Enqueue(std::move(buffer));
+		}
+
+		// Dynamic buffers stop being copied to the ring buffer straight away, while the objects stay alive until the Gpu is done with them
+		m_DynamicBufferAllocator->Release(releasedDynamicResources, m_DeferredReleases);
+
+		// Static buffers give their range back once the Gpu is done with them, so that spawning and destroying entities does not exhaust the static memory
+		m_StaticBufferAllocator->Release(releasedStaticResources, m_DeferredReleases);
+
+		m_DescHeapFactory->ReleaseViewObjects(releasedViews, m_DeferredReleases);
+
+		InBuffers.clear();
 	}
 
 	void D3D12GraphicsAllocator::Initialize(Mox::CommandList& InCmdList)
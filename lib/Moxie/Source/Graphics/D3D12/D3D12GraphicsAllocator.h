@@ -11,9 +11,11 @@
 
 #include <deque>
 #include <memory> // for std::unique_ptr
+#include <unordered_map>
 #include "d3d12.h"
 #include "GraphicsAllocator.h"
 #include "D3D12MoxUtils.h"
+#include "DeferredReleaseQueue.h"
 
 namespace Mox { 
 
@@ -21,6 +23,7 @@ namespace Mox {
 	class D3D12DynamicBufferAllocator;
 	class D3D12StaticBufferAllocator;
 	class D3D12TextureAllocator;
+	class D3D12TransientResourceAllocator;
 	class D3D12DescHeapFactory;
 	class Window;
 	struct WindowInitInput;
@@ -51,12 +54,30 @@ public:
 
 	void UpdateTextureResources(Mox::CommandList& InCmdList, const std::vector<Mox::TextureResourceUpdate>& InTextureUpdates) override;
 
+	void SetUploadQueue(Mox::CommandQueue& InUploadQueue) override { m_UploadQueue = &InUploadQueue; }
+
+	Mox::TransientResourceAllocator& GetTransientResourceAllocator() override;
+
+	void OnUploadSubmitted(uint64_t InFenceValue) override;
+
+	void RetireUploads(uint64_t InCompletedFenceValue) override;
+
+	void OnFrameSubmitted(uint64_t InFenceValue) override;
+
+	void ReclaimReleasedObjects(uint64_t InCompletedFenceValue) override;
+
+	void ReleaseRenderProxies(const std::vector<std::shared_ptr<Mox::RenderProxy>>& InProxies) override;
+
+	void ReleaseBuffers(std::vector<std::unique_ptr<Mox::ConstantBuffer>>&& InBuffers) override;
+
 	Mox::VertexBuffer& AllocateVertexBuffer(const Mox::INPUT_LAYOUT_DESC& InLayoutDesc, const void* InData, uint32_t InStride, uint32_t InSize) override;
 
 	Mox::IndexBuffer& AllocateIndexBuffer(const void* InData, uint32_t InStride, uint32_t InSize) override;
 
 	Mox::BufferResource& AllocateDynamicBuffer(uint32_t InSize) override;
 
+	void AllocateFrameData(uint32_t InSize, void*& OutCpuPtr, Mox::GPU_V_ADDRESS& OutGpuPtr) override;
+
 	void AllocateResourceForTexture(const Mox::TextureResourceRequest& InTexResRequest) override;
 
 	Mox::VertexBufferView& AllocateVertexBufferView(Mox::BufferResource& InVBResource) override;
@@ -90,6 +111,8 @@ public:
 
 	void CreateDrawables(const std::vector<Mox::DrawableCreationInfo>& InRequests) override;
 
+	std::vector<Mox::RenderProxy*> CreateSpawnBatch(const Mox::SpawnBatchRequest& InSpawnBatch) override;
+
 
 	void AllocateResourceForBuffer(const Mox::BufferResourceRequest& InResourceRequest) override;
 
@@ -97,7 +120,8 @@ public:
 		uint32_t InSize = 1, Mox::RESOURCE_FLAGS InFlags = RESOURCE_FLAGS::NONE);
 
 	// D3D12 Specific
-	Mox::D3D12Resource& AllocateD3D12Resource(Microsoft::WRL::ComPtr<ID3D12Resource> InD3D12Res, D3D12_RES_TYPE InResType, size_t InSize = 1);
+	Mox::D3D12Resource& AllocateD3D12Resource(Microsoft::WRL::ComPtr<ID3D12Resource> InD3D12Res, D3D12_RES_TYPE InResType, size_t InSize = 1, 
+		Mox::RESOURCE_STATE InState = Mox::RESOURCE_STATE::NEUTRAL);
 
 
 
@@ -118,6 +142,10 @@ private:
 	std::deque<Mox::D3D12VertexBufferView> m_VertexViewArray;
 	std::deque<Mox::D3D12IndexBufferView> m_IndexViewArray;
 	std::deque<std::unique_ptr<Mox::Shader>> m_ShaderArray;
+	// Shaders are shared by path, and by bytecode content when different paths contain the same compiled shader,
+	// so that pipeline states referencing them hash to the same key and share their cached state
+	std::unordered_map<std::wstring, Mox::Shader*> m_ShadersByPath;
+	std::unordered_map<uint64_t, Mox::Shader*> m_ShadersByBytecodeHash;
 	std::deque<std::unique_ptr<Mox::PipelineState>> m_PipelineStateArray;
 	std::deque<std::unique_ptr<Mox::Window>> m_WindowArray;
 	std::deque<std::unique_ptr<Mox::CommandQueue>> m_CommandQueueArray;
@@ -126,10 +154,20 @@ private:
 
 	std::unique_ptr<Mox::D3D12DynamicBufferAllocator> m_DynamicBufferAllocator;
 
+	// Separate ring for per-frame data, so that large instance data does not compete with the dynamic buffers copied every frame
+	std::unique_ptr<Mox::D3D12DynamicBufferAllocator> m_FrameDataAllocator;
+
 	std::unique_ptr<Mox::D3D12TextureAllocator> m_TextureAllocator;
 
+	std::unique_ptr<Mox::D3D12TransientResourceAllocator> m_TransientResourceAllocator;
+
 	std::unique_ptr<Mox::D3D12DescHeapFactory> m_DescHeapFactory;
 
+	Mox::CommandQueue* m_UploadQueue = nullptr;
+
+	// Released objects waiting for the Gpu to finish the frames that can still reference them
+	Mox::DeferredReleaseQueue m_DeferredReleases;
+
 
 	uint64_t m_FrameCounter = 0;
 };
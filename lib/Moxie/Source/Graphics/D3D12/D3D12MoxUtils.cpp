@@ -275,7 +275,8 @@ namespace Mox
 		return ThrowIfFailed(::D3DReadFileToBlob(InFilePath, OutFileBlob));
 	}
 
-	ComPtr<ID3D12RootSignature> SerializeAndCreateRootSignature(ComPtr<ID3D12Device2> InDevice, CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC* InRootSigDesc, D3D_ROOT_SIGNATURE_VERSION InVersion)
+	ComPtr<ID3D12RootSignature> SerializeAndCreateRootSignature(ComPtr<ID3D12Device2> InDevice, CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC* InRootSigDesc, D3D_ROOT_SIGNATURE_VERSION InVersion,
+		ComPtr<ID3DBlob>* OutSerializedBlob)
 	{
 		// Create Root Signature Blob
 		ComPtr<ID3DBlob> rootSignatureBlob;
@@ -287,6 +288,11 @@ namespace Mox
 		ComPtr<ID3D12RootSignature> rootSignature;
 		ThrowIfFailed(InDevice->CreateRootSignature(0, rootSignatureBlob->GetBufferPointer(), rootSignatureBlob->GetBufferSize(), IID_PPV_ARGS(&rootSignature)));
 
+		if (OutSerializedBlob)
+		{
+			*OutSerializedBlob = rootSignatureBlob;
+		}
+
 		return rootSignature;
 	}
 
@@ -403,6 +409,11 @@ namespace Mox
 		return false; // TODO fix me
 	}
 
+	uint32_t D3D12ShaderResourceView::GetHeapIndex()
+	{
+		return static_cast<Mox::D3D12GraphicsAllocator*>(Mox::GraphicsAllocator::Get())->GetDescriptorsGpuHeap().GetDescriptorIndex(GetGPUDescHandle());
+	}
+
 	void D3D12ShaderResourceView::InitAsTex2DArray(Mox::TextureResource& InTexture, uint32_t InArraySize, uint32_t InMostDetailedMip, uint32_t InMipLevels, uint32_t InFirstArraySlice, uint32_t InPlaceSlice)
 	{
 		// Allocate static descriptor in the CPU-only desc heap
@@ -520,11 +531,12 @@ namespace Mox
 		}
 	}
 
-	D3D12Resource::D3D12Resource(Microsoft::WRL::ComPtr<ID3D12Resource> InD3D12Res, D3D12_RES_TYPE InResType, size_t InSize)
+	D3D12Resource::D3D12Resource(Microsoft::WRL::ComPtr<ID3D12Resource> InD3D12Res, D3D12_RES_TYPE InResType, size_t InSize, Mox::RESOURCE_STATE InState)
 		: m_D3D12Resource(InD3D12Res),  m_Desc(InD3D12Res->GetDesc())
 	{
 		
 		m_DataSize = InSize;
+		m_TrackedState = InState;
 
 		if (InResType == D3D12_RES_TYPE::Buffer)
 		{
@@ -567,6 +579,7 @@ namespace Mox
 		Check(InSize > 0)
 
 		m_DataSize = Mox::Align(InSize, m_Alignment);
+		m_TrackedState = InState;
 
 		Mox::CreateCommittedResource(static_cast<Mox::D3D12Device&>(
 			Mox::GetDevice()).GetInner(),
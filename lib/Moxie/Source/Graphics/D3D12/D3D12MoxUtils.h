@@ -72,7 +72,9 @@ namespace Mox {
 
 	void ReadFileToBlob(LPCWSTR InFilePath, ID3DBlob** OutFileBlob);
 
-	Microsoft::WRL::ComPtr<ID3D12RootSignature> SerializeAndCreateRootSignature(Microsoft::WRL::ComPtr<ID3D12Device2> InDevice, CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC* InRootSigDesc, D3D_ROOT_SIGNATURE_VERSION InVersion);
+	// The serialized root signature is also returned in OutSerializedBlob, when given
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> SerializeAndCreateRootSignature(Microsoft::WRL::ComPtr<ID3D12Device2> InDevice, CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC* InRootSigDesc, D3D_ROOT_SIGNATURE_VERSION InVersion,
+		Microsoft::WRL::ComPtr<ID3DBlob>* OutSerializedBlob = nullptr);
 
 	// Returns true if the loading was successful
 	bool LoadDDSTextureData(const char* InFilePath, TextureDesc& OutTexDesc, void*& OutLoadedDataPtr, size_t& OutLoadedDataSize, std::vector<Mox::TexDataInfo>& OutSubresInfo);
@@ -118,8 +120,9 @@ namespace Mox {
 	};
 
 	struct D3D12Resource : public Mox::Resource {
-		// Constructor for when the resource is already allocated (like backbuffers from the window swapchain)
-		D3D12Resource(Microsoft::WRL::ComPtr<ID3D12Resource> InD3D12Res, D3D12_RES_TYPE InResType = D3D12_RES_TYPE::Buffer, size_t InSize = 0);
+		// Constructor for when the resource is already allocated (like backbuffers from the window swapchain), InState being the state it was created in
+		D3D12Resource(Microsoft::WRL::ComPtr<ID3D12Resource> InD3D12Res, D3D12_RES_TYPE InResType = D3D12_RES_TYPE::Buffer, size_t InSize = 0, 
+			Mox::RESOURCE_STATE InState = Mox::RESOURCE_STATE::NEUTRAL);
 
 		// This constructor will be very expensive! It creates a buffer resource in upload heap and orders a copy to a second new resource in default heap
 		// TODO it will need changing
@@ -130,7 +133,6 @@ namespace Mox {
 		Microsoft::WRL::ComPtr<ID3D12Resource>& GetInner() { return m_D3D12Resource; }
 		// ----- Fields mostly used only by texture resources ----- TODO MOVE in standalone class!
 		D3D12_RESOURCE_DESC& GetDesc() { return m_Desc; }
-		uint16_t GetSubresourcesNum() const { return m_SubresourcesNum; }
 		std::vector<uint32_t>& GetRowsNumVector() { return m_RowsNumVector; }
 		std::vector<uint64_t>& GetRowSizeVector() { return m_RowSizeVector; }
 		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT>& GetSubresourceFootprints() { return m_SubresourceFootprints; }
@@ -154,7 +156,6 @@ namespace Mox {
 		// Fields used only in texture resources.. // TODO move them to a separate class
 
 		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> m_SubresourceFootprints;
-		uint16_t m_SubresourcesNum;
 		std::vector <uint32_t> m_RowsNumVector;
 		std::vector <uint64_t> m_RowSizeVector;
 		
@@ -228,6 +229,8 @@ namespace Mox {
 
 		virtual void InitAsTex2DOrCubemap(Mox::TextureResource& InTexture);
 
+		uint32_t GetHeapIndex() override;
+
 		void RebuildResourceReference() { /** TODO do we really need this? */ };
 
 		// Descriptor range referenced by this View object.
@@ -314,7 +317,10 @@ namespace Mox {
 	};
 
 	struct D3D12Shader : public Mox::Shader {
-		D3D12Shader(Microsoft::WRL::ComPtr<ID3DBlob> InShaderBlob) : m_ShaderBlob(InShaderBlob) { }
+		D3D12Shader(Microsoft::WRL::ComPtr<ID3DBlob> InShaderBlob) : m_ShaderBlob(InShaderBlob) 
+		{
+			m_BytecodeHash = Mox::HashBytes(m_ShaderBlob->GetBufferPointer(), m_ShaderBlob->GetBufferSize());
+		}
 		Microsoft::WRL::ComPtr<ID3DBlob> m_ShaderBlob;
 	};
 
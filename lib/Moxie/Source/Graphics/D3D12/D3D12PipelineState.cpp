@@ -88,6 +88,12 @@ namespace Mox{
 			D3D12_DESCRIPTOR_RANGE1 descRange;
 			descRange.BaseShaderRegister = InResourceBinderParam.ShaderRegister;
 			descRange.Flags = D3D12_DESCRIPTOR_RANGE_FLAG_NONE; // TODO need to be able to pass flags with root params
+			// Unbounded tables also cover the dynamic descriptors of the heap, which keep being written while the table is set.
+			// Note: the same value stands for unbounded in D3D12 too.
+			if (InResourceBinderParam.NumDescriptors == RESOURCE_BINDER_PARAM::UnboundedDescriptorsNum)
+			{
+				descRange.Flags = D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE;
+			}
 			descRange.NumDescriptors = InResourceBinderParam.NumDescriptors;
 			descRange.OffsetInDescriptorsFromTableStart = 0;
 			descRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
@@ -114,6 +120,12 @@ namespace Mox{
 			returnParam.InitAsDescriptorTable(1, &OutDescRanges.back(), TransformShaderVisibility(InResourceBinderParam.shaderVisibility));
 			break;
 		}
+		case RESOURCE_BINDER_PARAM::RESOURCE_TYPE::SRV:
+		{
+			returnParam.InitAsShaderResourceView(InResourceBinderParam.ShaderRegister, InResourceBinderParam.RegisterSpace, 
+				D3D12_ROOT_DESCRIPTOR_FLAG_NONE, TransformShaderVisibility(InResourceBinderParam.shaderVisibility));
+			break;
+		}
 		default:
 			StopForFail("Root Param transformation not implemented yet!")
 			break;
@@ -141,6 +153,73 @@ namespace Mox{
 	{
 		m_IsGraphicsPSO = true;
 
+		Microsoft::WRL::ComPtr<ID3D12Device2> d3d12GraphicsDevice = static_cast<Mox::D3D12Device&>(Mox::GetDevice()).GetInner();
+		GenerateRootSignature(d3d12GraphicsDevice, InPipelineStateDesc.ResourceBinderDesc);
+
+		Mox::ThrowIfFailed(CreateGraphicsPipelineState(d3d12GraphicsDevice, InPipelineStateDesc, nullptr, 0));
+
+		m_IsInitialized = true;
+	}
+
+	bool D3D12PipelineState::InitFromCachedBlob(GRAPHICS_PSO_DESC& InPipelineStateDesc, const std::vector<uint8_t>& InCachedBlob)
+	{
+		// Layout: root signature size (32 bits) | serialized root signature | cached pipeline state
+		uint32_t rootSignatureSize = 0;
+		if (InCachedBlob.size() < sizeof(rootSignatureSize))
+		{
+			return false;
+		}
+		memcpy(&rootSignatureSize, InCachedBlob.data(), sizeof(rootSignatureSize));
+
+		if (InCachedBlob.size() - sizeof(rootSignatureSize) < rootSignatureSize)
+		{
+			return false;
+		}
+
+		const uint8_t* rootSignatureData = InCachedBlob.data() + sizeof(rootSignatureSize);
+		const uint8_t* pipelineStateData = rootSignatureData + rootSignatureSize;
+		const size_t pipelineStateSize = InCachedBlob.size() - sizeof(rootSignatureSize) - rootSignatureSize;
+
+		Microsoft::WRL::ComPtr<ID3D12Device2> d3d12GraphicsDevice = static_cast<Mox::D3D12Device&>(Mox::GetDevice()).GetInner();
+		if (!GenerateRootSignature(d3d12GraphicsDevice, InPipelineStateDesc.ResourceBinderDesc, rootSignatureData, rootSignatureSize))
+		{
+			return false;
+		}
+
+		// The driver refuses blobs created by a different adapter or driver version, in which case the state needs a full compilation
+		if (FAILED(CreateGraphicsPipelineState(d3d12GraphicsDevice, InPipelineStateDesc, pipelineStateData, pipelineStateSize)))
+		{
+			m_RootSignature.Reset();
+			return false;
+		}
+
+		m_IsGraphicsPSO = true;
+		m_IsInitialized = true;
+
+		return true;
+	}
+
+	std::vector<uint8_t> D3D12PipelineState::GetCachedBlob() const
+	{
+		Microsoft::WRL::ComPtr<ID3DBlob> pipelineStateBlob;
+		if (!m_PipelineState || m_SerializedRootSignature.empty() || FAILED(m_PipelineState->GetCachedBlob(&pipelineStateBlob)))
+		{
+			return {};
+		}
+
+		const uint32_t rootSignatureSize = static_cast<uint32_t>(m_SerializedRootSignature.size());
+
+		std::vector<uint8_t> cachedBlob(sizeof(rootSignatureSize) + rootSignatureSize + pipelineStateBlob->GetBufferSize());
+		memcpy(cachedBlob.data(), &rootSignatureSize, sizeof(rootSignatureSize));
+		memcpy(cachedBlob.data() + sizeof(rootSignatureSize), m_SerializedRootSignature.data(), rootSignatureSize);
+		memcpy(cachedBlob.data() + sizeof(rootSignatureSize) + rootSignatureSize, pipelineStateBlob->GetBufferPointer(), pipelineStateBlob->GetBufferSize());
+
+		return cachedBlob;
+	}
+
+	HRESULT D3D12PipelineState::CreateGraphicsPipelineState(Microsoft::WRL::ComPtr<ID3D12Device2> d3d12GraphicsDevice, GRAPHICS_PSO_DESC& InPipelineStateDesc, 
+		const void* InCachedPipelineState, size_t InCachedPipelineStateSize)
+	{
 		// Generate D3D12 Input Layout
 		std::vector<INPUT_LAYOUT_DESC::LayoutElement>& agnosticLayoutElements = InPipelineStateDesc.InputLayoutDesc.LayoutElements;
 		std::vector<D3D12_INPUT_ELEMENT_DESC> layoutElements;
@@ -148,9 +227,6 @@ namespace Mox{
 		// Convert platform-agnostic parameters into d3d12 specific
 		std::transform(agnosticLayoutElements.begin(), agnosticLayoutElements.end(), std::back_inserter(layoutElements), &D3D12PipelineState::TransformInputLayoutElement);
 
-		Microsoft::WRL::ComPtr<ID3D12Device2> d3d12GraphicsDevice = static_cast<Mox::D3D12Device&>(Mox::GetDevice()).GetInner();
-		GenerateRootSignature(d3d12GraphicsDevice, InPipelineStateDesc.ResourceBinderDesc);
-
 		//RTV Formats
 		D3D12_RT_FORMAT_ARRAY rtvFormats = {};
 		rtvFormats.NumRenderTargets = 1; // Note: we are supporting only 1 render target at the moment
@@ -168,6 +244,7 @@ namespace Mox{
 			CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT DSVFormat;
 			CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS RTVFormats;
 			CD3DX12_PIPELINE_STATE_STREAM_BLEND_DESC BlendDesc;
+			CD3DX12_PIPELINE_STATE_STREAM_CACHED_PSO CachedPSO;
 		} pipelineStateStream;
 
 		pipelineStateStream.pRootSignature = m_RootSignature.Get();
@@ -195,13 +272,12 @@ namespace Mox{
 			  D3D12_COLOR_WRITE_ENABLE_ALL//UINT8          RenderTargetWriteMask;
 		};
 		pipelineStateStream.BlendDesc = blendDesc;
+		pipelineStateStream.CachedPSO = D3D12_CACHED_PIPELINE_STATE{ InCachedPipelineState, InCachedPipelineStateSize };
 
 		D3D12_PIPELINE_STATE_STREAM_DESC pipelineStateStreamDesc = {
 			sizeof(pipelineStateStream), &pipelineStateStream
 		};
-		Mox::ThrowIfFailed(d3d12GraphicsDevice->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&m_PipelineState)));
-
-		m_IsInitialized = true;
+		return d3d12GraphicsDevice->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&m_PipelineState));
 	}
 
 	// Init for a Compute PSO
@@ -230,8 +306,12 @@ namespace Mox{
 		m_IsInitialized = true;
 	}
 
-	void D3D12PipelineState::GenerateRootSignature(Microsoft::WRL::ComPtr<ID3D12Device2> d3d12GraphicsDevice, RESOURCE_BINDER_DESC& InResourceBinder)
+	bool D3D12PipelineState::GenerateRootSignature(Microsoft::WRL::ComPtr<ID3D12Device2> d3d12GraphicsDevice, RESOURCE_BINDER_DESC& InResourceBinder, 
+		const void* InSerializedRootSignature, size_t InSerializedRootSignatureSize)
 	{
+		// A previous attempt from a cached blob could have been rejected
+		m_RootSignatureInfo = RootSignatureInfo();
+
 		// Create Root Signature
 		D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
 		featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
@@ -263,8 +343,29 @@ namespace Mox{
 
 		// Init Root Signature Desc
 		m_RootSignatureInfo.rootSignatureDesc.Init_1_1(rootParameters.size(), rootParameters.data(), staticSamplers.size(), staticSamplers.data(), rootSignatureFlags);
-		// Create Root Signature serialized blob and then the object from it
-		m_RootSignature = Mox::SerializeAndCreateRootSignature(d3d12GraphicsDevice, &m_RootSignatureInfo.rootSignatureDesc, featureData.HighestVersion);
+
+		// The description is still built from the resource binder when the serialized root signature is given, since it is queried by command lists
+		if (InSerializedRootSignature)
+		{
+			if (FAILED(d3d12GraphicsDevice->CreateRootSignature(0, InSerializedRootSignature, InSerializedRootSignatureSize, IID_PPV_ARGS(&m_RootSignature))))
+			{
+				return false;
+			}
+
+			const uint8_t* serializedBytes = static_cast<const uint8_t*>(InSerializedRootSignature);
+			m_SerializedRootSignature.assign(serializedBytes, serializedBytes + InSerializedRootSignatureSize);
+		}
+		else
+		{
+			// Create Root Signature serialized blob and then the object from it
+			Microsoft::WRL::ComPtr<ID3DBlob> serializedBlob;
+			m_RootSignature = Mox::SerializeAndCreateRootSignature(d3d12GraphicsDevice, &m_RootSignatureInfo.rootSignatureDesc, featureData.HighestVersion, &serializedBlob);
+
+			const uint8_t* serializedBytes = static_cast<const uint8_t*>(serializedBlob->GetBufferPointer());
+			m_SerializedRootSignature.assign(serializedBytes, serializedBytes + serializedBlob->GetBufferSize());
+		}
+
+		return true;
 	}
 
 	uint32_t D3D12PipelineState::GenerateRootTableBitMask()
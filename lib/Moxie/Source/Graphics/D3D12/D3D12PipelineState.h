@@ -26,18 +26,32 @@ public:
 
 	virtual void Init(COMPUTE_PSO_DESC& InPipelineStateDesc) override;
 
+	// The blob contains the serialized root signature followed by the driver's cached pipeline state
+	virtual bool InitFromCachedBlob(GRAPHICS_PSO_DESC& InPipelineStateDesc, const std::vector<uint8_t>& InCachedBlob) override;
+
+	virtual std::vector<uint8_t> GetCachedBlob() const override;
+
 
 	Microsoft::WRL::ComPtr<ID3D12PipelineState> GetInnerPSO() { return m_PipelineState; }
 	Microsoft::WRL::ComPtr<ID3D12RootSignature> GetInnerRootSignature() { return m_RootSignature; }
 	CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC& GetInnerRootSignatureDesc() { return m_RootSignatureInfo.rootSignatureDesc; }
 
+	virtual const void* GetResourceBinderHandle() const override { return m_RootSignature.Get(); }
+
 	uint32_t GenerateRootTableBitMask();
 
 	uint32_t GetRootDescriptorsNumAtIndex(uint32_t InRootIndex);
 
 private:
 
-	void GenerateRootSignature(Microsoft::WRL::ComPtr<ID3D12Device2> d3d12GraphicsDevice, RESOURCE_BINDER_DESC& InPipelineStateDesc);
+	// Creates the root signature from the already serialized one when given, otherwise serializes it from the resource binder.
+	// Returns false if the device rejects the given serialized root signature.
+	bool GenerateRootSignature(Microsoft::WRL::ComPtr<ID3D12Device2> d3d12GraphicsDevice, RESOURCE_BINDER_DESC& InPipelineStateDesc, 
+		const void* InSerializedRootSignature = nullptr, size_t InSerializedRootSignatureSize = 0);
+
+	// Creates the graphics pipeline state object once the root signature is ready, optionally starting from a driver cached blob
+	HRESULT CreateGraphicsPipelineState(Microsoft::WRL::ComPtr<ID3D12Device2> d3d12GraphicsDevice, GRAPHICS_PSO_DESC& InPipelineStateDesc, 
+		const void* InCachedPipelineState, size_t InCachedPipelineStateSize);
 
 	bool m_IsInitialized = false;
 
@@ -53,6 +67,9 @@ private:
 	// Pipeline State Object
 	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_PipelineState = nullptr;
 
+	// Kept to be stored in the persistent cache together with the pipeline state
+	std::vector<uint8_t> m_SerializedRootSignature;
+
 
 	struct RootSignatureInfo {
 		CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
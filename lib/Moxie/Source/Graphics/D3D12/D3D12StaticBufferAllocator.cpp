@@ -9,11 +9,14 @@
 #include "D3D12StaticBufferAllocator.h"
 #include "MoxMath.h"
 #include "D3D12CommandList.h"
+#include "UploadTracker.h"
+#include "DeferredReleaseQueue.h"
 
 namespace Mox {
 
 D3D12StaticBufferAllocator::D3D12StaticBufferAllocator(Mox::D3D12Resource& InTargetResource, Mox::D3D12Resource& InStagingResource) : m_Resource(InTargetResource), m_IntermediateResource(InStagingResource),
-	m_RangeAllocator(0, InTargetResource.GetSize()), m_ResourceAlignment(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT)
+	m_RangeAllocator(0, InTargetResource.GetSize()), m_ResourceAlignment(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT),
+	m_StagingRingAllocator(InStagingResource.GetSize())
 {
 
 }
@@ -36,30 +39,46 @@ Mox::BufferResource& D3D12StaticBufferAllocator::Allocate(const Mox::BufferResou
 	return *outResPtr;
 }
 
-void D3D12StaticBufferAllocator::UploadContentUpdates(Mox::CommandList& InCmdList, const std::vector<Mox::BufferResourceUpdate>& InUpdates)
+void D3D12StaticBufferAllocator::Release(const std::unordered_set<const Mox::BufferResource*>& InBuffers, Mox::DeferredReleaseQueue& InOutReleaseQueue)
+{
+	for (const Mox::BufferResource* releasedBuffer : InBuffers)
+	{
+		auto offsetIt = m_BufferOffsetMap.find(releasedBuffer);
+		Check(offsetIt != m_BufferOffsetMap.end())
+
+		// Same aligned size that was asked to the range allocator
+		InOutReleaseQueue.Enqueue(std::make_shared<RangeRelease>(m_RangeAllocator, offsetIt->second, Mox::Align(releasedBuffer->GetSize(), m_ResourceAlignment)));
+
+		m_BufferOffsetMap.erase(offsetIt);
+	}
+
+	InOutReleaseQueue.EnqueueFrom(m_AllocatedBufferResources, InBuffers);
+}
+
+void D3D12StaticBufferAllocator::UploadContentUpdates(Mox::CommandList& InCmdList, Mox::CommandQueue& InUploadQueue, const std::vector<Mox::BufferResourceUpdate>& InUpdates)
 {
 	// Map intermediate resource, copy content in it, unmap it, 
-	// then copy buffer region to transfer changes from the intermediate resource to the target resource
-	std::unordered_map<Mox::BufferResource*, uint32_t> intermediateAllocationOffsetMap;
-	uint32_t currentAllocOffset = 0;
+	// then copy buffer region to transfer changes from the intermediate resource to the target resource.
+	// Each update takes a new range of the intermediate resource, so previous uploads still in flight are not overwritten.
+	std::unordered_map<Mox::BufferResource*, size_t> intermediateAllocationOffsetMap;
 	uint8_t* mappedPtr = nullptr;
 	m_IntermediateResource.Map(&static_cast<void*>(mappedPtr));
 	for (const Mox::BufferResourceUpdate& bufUpdate : InUpdates)
 	{
-		intermediateAllocationOffsetMap[bufUpdate.m_BufResHolder->GetResource()] = currentAllocOffset;
-		memcpy(static_cast<void*>(mappedPtr + currentAllocOffset),
+		const size_t stagingOffset = Mox::AllocateStagingRange(m_StagingRingAllocator, InUploadQueue, bufUpdate.m_UpdateData.size(), m_ResourceAlignment);
+
+		intermediateAllocationOffsetMap[bufUpdate.m_BufResHolder->GetResource()] = stagingOffset;
+		memcpy(static_cast<void*>(mappedPtr + stagingOffset),
 			bufUpdate.m_UpdateData.data(), bufUpdate.m_UpdateData.size());
-		currentAllocOffset += Mox::Align(bufUpdate.m_UpdateData.size(), m_ResourceAlignment);
 	}
 
 	m_IntermediateResource.UnMap();
 
-	
-	Mox::TransitionInfoVector resBarriers{
-		{&m_Resource,Mox::RESOURCE_STATE::GEN_READ, Mox::RESOURCE_STATE::COPY_DEST}
-	};
+	// On copy lists no barrier is recorded, the buffer gets implicitly promoted to copy destination
+	InCmdList.TransitionResource(m_Resource, Mox::RESOURCE_STATE::COPY_DEST);
 
-	static_cast<Mox::D3D12CommandList&>(InCmdList).ResourceBarriers(resBarriers);
+	// The copies are recorded directly on the platform list, so the pending transitions need to be recorded first
+	InCmdList.FlushResourceBarriers();
 
 	// Here we expect every buffer to already have its own graphics resource
 	for (const Mox::BufferResourceUpdate& bufUpdate : InUpdates)
@@ -72,11 +91,8 @@ void D3D12StaticBufferAllocator::UploadContentUpdates(Mox::CommandList& InCmdLis
 				bufUpdate.m_UpdateData.size());
 	}
 
-	resBarriers = Mox::TransitionInfoVector {
-		{&m_Resource,Mox::RESOURCE_STATE::COPY_DEST, Mox::RESOURCE_STATE::GEN_READ}
-	};
-
-	static_cast<Mox::D3D12CommandList&>(InCmdList).ResourceBarriers(resBarriers);
+	// Recorded together with the next transitions, right before the first command reading the buffer
+	InCmdList.TransitionResource(m_Resource, Mox::RESOURCE_STATE::GEN_READ);
 
 }
 
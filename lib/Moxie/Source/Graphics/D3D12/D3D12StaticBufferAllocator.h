@@ -14,6 +14,9 @@
 
 namespace Mox {
 
+class CommandQueue;
+class DeferredReleaseQueue;
+
 /* Allocates buffer resources as sub-allocations from a graphics resource in default heap. */
 class D3D12StaticBufferAllocator
 {
@@ -23,11 +26,30 @@ public:
 	Mox::BufferResource& Allocate(const Mox::BufferResourceRequest& InRequest);
 
 	// Sends a command to update buffer resources with the given updates.
-	// Note: the buffer updates are considered to be in memory up until the command list finishes executing the command.
-	void UploadContentUpdates(Mox::CommandList& InCmdList, const std::vector<Mox::BufferResourceUpdate>& InUpdates);
+	// Update data is copied to staging memory, which stays reserved until the upload fence value is retired.
+	void UploadContentUpdates(Mox::CommandList& InCmdList, Mox::CommandQueue& InUploadQueue, const std::vector<Mox::BufferResourceUpdate>& InUpdates);
+
+	void OnUploadSubmitted(uint64_t InFenceValue) { m_StagingRingAllocator.CloseBatch(InFenceValue); }
 
+	void RetireStagingMemory(uint64_t InCompletedFenceValue) { m_StagingRingAllocator.Retire(InCompletedFenceValue); }
+
+	// Hands the given buffers over to the release queue, their ranges become available again once the Gpu stopped reading them
+	void Release(const std::unordered_set<const Mox::BufferResource*>& InBuffers, Mox::DeferredReleaseQueue& InOutReleaseQueue);
 
 private:
+	// Gives a range back to the range allocator when destroyed, which happens when the release queue reclaims it
+	struct RangeRelease
+	{
+		RangeRelease(Mox::StaticRangeAllocator& InRangeAllocator, uint32_t InRangeOffset, uint32_t InRangeSize)
+			: m_RangeAllocator(InRangeAllocator), m_RangeOffset(InRangeOffset), m_RangeSize(InRangeSize) { }
+
+		~RangeRelease() { m_RangeAllocator.FreeAllocatedRange(m_RangeOffset, m_RangeSize); }
+
+		Mox::StaticRangeAllocator& m_RangeAllocator;
+		uint32_t m_RangeOffset;
+		uint32_t m_RangeSize;
+	};
+
 	// Resource in dedicated memory (default heap) to contain buffers content
 	Mox::D3D12Resource& m_Resource;
 	// Staging resource in upload memory (upload heap) to serve as a bridge between CPU and reserved memory
@@ -38,9 +60,12 @@ private:
 
 	Mox::StaticRangeAllocator m_RangeAllocator;
 
+	// Sub-allocates the intermediate resource between the uploads in flight
+	Mox::FencedRingAllocator m_StagingRingAllocator;
+
 	std::vector<std::unique_ptr<Mox::BufferResource>> m_AllocatedBufferResources;
 
-	std::unordered_map<Mox::BufferResource*, uint32_t> m_BufferOffsetMap;
+	std::unordered_map<const Mox::BufferResource*, uint32_t> m_BufferOffsetMap;
 };
 
 }
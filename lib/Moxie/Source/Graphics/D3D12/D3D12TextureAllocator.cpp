@@ -13,12 +13,14 @@
 #include "RangeAllocators.h"
 #include "D3D12GraphicsAllocator.h"
 #include "D3D12CommandList.h"
+#include "UploadTracker.h"
 
 namespace Mox {
 
 D3D12TextureAllocator::D3D12TextureAllocator(size_t InHeapSize, Mox::D3D12Resource& InStagingResource)
 	: m_StagingResource(InStagingResource), m_AllocationsAlignment(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT),
-	 m_PoolSize(Mox::Align(InHeapSize, m_AllocationsAlignment)), m_RangeAllocator(std::make_unique<Mox::StaticRangeAllocator>(0, m_PoolSize))
+	 m_PoolSize(Mox::Align(InHeapSize, m_AllocationsAlignment)), m_RangeAllocator(std::make_unique<Mox::StaticRangeAllocator>(0, m_PoolSize)),
+	 m_StagingRingAllocator(InStagingResource.GetSize())
 {
 	// Create heap
 	CD3DX12_HEAP_DESC heapDesc = CD3DX12_HEAP_DESC(InHeapSize, D3D12_HEAP_TYPE_DEFAULT);
@@ -66,17 +68,15 @@ Mox::TextureResource& D3D12TextureAllocator::Allocate(const TextureDesc& InDesc)
 		IID_PPV_ARGS(&newD3D12Res)
 		);
 
-	Mox::Resource& newResource = static_cast<Mox::D3D12GraphicsAllocator*>(Mox::GraphicsAllocator::Get())->AllocateD3D12Resource(newD3D12Res, D3D12_RES_TYPE::Texture, allocInfo.SizeInBytes);
+	Mox::Resource& newResource = static_cast<Mox::D3D12GraphicsAllocator*>(Mox::GraphicsAllocator::Get())->AllocateD3D12Resource(newD3D12Res, D3D12_RES_TYPE::Texture, allocInfo.SizeInBytes, Mox::RESOURCE_STATE::COPY_DEST);
 		
 	m_TextureArray.emplace_back(std::make_unique<Mox::TextureResource>(InDesc, newResource, 0, allocInfo.SizeInBytes));
 
 	return *m_TextureArray.back().get();
 }
 
-void D3D12TextureAllocator::UpdateContent(Mox::CommandList& InCmdList, const std::vector<Mox::TextureResourceUpdate>& InTexUpdates)
+void D3D12TextureAllocator::UpdateContent(Mox::CommandList& InCmdList, Mox::CommandQueue& InUploadQueue, const std::vector<Mox::TextureResourceUpdate>& InTexUpdates)
 {
-	uint64_t intermediateOffset = 0;
-
 	for (const Mox::TextureResourceUpdate& curUpdate : InTexUpdates)
 	{
 		// Expected to find a contiguous memory of subresources in the data to upload
@@ -113,8 +113,17 @@ void D3D12TextureAllocator::UpdateContent(Mox::CommandList& InCmdList, const std
 			};
 
 			mip0Footprints[i] = curTexResource.GetSubresourceFootprints()[i];
+
+			InCmdList.TransitionResource(curTexResource, Mox::RESOURCE_STATE::COPY_DEST, i);
 		}
 
+		// The copy is recorded directly on the platform list, so the pending transitions need to be recorded first
+		InCmdList.FlushResourceBarriers();
+
+		// Reserve the staging memory for this update, it accounts for the row pitch alignment of the subresources
+		const uint64_t requiredStagingSize = ::GetRequiredIntermediateSize(curTexResource.GetInner().Get(), 0, subresourceUpdatesNum);
+		const uint64_t intermediateOffset = Mox::AllocateStagingRange(m_StagingRingAllocator, InUploadQueue, requiredStagingSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
 		UINT64 uploadEsit = ::UpdateSubresources(
 			static_cast<Mox::D3D12CommandList&>(InCmdList).GetInner().Get(),		//_In_ ID3D12GraphicsCommandList * pCmdList,
 			curTexResource.GetInner().Get(),										//_In_ ID3D12Resource * pDestinationResource,
@@ -127,8 +136,6 @@ void D3D12TextureAllocator::UpdateContent(Mox::CommandList& InCmdList, const std
 			
 
 		Check(uploadEsit > 0) // This should return the resource required size. If 0 is returned, the operation failed.
-			
-		intermediateOffset += Mox::Align(curUpdate.m_UpdateSize, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
 
 	}
 
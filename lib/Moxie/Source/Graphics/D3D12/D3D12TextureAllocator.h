@@ -9,11 +9,14 @@
 #ifndef D3D12TextureAllocator_h__
 #define D3D12TextureAllocator_h__
 
+#include "RangeAllocators.h"
+
 namespace Mox {
 
 struct D3D12Resource;
 class TextureResource;
 class StaticRangeAllocator;
+class CommandQueue;
 
 class D3D12TextureAllocator
 {
@@ -22,7 +25,13 @@ public:
 
 	Mox::TextureResource& Allocate(const TextureDesc& InDesc);
 
-	void UpdateContent(Mox::CommandList& InCmdList, const std::vector<Mox::TextureResourceUpdate>& InTexUpdates);
+	// Records the copies of the given updates from staging memory.
+	// The used staging memory stays reserved until the upload fence value is retired.
+	void UpdateContent(Mox::CommandList& InCmdList, Mox::CommandQueue& InUploadQueue, const std::vector<Mox::TextureResourceUpdate>& InTexUpdates);
+
+	void OnUploadSubmitted(uint64_t InFenceValue) { m_StagingRingAllocator.CloseBatch(InFenceValue); }
+
+	void RetireStagingMemory(uint64_t InCompletedFenceValue) { m_StagingRingAllocator.Retire(InCompletedFenceValue); }
 
 private:
 	// Default heap where placed texture resources will be allocated on
@@ -38,6 +47,9 @@ private:
 	std::vector<std::unique_ptr<Mox::TextureResource>> m_TextureArray;
 
 	std::unique_ptr<Mox::StaticRangeAllocator> m_RangeAllocator;
+
+	// Sub-allocates the staging resource between the uploads in flight
+	Mox::FencedRingAllocator m_StagingRingAllocator;
 };
 
 }
@@ -0,0 +1,99 @@
+/*
+ D3D12TransientResourceAllocator.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#include "D3D12TransientResourceAllocator.h"
+#include "D3D12MoxUtils.h"
+#include "D3D12Device.h"
+#include "D3D12UtilsInternal.h"
+#include "DeferredReleaseQueue.h"
+#include "MoxMath.h"
+
+namespace Mox {
+
+	namespace
+	{
+		D3D12_RESOURCE_DESC BuildTextureDesc(const Mox::RgTextureDesc& InDesc)
+		{
+			return CD3DX12_RESOURCE_DESC::Tex2D(Mox::BufferFormatToD3D12(InDesc.m_Format), InDesc.m_Width, InDesc.m_Height, 1, 1, 1, 0, Mox::ResFlagsToD3D12(InDesc.m_Flags));
+		}
+	}
+
+	D3D12TransientResourceAllocator::D3D12TransientResourceAllocator(Mox::DeferredReleaseQueue& InReleaseQueue)
+		: m_ReleaseQueue(InReleaseQueue)
+	{
+
+	}
+
+	D3D12TransientResourceAllocator::~D3D12TransientResourceAllocator() = default;
+
+	void D3D12TransientResourceAllocator::GetTextureAllocationInfo(const Mox::RgTextureDesc& InDesc, uint64_t& OutSize, uint64_t& OutAlignment)
+	{
+		const D3D12_RESOURCE_DESC texResDesc = BuildTextureDesc(InDesc);
+
+		const D3D12_RESOURCE_ALLOCATION_INFO allocInfo = static_cast<Mox::D3D12Device&>(GetDevice()).GetInner()->GetResourceAllocationInfo(0, 1, &texResDesc);
+
+		OutSize = allocInfo.SizeInBytes;
+		OutAlignment = allocInfo.Alignment;
+	}
+
+	void D3D12TransientResourceAllocator::ReserveMemory(uint64_t InSize)
+	{
+		if (InSize <= m_HeapSize)
+		{
+			return;
+		}
+
+		// Textures of the previous heap can still be referenced by the frames in flight
+		if (m_Heap)
+		{
+			m_ReleaseQueue.Enqueue(std::make_shared<Microsoft::WRL::ComPtr<ID3D12Heap>>(std::move(m_Heap)));
+		}
+
+		for (PlacedTexture& placedTexture : m_PlacedTextures)
+		{
+			m_ReleaseQueue.Enqueue(std::move(placedTexture.m_Resource));
+		}
+		m_PlacedTextures.clear();
+
+		m_HeapSize = Mox::Align(InSize, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+
+		// Render target and depth stencil textures can only share a heap with other textures of the same kind on resource heap tier 1
+		CD3DX12_HEAP_DESC heapDesc = CD3DX12_HEAP_DESC(m_HeapSize, D3D12_HEAP_TYPE_DEFAULT, 0, D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES);
+		Mox::ThrowIfFailed(static_cast<Mox::D3D12Device&>(GetDevice()).GetInner()->CreateHeap(&heapDesc, IID_PPV_ARGS(&m_Heap)));
+	}
+
+	Mox::Resource& D3D12TransientResourceAllocator::PlaceTexture(const Mox::RgTextureDesc& InDesc, uint64_t InHeapOffset, Mox::RESOURCE_STATE InInitialState)
+	{
+		for (PlacedTexture& placedTexture : m_PlacedTextures)
+		{
+			if (placedTexture.m_HeapOffset == InHeapOffset && placedTexture.m_Desc == InDesc)
+			{
+				return *placedTexture.m_Resource;
+			}
+		}
+
+		const D3D12_RESOURCE_DESC texResDesc = BuildTextureDesc(InDesc);
+
+		Microsoft::WRL::ComPtr<ID3D12Resource> newD3D12Res;
+		Mox::ThrowIfFailed(static_cast<Mox::D3D12Device&>(GetDevice()).GetInner()->CreatePlacedResource(
+			m_Heap.Get(),
+			InHeapOffset,
+			&texResDesc,
+			Mox::ResStateTypeToD3D12(InInitialState),
+			nullptr,
+			IID_PPV_ARGS(&newD3D12Res)
+		));
+
+		D3D12_RESOURCE_ALLOCATION_INFO allocInfo = static_cast<Mox::D3D12Device&>(GetDevice()).GetInner()->GetResourceAllocationInfo(0, 1, &texResDesc);
+
+		m_PlacedTextures.push_back({ InDesc, InHeapOffset, std::make_unique<Mox::D3D12Resource>(newD3D12Res, D3D12_RES_TYPE::Texture, allocInfo.SizeInBytes, InInitialState) });
+
+		return *m_PlacedTextures.back().m_Resource;
+	}
+
+}
@@ -0,0 +1,57 @@
+/*
+ D3D12TransientResourceAllocator.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef D3D12TransientResourceAllocator_h__
+#define D3D12TransientResourceAllocator_h__
+
+#include "RenderGraph.h"
+
+namespace Mox {
+
+	struct D3D12Resource;
+	class DeferredReleaseQueue;
+
+	/*
+	* Places the transient textures of the render graph as placed resources in a single heap, at the offsets chosen by the graph.
+	* Placed resources can overlap in the heap, so textures are created once per desc and offset and kept until the heap grows.
+	*/
+	class D3D12TransientResourceAllocator : public Mox::TransientResourceAllocator
+	{
+	public:
+		// Replaced heaps and their textures can still be used by the frames in flight, so they are handed over to the given queue
+		D3D12TransientResourceAllocator(Mox::DeferredReleaseQueue& InReleaseQueue);
+
+		~D3D12TransientResourceAllocator();
+
+		void GetTextureAllocationInfo(const Mox::RgTextureDesc& InDesc, uint64_t& OutSize, uint64_t& OutAlignment) override;
+
+		void ReserveMemory(uint64_t InSize) override;
+
+		Mox::Resource& PlaceTexture(const Mox::RgTextureDesc& InDesc, uint64_t InHeapOffset, Mox::RESOURCE_STATE InInitialState) override;
+
+	private:
+		struct PlacedTexture
+		{
+			Mox::RgTextureDesc m_Desc;
+			uint64_t m_HeapOffset;
+			std::unique_ptr<Mox::D3D12Resource> m_Resource;
+		};
+
+		Mox::DeferredReleaseQueue& m_ReleaseQueue;
+
+		Microsoft::WRL::ComPtr<ID3D12Heap> m_Heap;
+
+		uint64_t m_HeapSize = 0;
+
+		// Few textures are expected, so they are looked up linearly
+		std::vector<PlacedTexture> m_PlacedTextures;
+	};
+
+}
+
+#endif // D3D12TransientResourceAllocator_h__
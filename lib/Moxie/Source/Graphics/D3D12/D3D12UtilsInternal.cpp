@@ -65,6 +65,8 @@ D3D12_RESOURCE_STATES ResStateTypeToD3D12(Mox::RESOURCE_STATE InResState)
 	case Mox::RESOURCE_STATE::COPY_SOURCE: return D3D12_RESOURCE_STATE_COPY_SOURCE;
 	case Mox::RESOURCE_STATE::COPY_DEST: return D3D12_RESOURCE_STATE_COPY_DEST;
 	case Mox::RESOURCE_STATE::GEN_READ: return D3D12_RESOURCE_STATE_GENERIC_READ;
+	case Mox::RESOURCE_STATE::DEPTH_WRITE: return D3D12_RESOURCE_STATE_DEPTH_WRITE;
+	case Mox::RESOURCE_STATE::UNORDERED_ACCESS: return D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
 	default: StopForFail("Resource State Type not handled");
 	}
 	return D3D12_RESOURCE_STATE_GENERIC_READ;
@@ -241,13 +241,7 @@ namespace Mox
 
 	void D3D12Window::ClearRtAndDs(Mox::CommandList& InCmdList)
 {
-		// Transitioning current backbuffer resource to render target state
-		// We can be sure that the previous state was present because in this application all the render targets
-		// are first filled and then presented to the main window repetitevely.
-		InCmdList.ResourceBarriers(TransitionInfoVector{ 
-			{&m_BackBuffers[m_CurrentBackBufferIndex], RESOURCE_STATE::PRESENT, RESOURCE_STATE::RENDER_TARGET} 
-			});
-
+		// Note: the back buffer transitions from and to present state are recorded by the render graph
 		float clearColor[] = { .4f, .6f, .9f, 1.f };
 		InCmdList.ClearRTV(GetCurrentRTVDescriptorHandle(), clearColor);
 
@@ -261,6 +255,11 @@ namespace Mox
 		return m_BackBuffers[m_CurrentBackBufferIndex] ;
 	}
 
+	Mox::Resource& D3D12Window::GetDepthStencilBuffer()
+	{
+		return *m_DSBuffer;
+	}
+
 	void D3D12Window::CreateHWND(const wchar_t* InWindowClassName, HINSTANCE InHInstance, const wchar_t* InWindowTitle, uint32_t width, uint32_t height)
 	{
 		int32_t screenWidth = ::GetSystemMetrics(SM_CXSCREEN);
@@ -351,7 +350,7 @@ namespace Mox
 
 			m_CurrentDevice->CreateRenderTargetView(tempBB.Get(), nullptr, rtvDescHeapHandle);
 
-			m_BackBuffers.emplace_back(tempBB, Mox::D3D12_RES_TYPE::BackBuffer);
+			m_BackBuffers.emplace_back(tempBB, Mox::D3D12_RES_TYPE::BackBuffer, 0, Mox::RESOURCE_STATE::PRESENT);
 
 			rtvDescHeapHandle.Offset(m_RTVDescIncrementSize); // Shift rtvDescHandle pointer to the next element in desc heap
 		}
@@ -364,15 +363,27 @@ namespace Mox
 		D3D12_CLEAR_VALUE optimizedClearValue = {};
 		optimizedClearValue.Format = DXGI_FORMAT_D32_FLOAT;
 		optimizedClearValue.DepthStencil = { 1.f, 0 }; 
-		// Note: passing the same address of ID3DResource of m_DSBuffer to CreateDepthStencilCommittedResource on a second call of this function
-		// will actually replace (update) the committed resource on the GPU (and so it will recreate the corresponding heap)
-
-		m_DSBuffer.Reset(); // Note: Need to release the interface to the previous depth-stencil buffer before assigning to a new one or there will be an interface leak!
+		if (m_DSBuffer)
+		{
+			m_DSBuffer->GetInner().Reset(); // Note: Need to release the interface to the previous depth-stencil buffer before assigning to a new one or there will be an interface leak!
+		}
 
-		Mox::CreateDepthStencilCommittedResource(m_CurrentDevice, m_DSBuffer.GetAddressOf(), m_FrameWidth, M_FrameHeight,
+		ComPtr<ID3D12Resource> dsBuffer;
+		Mox::CreateDepthStencilCommittedResource(m_CurrentDevice, dsBuffer.GetAddressOf(), m_FrameWidth, M_FrameHeight,
 			D3D12_RESOURCE_STATE_DEPTH_WRITE, &optimizedClearValue);
+
+		if (m_DSBuffer)
+		{
+			m_DSBuffer->SetInner(dsBuffer);
+			m_DSBuffer->SetTrackedState(Mox::RESOURCE_STATE::DEPTH_WRITE);
+		}
+		else
+		{
+			m_DSBuffer = std::make_unique<Mox::D3D12Resource>(dsBuffer, Mox::D3D12_RES_TYPE::Texture, 0, Mox::RESOURCE_STATE::DEPTH_WRITE);
+		}
+
 		// Need to update the view pointing to the updated resource
-		Mox::CreateDepthStencilView(m_CurrentDevice, m_DSBuffer.Get(), m_DSVHeap->GetCPUDescriptorHandleForHeapStart());
+		Mox::CreateDepthStencilView(m_CurrentDevice, dsBuffer.Get(), m_DSVHeap->GetCPUDescriptorHandleForHeapStart());
 	}
 
 	void D3D12Window::UpdateBufferResourcesAndViews()
@@ -389,6 +400,7 @@ namespace Mox
 			m_CurrentDevice->CreateRenderTargetView(backBuffer.Get(), nullptr, rtvDescHeapHandle);
 
 			m_BackBuffers[bufferIdx].SetInner(backBuffer);
+			m_BackBuffers[bufferIdx].SetTrackedState(Mox::RESOURCE_STATE::PRESENT);
 
 			// Move the CPU descriptor handle to the next element on the heap
 			rtvDescHeapHandle.Offset(m_RTVDescIncrementSize);
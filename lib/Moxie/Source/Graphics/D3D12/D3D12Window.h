@@ -81,6 +81,8 @@ namespace Mox {
 
 		virtual Mox::Resource& GetCurrentBackBuffer() override;
 
+		virtual Mox::Resource& GetDepthStencilBuffer() override;
+
 	private:
 
 		void RegisterWindowClass(HINSTANCE hInst, const wchar_t* windowClassName, WNDPROC InWndProc);
@@ -108,7 +110,8 @@ namespace Mox {
 		// Replaced with the platform-agnostic version in Window
 		uint64_t m_FrameFenceValues[m_DefaultBufferCount] = { 0 }; // Note: important to initialize every member variable, otherwise it could contain garbage!
 		ComPtr<ID3D12DescriptorHeap> m_RTVDescriptorHeap;
-		ComPtr<ID3D12Resource> m_DSBuffer;
+		// Replaced by UpdateDepthStencil on resize, keeping the same Mox resource so that the render graph can import it every frame
+		std::unique_ptr<Mox::D3D12Resource> m_DSBuffer;
 		// DS buffer views need to be contained in a heap even if we use just one
 		ComPtr<ID3D12DescriptorHeap> m_DSVHeap;
 		UINT m_RTVDescIncrementSize = 0;
@@ -0,0 +1,56 @@
+/*
+ DeferredReleaseQueue.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#include "DeferredReleaseQueue.h"
+#include "MoxUtils.h"
+
+namespace Mox {
+
+	void DeferredReleaseQueue::Enqueue(std::shared_ptr<void> InObject)
+	{
+		if (InObject)
+		{
+			m_OpenBatch.push_back(std::move(InObject));
+			m_PendingObjectsNum++;
+		}
+	}
+
+	void DeferredReleaseQueue::CloseBatch(uint64_t InFenceValue)
+	{
+		if (m_OpenBatch.empty())
+		{
+			return;
+		}
+
+		Check(m_PendingBatches.empty() || m_PendingBatches.back().m_FenceValue <= InFenceValue)
+
+		m_PendingBatches.push_back(PendingBatch{ InFenceValue, std::move(m_OpenBatch) });
+
+		m_OpenBatch = std::vector<std::shared_ptr<void>>();
+	}
+
+	void DeferredReleaseQueue::Reclaim(uint64_t InCompletedFenceValue)
+	{
+		while (!m_PendingBatches.empty() && m_PendingBatches.front().m_FenceValue <= InCompletedFenceValue)
+		{
+			m_PendingObjectsNum -= m_PendingBatches.front().m_Objects.size();
+
+			m_PendingBatches.pop_front();
+		}
+	}
+
+	void DeferredReleaseQueue::ReleaseAll()
+	{
+		m_PendingBatches.clear();
+
+		m_OpenBatch.clear();
+
+		m_PendingObjectsNum = 0;
+	}
+
+}
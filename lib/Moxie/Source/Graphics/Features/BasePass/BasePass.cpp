@@ -14,22 +14,28 @@
 #include "MoxDrawable.h"
 #include "GraphicsAllocator.h"
 #include "MoxUtils.h"
+#include "ContextView.h"
+#include "MoxMaterial.h"
 
 namespace Mox {
 
 	// SPH = Shader Parameter Hash
-	static constexpr SpHash SPH_mvp = Mox::HashSpName("mvp");
 
-	// Color modifier for the pixel shader
+	// Per-instance data of the draw, see InstanceData
+	static constexpr SpHash SPH_instances = Mox::HashSpName("instances");
+
+	// Per-view view-projection matrix
+	static constexpr SpHash SPH_view_proj = Mox::HashSpName("view_proj");
+
+	// Color modifier for the pixel shader, read from the drawable buffer and written in the instance data
 	static constexpr SpHash SPH_c_mod = Mox::HashSpName("c_mod");
 
-	// Cubemap texture
+	// Cubemap textures, indexed with the instance data
 	static constexpr SpHash SPH_albedo_cube = Mox::HashSpName("albedo_cube");
 
+	// 2D textures, indexed with the instance data
 	static constexpr SpHash SPH_albedo_tex = Mox::HashSpName("albedo_tex");
 
-	static constexpr SpHash SPH_features_field = Mox::HashSpName("features_field");
-
 	enum DRAW_FEATURES : uint32_t
 	{
 		COLOR_MOD = 1,
@@ -37,6 +43,30 @@ namespace Mox {
 		COLOR_CUBE = 4,
 	};
 
+	// Per-instance bindings of the commands, in the order they are pushed by BuildDrawCommand
+	enum INSTANCE_BINDING : uint32_t
+	{
+		INSTANCE_BINDING_FEATURES,
+		INSTANCE_BINDING_COLOR_MOD,
+		INSTANCE_BINDING_COLOR_TEX,
+		INSTANCE_BINDING_COLOR_CUBE
+	};
+
+	// Element of the instances buffer, it needs to match the InstanceData struct in BasePass_VS.hlsl and BasePass_PS.hlsl
+	struct InstanceData
+	{
+		Mox::Matrix4f m_Model;
+
+		uint32_t m_FeaturesField;
+
+		float m_ColorModifier;
+
+		// Heap indices of the texture views, see ShaderResourceView::GetHeapIndex
+		uint32_t m_ColorTextureIndex;
+
+		uint32_t m_ColorCubeIndex;
+	};
+
 	// Hashmap holding information about shader parameters that the pipeline requires for drawing.
 	// This map is tied to the current pipeline state used. At the moment here in base pass we have only one,
 	// but in a generic case we can have multiple possible pipeline states, which can have same shader parameters
@@ -60,15 +90,14 @@ namespace Mox {
 	{
 		// Note: in a more serious context this information should come from the shader reflection system.
 		m_ShaderParamDefinitionMap = {
-			{SPH_mvp, {0, "mvp", Mox::SHADER_PARAM_TYPE::CONSTANT_BUFFER, 0, 0}},
-			{SPH_features_field, {1, "features_field", Mox::SHADER_PARAM_TYPE::CONSTANT_BUFFER, 0, 1}},
-			{SPH_c_mod, {2, "c_mod", Mox::SHADER_PARAM_TYPE::CONSTANT_BUFFER, 1, 1}},
-			{SPH_albedo_tex, {3, "albedo_tex", Mox::SHADER_PARAM_TYPE::TEXTURE, 0, 1}},
-			{SPH_albedo_cube, {4, "albedo_cube", Mox::SHADER_PARAM_TYPE::TEXTURE, 1, 1}},
+			{SPH_instances, {0, "instances", Mox::SHADER_PARAM_TYPE::STRUCTURED_BUFFER, 0, 0}},
+			{SPH_albedo_tex, {1, "albedo_tex", Mox::SHADER_PARAM_TYPE::TEXTURE, 0, 1}},
+			{SPH_albedo_cube, {2, "albedo_cube", Mox::SHADER_PARAM_TYPE::TEXTURE, 0, 2}},
+			{SPH_view_proj, {3, "view_proj", Mox::SHADER_PARAM_TYPE::CONSTANT_BUFFER, 1, 0}},
 		};
 
 		//Create Root Signature
-		// Allow Input layout access to shader resources (in out case, the MVP matrix) 
+		// Allow Input layout access to shader resources (in out case, the model and view-projection matrices) 
 		// and deny it to other stages (small optimization)
 		static Mox::PipelineState::RESOURCE_BINDER_DESC resourceBinderDesc;
 		resourceBinderDesc.Flags =
@@ -78,52 +107,44 @@ namespace Mox {
 			Mox::PipelineState::RESOURCE_BINDER_FLAGS::DENY_GEOMETRY_SHADER_ACCESS;
 
 
-		// Mvp matrix
-		Mox::PipelineState::RESOURCE_BINDER_PARAM mvpMatrixParam;
-		const Mox::ShaderParameterDefinition& mvpSpInfo = m_ShaderParamDefinitionMap[SPH_mvp];
-		mvpMatrixParam.InitAsTableCBVRange(1, mvpSpInfo.m_RegisterIndex, mvpSpInfo.m_SpaceIndex, Mox::SHADER_VISIBILITY::SV_VERTEX);
-
-		resourceBinderDesc.Params.emplace(resourceBinderDesc.Params.end(), std::move(mvpMatrixParam));
-
-
-		// FeaturesField is set as a root descriptor (size of 1 d-word = 32bits) and it will be used by the pixel shader
-		Mox::PipelineState::RESOURCE_BINDER_PARAM featuresFieldParam;
-		const Mox::ShaderParameterDefinition& featuresFieldSpInfo = m_ShaderParamDefinitionMap[SPH_features_field];
-		featuresFieldParam.InitAsConstants(1, featuresFieldSpInfo.m_RegisterIndex, featuresFieldSpInfo.m_SpaceIndex, Mox::SHADER_VISIBILITY::SV_PIXEL);
-
-		resourceBinderDesc.Params.emplace(resourceBinderDesc.Params.end(), std::move(featuresFieldParam));
+		// Instances buffer, set as a root descriptor since it is placed in per-frame memory that has no descriptor.
+		// Both shaders read it: the vertex shader for the transform and the pixel shader for the other per-object parameters.
+		Mox::PipelineState::RESOURCE_BINDER_PARAM instancesParam;
+		const Mox::ShaderParameterDefinition& instancesSpInfo = m_ShaderParamDefinitionMap[SPH_instances];
+		instancesParam.InitAsShaderResourceView(instancesSpInfo.m_RegisterIndex, instancesSpInfo.m_SpaceIndex, Mox::SHADER_VISIBILITY::SV_ALL);
 
-		// Constant buffer ColorModifierCB
-		Mox::PipelineState::RESOURCE_BINDER_PARAM colorModifierParam;
-		const Mox::ShaderParameterDefinition& cModSpInfo = m_ShaderParamDefinitionMap[SPH_c_mod];
-		colorModifierParam.InitAsTableCBVRange(1, cModSpInfo.m_RegisterIndex, cModSpInfo.m_SpaceIndex, Mox::SHADER_VISIBILITY::SV_PIXEL);
+		resourceBinderDesc.Params.emplace(resourceBinderDesc.Params.end(), std::move(instancesParam));
 
-		resourceBinderDesc.Params.emplace(resourceBinderDesc.Params.end(), std::move(colorModifierParam));
-
-		// 2D texture
+		// 2D textures, as a table over the whole descriptor heap that each instance indexes with its own texture index.
+		// Textures are not bound per draw, so that objects differing only in them can still be drawn as instances.
 		Mox::PipelineState::RESOURCE_BINDER_PARAM texParam;
 		const Mox::ShaderParameterDefinition& texSpInfo = m_ShaderParamDefinitionMap[SPH_albedo_tex];
-		texParam.InitAsTableSRVRange(1, texSpInfo.m_RegisterIndex, texSpInfo.m_SpaceIndex, Mox::SHADER_VISIBILITY::SV_PIXEL);
+		texParam.InitAsTableSRVRange(Mox::PipelineState::RESOURCE_BINDER_PARAM::UnboundedDescriptorsNum, texSpInfo.m_RegisterIndex, texSpInfo.m_SpaceIndex, Mox::SHADER_VISIBILITY::SV_PIXEL);
 
 		resourceBinderDesc.Params.emplace(resourceBinderDesc.Params.end(), std::move(texParam));
 
-		// Cubemap texture
+		// Cubemap textures, the same table for a different texture type
 		Mox::PipelineState::RESOURCE_BINDER_PARAM cubemapParam;
 		const Mox::ShaderParameterDefinition& cubemapSpInfo = m_ShaderParamDefinitionMap[SPH_albedo_cube];
-		cubemapParam.InitAsTableSRVRange(1, cubemapSpInfo.m_RegisterIndex, cubemapSpInfo.m_SpaceIndex, Mox::SHADER_VISIBILITY::SV_PIXEL);
+		cubemapParam.InitAsTableSRVRange(Mox::PipelineState::RESOURCE_BINDER_PARAM::UnboundedDescriptorsNum, cubemapSpInfo.m_RegisterIndex, cubemapSpInfo.m_SpaceIndex, Mox::SHADER_VISIBILITY::SV_PIXEL);
 
 		resourceBinderDesc.Params.emplace(resourceBinderDesc.Params.end(), std::move(cubemapParam));
 
+		// View-projection matrix is set as root constants (16 d-words), written once per view instead of being part of each object buffer
+		Mox::PipelineState::RESOURCE_BINDER_PARAM viewProjParam;
+		const Mox::ShaderParameterDefinition& viewProjSpInfo = m_ShaderParamDefinitionMap[SPH_view_proj];
+		viewProjParam.InitAsConstants(sizeof(Mox::Matrix4f) / 4, viewProjSpInfo.m_RegisterIndex, viewProjSpInfo.m_SpaceIndex, Mox::SHADER_VISIBILITY::SV_VERTEX);
+
+		resourceBinderDesc.Params.emplace(resourceBinderDesc.Params.end(), std::move(viewProjParam));
+
 		// Static sampler for the cubemap
 		resourceBinderDesc.StaticSamplers.emplace_back(0, SAMPLE_FILTER_TYPE::LINEAR, TEXTURE_ADDRESS_MODE::CLAMP);
 
 		
 
 		// --- Shader Loading ---
-		// Note: to generate the .cso file I will be using the offline method, using fxc.exe integrated in visual studio (but downloadable separately).
-		// fxc command can be used by opening a developer command console in the hlsl shader folder.
-		// To generate VertexShader.cso I will be using: fxc /Zi /T vs_5_1 /Fo VertexShader.cso VertexShader.hlsl
-		// To generate PixelShader.cso I will be using: fxc /Zi /T ps_5_1 /Fo PixelShader.cso PixelShader.hlsl
+		// Note: .cso files are compiled from the hlsl sources by the build, with fxc from the Windows SDK (see the Moxie CMakeLists).
+		// Bytecode then always matches the root signature defined above.
 
 		// Load the Vertex Shader
 		Mox::Shader& vertexShader = Mox::AllocateShader(MOX_SHADERS_PATH(BasePass_VS.cso));
@@ -150,185 +171,212 @@ namespace Mox {
 
 	}
 
-	void BasePass::ProcessRenderProxy(Mox::RenderProxy& InProxy)
+	bool BasePass::BuildDrawCommand(const Mox::RenderProxy& InProxy, const Mox::Drawable& InDrawable, Mox::DrawCommand& OutCommand)
 	{
-		// Note: for now we assume the proxy is relevant for this pass
-
-		// Generate draw command from each mesh to later use it on draw
-		for (const Mox::Drawable* curMesh : InProxy.m_Meshes)
-		{	
-			// featuresFiled is a bitfield intended as a cheap way to 
-			// enable selective features inside the single base pass shader.
-			// 
-			uint32_t featuresFiled = 0;
-
-			// SRV entries -----
-			std::vector<SrvEntry> srvEntries;
+		// Note: for now we assume every drawable is relevant for this pass
 
-			// Cube param
+		// featuresFiled is a bitfield intended as a cheap way to 
+		// enable selective features inside the single base pass shader.
+		// 
+		uint32_t featuresFiled = 0;
 
-			std::unordered_map<Mox::SpHash, Mox::Texture*>::const_iterator cubeTexParamValue = curMesh->m_TextureShaderParameters.find(SPH_albedo_cube);
+		// SRV entries -----
 
-			Mox::ShaderResourceView* CubeTexSrv;
+		// Cube param
 
-			if (cubeTexParamValue != curMesh->m_TextureShaderParameters.cend())
-			{
-				featuresFiled |= DRAW_FEATURES::COLOR_CUBE;
-				CubeTexSrv = cubeTexParamValue->second->GetResource()->GetView();
-			}
-			else
-			{
-				// Bind null descriptor
-				CubeTexSrv = Mox::ShaderResourceView::GetNullCube();
-			}
+		std::unordered_map<Mox::SpHash, Mox::Texture*>::const_iterator cubeTexParamValue = InDrawable.m_TextureShaderParameters.find(SPH_albedo_cube);
 
-			srvEntries.emplace_back(m_ShaderParamDefinitionMap[SPH_albedo_cube].PipelineRootIndex, CubeTexSrv);
+		Mox::ShaderResourceView* CubeTexSrv;
 
-			// Tex param
-
-			std::unordered_map<Mox::SpHash, Mox::Texture*>::const_iterator texParamValue = curMesh->m_TextureShaderParameters.find(SPH_albedo_tex);
+		if (cubeTexParamValue != InDrawable.m_TextureShaderParameters.cend())
+		{
+			featuresFiled |= DRAW_FEATURES::COLOR_CUBE;
+			CubeTexSrv = cubeTexParamValue->second->GetResource()->GetView();
+		}
+		else
+		{
+			// Null view, not sampled by the shader since the feature is off
+			CubeTexSrv = Mox::ShaderResourceView::GetNullCube();
+		}
 
-			Mox::ShaderResourceView* texSrv;
+		// Tex param
 
-			if (texParamValue != curMesh->m_TextureShaderParameters.cend())
-			{
-				featuresFiled |= DRAW_FEATURES::COLOR_TEX;
-				texSrv = texParamValue->second->GetResource()->GetView();
-			}
-			else
-			{
-				// Bind null descriptor
-				texSrv = Mox::ShaderResourceView::GetNull2D();
-			}
+		std::unordered_map<Mox::SpHash, Mox::Texture*>::const_iterator texParamValue = InDrawable.m_TextureShaderParameters.find(SPH_albedo_tex);
 
-			srvEntries.emplace_back(m_ShaderParamDefinitionMap[SPH_albedo_tex].PipelineRootIndex, texSrv);
+		Mox::ShaderResourceView* texSrv;
 
-			// CBV entries -----
-			std::vector<CbvEntry> cbvEntries;
+		if (texParamValue != InDrawable.m_TextureShaderParameters.cend())
+		{
+			featuresFiled |= DRAW_FEATURES::COLOR_TEX;
+			texSrv = texParamValue->second->GetResource()->GetView();
+		}
+		else
+		{
+			// Null view, not sampled by the shader since the feature is off
+			texSrv = Mox::ShaderResourceView::GetNull2D();
+		}
 
-			// We just need to store the reference to the mvp view, since the other info,
-			// such as the root index and the size of data, is already known and expected by the pass.
+		// Buffer entries -----
+		// Note: the model matrix is not one of them. It is taken from the proxy when drawing and written in the instances buffer,
+		// so that commands differing only in their transform can be drawn together.
 
-			// Note: we are assuming to find entries for relative parameters every time
-			std::unordered_map<Mox::SpHash, Mox::ConstantBuffer*>::const_iterator mvpParamValue = curMesh->m_BufferShaderParameters.find(SPH_mvp);
+		std::unordered_map<Mox::SpHash, Mox::ConstantBuffer*>::const_iterator cModParamValue = InDrawable.m_BufferShaderParameters.find(SPH_c_mod);
 
-			Check(mvpParamValue != curMesh->m_BufferShaderParameters.cend()) // If this triggers, we are missing the MVP shader param value for this mesh
+		Mox::BufferResource* cmodBuffer = nullptr;
+		if (cModParamValue != InDrawable.m_BufferShaderParameters.cend())
+		{
+			featuresFiled |= DRAW_FEATURES::COLOR_MOD;
+			cmodBuffer = cModParamValue->second->GetResource();
+		}
 
-			cbvEntries.emplace_back(m_ShaderParamDefinitionMap[SPH_mvp].PipelineRootIndex, static_cast<Mox::ConstantBufferView*>(mvpParamValue->second->GetResource()->GetView()));
+		// Now the input layout desc passed to the PSO needs to contain all the shader parameters defined by the vertex shader,
+		// not just the ones of the current vertex buffer.
+		// We need to have exactly the parameters required by the shader (in any order) and for this, a temp layout desc is created
+		// and by calling BuildLeftover all the parameters will match the default input layout desc.
+		Mox::INPUT_LAYOUT_DESC currentLayoutDesc = InDrawable.m_VertexBuffer.GetLayoutDesc();
+
+		currentLayoutDesc.BuildLeftover(m_DefaultInputLayoutDesc);
+
+		// The default PSO desc with the layout and the culling mode of the drawable. 
+		// The default desc refers to the default layout, so it is not modified.
+		Mox::PipelineState::GRAPHICS_PSO_DESC drawablePSODesc{
+			currentLayoutDesc,
+			m_DefaultPSODesc->ResourceBinderDesc,
+			m_DefaultPSODesc->TopologyType,
+			m_DefaultPSODesc->VertexShader,
+			m_DefaultPSODesc->PixelShader,
+			m_DefaultPSODesc->DSFormat,
+			m_DefaultPSODesc->RTFormat,
+			InDrawable.m_RenderBackfaces
+		};
 
-			std::unordered_map<Mox::SpHash, Mox::ConstantBuffer*>::const_iterator cModParamValue = curMesh->m_BufferShaderParameters.find(SPH_c_mod);
+		// Meshes with the same layout and culling mode share the same Pipeline State Object
+		Mox::PipelineState& currentPSO = GraphicsAllocator::Get()->GetPipelineStateCache().GetOrCreate(drawablePSODesc);
 
-			Mox::ConstantBufferView* cmodCbv;
-			if (cModParamValue != curMesh->m_BufferShaderParameters.cend())
-			{
-				featuresFiled |= DRAW_FEATURES::COLOR_MOD;
-				cmodCbv = static_cast<Mox::ConstantBufferView*>(cModParamValue->second->GetResource()->GetView());
-			}
-			else
-			{
-				cmodCbv = Mox::ConstantBufferView::GetNull();
-			}
+		Mox::VertexBufferView& vertexBufferView = static_cast<Mox::VertexBufferView&>(*InDrawable.m_VertexBuffer.GetResource()->GetView());
+		Mox::IndexBufferView& indexBufferView = static_cast<Mox::IndexBufferView&>(*InDrawable.m_IndexBuffer.GetResource()->GetView());
 
-			cbvEntries.emplace_back(m_ShaderParamDefinitionMap[SPH_c_mod].PipelineRootIndex, cmodCbv);
+		// Bindings are stored in the pass arena, in INSTANCE_BINDING order. 
+		// They are all per-instance: nothing is bound for a single command, its parameters are written in the instance data when drawing.
+		const uint32_t firstBinding = m_DrawBindings.GetBindingsNum();
 
-			// CONST Entries -----
-			std::vector<std::byte> featFieldContent(sizeof(featuresFiled));
-			memcpy(featFieldContent.data(), &featuresFiled, sizeof(featuresFiled));
-			std::vector<Mox::ConstEntry> constEntries {
-				Mox::ConstEntry(m_ShaderParamDefinitionMap[SPH_features_field].PipelineRootIndex, std::move(featFieldContent))
-			};
+		m_DrawBindings.PushConstants(Mox::DrawBinding::PerInstanceRootIndex, &featuresFiled, 1);
 
-			Mox::PipelineState& currentPSO = GraphicsAllocator::Get()->AllocatePipelineState();
-			
-			// Now the input layout desc passed to the PSO needs to contain all the shader parameters defined by the vertex shader,
-			// not just the ones of the current vertex buffer.
-			// We need to have exactly the parameters required by the shader (in any order) and for this, a temp layout desc is created
-			// and by calling BuildLeftover all the parameters will match the default input layout desc.
-			static Mox::INPUT_LAYOUT_DESC currentLayoutDesc = curMesh->m_VertexBuffer.GetLayoutDesc();
+		m_DrawBindings.PushBuffer(cmodBuffer);
 
-			currentLayoutDesc.BuildLeftover(m_DefaultInputLayoutDesc);
+		m_DrawBindings.PushSrv(Mox::DrawBinding::PerInstanceRootIndex, *texSrv);
 
-			// Assign the newly created input layout desc to the default PSO which for the rest, remains unchanged
-			m_DefaultPSODesc->InputLayoutDesc = currentLayoutDesc;
+		m_DrawBindings.PushSrv(Mox::DrawBinding::PerInstanceRootIndex, *CubeTexSrv);
 
-			// If to render backfaces or front faces
-			m_DefaultPSODesc->RenderBackfaces = curMesh->m_RenderBackfaces;
+		OutCommand.m_SourceProxy = &InProxy;
 
+		OutCommand.m_WorldBounds = &InDrawable.m_WorldBounds;
 
-			//Init the Pipeline State Object
-			currentPSO.Init(*m_DefaultPSODesc.get());
+		OutCommand.m_StateSortKey = ComputeStateSortKey(currentPSO, InDrawable.m_Material.m_ID, vertexBufferView, indexBufferView);
 
+		OutCommand.m_VertexBufferView = &vertexBufferView;
 
-			m_DrawCommands.emplace_back(
+		OutCommand.m_IndexBufferView = &indexBufferView;
 
-				static_cast<Mox::VertexBufferView&>(*curMesh->m_VertexBuffer.GetResource()->GetView()),
+		OutCommand.m_PipelineState = &currentPSO;
 
-				static_cast<Mox::IndexBufferView&>(*curMesh->m_IndexBuffer.GetResource()->GetView()),
+		OutCommand.m_IndicesNum = indexBufferView.GetElementsNum();
 
-				currentPSO,
+		OutCommand.m_FirstBinding = firstBinding;
 
-				cbvEntries,
+		OutCommand.m_BindingsNum = static_cast<uint16_t>(m_DrawBindings.GetBindingsNum() - firstBinding);
 
-				srvEntries,
+		// Coarser meshes share the pipeline state, since they are expected to have the same vertex layout
+		PushDrawLods(InDrawable, currentPSO, InDrawable.m_Material.m_ID, OutCommand);
 
-				constEntries
-			);
-		}
+		return true;
 	}
 
-	void BasePass::SendDrawCommands(Mox::CommandList& InCmdList)
+	void BasePass::SendDrawCommands(Mox::CommandList& InCmdList, const Mox::ContextView& InView)
 	{
-		for (const DrawCommand& dc : m_DrawCommands)
+		const uint32_t viewProjRootIdx = m_ShaderParamDefinitionMap[SPH_view_proj].PipelineRootIndex;
+		const uint32_t instancesRootIdx = m_ShaderParamDefinitionMap[SPH_instances].PipelineRootIndex;
+		const uint32_t texturesRootIdx = m_ShaderParamDefinitionMap[SPH_albedo_tex].PipelineRootIndex;
+		const uint32_t cubesRootIdx = m_ShaderParamDefinitionMap[SPH_albedo_cube].PipelineRootIndex;
+
+		// Only the commands whose drawable is in the view frustum get recorded
+		const std::vector<uint32_t>& visibleCommands = SortDrawCommands(InView, CullDrawCommands(InView));
+		if (visibleCommands.empty())
 		{
-			InCmdList.SetPipelineStateAndResourceBinder(dc.m_PipelineState);
+			return;
+		}
 
-			InCmdList.SetInputAssemblerData(Mox::PRIMITIVE_TOPOLOGY::PT_TRIANGLELIST, dc.m_VertexBufferView, dc.m_IndexBufferView);
+		// Instance data of all the visible commands, in recording order, so that each instanced draw reads a contiguous range of it
+		void* instancesCpuPtr; Mox::GPU_V_ADDRESS instancesGpuPtr;
+		GraphicsAllocator::Get()->AllocateFrameData(static_cast<uint32_t>(visibleCommands.size() * sizeof(InstanceData)), instancesCpuPtr, instancesGpuPtr);
+		InstanceData* instances = static_cast<InstanceData*>(instancesCpuPtr);
 
-			// Setting Resources
-			
-			// CBVs
-			// Checking if we have all the descriptors on gpu we need
-			for(const CbvEntry & curCbvEntry : dc.m_CbvResourceEntries)
-			{
-				// [uint32_t, Mox::ConstantBufferView*]
-				auto [rootIdx, curCbv] = curCbvEntry;
-				// If the view is Gpu allocated, just reference the view in the command list
-				if (curCbv->IsGpuAllocated())
-				{
-					InCmdList.ReferenceCBV(rootIdx, *curCbv);
-				}
-				else
-				// Otherwise we stage it to dynamically allocate one in the position it belongs
-				{
-					InCmdList.StageDynamicCbv(rootIdx, *curCbv);
-				}
-			}
-			// Pushing all the staged descriptors to Gpu and assigning them to the root signature
-			InCmdList.CommitStagedViews();
+		size_t batchEnd = 0;
+		for (size_t batchStart = 0; batchStart < visibleCommands.size(); batchStart = batchEnd)
+		{
+			const DrawCommand& dc = m_DrawCommands[visibleCommands[batchStart]];
 
-			// SRVs
-			for (const SrvEntry& curSrvEntry : dc.m_SrvResourceEntries)
+			// Commands sharing state are next to each other after sorting, and they become a single draw
+			// since all the parameters that differ among them are per-instance
+			batchEnd = batchStart + 1;
+			while (batchEnd < visibleCommands.size() && m_DrawBindings.CanBeInstanced(dc, m_DrawCommands[visibleCommands[batchEnd]]))
 			{
-				// [uint32_t, Mox::ShaderResourceView*]
-				auto [rootIdx, curSrv] = curSrvEntry;
-				// SRVs are expected to be already allocated as textures are considered static resources
-				InCmdList.ReferenceSRV(rootIdx, *curSrv);
+				++batchEnd;
 			}
 
-			// Root constants
-			// [uint32_t, std::vector<std::byte> curData]
-			for (const ConstEntry& curRootEntry : dc.m_ConstEntries)
+			// Note: the memory is write-combined, so it is filled in order and never read back
+			for (size_t instanceIdx = batchStart; instanceIdx < batchEnd; ++instanceIdx)
 			{
-				auto [rootIdx, curData] = curRootEntry;
-				Check(curData.size() % 4 == 0)
-				InCmdList.SetGraphicsRootConstants(rootIdx, curData.size()/4, curData.data(), 0);
+				const DrawCommand& instanceDc = m_DrawCommands[visibleCommands[instanceIdx]];
+				const Mox::DrawBinding* instanceBindings = m_DrawBindings.GetBindings(instanceDc);
+				InstanceData& instance = instances[instanceIdx];
+
+				memcpy(&instance.m_Model, instanceDc.m_SourceProxy->m_ModelMatrix.data(), sizeof(Mox::Matrix4f));
+
+				instance.m_FeaturesField = *m_DrawBindings.GetConstantValues(instanceBindings[INSTANCE_BINDING_FEATURES]);
+
+				// The modifier is read from the content the buffer has this frame, the shader does not read it for drawables without one
+				const Mox::BufferResource* colorModBuffer = instanceBindings[INSTANCE_BINDING_COLOR_MOD].m_Buffer;
+				instance.m_ColorModifier = colorModBuffer ? *static_cast<const float*>(colorModBuffer->GetLocalData()) : 1.f;
+
+				instance.m_ColorTextureIndex = instanceBindings[INSTANCE_BINDING_COLOR_TEX].m_Srv->GetHeapIndex();
+
+				instance.m_ColorCubeIndex = instanceBindings[INSTANCE_BINDING_COLOR_CUBE].m_Srv->GetHeapIndex();
 			}
-			
 
-			InCmdList.DrawIndexed(dc.m_IndexBufferView.GetElementsNum());
+			// The whole state of the draw is set every time: the command list drops the binds that would not change what is bound,
+			// and commands are sorted by state, so most of it carries over from one draw to the next
+			InCmdList.SetPipelineStateAndResourceBinder(*dc.m_PipelineState);
+
+			// Setting a different resource binder resets root arguments, in which case the per-view constants are set again.
+			// This only records the 16 d-words in the command list, nothing is uploaded per object.
+			InCmdList.SetGraphicsRootConstants(viewProjRootIdx, sizeof(Mox::Matrix4f) / 4, InView.m_ViewProjMatrix.data(), 0);
+
+			// Texture tables cover the whole heap, every draw indexes them
+			InCmdList.ReferenceViewsHeap(texturesRootIdx);
+
+			InCmdList.ReferenceViewsHeap(cubesRootIdx);
+
+			InCmdList.SetInputAssemblerData(Mox::PRIMITIVE_TOPOLOGY::PT_TRIANGLELIST, *dc.m_VertexBufferView, *dc.m_IndexBufferView);
+
+			// Instance ids start from 0 for each draw, so the buffer is bound from the first instance of the batch
+			InCmdList.SetGraphicsRootShaderResource(instancesRootIdx, instancesGpuPtr + batchStart * sizeof(InstanceData));
+
+			InCmdList.DrawIndexed(dc.m_IndicesNum, static_cast<uint32_t>(batchEnd - batchStart));
 		}
 
 	}
 
+	void BasePass::AddToRenderGraph(Mox::RenderGraph& InOutGraph, const Mox::ContextView& InView, const Mox::RgViewTargets& InTargets)
+	{
+		InOutGraph.AddPass("BasePass", {}, { {InTargets.m_Color, Mox::RESOURCE_STATE::RENDER_TARGET}, {InTargets.m_Depth, Mox::RESOURCE_STATE::DEPTH_WRITE} },
+			[this, &InView, bindTargets = InTargets.m_BindTargets](Mox::CommandList& InCmdList)
+			{
+				bindTargets(InCmdList);
+
+				SendDrawCommands(InCmdList, InView);
+			});
+	}
+
 
 }
@@ -0,0 +1,135 @@
+/*
+ DrawCommand.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#include "DrawCommand.h"
+
+namespace Mox {
+
+	void DrawBindingArena::PushCbv(uint32_t InRootIndex, Mox::ConstantBufferView& InCbv)
+	{
+		Mox::DrawBinding& newBinding = m_Bindings.emplace_back();
+		newBinding.m_RootIndex = InRootIndex;
+		newBinding.m_Type = Mox::DRAW_BINDING_TYPE::CBV;
+		newBinding.m_Cbv = &InCbv;
+	}
+
+	void DrawBindingArena::PushSrv(uint32_t InRootIndex, Mox::ShaderResourceView& InSrv)
+	{
+		Mox::DrawBinding& newBinding = m_Bindings.emplace_back();
+		newBinding.m_RootIndex = InRootIndex;
+		newBinding.m_Type = Mox::DRAW_BINDING_TYPE::SRV;
+		newBinding.m_Srv = &InSrv;
+	}
+
+	void DrawBindingArena::PushConstants(uint32_t InRootIndex, const void* InValues, uint32_t InValuesNum)
+	{
+		Mox::DrawBinding& newBinding = m_Bindings.emplace_back();
+		newBinding.m_RootIndex = InRootIndex;
+		newBinding.m_Type = Mox::DRAW_BINDING_TYPE::CONSTANTS;
+		newBinding.m_Constants.m_First = static_cast<uint32_t>(m_ConstantValues.size());
+		newBinding.m_Constants.m_Num = InValuesNum;
+
+		const uint32_t* values = static_cast<const uint32_t*>(InValues);
+		m_ConstantValues.insert(m_ConstantValues.end(), values, values + InValuesNum);
+	}
+
+	void DrawBindingArena::PushBuffer(Mox::BufferResource* InBuffer)
+	{
+		Mox::DrawBinding& newBinding = m_Bindings.emplace_back();
+		newBinding.m_RootIndex = Mox::DrawBinding::PerInstanceRootIndex;
+		newBinding.m_Type = Mox::DRAW_BINDING_TYPE::BUFFER;
+		newBinding.m_Buffer = InBuffer;
+	}
+
+	bool DrawBindingArena::AreBindingsEqual(const Mox::DrawBinding& InFirst, const Mox::DrawBinding& InSecond) const
+	{
+		if (InFirst.m_RootIndex != InSecond.m_RootIndex || InFirst.m_Type != InSecond.m_Type)
+		{
+			return false;
+		}
+
+		switch (InFirst.m_Type)
+		{
+		case Mox::DRAW_BINDING_TYPE::CBV:
+			return InFirst.m_Cbv == InSecond.m_Cbv;
+		case Mox::DRAW_BINDING_TYPE::SRV:
+			return InFirst.m_Srv == InSecond.m_Srv;
+		case Mox::DRAW_BINDING_TYPE::BUFFER:
+			return InFirst.m_Buffer == InSecond.m_Buffer;
+		case Mox::DRAW_BINDING_TYPE::CONSTANTS:
+		{
+			const uint32_t* firstValues = GetConstantValues(InFirst);
+			return InFirst.m_Constants.m_Num == InSecond.m_Constants.m_Num
+				&& std::equal(firstValues, firstValues + InFirst.m_Constants.m_Num, GetConstantValues(InSecond));
+		}
+		default:
+			return false;
+		}
+	}
+
+	bool DrawBindingArena::CanBeInstanced(const Mox::DrawCommand& InFirst, const Mox::DrawCommand& InSecond) const
+	{
+		if (InFirst.m_PipelineState != InSecond.m_PipelineState
+			|| InFirst.m_VertexBufferView != InSecond.m_VertexBufferView || InFirst.m_IndexBufferView != InSecond.m_IndexBufferView
+			|| InFirst.m_BindingsNum != InSecond.m_BindingsNum)
+		{
+			return false;
+		}
+
+		const Mox::DrawBinding* firstBindings = GetBindings(InFirst);
+		const Mox::DrawBinding* secondBindings = GetBindings(InSecond);
+		for (uint32_t bindingIdx = 0; bindingIdx < InFirst.m_BindingsNum; ++bindingIdx)
+		{
+			if (!firstBindings[bindingIdx].IsPerInstance() && !AreBindingsEqual(firstBindings[bindingIdx], secondBindings[bindingIdx]))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void DrawBindingArena::Compact(Mox::SlotMap<Mox::DrawCommand>& InOutCommands)
+	{
+		std::vector<Mox::DrawBinding> keptBindings;
+		std::vector<uint32_t> keptConstantValues;
+		std::vector<Mox::DrawLod> keptLods;
+		keptBindings.reserve(m_Bindings.size());
+		keptConstantValues.reserve(m_ConstantValues.size());
+		keptLods.reserve(m_Lods.size());
+
+		for (Mox::DrawCommand& drawCommand : InOutCommands)
+		{
+			const uint32_t firstKeptBinding = static_cast<uint32_t>(keptBindings.size());
+
+			for (uint32_t bindingIdx = drawCommand.m_FirstBinding; bindingIdx < drawCommand.m_FirstBinding + drawCommand.m_BindingsNum; ++bindingIdx)
+			{
+				Mox::DrawBinding& keptBinding = keptBindings.emplace_back(m_Bindings[bindingIdx]);
+
+				if (keptBinding.m_Type == Mox::DRAW_BINDING_TYPE::CONSTANTS)
+				{
+					const uint32_t* values = GetConstantValues(keptBinding);
+					keptBinding.m_Constants.m_First = static_cast<uint32_t>(keptConstantValues.size());
+					keptConstantValues.insert(keptConstantValues.end(), values, values + keptBinding.m_Constants.m_Num);
+				}
+			}
+
+			drawCommand.m_FirstBinding = firstKeptBinding;
+
+			const uint32_t firstKeptLod = static_cast<uint32_t>(keptLods.size());
+			keptLods.insert(keptLods.end(), m_Lods.begin() + drawCommand.m_FirstLod, m_Lods.begin() + drawCommand.m_FirstLod + drawCommand.m_LodsNum);
+			drawCommand.m_FirstLod = firstKeptLod;
+		}
+
+		m_Bindings = std::move(keptBindings);
+		m_ConstantValues = std::move(keptConstantValues);
+		m_Lods = std::move(keptLods);
+		m_ReleasedBindingsNum = 0;
+	}
+
+}
@@ -32,9 +32,14 @@ namespace Mox {
 
 		void SetupPass(Mox::CommandList& InCmdList) override;
 
-		void ProcessRenderProxy(Mox::RenderProxy& InProxy) override;
+		void SendDrawCommands(Mox::CommandList& InCmdList, const Mox::ContextView& InView) override;
 
-		void SendDrawCommands(Mox::CommandList& InCmdList) override;
+		// Draws in the color and depth targets of the view, testing and writing depth
+		void AddToRenderGraph(Mox::RenderGraph& InOutGraph, const Mox::ContextView& InView, const Mox::RgViewTargets& InTargets) override;
+
+	protected:
+
+		bool BuildDrawCommand(const Mox::RenderProxy& InProxy, const Mox::Drawable& InDrawable, Mox::DrawCommand& OutCommand) override;
 
 	private:
 
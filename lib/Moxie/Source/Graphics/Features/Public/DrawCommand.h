@@ -9,51 +9,185 @@
 #ifndef DrawCommand_h__
 #define DrawCommand_h__
 
+#include "SlotMap.h"
 
 namespace Mox {
 
 	class PipelineState;
+	class RenderProxy;
+	struct Aabb;
 	struct IndexBufferView;
 	struct VertexBufferView;
 	struct ConstantBufferView;
+	struct ShaderResourceView;
+	struct BufferResource;
 
-	// In form of: std::tuple<RootIndex, ResourceView*>
-	using CbvEntry = std::tuple<uint32_t, Mox::ConstantBufferView*>;
-	using SrvEntry = std::tuple<uint32_t, Mox::ShaderResourceView*>;
-	// In form of: std::tuple<RootIndex, Content>
-	using ConstEntry = std::tuple<uint32_t, std::vector<std::byte>>;
+	enum class DRAW_BINDING_TYPE : uint32_t
+	{
+		CBV,
+		SRV,
+		CONSTANTS,
+		// Buffer whose content is read on the Cpu, only for per-instance bindings
+		BUFFER
+	};
+
+	// Resource or constants bound at a root index of the pipeline state for a draw command.
+	// Per-instance bindings are not bound: the pass reads them when writing the instance data of the command, 
+	// so that commands differing only in those can still be drawn as instances of a single draw.
+	struct DrawBinding
+	{
+		// Root index of the bindings that are written in the instance data by the pass
+		static constexpr uint32_t PerInstanceRootIndex = UINT32_MAX;
+
+		bool IsPerInstance() const { return m_RootIndex == PerInstanceRootIndex; }
+
+		uint32_t m_RootIndex;
+
+		Mox::DRAW_BINDING_TYPE m_Type;
+
+		union
+		{
+			Mox::ConstantBufferView* m_Cbv;
+
+			Mox::ShaderResourceView* m_Srv;
+
+			Mox::BufferResource* m_Buffer;
+
+			// Range of 32 bit values in the constant values of the arena
+			struct
+			{
+				uint32_t m_First;
+				uint32_t m_Num;
+			} m_Constants;
+		};
+	};
+
+	// Geometry of a level of detail of a draw command, see DrawCommand::m_FirstLod
+	struct DrawLod
+	{
+		uint64_t m_StateSortKey;
+
+		Mox::VertexBufferView* m_VertexBufferView;
+
+		Mox::IndexBufferView* m_IndexBufferView;
+
+		uint32_t m_IndicesNum;
+
+		// The level is drawn while the projected size of the command bounds, as a fraction of the view height, is at least this one.
+		// It is zero for the last level.
+		float m_MinScreenSize;
+	};
 
 	/*
 	DrawCommand abstracts a single draw call for a single object on a single render pass.
 	It will be generated and stored in the render pass, and updated among render proxy or material updates.
+	It is a fixed size record without owned memory: its bindings are a range of the bindings arena of the pass,
+	so that going through the commands every frame is a linear walk over two contiguous arrays, without allocations.
 	*/
 	struct DrawCommand
 	{
-		DrawCommand(Mox::VertexBufferView& InVb, Mox::IndexBufferView& InIb, Mox::PipelineState& InPs, 
-			std::vector<CbvEntry> InCbvs, std::vector<SrvEntry> InSrvs = std::vector<SrvEntry>(), 
-			std::vector<ConstEntry> InConsts = std::vector<ConstEntry>())
-			: m_VertexBufferView(InVb), m_IndexBufferView(InIb), m_PipelineState(InPs), 
-			// Note: This is good for both lvalues and rvalues passes to InRe. 
-			m_CbvResourceEntries( std::move(InCbvs)), m_SrvResourceEntries( std::move(InSrvs)),
-			m_ConstEntries(std::move(InConsts)){ }; 
-		// The reason is:
-		// - If we pass an lvalue, InRe gets COPY constructed and then moved to m_ResourceEntries
-		// - If we pass an rvalue, InRe gets MOVE constructed and then moved to m_ResourceEntries
-		// So either way, the new object gets constructed only once and never copied in vain.
-		// More info here https://www.fluentcpp.com/2018/07/17/how-to-construct-c-objects-without-making-copies/
+		// Proxy the command was generated from, used to find the commands to remove when the proxy gets released
+		const Mox::RenderProxy* m_SourceProxy;
+
+		// Bounds of the drawable the command was generated from, kept up to date by the source proxy
+		const Mox::Aabb* m_WorldBounds;
+
+		// Sort key without the depth part, see RenderPass::ComputeStateSortKey.
+		// This and the geometry fields below are the ones of the level of detail selected for the view being drawn.
+		uint64_t m_StateSortKey;
+
+		Mox::VertexBufferView* m_VertexBufferView;
+
+		Mox::IndexBufferView* m_IndexBufferView;
+
+		Mox::PipelineState* m_PipelineState;
+
+		// Cached from the index buffer view, to not reach for it on every draw
+		uint32_t m_IndicesNum;
+
+		// Range of the command bindings in the arena, see DrawBindingArena
+		uint32_t m_FirstBinding;
+
+		// Range of the levels of detail of the command in the arena, from the most detailed.
+		// Commands with a single level have none, their geometry never changes.
+		uint32_t m_FirstLod;
+
+		uint16_t m_BindingsNum;
+
+		uint8_t m_LodsNum;
+
+		// Level last selected for the command, used to only switch level once the screen size moved past the threshold by a margin
+		uint8_t m_SelectedLod;
+	};
+
+	static_assert(std::is_trivially_copyable_v<Mox::DrawCommand>, "DrawCommand is expected to be copied as plain memory");
+	static_assert(sizeof(Mox::DrawCommand) <= 64, "DrawCommand is expected to fit in a cache line");
+
+	/*
+	* Contiguous storage for the bindings and the levels of detail of the draw commands of a render pass.
+	* Bindings and levels of a command are pushed one after the other right before storing the command,
+	* then they are only read until the command gets removed or regenerated, when they are released.
+	* Released entries keep their space until the arena is compacted.
+	*/
+	class DrawBindingArena
+	{
+	public:
+
+		// Index the next pushed binding will have, to be used as first binding of a command
+		uint32_t GetBindingsNum() const { return static_cast<uint32_t>(m_Bindings.size()); }
+
+		void PushCbv(uint32_t InRootIndex, Mox::ConstantBufferView& InCbv);
+
+		void PushSrv(uint32_t InRootIndex, Mox::ShaderResourceView& InSrv);
+
+		// Copies the given 32 bit values in the arena
+		void PushConstants(uint32_t InRootIndex, const void* InValues, uint32_t InValuesNum);
+
+		// Per-instance binding only, see DrawBinding::PerInstanceRootIndex.
+		// The buffer is null for parameters the drawable does not have, so that every command of the pass has the same bindings.
+		void PushBuffer(Mox::BufferResource* InBuffer);
+
+		// Index the next pushed level will have, to be used as first level of a command
+		uint32_t GetLodsNum() const { return static_cast<uint32_t>(m_Lods.size()); }
+
+		void PushLod(const Mox::DrawLod& InLod) { m_Lods.push_back(InLod); }
+
+		const Mox::DrawBinding* GetBindings(const Mox::DrawCommand& InCommand) const { return m_Bindings.data() + InCommand.m_FirstBinding; }
+
+		const Mox::DrawLod* GetLods(const Mox::DrawCommand& InCommand) const { return m_Lods.data() + InCommand.m_FirstLod; }
+
+		// False when no command of the pass has levels of detail, so that their selection can be skipped
+		bool HasLods() const { return !m_Lods.empty(); }
+
+		const uint32_t* GetConstantValues(const Mox::DrawBinding& InBinding) const { return m_ConstantValues.data() + InBinding.m_Constants.m_First; }
+
+		// True if both commands bind the same pipeline state, geometry and resources,
+		// so that they can be recorded as instances of a single draw differing only in per-instance data.
+		// Per-instance bindings are not compared, the commands of a pass are expected to push the same ones in the same order.
+		bool CanBeInstanced(const Mox::DrawCommand& InFirst, const Mox::DrawCommand& InSecond) const;
+
+		// Marks the bindings and the levels of the command as no longer referenced
+		void Release(const Mox::DrawCommand& InCommand) { m_ReleasedBindingsNum += InCommand.m_BindingsNum; }
+
+		// True when most of the bindings in the arena are released
+		bool NeedsCompaction() const { return m_ReleasedBindingsNum * 2 > m_Bindings.size(); }
+
+		// Removes the bindings and the levels no longer referenced by the given commands, and updates the commands to the new ranges
+		void Compact(Mox::SlotMap<Mox::DrawCommand>& InOutCommands);
 
-		Mox::VertexBufferView& m_VertexBufferView;
+	private:
 
-		Mox::IndexBufferView& m_IndexBufferView;
+		// True if both bindings set the same view or the same constant values at the same root index
+		bool AreBindingsEqual(const Mox::DrawBinding& InFirst, const Mox::DrawBinding& InSecond) const;
 
-		Mox::PipelineState& m_PipelineState;
+		std::vector<Mox::DrawBinding> m_Bindings;
 
-		std::vector<ConstEntry> m_ConstEntries;
+		uint32_t m_ReleasedBindingsNum = 0;
 
-		std::vector<CbvEntry> m_CbvResourceEntries;
+		std::vector<uint32_t> m_ConstantValues;
 
-		std::vector<SrvEntry> m_SrvResourceEntries;
+		std::vector<Mox::DrawLod> m_Lods;
 	};
 
 }
-#endif // DrawCommand_h__
\ No newline at end of file
+#endif // DrawCommand_h__
@@ -9,20 +9,96 @@
 #ifndef RenderPass_h__
 #define RenderPass_h__
 #include "DrawCommand.h"
+#include "MoxFrustumCulling.h"
+#include "MoxDynamicBvh.h"
+#include "RadixSort.h"
+#include "SlotMap.h"
+#include "RenderGraph.h"
+#include <map>
 
 namespace Mox {
 
 	class RenderProxy;
+	class Drawable;
 	class CommandList;
+	class PipelineState;
+	struct ContextView;
+	struct VertexBufferView;
+	struct IndexBufferView;
 
 
 	using RenderPassVector = std::vector<std::unique_ptr<class RenderPass>>;
 
+	// Identifies the draw command generated by a pass for a drawable, it is invalidated when the command gets removed
+	using DrawCommandId = Mox::SlotMapHandle;
+
+	// Render graph resources a view is drawn into
+	struct RgViewTargets
+	{
+		Mox::RgResourceHandle m_Color;
+		Mox::RgResourceHandle m_Depth;
+
+		// Sets viewport, scissor rect and render targets of the view, to be called by each graph pass drawing in the targets
+		std::function<void(Mox::CommandList&)> m_BindTargets;
+	};
+
+	// Gives small ids to the states packed in the sort keys, counting the users of each state.
+	// Ids of states without users anymore are handed out again, so ids stay below the number of states in use at the same time.
+	template <typename KeyType>
+	class SortIdTable
+	{
+	public:
+		uint32_t Acquire(const KeyType& InKey)
+		{
+			auto entryIt = m_Entries.find(InKey);
+			if (entryIt == m_Entries.end())
+			{
+				uint32_t newId = static_cast<uint32_t>(m_Entries.size());
+				if (!m_FreeIds.empty())
+				{
+					newId = m_FreeIds.back();
+					m_FreeIds.pop_back();
+				}
+
+				entryIt = m_Entries.emplace(InKey, SortIdEntry{ newId, 0 }).first;
+			}
+
+			++entryIt->second.m_UsersNum;
+			return entryIt->second.m_Id;
+		}
+
+		void Release(const KeyType& InKey)
+		{
+			auto entryIt = m_Entries.find(InKey);
+			Check(entryIt != m_Entries.end() && entryIt->second.m_UsersNum > 0)
+
+			if (--entryIt->second.m_UsersNum == 0)
+			{
+				m_FreeIds.push_back(entryIt->second.m_Id);
+				m_Entries.erase(entryIt);
+			}
+		}
+
+	private:
+		struct SortIdEntry
+		{
+			uint32_t m_Id;
+			uint32_t m_UsersNum;
+		};
+
+		std::map<KeyType, SortIdEntry> m_Entries;
+
+		// Ids in use and free ids together always are the first ids, so when none is free the next id is the number of entries
+		std::vector<uint32_t> m_FreeIds;
+	};
+
 
 	/*
 	* RenderPass abstracts a set of draw calls or dispatches with similar intent.
 	* Its duty is process render proxy and generate draw commands from them, 
 	* that later will be translated and sent to the GPU by the render thread.
+	* Draw commands are cached across frames, at most one for each drawable, and only the ones of drawables
+	* that get added, changed or removed are touched, so the upkeep does not depend on the size of the scene.
 	*/
 	class RenderPass
 	{
@@ -39,10 +115,36 @@ namespace Mox {
 		// (for simplicity, at the moment, there is one static PSO for render pass) 
 		virtual void SetupPass(Mox::CommandList& InCmdList) = 0;
 
-		// Inspects relevant parameters of the proxy: if relevant generates a draw command out from it.
-		virtual void ProcessRenderProxy(Mox::RenderProxy& InProxy) = 0;
+		// Generates the draw commands of the drawables of the proxy that are relevant for the pass
+		void ProcessRenderProxy(Mox::RenderProxy& InProxy);
+
+		// Generates again the draw commands of the given drawables, after their parameters changed. Commands keep their ids.
+		// Drawables without a command in the pass are skipped.
+		void UpdateDrawables(const std::vector<const Mox::Drawable*>& InDrawables);
+
+		// Per-view data, such as view and projection, is taken from the given view 
+		// so that it does not need to be stored in each draw command.
+		virtual void SendDrawCommands(Mox::CommandList& InCmdList, const Mox::ContextView& InView) = 0;
+
+		// Declares the graph passes of the render pass for the given view, with the resources they read and write.
+		// Render passes are registered in no particular order, so their passes are ordered by the graph from those resources.
+		virtual void AddToRenderGraph(Mox::RenderGraph& InOutGraph, const Mox::ContextView& InView, const Mox::RgViewTargets& InTargets) = 0;
+
+		// Removes all the draw commands generated from the given proxies.
+		// Pipeline states are shared through the pipeline state cache, so they are not released with the commands.
+		void RemoveRenderProxies(const std::unordered_set<const Mox::RenderProxy*>& InProxies);
+
+		// Returns an invalid id if the pass has no command for the drawable
+		Mox::DrawCommandId GetDrawCommandId(const Mox::Drawable& InDrawable) const;
 
-		virtual void SendDrawCommands(Mox::CommandList& InCmdList) = 0;
+		// Moves the given drawables in the bounding volume hierarchy used for culling, after their proxy moved.
+		// Drawables without a command in the pass are skipped.
+		void UpdateDrawableBounds(const std::vector<const Mox::Drawable*>& InDrawables);
+
+		// Returns nullptr if the command was removed
+		const Mox::DrawCommand* GetDrawCommand(Mox::DrawCommandId InId) const { return m_DrawCommands.Get(InId); }
+
+		uint32_t GetDrawCommandsNum() const { return static_cast<uint32_t>(m_DrawCommands.Size()); }
 
 	
 
@@ -56,15 +158,99 @@ namespace Mox {
 		static bool RegisterRenderPass(VariadicTypes... InVariadiArgs)
 		{
 			GetRegisteredRenderPasses().push_back(std::make_unique<T>(InVariadiArgs...));
+			GetRegisteredRenderPasses().back()->m_PassIndex = static_cast<uint32_t>(GetRegisteredRenderPasses().size() - 1);
 			return true;
 		}
 
 	protected:
+
+		// Fills the draw command of the drawable, pushing its bindings in m_DrawBindings. 
+		// Returns false, before pushing any binding or computing any sort key, if the drawable is not drawn by the pass.
+		virtual bool BuildDrawCommand(const Mox::RenderProxy& InProxy, const Mox::Drawable& InDrawable, Mox::DrawCommand& OutCommand) = 0;
+
+		// Queries the bounding volume hierarchy of the commands with the frustum of the view, tests the bounds of the commands found
+		// against the frustum and then against the occlusion buffer of the view, if it has one.
+		// Visible commands with levels of detail then get the geometry of the level fitting their size on screen.
+		// Returns the indices of the visible commands, in no particular order.
+		const std::vector<uint32_t>& CullDrawCommands(const Mox::ContextView& InView);
+
+		// Orders the given draw commands by sort key, so that commands sharing state are recorded one after the other.
+		// Sort keys are packed in 64 bits, from the most significant:
+		// pass index (4 bits) | pipeline state (16 bits) | material (12 bits) | vertex and index buffers (16 bits) | depth (16 bits).
+		// Depth is computed every frame from the view, so that within the same state commands are recorded front to back.
+		const std::vector<uint32_t>& SortDrawCommands(const Mox::ContextView& InView, const std::vector<uint32_t>& InCommandIndices);
+
+		// To be called by BuildDrawCommand once the command has the geometry and sort key of the full detail mesh.
+		// Pushes the levels of detail of the drawable in the arena, starting from the full detail one, and points the command to them.
+		// Commands of drawables without levels of detail are left with none.
+		void PushDrawLods(const Mox::Drawable& InDrawable, const Mox::PipelineState& InPipelineState, uint32_t InMaterialId, Mox::DrawCommand& InOutCommand);
+
+		// Packs the state fields of the sort key, to be computed once when the draw command is created.
+		// States get small ids that are given back when the last command using them is removed (see ReleaseSortIds),
+		// so ids only wrap around their bits with more states than that in use at the same time.
+		uint64_t ComputeStateSortKey(const Mox::PipelineState& InPipelineState, uint32_t InMaterialId, const Mox::VertexBufferView& InVb, const Mox::IndexBufferView& InIb);
 		
-		// Note: if this was an unordered set, we would have to define the hashing function for Mox::DrawCommand.
-		// In our case, what we usually do with draw commands is iterating all of them every time, so a vector is enough.
-		std::vector<Mox::DrawCommand> m_DrawCommands; 
+		// Commands are kept packed, so that the visible ones are gathered from contiguous memory.
+		// Removing one moves the last command in its place, so their order is not meaningful.
+		Mox::SlotMap<Mox::DrawCommand> m_DrawCommands; 
+
+		// Bindings of all the draw commands, each command referring to its own range
+		Mox::DrawBindingArena m_DrawBindings;
+
+	private:
+
+		// Draw command of a drawable, together with its entry in the bounding volume hierarchy
+		struct DrawableCommand
+		{
+			Mox::DrawCommandId m_CommandId;
+
+			// Invalid for drawables without bounds, which are never culled
+			Mox::BvhProxyId m_BvhProxy;
+		};
+
+		// Inserts the command in the bounding volume hierarchy, or among the ones never culled
+		Mox::BvhProxyId AddDrawCommandToBvh(const Mox::Drawable& InDrawable, Mox::DrawCommandId InId);
+
+		void RemoveDrawCommand(const DrawableCommand& InDrawableCommand);
+
+		// Releases the sort ids acquired when computing the sort keys of the command and of its levels of detail.
+		// Levels still need to be in the arena, so it is to be called before compacting it.
+		void ReleaseSortIds(const Mox::DrawCommand& InCommand);
+
+		// Bindings of removed commands are left in the arena until they are the majority, so that compacting it is amortized over many removals
+		void CompactDrawBindingsIfNeeded();
+
+		// Picks the level of detail of each visible command from the screen size of its bounds, computed for all the candidates in one batch
+		void SelectDrawCommandLods(const Mox::ContextView& InView);
+
+		std::unordered_map<const Mox::Drawable*, DrawableCommand> m_DrawableCommands;
+
+		// World bounds of the commands, each proxy holding the slot index of its command in m_DrawCommands
+		Mox::DynamicBvh m_DrawCommandBvh;
+
+		// Slot indices of the commands of drawables without bounds
+		std::vector<uint32_t> m_UnboundedDrawCommands;
+
+		// Commands found in the hierarchy for the view being culled, as indices in m_DrawCommands
+		std::vector<uint32_t> m_CandidateDrawCommands;
+
+		// Bounds of the candidate commands gathered for the culling kernel, kept to avoid allocations every frame
+		Mox::AabbSoA m_DrawCommandBounds;
+
+		std::vector<uint32_t> m_VisibleDrawCommands;
+
+		std::vector<float> m_DrawCommandScreenSizes;
+
+		// Index of the pass in the registered passes, used as the highest field of the sort keys
+		uint32_t m_PassIndex = 0;
+
+		Mox::SortIdTable<const Mox::PipelineState*> m_PipelineStateSortIds;
+		Mox::SortIdTable<std::pair<const Mox::VertexBufferView*, const Mox::IndexBufferView*>> m_GeometrySortIds;
 
+		// Keys and command indices sorted each frame, kept with the sort buffers to avoid allocations
+		std::vector<uint64_t> m_SortKeys;
+		std::vector<uint32_t> m_SortedDrawCommands;
+		Mox::RadixSortScratch m_SortScratch;
 
 	};
 
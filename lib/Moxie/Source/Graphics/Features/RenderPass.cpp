@@ -7,6 +7,28 @@
 */
  
 #include "RenderPass.h"
+#include "ContextView.h"
+#include "MoxRenderProxy.h"
+#include "MoxUtils.h"
+#include "MoxDrawable.h"
+#include "GraphicsTypes.h"
+
+namespace
+{
+	// First level drawn at the given screen size, with the level thresholds scaled by InThresholdScale
+	uint32_t FindDrawLod(const Mox::DrawLod* InLods, uint32_t InLodsNum, float InScreenSize, float InThresholdScale)
+	{
+		for (uint32_t lodIdx = 0; lodIdx + 1 < InLodsNum; ++lodIdx)
+		{
+			if (InScreenSize >= InLods[lodIdx].m_MinScreenSize * InThresholdScale)
+			{
+				return lodIdx;
+			}
+		}
+
+		return InLodsNum - 1;
+	}
+}
 
 Mox::RenderPassVector& Mox::RenderPass::GetRegisteredRenderPasses()
 {
@@ -16,3 +38,307 @@ Mox::RenderPassVector& Mox::RenderPass::GetRegisteredRenderPasses()
 	return RegisteredRenderPasses;
 }
 
+void Mox::RenderPass::ProcessRenderProxy(Mox::RenderProxy& InProxy)
+{
+	for (const Mox::Drawable* drawable : InProxy.m_Meshes)
+	{
+		// A proxy is expected to be processed only once
+		Check(m_DrawableCommands.find(drawable) == m_DrawableCommands.end())
+
+		Mox::DrawCommand newCommand;
+		if (BuildDrawCommand(InProxy, *drawable, newCommand))
+		{
+			const Mox::DrawCommandId commandId = m_DrawCommands.Emplace(newCommand);
+			m_DrawableCommands.emplace(drawable, DrawableCommand{ commandId, AddDrawCommandToBvh(*drawable, commandId) });
+		}
+	}
+}
+
+void Mox::RenderPass::UpdateDrawableBounds(const std::vector<const Mox::Drawable*>& InDrawables)
+{
+	for (const Mox::Drawable* drawable : InDrawables)
+	{
+		auto drawableCommandIt = m_DrawableCommands.find(drawable);
+		if (drawableCommandIt == m_DrawableCommands.end() || drawableCommandIt->second.m_BvhProxy == Mox::DynamicBvh::InvalidProxy)
+		{
+			continue;
+		}
+
+		// Small moves stay within the fat bounds of the proxy and leave the hierarchy untouched
+		m_DrawCommandBvh.MoveProxy(drawableCommandIt->second.m_BvhProxy, drawable->m_WorldBounds);
+	}
+}
+
+void Mox::RenderPass::UpdateDrawables(const std::vector<const Mox::Drawable*>& InDrawables)
+{
+	for (const Mox::Drawable* drawable : InDrawables)
+	{
+		auto drawableCommandIt = m_DrawableCommands.find(drawable);
+		if (drawableCommandIt == m_DrawableCommands.end())
+		{
+			continue;
+		}
+
+		Mox::DrawCommand& drawCommand = *m_DrawCommands.Get(drawableCommandIt->second.m_CommandId);
+
+		// The command is replaced in place, so its id, its position among the commands and its proxy in the hierarchy stay the same
+		Mox::DrawCommand updatedCommand;
+		if (BuildDrawCommand(*drawCommand.m_SourceProxy, *drawable, updatedCommand))
+		{
+			// Released after building the new command, so that states still in use keep their sort ids
+			ReleaseSortIds(drawCommand);
+			m_DrawBindings.Release(drawCommand);
+			drawCommand = updatedCommand;
+		}
+		else
+		{
+			RemoveDrawCommand(drawableCommandIt->second);
+			m_DrawableCommands.erase(drawableCommandIt);
+		}
+	}
+
+	CompactDrawBindingsIfNeeded();
+}
+
+void Mox::RenderPass::RemoveRenderProxies(const std::unordered_set<const Mox::RenderProxy*>& InProxies)
+{
+	// Commands are found from the drawables of the proxies, without going through the commands of the other proxies
+	for (const Mox::RenderProxy* proxy : InProxies)
+	{
+		for (const Mox::Drawable* drawable : proxy->m_Meshes)
+		{
+			auto drawableCommandIt = m_DrawableCommands.find(drawable);
+			if (drawableCommandIt != m_DrawableCommands.end())
+			{
+				RemoveDrawCommand(drawableCommandIt->second);
+				m_DrawableCommands.erase(drawableCommandIt);
+			}
+		}
+	}
+
+	CompactDrawBindingsIfNeeded();
+}
+
+Mox::DrawCommandId Mox::RenderPass::GetDrawCommandId(const Mox::Drawable& InDrawable) const
+{
+	auto drawableCommandIt = m_DrawableCommands.find(&InDrawable);
+
+	return drawableCommandIt != m_DrawableCommands.end() ? drawableCommandIt->second.m_CommandId : Mox::DrawCommandId{};
+}
+
+Mox::BvhProxyId Mox::RenderPass::AddDrawCommandToBvh(const Mox::Drawable& InDrawable, Mox::DrawCommandId InId)
+{
+	// The slot index of a command does not change when other commands are removed, unlike its position among the commands
+	if (InDrawable.m_WorldBounds.IsValid())
+	{
+		return m_DrawCommandBvh.CreateProxy(InDrawable.m_WorldBounds, InId.m_Index);
+	}
+
+	m_UnboundedDrawCommands.push_back(InId.m_Index);
+
+	return Mox::DynamicBvh::InvalidProxy;
+}
+
+void Mox::RenderPass::RemoveDrawCommand(const DrawableCommand& InDrawableCommand)
+{
+	if (InDrawableCommand.m_BvhProxy != Mox::DynamicBvh::InvalidProxy)
+	{
+		m_DrawCommandBvh.DestroyProxy(InDrawableCommand.m_BvhProxy);
+	}
+	else
+	{
+		m_UnboundedDrawCommands.erase(std::find(m_UnboundedDrawCommands.begin(), m_UnboundedDrawCommands.end(), InDrawableCommand.m_CommandId.m_Index));
+	}
+
+	const Mox::DrawCommandId commandId = InDrawableCommand.m_CommandId;
+	ReleaseSortIds(*m_DrawCommands.Get(commandId));
+	m_DrawBindings.Release(*m_DrawCommands.Get(commandId));
+
+	// The last command takes the place of the removed one, so that commands stay packed without shifting them
+	m_DrawCommands.Remove(commandId);
+}
+
+void Mox::RenderPass::ReleaseSortIds(const Mox::DrawCommand& InCommand)
+{
+	// A sort key was computed for each level, the first one being the full detail mesh.
+	// Commands without levels have a single key, computed from the geometry they always keep.
+	if (InCommand.m_LodsNum == 0)
+	{
+		m_PipelineStateSortIds.Release(InCommand.m_PipelineState);
+		m_GeometrySortIds.Release(std::make_pair(InCommand.m_VertexBufferView, InCommand.m_IndexBufferView));
+		return;
+	}
+
+	const Mox::DrawLod* lods = m_DrawBindings.GetLods(InCommand);
+	for (uint32_t lodIdx = 0; lodIdx < InCommand.m_LodsNum; ++lodIdx)
+	{
+		m_PipelineStateSortIds.Release(InCommand.m_PipelineState);
+		m_GeometrySortIds.Release(std::make_pair(lods[lodIdx].m_VertexBufferView, lods[lodIdx].m_IndexBufferView));
+	}
+}
+
+void Mox::RenderPass::CompactDrawBindingsIfNeeded()
+{
+	if (m_DrawBindings.NeedsCompaction())
+	{
+		m_DrawBindings.Compact(m_DrawCommands);
+	}
+}
+
+const std::vector<uint32_t>& Mox::RenderPass::CullDrawCommands(const Mox::ContextView& InView)
+{
+	// The hierarchy skips whole regions of the scene outside the frustum, so the cost follows what is around the view rather than the scene size.
+	// Commands without bounds are never culled and always join the candidates.
+	m_CandidateDrawCommands.clear();
+	m_DrawCommandBvh.QueryFrustum(InView.m_Frustum, m_CandidateDrawCommands);
+	m_CandidateDrawCommands.insert(m_CandidateDrawCommands.end(), m_UnboundedDrawCommands.begin(), m_UnboundedDrawCommands.end());
+
+	m_DrawCommandBounds.Clear();
+	m_DrawCommandBounds.Reserve(m_CandidateDrawCommands.size());
+
+	for (uint32_t& candidateCommand : m_CandidateDrawCommands)
+	{
+		candidateCommand = m_DrawCommands.GetDenseIndex(candidateCommand);
+		m_DrawCommandBounds.PushBack(*m_DrawCommands[candidateCommand].m_WorldBounds);
+	}
+
+	// Proxies in the hierarchy have fat bounds, the exact bounds of the candidates are tested again with the vector kernel.
+	// Up to the end of culling, visible commands are positions among the candidates.
+	Mox::CullBoxes(InView.m_Frustum, m_DrawCommandBounds, m_VisibleDrawCommands);
+
+	// Commands left by the frustum are few enough to be tested one by one against the occluders
+	if (InView.m_OcclusionBuffer)
+	{
+		const Mox::OcclusionBuffer& occlusionBuffer = *InView.m_OcclusionBuffer;
+		m_VisibleDrawCommands.erase(std::remove_if(m_VisibleDrawCommands.begin(), m_VisibleDrawCommands.end(),
+			[this, &occlusionBuffer](uint32_t InCandidateIdx) { return occlusionBuffer.IsOccluded(*m_DrawCommands[m_CandidateDrawCommands[InCandidateIdx]].m_WorldBounds); }),
+			m_VisibleDrawCommands.end());
+	}
+
+	if (m_DrawBindings.HasLods())
+	{
+		SelectDrawCommandLods(InView);
+	}
+
+	for (uint32_t& visibleCommand : m_VisibleDrawCommands)
+	{
+		visibleCommand = m_CandidateDrawCommands[visibleCommand];
+	}
+
+	return m_VisibleDrawCommands;
+}
+
+void Mox::RenderPass::SelectDrawCommandLods(const Mox::ContextView& InView)
+{
+	// Screen sizes are computed for all the candidates from the bounds already gathered for culling, 
+	// which is cheaper with the vector kernel than gathering the bounds of the visible ones again
+	const Mox::Vector4f viewDepthRow = InView.m_ViewProjMatrix.row(3);
+	const float projScale = InView.m_ProjMatrix(1, 1) * std::exp2(-InView.m_LodBias);
+
+	Mox::ComputeScreenSizes(viewDepthRow, projScale, InView.m_ZMin, m_DrawCommandBounds, m_DrawCommandScreenSizes);
+
+	for (uint32_t candidateIdx : m_VisibleDrawCommands)
+	{
+		Mox::DrawCommand& drawCommand = m_DrawCommands[m_CandidateDrawCommands[candidateIdx]];
+		if (drawCommand.m_LodsNum == 0)
+		{
+			continue;
+		}
+
+		const Mox::DrawLod* lods = m_DrawBindings.GetLods(drawCommand);
+		const float screenSize = m_DrawCommandScreenSizes[candidateIdx];
+
+		// The selected level is kept as long as it is between the level picked with thresholds lowered by the hysteresis margin,
+		// and the one picked with thresholds raised by it. Otherwise it moves to the closest of the two.
+		const uint32_t finestLod = FindDrawLod(lods, drawCommand.m_LodsNum, screenSize, 1.f - InView.m_LodHysteresis);
+		const uint32_t coarsestLod = FindDrawLod(lods, drawCommand.m_LodsNum, screenSize, 1.f + InView.m_LodHysteresis);
+		const uint32_t selectedLod = std::clamp<uint32_t>(drawCommand.m_SelectedLod, finestLod, coarsestLod);
+
+		if (selectedLod != drawCommand.m_SelectedLod)
+		{
+			// The command takes the geometry of the level, so that sorting, instancing and drawing do not need to know about levels
+			const Mox::DrawLod& lod = lods[selectedLod];
+			drawCommand.m_StateSortKey = lod.m_StateSortKey;
+			drawCommand.m_VertexBufferView = lod.m_VertexBufferView;
+			drawCommand.m_IndexBufferView = lod.m_IndexBufferView;
+			drawCommand.m_IndicesNum = lod.m_IndicesNum;
+			drawCommand.m_SelectedLod = static_cast<uint8_t>(selectedLod);
+		}
+	}
+}
+
+const std::vector<uint32_t>& Mox::RenderPass::SortDrawCommands(const Mox::ContextView& InView, const std::vector<uint32_t>& InCommandIndices)
+{
+	// Distance along the view direction is the w component of the clip space position
+	const Mox::Vector4f viewDepthRow = InView.m_ViewProjMatrix.row(3);
+	const float depthToBucket = 0xFFFF / (InView.m_ZMax - InView.m_ZMin);
+
+	m_SortKeys.clear();
+	m_SortKeys.reserve(InCommandIndices.size());
+
+	for (uint32_t commandIdx : InCommandIndices)
+	{
+		const Mox::DrawCommand& drawCommand = m_DrawCommands[commandIdx];
+
+		// Commands without bounds are placed first among the ones with the same state
+		uint64_t depthBucket = 0;
+		if (drawCommand.m_WorldBounds->IsValid())
+		{
+			const Mox::Vector3f center = drawCommand.m_WorldBounds->GetCenter();
+			const float viewDepth = viewDepthRow.x() * center.x() + viewDepthRow.y() * center.y() + viewDepthRow.z() * center.z() + viewDepthRow.w();
+
+			depthBucket = static_cast<uint64_t>(std::clamp((viewDepth - InView.m_ZMin) * depthToBucket, 0.f, static_cast<float>(0xFFFF)));
+		}
+
+		m_SortKeys.push_back(drawCommand.m_StateSortKey | depthBucket);
+	}
+
+	m_SortedDrawCommands.assign(InCommandIndices.begin(), InCommandIndices.end());
+
+	Mox::RadixSortPairs(m_SortKeys, m_SortedDrawCommands, m_SortScratch);
+
+	return m_SortedDrawCommands;
+}
+
+void Mox::RenderPass::PushDrawLods(const Mox::Drawable& InDrawable, const Mox::PipelineState& InPipelineState, uint32_t InMaterialId, Mox::DrawCommand& InOutCommand)
+{
+	InOutCommand.m_FirstLod = m_DrawBindings.GetLodsNum();
+	InOutCommand.m_LodsNum = 0;
+	InOutCommand.m_SelectedLod = 0;
+
+	if (InDrawable.m_Lods.empty())
+	{
+		return;
+	}
+
+	Check(InDrawable.m_Lods.size() < std::numeric_limits<uint8_t>::max())
+
+	// Each level is drawn down to the screen size where the next one replaces it
+	m_DrawBindings.PushLod({ InOutCommand.m_StateSortKey, InOutCommand.m_VertexBufferView, InOutCommand.m_IndexBufferView, 
+		InOutCommand.m_IndicesNum, InDrawable.m_Lods.front().m_ScreenSize });
+
+	for (size_t lodIdx = 0; lodIdx < InDrawable.m_Lods.size(); ++lodIdx)
+	{
+		const Mox::MeshLod& meshLod = InDrawable.m_Lods[lodIdx];
+		Mox::VertexBufferView& vertexBufferView = static_cast<Mox::VertexBufferView&>(*meshLod.m_VertexBuffer->GetResource()->GetView());
+		Mox::IndexBufferView& indexBufferView = static_cast<Mox::IndexBufferView&>(*meshLod.m_IndexBuffer->GetResource()->GetView());
+		const float minScreenSize = lodIdx + 1 < InDrawable.m_Lods.size() ? InDrawable.m_Lods[lodIdx + 1].m_ScreenSize : 0.f;
+
+		m_DrawBindings.PushLod({ ComputeStateSortKey(InPipelineState, InMaterialId, vertexBufferView, indexBufferView),
+			&vertexBufferView, &indexBufferView, indexBufferView.GetElementsNum(), minScreenSize });
+	}
+
+	InOutCommand.m_LodsNum = static_cast<uint8_t>(InDrawable.m_Lods.size() + 1);
+}
+
+uint64_t Mox::RenderPass::ComputeStateSortKey(const Mox::PipelineState& InPipelineState, uint32_t InMaterialId, const Mox::VertexBufferView& InVb, const Mox::IndexBufferView& InIb)
+{
+	const uint64_t pipelineStateId = m_PipelineStateSortIds.Acquire(&InPipelineState);
+	const uint64_t geometryId = m_GeometrySortIds.Acquire(std::make_pair(&InVb, &InIb));
+
+	return (static_cast<uint64_t>(m_PassIndex & 0xF) << 60)
+		| ((pipelineStateId & 0xFFFF) << 44)
+		| (static_cast<uint64_t>(InMaterialId & 0xFFF) << 32)
+		| ((geometryId & 0xFFFF) << 16);
+}
+
@@ -16,6 +16,91 @@
 
 namespace Mox { 
 
+	namespace
+	{
+		// Buffers copy their content on creation, so the optimization can work on temporary copies
+		void OptimizeMeshData(const Mox::INPUT_LAYOUT_DESC& InLayoutDesc, const void* InVertexData, uint32_t InVertexStride, uint32_t InVertexSize,
+			const void* InIndexData, uint32_t InIndexStride, uint32_t InIndexSize, std::vector<std::byte>& OutVertexData, std::vector<std::byte>& OutIndexData,
+			Mox::MeshOptimizationStats* OutStats)
+		{
+			OutVertexData.assign(static_cast<const std::byte*>(InVertexData), static_cast<const std::byte*>(InVertexData) + InVertexSize);
+			OutIndexData.assign(static_cast<const std::byte*>(InIndexData), static_cast<const std::byte*>(InIndexData) + InIndexSize);
+
+			Mox::MeshOptimizationStats optimizationStats;
+			Mox::OptimizeMeshBuffers(OutVertexData.data(), InVertexStride, InVertexSize / InVertexStride, InLayoutDesc.GetPositionOffset(InVertexStride),
+				OutIndexData.data(), InIndexStride, InIndexSize / InIndexStride, &optimizationStats);
+
+			DebugPrint("Mesh optimized, ACMR " << optimizationStats.m_Before.m_Acmr << " -> " << optimizationStats.m_After.m_Acmr
+				<< ", ATVR " << optimizationStats.m_Before.m_Atvr << " -> " << optimizationStats.m_After.m_Atvr)
+
+			if (OutStats)
+			{
+				*OutStats = optimizationStats;
+			}
+		}
+
+		// Positions and float attributes of the vertices, read with the layout of the vertex buffer
+		Mox::SimplifierMesh BuildSimplifierMesh(const Mox::INPUT_LAYOUT_DESC& InLayoutDesc, const std::vector<std::byte>& InVertexData, uint32_t InVertexStride,
+			const std::vector<std::byte>& InIndexData, uint32_t InIndexStride)
+		{
+			const int32_t positionOffset = InLayoutDesc.GetPositionOffset(InVertexStride);
+			Check(positionOffset >= 0)
+
+			// Offset and number of floats of each element kept as attribute
+			std::vector<std::pair<uint32_t, uint32_t>> attributeElements;
+			uint32_t attributesNum = 0, elementOffset = 0;
+			for (const Mox::INPUT_LAYOUT_DESC::LayoutElement& curElement : InLayoutDesc.LayoutElements)
+			{
+				const uint32_t elementFloatsNum = curElement.m_Format == Mox::BUFFER_FORMAT::R32G32B32_FLOAT ? 3 : curElement.m_Format == Mox::BUFFER_FORMAT::R32G32_FLOAT ? 2 : 0;
+				if (curElement.m_Name != "POSITION" && elementFloatsNum > 0 && attributesNum + elementFloatsNum <= Mox::SimplifierMaxAttributesNum
+					&& elementOffset + elementFloatsNum * sizeof(float) <= InVertexStride)
+				{
+					attributeElements.emplace_back(elementOffset, elementFloatsNum);
+					attributesNum += elementFloatsNum;
+				}
+
+				elementOffset += Mox::GetVertexElementSize(curElement.m_Format);
+			}
+
+			Mox::SimplifierMesh simplifierMesh;
+			simplifierMesh.m_AttributesNum = attributesNum;
+
+			const uint32_t verticesNum = static_cast<uint32_t>(InVertexData.size()) / InVertexStride;
+			simplifierMesh.m_Positions.resize(verticesNum);
+			simplifierMesh.m_Attributes.resize(verticesNum * attributesNum);
+			for (uint32_t vertexIdx = 0; vertexIdx < verticesNum; ++vertexIdx)
+			{
+				const std::byte* vertexData = InVertexData.data() + vertexIdx * InVertexStride;
+				memcpy(simplifierMesh.m_Positions[vertexIdx].data(), vertexData + positionOffset, sizeof(Mox::Vector3f));
+
+				float* vertexAttributes = simplifierMesh.m_Attributes.data() + vertexIdx * attributesNum;
+				for (const std::pair<uint32_t, uint32_t>& attributeElement : attributeElements)
+				{
+					memcpy(vertexAttributes, vertexData + attributeElement.first, attributeElement.second * sizeof(float));
+					vertexAttributes += attributeElement.second;
+				}
+			}
+
+			Check(InIndexStride == sizeof(uint16_t) || InIndexStride == sizeof(uint32_t))
+			simplifierMesh.m_Indices.resize(InIndexData.size() / InIndexStride);
+			for (size_t indexIdx = 0; indexIdx < simplifierMesh.m_Indices.size(); ++indexIdx)
+			{
+				if (InIndexStride == sizeof(uint16_t))
+				{
+					uint16_t shortIndex;
+					memcpy(&shortIndex, InIndexData.data() + indexIdx * InIndexStride, sizeof(uint16_t));
+					simplifierMesh.m_Indices[indexIdx] = shortIndex;
+				}
+				else
+				{
+					memcpy(&simplifierMesh.m_Indices[indexIdx], InIndexData.data() + indexIdx * InIndexStride, sizeof(uint32_t));
+				}
+			}
+
+			return simplifierMesh;
+		}
+	}
+
 	Mox::GraphicsAllocatorBase* GraphicsAllocator::m_DefaultInstance = nullptr;
 
 	std::unique_ptr<Mox::GraphicsAllocatorBase> GraphicsAllocator::CreateInstance()
@@ -33,6 +118,76 @@ namespace Mox {
 
 	GraphicsAllocatorBase::~GraphicsAllocatorBase() = default;
 
-	GraphicsAllocatorBase::GraphicsAllocatorBase() = default;
+	GraphicsAllocatorBase::GraphicsAllocatorBase()
+		: m_PipelineStateCache(std::make_unique<Mox::PipelineStateCache>())
+	{ }
+
+	GraphicsAllocatorBase::GraphicsAllocatorBase(std::unique_ptr<Mox::PipelineStateCache> InPipelineStateCache)
+		: m_PipelineStateCache(std::move(InPipelineStateCache))
+	{ }
+
+	void GraphicsAllocatorBase::AllocateOptimizedMeshBuffers(const Mox::INPUT_LAYOUT_DESC& InLayoutDesc, const void* InVertexData, uint32_t InVertexStride, uint32_t InVertexSize,
+		const void* InIndexData, uint32_t InIndexStride, uint32_t InIndexSize, Mox::VertexBuffer*& OutVertexBuffer, Mox::IndexBuffer*& OutIndexBuffer,
+		Mox::MeshOptimizationStats* OutStats /*= nullptr*/)
+	{
+		std::vector<std::byte> vertexData, indexData;
+		OptimizeMeshData(InLayoutDesc, InVertexData, InVertexStride, InVertexSize, InIndexData, InIndexStride, InIndexSize, vertexData, indexData, OutStats);
+
+		OutVertexBuffer = &AllocateVertexBuffer(InLayoutDesc, vertexData.data(), InVertexStride, InVertexSize);
+		OutIndexBuffer = &AllocateIndexBuffer(indexData.data(), InIndexStride, InIndexSize);
+	}
+
+	void GraphicsAllocatorBase::AllocateMeshWithLods(const Mox::INPUT_LAYOUT_DESC& InLayoutDesc, const void* InVertexData, uint32_t InVertexStride, uint32_t InVertexSize,
+		const void* InIndexData, uint32_t InIndexStride, uint32_t InIndexSize, const Mox::MeshLodSettings& InLodSettings,
+		Mox::VertexBuffer*& OutVertexBuffer, Mox::IndexBuffer*& OutIndexBuffer, std::vector<Mox::MeshLod>& OutLods,
+		float InMaxScreenError /*= Mox::DefaultLodScreenError*/)
+	{
+		// Levels are simplified from the optimized vertices, so that they can share the vertex buffer without a remap
+		std::vector<std::byte> vertexData, indexData;
+		OptimizeMeshData(InLayoutDesc, InVertexData, InVertexStride, InVertexSize, InIndexData, InIndexStride, InIndexSize, vertexData, indexData, nullptr);
+
+		OutVertexBuffer = &AllocateVertexBuffer(InLayoutDesc, vertexData.data(), InVertexStride, InVertexSize);
+		OutIndexBuffer = &AllocateIndexBuffer(indexData.data(), InIndexStride, InIndexSize);
+
+		const Mox::SimplifierMesh simplifierMesh = BuildSimplifierMesh(InLayoutDesc, vertexData, InVertexStride, indexData, InIndexStride);
+
+		std::vector<Mox::SimplifiedMeshLod> simplifiedLods;
+		Mox::GenerateMeshLods(simplifierMesh, InLodSettings, simplifiedLods);
+
+		// Screen sizes are projected bounding sphere diameters over the view height, so a level with error E on a mesh of diameter D
+		// shows an error of E * ScreenSize / D of the view height
+		const Mox::Aabb& localBounds = OutVertexBuffer->GetLocalBounds();
+		const float meshDiameter = (localBounds.m_Max - localBounds.m_Min).norm();
+		float previousScreenSize = std::numeric_limits<float>::max();
+
+		OutLods.clear();
+		OutLods.reserve(simplifiedLods.size());
+		for (Mox::SimplifiedMeshLod& simplifiedLod : simplifiedLods)
+		{
+			Mox::OptimizeVertexCache(simplifiedLod.m_Indices, static_cast<uint32_t>(simplifierMesh.m_Positions.size()));
+			Mox::OptimizeOverdraw(simplifiedLod.m_Indices, simplifierMesh.m_Positions);
+
+			Mox::IndexBuffer* lodIndexBuffer = nullptr;
+			if (InIndexStride == sizeof(uint16_t))
+			{
+				const std::vector<uint16_t> shortIndices(simplifiedLod.m_Indices.begin(), simplifiedLod.m_Indices.end());
+				lodIndexBuffer = &AllocateIndexBuffer(shortIndices.data(), InIndexStride, static_cast<uint32_t>(shortIndices.size()) * InIndexStride);
+			}
+			else
+			{
+				lodIndexBuffer = &AllocateIndexBuffer(simplifiedLod.m_Indices.data(), InIndexStride, static_cast<uint32_t>(simplifiedLod.m_Indices.size()) * InIndexStride);
+			}
+
+			if (simplifiedLod.m_Error > 0.f)
+			{
+				previousScreenSize = std::min(previousScreenSize, InMaxScreenError * meshDiameter / simplifiedLod.m_Error);
+			}
+
+			OutLods.push_back({ OutVertexBuffer, lodIndexBuffer, previousScreenSize });
+
+			DebugPrint("Mesh level of detail " << OutLods.size() << ": " << simplifiedLod.m_Indices.size() / 3 << " triangles, error " << simplifiedLod.m_Error
+				<< ", screen size " << previousScreenSize)
+		}
+	}
 
 }
@@ -14,6 +14,50 @@
 
 namespace Mox {
 
+	Mox::RESOURCE_STATE Resource::GetTrackedState(uint32_t InSubresource /*= ALL_SUBRESOURCES*/) const
+	{
+		if (m_TrackedSubresourceStates.empty())
+		{
+			return m_TrackedState;
+		}
+
+		// Asking for the state of the whole resource only makes sense when all subresources share it
+		Check(InSubresource < m_TrackedSubresourceStates.size())
+
+		return m_TrackedSubresourceStates[InSubresource];
+	}
+
+	void Resource::SetTrackedState(Mox::RESOURCE_STATE InState, uint32_t InSubresource /*= ALL_SUBRESOURCES*/)
+	{
+		if (InSubresource == Mox::ALL_SUBRESOURCES)
+		{
+			m_TrackedState = InState;
+			m_TrackedSubresourceStates.clear();
+			return;
+		}
+
+		Check(InSubresource < m_SubresourcesNum)
+
+		if (m_TrackedSubresourceStates.empty())
+		{
+			if (InState == m_TrackedState)
+			{
+				return;
+			}
+
+			m_TrackedSubresourceStates.assign(m_SubresourcesNum, m_TrackedState);
+		}
+
+		m_TrackedSubresourceStates[InSubresource] = InState;
+
+		// Back to a single state once all subresources agree on it
+		if (std::all_of(m_TrackedSubresourceStates.begin(), m_TrackedSubresourceStates.end(), [InState](Mox::RESOURCE_STATE InSubState) { return InSubState == InState; }))
+		{
+			m_TrackedState = InState;
+			m_TrackedSubresourceStates.clear();
+		}
+	}
+
 	BufferResourceHolder::~BufferResourceHolder() = default;
 
 	void BufferResourceHolder::SetData(const void* InData, uint32_t InSize)
@@ -21,10 +65,54 @@ namespace Mox {
 		Mox::UpdateConstantBufferValue(*this, InData, InSize);
 	}
 
+	uint32_t GetVertexElementSize(Mox::BUFFER_FORMAT InFormat)
+	{
+		switch (InFormat)
+		{
+		case Mox::BUFFER_FORMAT::R16_UINT: return 2;
+		case Mox::BUFFER_FORMAT::R32G32B32_FLOAT: return 12;
+		case Mox::BUFFER_FORMAT::R32G32_FLOAT: return 8;
+		case Mox::BUFFER_FORMAT::R8G8B8A8_UNORM:
+		case Mox::BUFFER_FORMAT::B8G8R8A8_UNORM:
+		case Mox::BUFFER_FORMAT::D32_FLOAT: return 4;
+		default: return 0;
+		}
+	}
+
+	int32_t INPUT_LAYOUT_DESC::GetPositionOffset(uint32_t InStride) const
+	{
+		uint32_t elementOffset = 0;
+		for (const LayoutElement& curElement : LayoutElements)
+		{
+			if (curElement.m_Name == "POSITION")
+			{
+				const bool isValidPosition = curElement.m_Format == Mox::BUFFER_FORMAT::R32G32B32_FLOAT && elementOffset + sizeof(Mox::Vector3f) <= InStride;
+				return isValidPosition ? static_cast<int32_t>(elementOffset) : -1;
+			}
+
+			elementOffset += GetVertexElementSize(curElement.m_Format);
+		}
+
+		return -1;
+	}
+
 	VertexBuffer::VertexBuffer(const INPUT_LAYOUT_DESC& InLayoutDesc, const void* InData, uint32_t InStride, uint32_t InSize)
 		: BufferResourceHolder(Mox::RES_CONTENT_TYPE::VERTEX, Mox::BUFFER_ALLOC_TYPE::STATIC, InSize, InStride),
 		m_LayoutDesc(InLayoutDesc)
 	{
+		// Bounds are computed here, while the vertex data is still available on the Cpu, and they are used later for culling
+		const int32_t positionOffset = InLayoutDesc.GetPositionOffset(InStride);
+		if (positionOffset >= 0)
+		{
+			const std::byte* vertexData = static_cast<const std::byte*>(InData);
+			for (uint32_t vertexOffset = 0; vertexOffset + InStride <= InSize; vertexOffset += InStride)
+			{
+				Mox::Vector3f vertexPosition;
+				memcpy(vertexPosition.data(), vertexData + vertexOffset + positionOffset, sizeof(Mox::Vector3f));
+				m_LocalBounds.Expand(vertexPosition);
+			}
+		}
+
 		Mox::RequestBufferResourceForHolder(*this);
 
 		Mox::UpdateConstantBufferValue(*this, InData, InSize);
@@ -96,10 +184,9 @@ namespace Mox {
 		Mox::RequestBufferResourceForHolder(*this);
 	}
 
-	ConstantBuffer::~ConstantBuffer()
-	{
-		Mox::ReleaseResourceForBuffer(*this);
-	}
+	// Note: The buffer resource is released through Mox::ReleaseResourceForBuffer, 
+	// since the render thread can still be using it when the buffer goes out of scope on the simulation thread
+	ConstantBuffer::~ConstantBuffer() = default;
 
 	TextureResource::TextureResource(const Mox::TextureDesc& InDesc, 
 		Mox::Resource& InOwnerResource, size_t InAllocationOffset, size_t InSize)
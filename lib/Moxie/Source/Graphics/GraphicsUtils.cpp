@@ -32,9 +32,12 @@ namespace Mox {
 			InHolder.GetContentType(), InHolder.GetAllocType(), InHolder.GetSize(), InHolder.GetStride());
 	}
 
-	void ReleaseResourceForBuffer(ConstantBuffer& InBuffer)
+	void ReleaseResourceForBuffer(std::unique_ptr<Mox::ConstantBuffer> InBuffer)
 	{
-		// TODO
+		if (InBuffer)
+		{
+			GetSimThreadUpdatesForRenderer().m_BufferReleases.push_back(std::move(InBuffer));
+		}
 	}
 
 	void RequestTextureResource(Mox::Texture& InTexture, Mox::TextureDesc& InDesc)
@@ -49,7 +52,11 @@ namespace Mox {
 
 	void ReleaseRenderProxyForEntity(Entity& InEntity)
 	{
-		// TODO
+		// The proxy is shared with the render thread, which will keep it alive until its draw commands are gone
+		if (std::shared_ptr<Mox::RenderProxy> entityProxy = InEntity.GetRenderProxy())
+		{
+			GetSimThreadUpdatesForRenderer().m_ProxyReleases.push_back(std::move(entityProxy));
+		}
 	}
 
 	void RequestDrawable(const DrawableCreationInfo& InCreationInfo)
@@ -57,6 +64,22 @@ namespace Mox {
 		GetSimThreadUpdatesForRenderer().m_DrawableRequests.emplace_back(std::move(InCreationInfo));
 	}
 
+	void RequestSpawnBatch(Mox::SpawnBatchRequest&& InSpawnBatch)
+	{
+		GetSimThreadUpdatesForRenderer().m_SpawnBatchRequests.push_back(std::move(InSpawnBatch));
+	}
+
+	void UpdateRenderProxyTransform(Mox::RenderProxy& InProxy, const Mox::Matrix4f& InModelMatrix)
+	{
+		GetSimThreadUpdatesForRenderer().m_ProxyTransformUpdates.push_back(Mox::RenderProxyTransformUpdate{ &InProxy, InModelMatrix });
+	}
+
+	void UpdateDrawableParameters(Mox::RenderProxy& InProxy, uint32_t InDrawableIdx, BufferMeshParams&& InBufferParams, TextureMeshParams&& InTextureParams)
+	{
+		GetSimThreadUpdatesForRenderer().m_DrawableParametersUpdates.push_back(
+			Mox::DrawableParametersUpdate{ &InProxy, InDrawableIdx, std::move(InBufferParams), std::move(InTextureParams) });
+	}
+
 	void UpdateConstantBufferValue(Mox::BufferResourceHolder& InBufferHolder, const void* InData, uint32_t InSize)
 	{
 		if (InBufferHolder.GetAllocType() == BUFFER_ALLOC_TYPE::DYNAMIC)
@@ -9,12 +9,14 @@
 #include "MoxDrawable.h"
 #include "MoxGeometry.h"
 #include "Public/MoxMaterial.h"
+#include "MoxUtils.h"
 
 namespace Mox {
 
 Drawable::Drawable(const Mox::DrawableCreationInfo& InCreationInfo)
 	: m_VertexBuffer(*InCreationInfo.m_VertexBuffer), m_IndexBuffer(*InCreationInfo.m_IndexBuffer),
-	m_RenderBackfaces(InCreationInfo.m_RenderBackfaces), m_Material(Mox::Material::DefaultMaterial)
+	m_LocalBounds(InCreationInfo.m_VertexBuffer->GetLocalBounds()), m_WorldBounds(m_LocalBounds),
+	m_RenderBackfaces(InCreationInfo.m_RenderBackfaces), m_Occluder(InCreationInfo.m_Occluder), m_Lods(InCreationInfo.m_Lods), m_Material(Mox::Material::DefaultMaterial)
 {
 	for (const std::tuple<Mox::SpHash, Mox::ConstantBuffer*>& newCbParam : InCreationInfo.m_BufferShaderParameters)
 	{
@@ -26,6 +28,13 @@ Drawable::Drawable(const Mox::DrawableCreationInfo& InCreationInfo)
 		auto [paramHash, texPtr] = newTexParam;
 		SetTexShaderParamValue(paramHash, texPtr);
 	}
+
+	for (size_t lodIdx = 0; lodIdx < m_Lods.size(); ++lodIdx)
+	{
+		// Levels are expected from the most to the least detailed
+		Check(m_Lods[lodIdx].m_VertexBuffer && m_Lods[lodIdx].m_IndexBuffer)
+		Check(lodIdx == 0 || m_Lods[lodIdx].m_ScreenSize <= m_Lods[lodIdx - 1].m_ScreenSize)
+	}
 }
 
 Drawable::~Drawable() = default;
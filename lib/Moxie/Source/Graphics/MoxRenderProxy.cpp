@@ -7,6 +7,7 @@
 */
 
 #include "MoxRenderProxy.h"
+#include "MoxDrawable.h"
 
 namespace Mox {
 
@@ -18,5 +19,22 @@ namespace Mox {
 
 	RenderProxy::~RenderProxy() = default;
 
+	void RenderProxy::AddDrawable(Mox::Drawable* InDrawable)
+	{
+		InDrawable->UpdateWorldBounds(m_ModelMatrix);
+
+		m_Meshes.push_back(InDrawable);
+	}
+
+	void RenderProxy::SetModelMatrix(const Mox::Matrix4f& InModelMatrix)
+	{
+		m_ModelMatrix = InModelMatrix;
+
+		for (Mox::Drawable* curMesh : m_Meshes)
+		{
+			curMesh->UpdateWorldBounds(m_ModelMatrix);
+		}
+	}
+
 
 }
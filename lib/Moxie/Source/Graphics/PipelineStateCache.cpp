@@ -0,0 +1,228 @@
+/*
+ PipelineStateCache.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#include "PipelineStateCache.h"
+#include "GraphicsAllocator.h"
+#include "Device.h"
+
+namespace Mox {
+
+	namespace
+	{
+		constexpr uint32_t InitialTableCapacity = 64;
+
+		constexpr const char* DiskCacheCategory = "pso";
+
+		template<typename T>
+		void AppendValue(const T& InValue, std::vector<uint8_t>& InOutKey)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be part of the key as their bytes");
+			const uint8_t* valueBytes = reinterpret_cast<const uint8_t*>(&InValue);
+			InOutKey.insert(InOutKey.end(), valueBytes, valueBytes + sizeof(T));
+		}
+	}
+
+	PipelineStateCache::PipelineStateCache()
+		: PipelineStateCache(Mox::Constants::g_PersistentCacheDirectory[0] != '\0' ?
+			std::make_unique<Mox::PersistentBlobCache>(Mox::Constants::g_PersistentCacheDirectory, Mox::GetDevice().GetPipelineCacheContextHash()) : nullptr)
+	{ }
+
+	PipelineStateCache::PipelineStateCache(std::unique_ptr<Mox::PersistentBlobCache> InDiskCache)
+		: m_DiskCache(std::move(InDiskCache))
+	{
+		m_Tables.push_back(std::make_unique<Table>(InitialTableCapacity));
+		m_Table.store(m_Tables.back().get(), std::memory_order_release);
+	}
+
+	PipelineStateCache::~PipelineStateCache() = default;
+
+	Mox::PipelineState& PipelineStateCache::GetOrCreate(Mox::PipelineState::GRAPHICS_PSO_DESC& InDesc)
+	{
+		std::vector<uint8_t> descKey;
+		BuildDescKey(InDesc, descKey);
+		const uint64_t descHash = HashDescKey(descKey);
+
+		if (Mox::PipelineState* cachedState = Find(*m_Table.load(std::memory_order_acquire), descHash, descKey))
+		{
+			m_HitsNum.fetch_add(1, std::memory_order_relaxed);
+			return *cachedState;
+		}
+
+		std::lock_guard<std::mutex> insertLock(m_InsertMutex);
+
+		// Another thread could have created the same state while waiting for the lock
+		Table* currentTable = m_Table.load(std::memory_order_relaxed);
+		if (Mox::PipelineState* cachedState = Find(*currentTable, descHash, descKey))
+		{
+			m_HitsNum.fetch_add(1, std::memory_order_relaxed);
+			return *cachedState;
+		}
+
+		m_MissesNum.fetch_add(1, std::memory_order_relaxed);
+
+		Mox::PipelineState& newState = Mox::GraphicsAllocator::Get()->AllocatePipelineState();
+		InitState(newState, InDesc, descHash, descKey);
+
+		// Keeping the table at most half full keeps probe sequences short
+		if ((m_Entries.size() + 1) * 2 > currentTable->m_Capacity)
+		{
+			std::unique_ptr<Table> grownTable = std::make_unique<Table>(currentTable->m_Capacity * 2);
+			for (uint32_t slotIdx = 0; slotIdx < currentTable->m_Capacity; ++slotIdx)
+			{
+				const Slot& slot = currentTable->m_Slots[slotIdx];
+				if (const uint64_t slotHash = slot.m_Hash.load(std::memory_order_relaxed))
+				{
+					Insert(*grownTable, slotHash, *slot.m_Entry.load(std::memory_order_relaxed));
+				}
+			}
+
+			currentTable = grownTable.get();
+			m_Tables.push_back(std::move(grownTable));
+		}
+
+		m_Entries.push_back(Entry{ std::move(descKey), &newState });
+		Insert(*currentTable, descHash, m_Entries.back());
+
+		// Publishing a grown table only after it is complete, readers keep using the previous one until then
+		m_Table.store(currentTable, std::memory_order_release);
+
+		return newState;
+	}
+
+	void PipelineStateCache::BuildDescKey(const Mox::PipelineState::GRAPHICS_PSO_DESC& InDesc, std::vector<uint8_t>& OutKey)
+	{
+		OutKey.clear();
+		AppendValue(InDesc.TopologyType, OutKey);
+
+		// Fields are appended one by one, appending whole structs would include their padding
+		AppendValue(static_cast<uint32_t>(InDesc.InputLayoutDesc.LayoutElements.size()), OutKey);
+		for (const Mox::INPUT_LAYOUT_DESC::LayoutElement& element : InDesc.InputLayoutDesc.LayoutElements)
+		{
+			// Names are prefixed by their length, so that different layouts never give the same bytes
+			AppendValue(static_cast<uint32_t>(element.m_Name.size()), OutKey);
+			OutKey.insert(OutKey.end(), element.m_Name.begin(), element.m_Name.end());
+			AppendValue(element.m_Format, OutKey);
+		}
+
+		const Mox::PipelineState::RESOURCE_BINDER_DESC& binderDesc = InDesc.ResourceBinderDesc;
+		AppendValue(binderDesc.Flags, OutKey);
+		AppendValue(static_cast<uint32_t>(binderDesc.Params.size()), OutKey);
+		for (const Mox::PipelineState::RESOURCE_BINDER_PARAM& param : binderDesc.Params)
+		{
+			AppendValue(param.Num32BitValues, OutKey);
+			AppendValue(param.ShaderRegister, OutKey);
+			AppendValue(param.RegisterSpace, OutKey);
+			AppendValue(param.NumDescriptors, OutKey);
+			AppendValue(param.ResourceType, OutKey);
+			AppendValue(param.shaderVisibility, OutKey);
+		}
+		AppendValue(static_cast<uint32_t>(binderDesc.StaticSamplers.size()), OutKey);
+		for (const Mox::StaticSampler& sampler : binderDesc.StaticSamplers)
+		{
+			AppendValue(sampler.m_ShaderRegister, OutKey);
+			AppendValue(sampler.m_Filter, OutKey);
+			AppendValue(sampler.m_AddressU, OutKey);
+			AppendValue(sampler.m_AddressV, OutKey);
+			AppendValue(sampler.m_AddressW, OutKey);
+		}
+
+		AppendValue(InDesc.VertexShader.GetBytecodeHash(), OutKey);
+		AppendValue(InDesc.PixelShader.GetBytecodeHash(), OutKey);
+		AppendValue(InDesc.DSFormat, OutKey);
+		AppendValue(InDesc.RTFormat, OutKey);
+		AppendValue(InDesc.RenderBackfaces, OutKey);
+	}
+
+	uint64_t PipelineStateCache::ComputeDescHash(const Mox::PipelineState::GRAPHICS_PSO_DESC& InDesc)
+	{
+		std::vector<uint8_t> descKey;
+		BuildDescKey(InDesc, descKey);
+
+		return HashDescKey(descKey);
+	}
+
+	uint64_t PipelineStateCache::HashDescKey(const std::vector<uint8_t>& InKey)
+	{
+		const uint64_t keyHash = Mox::HashBytes(InKey.data(), InKey.size());
+
+		// Zero marks empty slots
+		return keyHash != 0 ? keyHash : 1;
+	}
+
+	void PipelineStateCache::InitState(Mox::PipelineState& InOutState, Mox::PipelineState::GRAPHICS_PSO_DESC& InDesc, uint64_t InDescHash, const std::vector<uint8_t>& InDescKey)
+	{
+		if (!m_DiskCache)
+		{
+			InOutState.Init(InDesc);
+			return;
+		}
+
+		// Stored blobs start with the key of their description, a blob stored for a different description with the same hash is a miss
+		std::vector<uint8_t> cachedBlob;
+		if (m_DiskCache->Load(DiskCacheCategory, InDescHash, cachedBlob) && cachedBlob.size() > InDescKey.size() 
+			&& std::equal(InDescKey.begin(), InDescKey.end(), cachedBlob.begin()))
+		{
+			cachedBlob.erase(cachedBlob.begin(), cachedBlob.begin() + InDescKey.size());
+			if (InOutState.InitFromCachedBlob(InDesc, cachedBlob))
+			{
+				m_DiskHitsNum.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+		}
+
+		// Not stored yet, stored for another description or by a run that the platform does not accept anymore: 
+		// compiling and replacing the stored blob
+		InOutState.Init(InDesc);
+
+		const std::vector<uint8_t> compiledBlob = InOutState.GetCachedBlob();
+		if (!compiledBlob.empty())
+		{
+			std::vector<uint8_t> storedBlob(InDescKey);
+			storedBlob.insert(storedBlob.end(), compiledBlob.begin(), compiledBlob.end());
+
+			m_DiskCache->Store(DiskCacheCategory, InDescHash, storedBlob.data(), storedBlob.size());
+		}
+	}
+
+	Mox::PipelineState* PipelineStateCache::Find(const Table& InTable, uint64_t InHash, const std::vector<uint8_t>& InKey)
+	{
+		// Capacity is a power of two, so the starting slot is given by the low bits of the hash
+		for (uint32_t slotIdx = static_cast<uint32_t>(InHash) & (InTable.m_Capacity - 1); ; slotIdx = (slotIdx + 1) & (InTable.m_Capacity - 1))
+		{
+			const uint64_t slotHash = InTable.m_Slots[slotIdx].m_Hash.load(std::memory_order_acquire);
+			if (slotHash == InHash)
+			{
+				// Colliding descriptions are next to each other in the probe sequence, so the search goes on past them
+				const Entry& slotEntry = *InTable.m_Slots[slotIdx].m_Entry.load(std::memory_order_relaxed);
+				if (slotEntry.m_Key == InKey)
+				{
+					return slotEntry.m_State;
+				}
+			}
+			if (slotHash == 0)
+			{
+				return nullptr;
+			}
+		}
+	}
+
+	void PipelineStateCache::Insert(Table& InTable, uint64_t InHash, const Entry& InEntry)
+	{
+		for (uint32_t slotIdx = static_cast<uint32_t>(InHash) & (InTable.m_Capacity - 1); ; slotIdx = (slotIdx + 1) & (InTable.m_Capacity - 1))
+		{
+			Slot& slot = InTable.m_Slots[slotIdx];
+			if (slot.m_Hash.load(std::memory_order_relaxed) == 0)
+			{
+				slot.m_Entry.store(&InEntry, std::memory_order_relaxed);
+				slot.m_Hash.store(InHash, std::memory_order_release);
+				return;
+			}
+		}
+	}
+
+}
@@ -10,8 +10,9 @@
 #define CommandList_h__
 
 #include "GraphicsTypes.h"
+#include <array>
 
-namespace Mox { 
+namespace Mox {
 
 	class Device;
 	class PipelineState;
@@ -19,64 +20,204 @@ namespace Mox {
 
 	using TransitionInfoVector = std::vector<std::tuple<Mox::Resource*, Mox::RESOURCE_STATE, Mox::RESOURCE_STATE>>;
 
+	// Transition of a resource, or of one of its subresources, as recorded on the command list
+	struct ResourceTransition
+	{
+		Mox::Resource* m_Resource;
+		uint32_t m_Subresource;
+		Mox::RESOURCE_STATE m_Before;
+		Mox::RESOURCE_STATE m_After;
+	};
+
+	/*
+	* Records commands for the Gpu.
+	* State setting calls are compared with the state currently bound on the list, and the ones that would not change it
+	* are dropped before reaching the graphics API. Platform-specific lists implement the _Internal functions,
+	* which only get called for binds that change something.
+	* Resource transitions are requested with the state the next commands need, the list knows the state resources are in
+	* and records all the pending transitions in a single batch right before the next command accessing resources.
+	*/
 	class CommandList
 	{
 	public:
 
 		virtual ~CommandList() = default;
 
-		virtual void Close() = 0;
+		void Close();
+
+		// Requests the resource, or one of its subresources, to be in the given state for the commands recorded next.
+		// The transition from the tracked state is delayed until the next draw, dispatch, clear, copy or discard, 
+		// and it is dropped if the resource is already in that state.
+		// Command lists are expected to be submitted in the same order they are recorded, since the tracked state is shared among them.
+		void TransitionResource(Mox::Resource& InResource, Mox::RESOURCE_STATE InState, uint32_t InSubresource = Mox::ALL_SUBRESOURCES);
+
+		// Records the pending transitions as a single barrier batch. 
+		// Only needs to be called explicitly before commands recorded directly on the platform list.
+		void FlushResourceBarriers();
+
+		// Marks the given resources as the ones now using the memory they share with other resources
+		void AliasingBarriers(const std::vector<Mox::Resource*>& InResources);
 
-		virtual void ResourceBarriers(const TransitionInfoVector& InTransitions) = 0;
+		// Marks the content of the given resources as undefined, which initializes placed render targets and depth stencils 
+		// after an aliasing barrier. They are expected in the render target, depth write or unordered access state.
+		void DiscardResources(const std::vector<Mox::Resource*>& InResources);
 
-		virtual void ClearRTV(Mox::CpuDescHandle& InDescHandle, float* InColor) = 0;
-		
-		virtual void ClearDepth(Mox::CpuDescHandle& InDescHandle) = 0;
+		void ClearRTV(Mox::CpuDescHandle& InDescHandle, float* InColor);
 
-		virtual void SetPipelineStateAndResourceBinder(Mox::PipelineState& InPipelineState) = 0;
+		void ClearDepth(Mox::CpuDescHandle& InDescHandle);
 
-		virtual void SetInputAssemblerData(Mox::PRIMITIVE_TOPOLOGY InPrimTopology, Mox::VertexBufferView& InVertexBufView, Mox::IndexBufferView& InIndexBufView) = 0;
+		// Changing resource binder invalidates the root arguments bound with the previous one
+		void SetPipelineStateAndResourceBinder(Mox::PipelineState& InPipelineState);
+
+		void SetInputAssemblerData(Mox::PRIMITIVE_TOPOLOGY InPrimTopology, Mox::VertexBufferView& InVertexBufView, Mox::IndexBufferView& InIndexBufView);
 
 		virtual void SetViewportAndScissorRect(Mox::ViewPort& InViewport, Mox::Rect& InScissorRect) = 0;
 
 		virtual void SetRenderTargetFromWindow(Mox::Window& InWindow) = 0;
 
-		virtual void SetGraphicsRootConstants(uint64_t InRootParameterIndex, uint64_t InNum32BitValuesToSet, const void* InSrcData, uint64_t InDestOffsetIn32BitValues) = 0;
+		void SetGraphicsRootConstants(uint64_t InRootParameterIndex, uint64_t InNum32BitValuesToSet, const void* InSrcData, uint64_t InDestOffsetIn32BitValues);
 
 		virtual void SetComputeRootConstants(uint64_t InRootParameterIndex, uint64_t InNum32BitValuesToSet, const void* InSrcData, uint64_t InDestOffsetIn32BitValues) = 0;
 
-		virtual void SetGraphicsRootTable(uint32_t InRootIndex, Mox::ConstantBufferView& InView) = 0;
+		void SetGraphicsRootTable(uint32_t InRootIndex, Mox::ConstantBufferView& InView);
+
+		// Binds the buffer memory at the given Gpu address to a root shader resource, e.g. a structured buffer
+		void SetGraphicsRootShaderResource(uint32_t InRootIndex, Mox::GPU_V_ADDRESS InBufferLocation);
 
 		// Records the given Cbv at the specified root index for Gpu upload upon calling CommitStagedDescriptors()
-		virtual void StageDynamicCbv(uint32_t InRootIndex, Mox::ConstantBufferView& InCbv) = 0;
+		void StageDynamicCbv(uint32_t InRootIndex, Mox::ConstantBufferView& InCbv);
 
 		// Uploads the staged descriptors to Gpu. This is usually done before a draw command using such descriptors.
 		virtual void CommitStagedViews() = 0;
 
-		virtual void DrawIndexed(uint64_t InIndexCountPerInstance) = 0;
+		// Instances are numbered from 0 in the shaders, for each call
+		void DrawIndexed(uint64_t InIndexCountPerInstance, uint32_t InInstancesNum = 1);
 
-		virtual void Dispatch(uint32_t InGroupsNumX, uint32_t InGroupsNumY, uint32_t InGroupsNumZ) = 0;
+		void Dispatch(uint32_t InGroupsNumX, uint32_t InGroupsNumY, uint32_t InGroupsNumZ);
 
 		virtual void UploadViewToGPU(Mox::ShaderResourceView& InSRV) = 0;
 
 		virtual void UploadUavToGpu(Mox::UnorderedAccessView& InUav) = 0;
 
-		virtual void ReferenceSRV(uint32_t InRootIdx, Mox::ShaderResourceView& InSRV) = 0;
+		void ReferenceSRV(uint32_t InRootIdx, Mox::ShaderResourceView& InSRV);
+
+		void ReferenceCBV(uint32_t InRootIdx, Mox::ConstantBufferView& InCBV);
 
-		virtual void ReferenceCBV(uint32_t InRootIdx, Mox::ConstantBufferView& InCBV) = 0;
+		// Sets the table at the given root index to the start of the shader visible descriptor heap,
+		// so that shaders can reach every Gpu allocated view by its index there, see ShaderResourceView::GetHeapIndex
+		void ReferenceViewsHeap(uint32_t InRootIdx);
 
 		virtual void ReferenceComputeTable(uint32_t InRootIdx, Mox::ShaderResourceView& InUav) = 0;
 
 		virtual void ReferenceComputeTable(uint32_t InRootIdx, Mox::UnorderedAccessView& InUav) = 0;
 
 		// Internally calls ::UpdateSubresources(..) where IntermediateBuffer is expected to be allocated in upload heap
-		virtual void UploadBufferData(Mox::BufferResource& DestinationBuffer, Mox::BufferResource& IntermediateBuffer, const void* InBufferData, size_t InDataSize) = 0;
+		void UploadBufferData(Mox::BufferResource& DestinationBuffer, Mox::BufferResource& IntermediateBuffer, const void* InBufferData, size_t InDataSize);
 
+		// To be called when the list is reset for recording, after which nothing is bound on it anymore
+		void ResetBoundState();
+
+		// Number of binds that were dropped because they would not have changed the bound state, since the last reset
+		uint64_t GetSkippedBindsNum() const { return m_SkippedBindsNum; }
+
+		// Number of requested transitions that were dropped or merged with a pending one, since the last reset
+		uint64_t GetSkippedTransitionsNum() const { return m_SkippedTransitionsNum; }
 
 	protected:
 		CommandList(Mox::Device& InDevice);
 
+		virtual void Close_Internal() = 0;
+
+		virtual void ResourceBarriers_Internal(const std::vector<Mox::ResourceTransition>& InTransitions) = 0;
+
+		virtual void AliasingBarriers_Internal(const std::vector<Mox::Resource*>& InResources) = 0;
+
+		virtual void DiscardResources_Internal(const std::vector<Mox::Resource*>& InResources) = 0;
+
+		virtual void ClearRTV_Internal(Mox::CpuDescHandle& InDescHandle, float* InColor) = 0;
+
+		virtual void ClearDepth_Internal(Mox::CpuDescHandle& InDescHandle) = 0;
+
+		virtual void DrawIndexed_Internal(uint64_t InIndexCountPerInstance, uint32_t InInstancesNum) = 0;
+
+		virtual void Dispatch_Internal(uint32_t InGroupsNumX, uint32_t InGroupsNumY, uint32_t InGroupsNumZ) = 0;
+
+		virtual void UploadBufferData_Internal(Mox::BufferResource& DestinationBuffer, Mox::BufferResource& IntermediateBuffer, const void* InBufferData, size_t InDataSize) = 0;
+
+		virtual void SetPipelineState_Internal(Mox::PipelineState& InPipelineState) = 0;
+
+		virtual void SetResourceBinder_Internal(Mox::PipelineState& InPipelineState) = 0;
+
+		// Binds the shader visible descriptor heaps, they stay the same for the whole recording
+		virtual void SetDescriptorHeaps_Internal() = 0;
+
+		virtual void SetPrimitiveTopology_Internal(Mox::PRIMITIVE_TOPOLOGY InPrimTopology) = 0;
+
+		virtual void SetVertexBuffer_Internal(Mox::VertexBufferView& InVertexBufView) = 0;
+
+		virtual void SetIndexBuffer_Internal(Mox::IndexBufferView& InIndexBufView) = 0;
+
+		virtual void SetGraphicsRootConstants_Internal(uint64_t InRootParameterIndex, uint64_t InNum32BitValuesToSet, const void* InSrcData, uint64_t InDestOffsetIn32BitValues) = 0;
+
+		virtual void SetGraphicsRootTable_Internal(uint32_t InRootIndex, Mox::ConstantBufferView& InView) = 0;
+
+		virtual void SetGraphicsRootShaderResource_Internal(uint32_t InRootIndex, Mox::GPU_V_ADDRESS InBufferLocation) = 0;
+
+		virtual void StageDynamicCbv_Internal(uint32_t InRootIndex, Mox::ConstantBufferView& InCbv) = 0;
+
+		virtual void ReferenceSRV_Internal(uint32_t InRootIdx, Mox::ShaderResourceView& InSRV) = 0;
+
+		virtual void ReferenceCBV_Internal(uint32_t InRootIdx, Mox::ConstantBufferView& InCBV) = 0;
+
+		virtual void ReferenceViewsHeap_Internal(uint32_t InRootIdx) = 0;
+
 		Mox::Device& m_Device;
+
+		// Copy lists cannot record transitions: resources there are implicitly promoted to copy states and decay back once the work completes,
+		// so transition requests only move the tracked state to neutral, the one the next queue will find the resource in
+		bool m_CanTransitionResources = true;
+
+	private:
+
+		// Appends the transition of a single subresource, or of the whole resource when all subresources are in the same state
+		void RequestTransition(Mox::Resource& InResource, uint32_t InSubresource, Mox::RESOURCE_STATE InState);
+
+		// Copy list counterpart of RequestTransition, the subresource is expected to be in a state a copy queue can access
+		void DecayOnCopyQueue(Mox::Resource& InResource, uint32_t InSubresource);
+
+		// Records the view or Gpu address referenced by the root argument. Returns false if it was referenced already, in which case nothing needs to be bound.
+		bool BindGraphicsRootArgument(uint32_t InRootIdx, uint64_t InValue);
+
+		void InvalidateGraphicsRootArguments();
+
+		// D3D12 allows up to 64 d-words in a root signature, with at least one d-word per root argument
+		static constexpr uint32_t MaxRootArgumentsNum = 64;
+
+		// Value recorded for root arguments referencing the start of the descriptor heap, which no view or Gpu address can have
+		static constexpr uint64_t ViewsHeapRootArgument = UINT64_MAX;
+
+		const Mox::PipelineState* m_BoundPipelineState = nullptr;
+		// Resource binders are identified by their platform object, which can be shared by different pipeline states
+		const void* m_BoundGraphicsResourceBinder = nullptr;
+		const void* m_BoundComputeResourceBinder = nullptr;
+		bool m_AreDescriptorHeapsBound = false;
+
+		Mox::PRIMITIVE_TOPOLOGY m_BoundTopology = Mox::PRIMITIVE_TOPOLOGY::PT_UNDEFINED;
+		const Mox::VertexBufferView* m_BoundVertexBufferView = nullptr;
+		const Mox::IndexBufferView* m_BoundIndexBufferView = nullptr;
+
+		// View or Gpu address referenced by each root argument of the graphics resource binder, 0 when not known
+		std::array<uint64_t, MaxRootArgumentsNum> m_BoundGraphicsRootArguments{};
+
+		// Offset and values of the last constants set at each root argument of the graphics resource binder, empty when not known
+		std::array<uint64_t, MaxRootArgumentsNum> m_BoundGraphicsRootConstantsOffsets{};
+		std::array<std::vector<uint32_t>, MaxRootArgumentsNum> m_BoundGraphicsRootConstants;
+
+		uint64_t m_SkippedBindsNum = 0;
+
+		std::vector<Mox::ResourceTransition> m_PendingTransitions;
+
+		uint64_t m_SkippedTransitionsNum = 0;
 	};
 
 }
@@ -36,6 +36,18 @@ class CommandList;
 
 		virtual void Flush() = 0;
 
+		// Last fence value reached by the Gpu on this queue
+		virtual uint64_t GetCompletedFenceValue() = 0;
+
+		virtual bool IsFenceComplete(uint64_t InFenceValue) = 0;
+
+		// Stalls the calling thread until the Gpu reaches the given fence value on this queue
+		virtual void WaitForFenceValue(uint64_t InFenceValue) = 0;
+
+		// Makes the Gpu wait for another queue to reach the given fence value before executing the work submitted next on this queue,
+		// the calling thread does not stall
+		virtual void GpuWaitForQueue(Mox::CommandQueue& InOtherQueue, uint64_t InFenceValue) = 0;
+
 		virtual void OnRenderFrameStarted() = 0;
 
 		virtual void OnRenderFrameFinished() = 0;
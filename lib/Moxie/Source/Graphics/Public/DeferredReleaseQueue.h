@@ -0,0 +1,81 @@
+/*
+ DeferredReleaseQueue.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef DeferredReleaseQueue_h__
+#define DeferredReleaseQueue_h__
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace Mox {
+
+	/*
+	* Keeps alive the objects that were taken out of rendering but that the Gpu can still be reading in the frames in flight.
+	* Objects are collected in a batch that gets closed with the fence value signaled after the frame that could last reference them,
+	* and they are destroyed only once that fence value is reported as completed.
+	* As for the UploadTracker, completed fence values are passed in by the caller and no command queue is ever queried.
+	*/
+	class DeferredReleaseQueue
+	{
+	public:
+		// Takes ownership of the given object, it will be destroyed together with the batch it ends up in.
+		// Note: Any unique or shared pointer converts to a shared_ptr<void> that still calls the right destructor.
+		void Enqueue(std::shared_ptr<void> InObject);
+
+		// Moves every owning pointer of the container that points to one of the targets in the open batch,
+		// then erases the emptied entries while keeping the order of the remaining ones.
+		template<typename ContainerT, typename TargetSetT>
+		void EnqueueFrom(ContainerT& InOutContainer, const TargetSetT& InTargets)
+		{
+			if (InTargets.empty())
+			{
+				return;
+			}
+
+			for (auto& element : InOutContainer)
+			{
+				if (InTargets.find(element.get()) != InTargets.end())
+				{
+					Enqueue(std::move(element));
+				}
+			}
+
+			InOutContainer.erase(std::remove(InOutContainer.begin(), InOutContainer.end(), nullptr), InOutContainer.end());
+		}
+
+		// Closes the objects enqueued so far in a batch tagged with the given fence value
+		void CloseBatch(uint64_t InFenceValue);
+
+		// Destroys the objects of all the batches completed up to the given fence value
+		void Reclaim(uint64_t InCompletedFenceValue);
+
+		// Destroys every object, including the ones in the batch still open. Only to be called once the Gpu is idle.
+		void ReleaseAll();
+
+		size_t GetPendingObjectsNum() const { return m_PendingObjectsNum; }
+
+	private:
+		struct PendingBatch
+		{
+			uint64_t m_FenceValue;
+			std::vector<std::shared_ptr<void>> m_Objects;
+		};
+
+		std::vector<std::shared_ptr<void>> m_OpenBatch;
+
+		// Ordered by increasing fence value
+		std::deque<PendingBatch> m_PendingBatches;
+
+		size_t m_PendingObjectsNum = 0;
+	};
+
+}
+
+#endif // DeferredReleaseQueue_h__
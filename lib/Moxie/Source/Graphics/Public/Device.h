@@ -29,6 +29,9 @@ public:
 
 	virtual void ShutDown() = 0;
 
+	// Identifies the adapter and driver in use. Compiled pipeline states stored by a previous run are only valid with the same hash.
+	virtual uint64_t GetPipelineCacheContextHash() const = 0;
+
 private:
 	bool m_IsMainDevice=false;
 };
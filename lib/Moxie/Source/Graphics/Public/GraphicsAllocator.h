@@ -11,6 +11,9 @@
 
 #include "GraphicsTypes.h"
 #include "PipelineState.h"
+#include "PipelineStateCache.h"
+#include "MoxMeshOptimizer.h"
+#include "MoxMeshSimplifier.h"
 
 namespace Mox { 
 
@@ -21,6 +24,7 @@ namespace Mox {
 	class CommandQueue;
 	class RenderProxy;
 	class Drawable;
+	class TransientResourceAllocator;
 
 /* 
 * This pure virtual class serves as interface for any Graphics Allocator we want to implement.
@@ -49,12 +53,59 @@ public:
 
 	virtual void UpdateStaticBufferResources(Mox::CommandList& InCmdList, const std::vector<Mox::BufferResourceUpdate>& InUpdates) = 0;
 
+	// Sets the queue that executes content uploads. The allocator can wait on it when staging memory runs out.
+	virtual void SetUploadQueue(Mox::CommandQueue& InUploadQueue) = 0;
+
+	// Pipeline states shared by all the render passes, render passes should get their states from here rather than allocating them
+	Mox::PipelineStateCache& GetPipelineStateCache() { return *m_PipelineStateCache; }
+
+	// Memory for the transient textures of the render graph
+	virtual Mox::TransientResourceAllocator& GetTransientResourceAllocator() = 0;
+
+	// Tags the staging memory used by the uploads recorded so far with the fence value signaled after their submission
+	virtual void OnUploadSubmitted(uint64_t InFenceValue) = 0;
+
+	// Gives back the staging memory of all the uploads that the Gpu completed
+	virtual void RetireUploads(uint64_t InCompletedFenceValue) = 0;
+
+	// Tags the objects released so far with the fence value signaled after the frame that could last reference them
+	virtual void OnFrameSubmitted(uint64_t InFenceValue) = 0;
+
+	// Destroys the released objects of all the frames that the Gpu completed
+	virtual void ReclaimReleasedObjects(uint64_t InCompletedFenceValue) = 0;
+
+	// Takes the given proxies and their drawables out of the allocator. 
+	// Their draw commands need to be removed from the render passes beforehand.
+	virtual void ReleaseRenderProxies(const std::vector<std::shared_ptr<Mox::RenderProxy>>& InProxies) = 0;
+
+	// Takes ownership of the given buffers and releases them together with their buffer resources and views
+	virtual void ReleaseBuffers(std::vector<std::unique_ptr<Mox::ConstantBuffer>>&& InBuffers) = 0;
+
 	virtual Mox::VertexBuffer& AllocateVertexBuffer(const Mox::INPUT_LAYOUT_DESC& InLayoutDesc, const void* InData, uint32_t InStride, uint32_t InSize) = 0;
 
 	virtual Mox::IndexBuffer& AllocateIndexBuffer(const void* InData, uint32_t InStride, uint32_t InSize) = 0;
 
+	// Allocates the vertex and index buffers of a mesh after reordering their content for the Gpu vertex caches and for overdraw,
+	// see OptimizeMeshBuffers. The given data is not modified. Vertex cache statistics before and after are written to OutStats, when given.
+	// Other index buffers referencing the same vertices would need the remap, so levels of detail come from AllocateMeshWithLods.
+	void AllocateOptimizedMeshBuffers(const Mox::INPUT_LAYOUT_DESC& InLayoutDesc, const void* InVertexData, uint32_t InVertexStride, uint32_t InVertexSize,
+		const void* InIndexData, uint32_t InIndexStride, uint32_t InIndexSize, Mox::VertexBuffer*& OutVertexBuffer, Mox::IndexBuffer*& OutIndexBuffer,
+		Mox::MeshOptimizationStats* OutStats = nullptr);
+
+	// Allocates the buffers of a mesh as AllocateOptimizedMeshBuffers does, then its coarser levels of detail from GenerateMeshLods,
+	// each with its own index buffer on the same vertex buffer, reordered for the vertex cache and overdraw as well.
+	// Float elements other than the position are preserved as attributes by the simplifier, up to SimplifierMaxAttributesNum values.
+	// The screen size of each level is where its error, projected on screen, gets below InMaxScreenError.
+	void AllocateMeshWithLods(const Mox::INPUT_LAYOUT_DESC& InLayoutDesc, const void* InVertexData, uint32_t InVertexStride, uint32_t InVertexSize,
+		const void* InIndexData, uint32_t InIndexStride, uint32_t InIndexSize, const Mox::MeshLodSettings& InLodSettings,
+		Mox::VertexBuffer*& OutVertexBuffer, Mox::IndexBuffer*& OutIndexBuffer, std::vector<Mox::MeshLod>& OutLods,
+		float InMaxScreenError = Mox::DefaultLodScreenError);
+
 	virtual Mox::BufferResource& AllocateDynamicBuffer(uint32_t InSize) = 0;
 
+	// Upload memory valid only for the frame currently being recorded, for data that is written once per frame such as instance data
+	virtual void AllocateFrameData(uint32_t InSize, void*& OutCpuPtr, Mox::GPU_V_ADDRESS& OutGpuPtr) = 0;
+
 	virtual void AllocateResourceForTexture(const Mox::TextureResourceRequest& InTexDesc) = 0;
 
 	virtual void UpdateTextureResources(Mox::CommandList& InCmdList, const std::vector<Mox::TextureResourceUpdate>& InTextureUpdates) = 0;
@@ -89,6 +140,9 @@ public:
 
 	virtual void CreateDrawables(const std::vector<Mox::DrawableCreationInfo>& InRequests) = 0;
 
+	// Registers the proxies of the batch and creates their drawables, returning the registered proxies
+	virtual std::vector<RenderProxy*> CreateSpawnBatch(const Mox::SpawnBatchRequest& InSpawnBatch) = 0;
+
 
 
 	// Deleting copy constructor, assignment operator, move constructor and move assignment
@@ -96,6 +150,13 @@ public:
 	GraphicsAllocatorBase& operator=(const GraphicsAllocatorBase&) = delete;
 	GraphicsAllocatorBase(GraphicsAllocatorBase&&) = delete;
 	GraphicsAllocatorBase& operator=(GraphicsAllocatorBase&&) = delete;
+
+protected:
+	// Allocators that do not run on a graphics device (e.g. for testing) provide their own pipeline state cache
+	explicit GraphicsAllocatorBase(std::unique_ptr<Mox::PipelineStateCache> InPipelineStateCache);
+
+private:
+	std::unique_ptr<Mox::PipelineStateCache> m_PipelineStateCache;
 };
 
 
@@ -13,6 +13,7 @@
 #include <string>
 #include <vector>
 #include <unordered_set>
+#include "MoxBoundingVolumes.h"
 
 namespace std {
 enum class byte : unsigned char;
@@ -123,7 +124,9 @@ enum class RESOURCE_STATE : uint8_t {
 	RENDER_TARGET,
 	COPY_SOURCE,
 	COPY_DEST,
-	GEN_READ
+	GEN_READ,
+	DEPTH_WRITE,
+	UNORDERED_ACCESS
 };
 
 enum class TEXTURE_TYPE : uint8_t {
@@ -135,6 +138,9 @@ enum class TEXTURE_TYPE : uint8_t {
 
 using GPU_V_ADDRESS = uint64_t; // TODO this should depend on graphics API.. as it is valid for D3D12 specifically
 
+// Subresource index referring to every subresource of a resource at once
+constexpr uint32_t ALL_SUBRESOURCES = 0xffffffff;
+
 /*
 A Resource can either be a buffer or a texture (and their specifications)
 */
@@ -147,10 +153,26 @@ struct Resource {
 	virtual void Map(void** OutCpuPp) = 0;
 	virtual void UnMap() = 0;
 
+	// Mip levels times array slices for textures, 1 for buffers
+	uint16_t GetSubresourcesNum() const { return m_SubresourcesNum; }
+
+	// State the resource is left in by the commands recorded so far, updated by CommandList::TransitionResource.
+	// Subresources are tracked one by one only while they are not all in the same state.
+	Mox::RESOURCE_STATE GetTrackedState(uint32_t InSubresource = ALL_SUBRESOURCES) const;
+
+	bool HasUniformTrackedState() const { return m_TrackedSubresourceStates.empty(); }
+
+	void SetTrackedState(Mox::RESOURCE_STATE InState, uint32_t InSubresource = ALL_SUBRESOURCES);
+
 protected:
 	GPU_V_ADDRESS m_GpuPtr;
 	uint32_t m_DataSize;
 	uint32_t m_Alignment;
+	uint16_t m_SubresourcesNum = 1;
+
+	Mox::RESOURCE_STATE m_TrackedState = Mox::RESOURCE_STATE::NEUTRAL;
+	// Only filled while subresources are in different states
+	std::vector<Mox::RESOURCE_STATE> m_TrackedSubresourceStates;
 };
 
 enum class RES_CONTENT_TYPE : int8_t
@@ -181,6 +203,9 @@ struct BufferResource {
 
 	void* GetData() const { return m_CpuPtr; }
 
+	// Latest content set by the render thread, readable also when the Gpu memory of the buffer is not
+	const void* GetLocalData() const { return m_LocalData.data(); }
+
 	GPU_V_ADDRESS GetGpuPtr() const { return m_GpuPtr; }
 
 	uint32_t GetSize() const { return m_Size; }
@@ -261,6 +286,9 @@ protected:
 	BufferResource* m_Resource;
 };
 
+// Size in bytes of a vertex element, 0 for formats that cannot be part of a vertex
+uint32_t GetVertexElementSize(Mox::BUFFER_FORMAT InFormat);
+
 class INPUT_LAYOUT_DESC {
 public:
 	struct LayoutElement {
@@ -281,6 +309,10 @@ public:
 	// Ordered element sequence
 	std::vector<LayoutElement> LayoutElements;
 
+	// Byte offset of the R32G32B32_FLOAT POSITION element in a vertex of the given stride, or -1 when there is none.
+	// Elements are expected to be tightly packed in the order of the layout.
+	int32_t GetPositionOffset(uint32_t InStride) const;
+
 	// Insert any missing layout element from the given input
 	void BuildLeftover(const INPUT_LAYOUT_DESC& InOtherDesc)
 	{
@@ -308,8 +340,14 @@ public:
 
 	const INPUT_LAYOUT_DESC& GetLayoutDesc() const { return m_LayoutDesc; }
 
+	// Bounds of the vertex positions, computed from the data given on creation.
+	// Empty if the layout has no R32G32B32_FLOAT POSITION element.
+	const Mox::Aabb& GetLocalBounds() const { return m_LocalBounds; }
+
 private:
 	INPUT_LAYOUT_DESC m_LayoutDesc;
+
+	Mox::Aabb m_LocalBounds;
 };
 
 class IndexBuffer : public BufferResourceHolder
@@ -427,6 +465,10 @@ protected:
 struct ShaderResourceView : public ResourceView {
 	virtual void InitAsTex2DOrCubemap(Mox::TextureResource& InTexture) = 0;
 
+	// Position of the view in the shader visible descriptor heap, for shaders indexing the views there.
+	// Only valid for Gpu allocated views.
+	virtual uint32_t GetHeapIndex() = 0;
+
 	static ShaderResourceView* GetNull2D() { return m_NullTex2DSrv.get(); }
 	static ShaderResourceView* GetNullCube() { return m_NullCubeSrv.get(); }
 
@@ -567,8 +609,13 @@ enum class SHADER_VISIBILITY {
 };
 
 struct Shader {
+	// Hash of the compiled shader code, the same across runs of the application
+	uint64_t GetBytecodeHash() const { return m_BytecodeHash; }
+
 protected:
 	Shader() = default;
+
+	uint64_t m_BytecodeHash = 0;
 };
 
 
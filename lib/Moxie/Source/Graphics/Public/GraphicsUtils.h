@@ -10,12 +10,14 @@
 #define GraphicsUtils_h__
 
 #include "GraphicsTypes.h"
+#include "MoxMath.h"
 #include <memory> // for std::unique_ptr
 
-// Note: MOX_ROOT_PATH should be coming from CMake
+// Note: MOX_ROOT_PATH and MOX_SHADERS_DIR should be coming from CMake
 #define Q(x) L#x
 #define LQUOTE(x) Q(x)
-#define MOX_SHADERS_PATH(NAME) LQUOTE(MOX_ROOT_PATH/Shaders/NAME)
+// Shader bytecode is generated by the build from the hlsl files in MOX_ROOT_PATH/Shaders
+#define MOX_SHADERS_PATH(NAME) LQUOTE(MOX_SHADERS_DIR/NAME)
 
 // TODO move this in general Utils (not graphics specific)
 // this has taken inspiration from DEFINE_ENUM_FLAG_OPERATORS(ENUMTYPE) defined in winnt.h
@@ -87,6 +89,7 @@ namespace Mox {
 	};
 
 	class RenderProxy;
+	struct OccluderMesh;
 
 	// When the render proxy will be created for the target entity, 
 	// the render resources for the bound meshes will be created as well
@@ -105,7 +108,8 @@ namespace Mox {
 	{
 		CONSTANT_BUFFER,
 		TEXTURE,
-		UNORDERED_ACCESS
+		UNORDERED_ACCESS,
+		STRUCTURED_BUFFER
 	};
 
 	struct ShaderParameterDefinition
@@ -125,6 +129,20 @@ namespace Mox {
 	using BufferMeshParams = std::vector<std::tuple<Mox::SpHash, Mox::ConstantBuffer*>>;
 	using TextureMeshParams = std::vector<std::tuple<Mox::SpHash, Mox::Texture*>>;
 
+	// Simplified version of a mesh, drawn in place of the previous level of detail when the mesh gets small on screen
+	struct MeshLod
+	{
+		// Expected to have the same vertex layout as the full detail mesh
+		const Mox::VertexBuffer* m_VertexBuffer;
+		const Mox::IndexBuffer* m_IndexBuffer;
+		// Projected size, as a fraction of the view height, below which this level replaces the previous one
+		float m_ScreenSize;
+	};
+
+	// Error of a level of detail, projected on screen as a fraction of the view height, below which the level replaces the previous one.
+	// About a pixel at 1080p.
+	constexpr float DefaultLodScreenError = 1.f / 1080.f;
+
 	struct DrawableCreationInfo
 	{
 		Mox::RenderProxy* m_OwningProxy;
@@ -134,6 +152,40 @@ namespace Mox {
 		BufferMeshParams m_BufferShaderParameters;
 		TextureMeshParams m_TextureShaderParameters;
 		bool m_RenderBackfaces = false;
+		// Optional simplified version of the mesh, rasterized to cull the objects it hides
+		std::shared_ptr<const Mox::OccluderMesh> m_Occluder;
+		// Coarser levels of detail of the mesh, ordered by decreasing screen size. The buffers above are the full detail level.
+		std::vector<Mox::MeshLod> m_Lods;
+	};
+
+	// Render data of a group of entities spawned together from the same template.
+	// It replaces a proxy request, a drawable request and a transform update for each entity.
+	struct SpawnBatchRequest
+	{
+		std::vector<std::shared_ptr<Mox::RenderProxy>> m_Proxies;
+
+		// Drawable created for each proxy. Not used if the entities have no mesh.
+		Mox::DrawableCreationInfo m_DrawableTemplate{};
+
+		// One for each proxy, in the same order, or empty if the entities have no mesh
+		std::vector<Mox::Matrix4f> m_InitialModelMatrices;
+	};
+
+	// New world transform of an entity, used by the render thread to place the bounds of its drawables
+	struct RenderProxyTransformUpdate
+	{
+		Mox::RenderProxy* m_TargetProxy;
+		Mox::Matrix4f m_ModelMatrix;
+	};
+
+	// New shader parameters for a drawable of a proxy, identified by the order drawables were added to the proxy.
+	// Parameters not listed keep their value.
+	struct DrawableParametersUpdate
+	{
+		Mox::RenderProxy* m_TargetProxy;
+		uint32_t m_DrawableIndex;
+		BufferMeshParams m_BufferShaderParameters;
+		TextureMeshParams m_TextureShaderParameters;
 	};
 
 	// Used by the simulation thread to transfer object changes to the render thread
@@ -143,15 +195,28 @@ namespace Mox {
 
 		std::vector<Mox::DrawableCreationInfo> m_DrawableRequests;
 
+		std::vector<Mox::SpawnBatchRequest> m_SpawnBatchRequests;
+
 		std::vector<Mox::BufferResourceRequest> m_BufferResourceRequests;
 
 		std::vector<Mox::BufferResourceUpdate> m_DynamicBufferUpdates;
 
 		std::vector<Mox::BufferResourceUpdate> m_StaticBufferUpdates;
 
+		std::vector<Mox::RenderProxyTransformUpdate> m_ProxyTransformUpdates;
+
+		std::vector<Mox::DrawableParametersUpdate> m_DrawableParametersUpdates;
+
 		std::vector<Mox::TextureResourceRequest> m_TextureResourceRequests;
 
 		std::vector<Mox::TextureResourceUpdate> m_TextureUpdates;
+
+		// Render proxies of destroyed entities, to be taken out of rendering and released by the render thread
+		std::vector<std::shared_ptr<Mox::RenderProxy>> m_ProxyReleases;
+
+		// Buffers whose owner went away on the simulation thread.
+		// Ownership is transferred here so that requests and updates still pending for them stay valid until the render thread is done with them.
+		std::vector<std::unique_ptr<Mox::ConstantBuffer>> m_BufferReleases;
 	};
 
 	// Render updates are meant to be filled in the simulation thread
@@ -160,8 +225,9 @@ namespace Mox {
 
 	// Stores a request of creating a buffer resource for the given buffer
 	void RequestBufferResourceForHolder(Mox::BufferResourceHolder& InHolder);
-	// Stores a request of releasing the buffer resource associated with the given buffer
-	void ReleaseResourceForBuffer(Mox::ConstantBuffer& InBuffer);
+	// Stores a request of releasing the buffer resource associated with the given buffer.
+	// The buffer itself is handed over to the render thread, that will destroy it once it is not referenced anymore.
+	void ReleaseResourceForBuffer(std::unique_ptr<Mox::ConstantBuffer> InBuffer);
 
 	void RequestTextureResource(Mox::Texture& InTexture, TextureDesc& InDesc);
 
@@ -171,6 +237,14 @@ namespace Mox {
 
 	void RequestDrawable(const DrawableCreationInfo& InCreationInfo);
 
+	void RequestSpawnBatch(Mox::SpawnBatchRequest&& InSpawnBatch);
+
+	// The proxy is expected to be alive until the render thread processes the updates of the current frame
+	void UpdateRenderProxyTransform(Mox::RenderProxy& InProxy, const Mox::Matrix4f& InModelMatrix);
+
+	// Textures are expected to have their content uploaded already. The proxy is expected to be alive until the render thread processes the updates of the current frame.
+	void UpdateDrawableParameters(Mox::RenderProxy& InProxy, uint32_t InDrawableIdx, BufferMeshParams&& InBufferParams, TextureMeshParams&& InTextureParams);
+
 	void UpdateConstantBufferValue(Mox::BufferResourceHolder& InBufferHolder, const void* InData, uint32_t InSize);
 
 	void UpdateTextureContent(Mox::TextureResourceUpdate&& InUpdate);
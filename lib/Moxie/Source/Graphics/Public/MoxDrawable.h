@@ -10,6 +10,7 @@
 #define MoxDrawable_h__
 
 #include "MoxMath.h"
+#include "MoxBoundingVolumes.h"
 #include <unordered_map>
 
 namespace Mox {
@@ -37,6 +38,9 @@ public:
 	void SetCbShaderParamValue(Mox::SpHash InHash, Mox::ConstantBuffer* InBuffer);
 	void SetTexShaderParamValue(Mox::SpHash InHash, Mox::Texture* InTexture);
 
+	// Places the local bounds in the world, called by the owning proxy when its transform changes
+	void UpdateWorldBounds(const Mox::Matrix4f& InModelMatrix) { m_WorldBounds = m_LocalBounds.Transformed(InModelMatrix); }
+
 
 	// Translation, Rotation and Scale
 
@@ -44,6 +48,11 @@ public:
 	const Mox::VertexBuffer& m_VertexBuffer;
 	const Mox::IndexBuffer& m_IndexBuffer;
 
+	// Bounds of the vertex buffer, and the same bounds transformed by the model matrix, used by render passes for culling.
+	// Empty bounds mean that the drawable is never culled.
+	Mox::Aabb m_LocalBounds;
+	Mox::Aabb m_WorldBounds;
+
 
 	// Shader parameter hash -> Buffer
 	std::unordered_map<Mox::SpHash, Mox::ConstantBuffer*> m_BufferShaderParameters;
@@ -53,6 +62,13 @@ public:
 	// If to consider backfaces as the ones to render for this drawable
 	bool m_RenderBackfaces = false;
 
+	// Set when the drawable hides what is behind it, in local space as the vertex buffer
+	std::shared_ptr<const Mox::OccluderMesh> m_Occluder;
+
+	// Coarser levels of detail, picked by render passes from the size of the world bounds on screen.
+	// They share the bounds of the full detail mesh.
+	std::vector<Mox::MeshLod> m_Lods;
+
 	Mox::Material& m_Material;
 };
 
@@ -9,6 +9,8 @@
 #ifndef MoxRenderProxy_h__
 #define MoxRenderProxy_h__
 
+#include "MoxMath.h"
+
 namespace Mox {
 
 	struct VertexBufferView;
@@ -28,9 +30,15 @@ namespace Mox {
 		~RenderProxy();
 		RenderProxy(RenderProxy&&) noexcept;
 
-		void AddDrawable(Mox::Drawable* InDrawable) { m_Meshes.push_back(InDrawable); }
+		void AddDrawable(Mox::Drawable* InDrawable);
+
+		// Called on the render thread when the entity moves, it keeps the world bounds of the drawables up to date
+		void SetModelMatrix(const Mox::Matrix4f& InModelMatrix);
 
 		std::vector<Mox::Drawable*> m_Meshes;
+
+		// Last model matrix received from the simulation, read by the render passes when drawing and also given to drawables added later
+		Mox::Matrix4f m_ModelMatrix = Mox::Matrix4f::Identity();
 	};
 
 }
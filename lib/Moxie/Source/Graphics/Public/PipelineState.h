@@ -27,7 +27,11 @@ public:
 
 	// Abstraction of root signature parameter desc
 	struct RESOURCE_BINDER_PARAM {
-		// TODO create support for root descriptors
+		// Descriptors number of a table reaching the end of the descriptor heap, for shaders indexing the views in it.
+		// Such a table is meant to be set at the start of the heap, see CommandList::ReferenceViewsHeap
+		static constexpr uint32_t UnboundedDescriptorsNum = UINT32_MAX;
+
+		// TODO create support for CBV and UAV root descriptors
 		void InitAsConstants(uint32_t InNum32BitValues, uint32_t InShaderRegister, uint32_t InRegisterSpace = 0, Mox::SHADER_VISIBILITY InShaderVisibility = SHADER_VISIBILITY::SV_ALL)
 		{
 			Num32BitValues = InNum32BitValues;
@@ -37,6 +41,15 @@ public:
 			shaderVisibility = InShaderVisibility;
 		}
 
+		// Root descriptor referencing a buffer by its Gpu address, so that no descriptor needs to be allocated for it
+		void InitAsShaderResourceView(uint32_t InShaderRegister, uint32_t InRegisterSpace = 0, Mox::SHADER_VISIBILITY InShaderVisibility = SHADER_VISIBILITY::SV_ALL)
+		{
+			ShaderRegister = InShaderRegister;
+			RegisterSpace = InRegisterSpace;
+			ResourceType = RESOURCE_TYPE::SRV;
+			shaderVisibility = InShaderVisibility;
+		}
+
 		void InitAsTableCBVRange(uint32_t InNumDescriptors, uint32_t InShaderRegister, uint32_t InRegisterSpace = 0, Mox::SHADER_VISIBILITY InShaderVisibility = SHADER_VISIBILITY::SV_ALL)
 		{
 			NumDescriptors = InNumDescriptors;
@@ -70,7 +83,8 @@ public:
 			CONSTANTS,
 			CBV_RANGE,
 			SRV_RANGE,
-			UAV_RANGE
+			UAV_RANGE,
+			SRV
 		} ResourceType = RESOURCE_TYPE::CONSTANTS;
 		
 		SHADER_VISIBILITY shaderVisibility;
@@ -117,8 +131,19 @@ public:
 
 	virtual void Init(COMPUTE_PSO_DESC& InPipelineStateDesc) = 0;
 
+	// Initializes the state from a blob previously returned by GetCachedBlob, which skips most of the compilation.
+	// Returns false, leaving the state uninitialized, if the platform rejects the blob (e.g. because it comes from another driver).
+	virtual bool InitFromCachedBlob(GRAPHICS_PSO_DESC& InPipelineStateDesc, const std::vector<uint8_t>& InCachedBlob) = 0;
+
+	// Compiled form of an initialized state, that can be stored and given to InitFromCachedBlob on later runs.
+	// Empty if the platform cannot provide it.
+	virtual std::vector<uint8_t> GetCachedBlob() const = 0;
+
 	bool IsGraphics() const  {return m_IsGraphicsPSO; }
 
+	// Platform object of the resource binder, used to tell if two states share it
+	virtual const void* GetResourceBinderHandle() const = 0;
+
 protected:
 	bool m_IsGraphicsPSO = false;
 };
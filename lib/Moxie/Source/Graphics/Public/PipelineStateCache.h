@@ -0,0 +1,109 @@
+/*
+ PipelineStateCache.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef PipelineStateCache_h__
+#define PipelineStateCache_h__
+
+#include "PipelineState.h"
+#include "PersistentBlobCache.h"
+#include <atomic>
+#include <mutex>
+#include <deque>
+
+namespace Mox {
+
+	/*
+	* Shares pipeline states between users asking for the same description, so that the number of pipeline states
+	* (and root signatures) grows with the number of unique states rather than with the number of meshes.
+	* - States are identified by a 64-bit hash of their description, see ComputeDescHash. A matching hash is confirmed
+	*   by comparing the whole description key, so descriptions whose hashes collide never share a state.
+	* - Lookups of existing states are lock-free: they only read an open addressing table whose slots are published atomically.
+	*   Creating a new state takes a lock, and the table grows by publishing a bigger copy, old tables are kept for readers still using them.
+	* - Created states are kept until the cache is destroyed, they are owned by the graphics allocator.
+	* - States missing from memory are looked up on disk by the same hash, so that later runs skip the compilation of the states
+	*   compiled by previous ones. Stored states are discarded when the graphics adapter or driver change.
+	*/
+	class PipelineStateCache
+	{
+	public:
+		PipelineStateCache();
+
+		// Stores compiled states in the given cache, or keeps them in memory only when it is null
+		explicit PipelineStateCache(std::unique_ptr<Mox::PersistentBlobCache> InDiskCache);
+
+		~PipelineStateCache();
+
+		// Returns the state matching the description, creating it if none was created before
+		Mox::PipelineState& GetOrCreate(Mox::PipelineState::GRAPHICS_PSO_DESC& InDesc);
+
+		// Bytes of everything that defines the state: input layout, resource binder, topology, shader code, formats and culling mode.
+		// Shaders are identified by the hash of their code, so the same description gives the same key across runs.
+		static void BuildDescKey(const Mox::PipelineState::GRAPHICS_PSO_DESC& InDesc, std::vector<uint8_t>& OutKey);
+
+		// Hash of the description key, never zero
+		static uint64_t ComputeDescHash(const Mox::PipelineState::GRAPHICS_PSO_DESC& InDesc);
+
+		uint64_t GetHitsNum() const { return m_HitsNum.load(std::memory_order_relaxed); }
+		// Each miss creates a new state
+		uint64_t GetMissesNum() const { return m_MissesNum.load(std::memory_order_relaxed); }
+
+		// Misses whose state was created from a compiled blob stored by a previous run
+		uint64_t GetDiskHitsNum() const { return m_DiskHitsNum.load(std::memory_order_relaxed); }
+
+	private:
+		// Created state together with the key of its description, entries are never moved or removed
+		struct Entry
+		{
+			std::vector<uint8_t> m_Key;
+			Mox::PipelineState* m_State;
+		};
+
+		struct Slot
+		{
+			// Zero means the slot is empty. The entry is written before the hash, so a reader that finds the hash also finds the entry.
+			std::atomic<uint64_t> m_Hash{ 0 };
+			std::atomic<const Entry*> m_Entry{ nullptr };
+		};
+
+		struct Table
+		{
+			explicit Table(uint32_t InCapacity) : m_Capacity(InCapacity), m_Slots(std::make_unique<Slot[]>(InCapacity)) { }
+
+			const uint32_t m_Capacity;
+			std::unique_ptr<Slot[]> m_Slots;
+		};
+
+		static uint64_t HashDescKey(const std::vector<uint8_t>& InKey);
+
+		static Mox::PipelineState* Find(const Table& InTable, uint64_t InHash, const std::vector<uint8_t>& InKey);
+
+		static void Insert(Table& InTable, uint64_t InHash, const Entry& InEntry);
+
+		void InitState(Mox::PipelineState& InOutState, Mox::PipelineState::GRAPHICS_PSO_DESC& InDesc, uint64_t InDescHash, const std::vector<uint8_t>& InDescKey);
+
+		std::atomic<Table*> m_Table;
+
+		// Tables replaced by bigger ones, including the current one at the back
+		std::vector<std::unique_ptr<Table>> m_Tables;
+
+		// Serializes state creation and table growth, together with the entries
+		std::mutex m_InsertMutex;
+
+		std::deque<Entry> m_Entries;
+
+		std::atomic<uint64_t> m_HitsNum{ 0 };
+		std::atomic<uint64_t> m_MissesNum{ 0 };
+		std::atomic<uint64_t> m_DiskHitsNum{ 0 };
+
+		// Null when the persistent cache is disabled
+		std::unique_ptr<Mox::PersistentBlobCache> m_DiskCache;
+	};
+
+}
+
+#endif // PipelineStateCache_h__
@@ -10,6 +10,7 @@
 #define RangeAllocators_h__
 
 #include <map>
+#include <deque>
 
 namespace Mox { 
 
@@ -39,6 +40,9 @@ namespace Mox {
 		virtual size_t AllocateRange(size_t InRangeSize);
 
 		virtual void FreeAllocatedRange(uint32_t InRangeOffset, uint32_t InRangeSize);
+
+		// Size of the biggest range that can be allocated right now
+		size_t GetLargestFreeRangeSize() const { return m_FreeRangesBySize.empty() ? 0 : m_FreeRangesBySize.rbegin()->first; }
 protected:
 		StaticRangeAllocator() = default;
 		// No copies, only moves are allowed
@@ -97,6 +101,54 @@ private:
 		uint32_t m_AllocationLimit;
 	};
 
+	// Circular allocator meant for staging (upload) memory.
+	// Allocations are grouped in batches, and each batch is tagged with the fence value of the Gpu work that reads from it.
+	// Memory of a batch is given back only when the caller reports that fence value as completed,
+	// so there is no need to stall the Gpu before reusing the staging memory.
+	// Note: this class knows nothing about command queues, fence values are plain numbers passed in by the caller.
+	class FencedRingAllocator
+	{
+	public:
+		FencedRingAllocator(size_t InPoolSize);
+
+		// Returns false if the range does not fit in the memory that has not been retired yet
+		bool TryAllocateRange(size_t InRangeSize, size_t InAlignment, size_t& OutRangeOffset);
+
+		// Tags all the ranges allocated since the previous call with the given fence value
+		void CloseBatch(uint64_t InFenceValue);
+
+		// Gives back the memory of all the batches with a fence value less or equal than the given one
+		void Retire(uint64_t InCompletedFenceValue);
+
+		bool HasPendingBatches() const { return !m_PendingBatches.empty(); }
+
+		// Fence value of the oldest batch still in flight. Only valid if HasPendingBatches() returns true.
+		uint64_t GetOldestPendingFenceValue() const { return m_PendingBatches.front().m_FenceValue; }
+
+		size_t GetUsedSize() const { return m_UsedSize; }
+
+	private:
+		struct FencedBatch {
+			uint64_t m_FenceValue;
+			// Offset where the batch memory ends, it will become the new tail once the batch is retired
+			size_t m_EndOffset;
+			// Memory consumed by the batch, including the padding due to alignment and wrap-around
+			size_t m_Size;
+		};
+
+		std::deque<FencedBatch> m_PendingBatches;
+
+		size_t m_PoolSize;
+		// Offset where the next allocation will start
+		size_t m_HeadOffset = 0;
+		// Offset where the oldest memory still in use starts
+		size_t m_TailOffset = 0;
+
+		size_t m_UsedSize = 0;
+		// Memory allocated since the last CloseBatch call
+		size_t m_OpenBatchSize = 0;
+	};
+
 }
 
 #endif // RangeAllocators_h__
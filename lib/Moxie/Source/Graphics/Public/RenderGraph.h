@@ -0,0 +1,204 @@
+/*
+ RenderGraph.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef RenderGraph_h__
+#define RenderGraph_h__
+
+#include "CommandList.h"
+#include <functional>
+
+namespace Mox {
+
+	// Index of a resource declared in the render graph, valid until the graph is reset
+	using RgResourceHandle = uint32_t;
+
+	// Texture that only lives during the execution of the render graph, such as an intermediate render target
+	struct RgTextureDesc
+	{
+		uint32_t m_Width;
+		uint32_t m_Height;
+		Mox::BUFFER_FORMAT m_Format;
+		// Expected to allow render target or depth stencil usage
+		Mox::RESOURCE_FLAGS m_Flags;
+
+		bool operator==(const RgTextureDesc& InOther) const
+		{
+			return m_Width == InOther.m_Width && m_Height == InOther.m_Height && m_Format == InOther.m_Format && m_Flags == InOther.m_Flags;
+		}
+	};
+
+	// Resource accessed by a pass, together with the state the pass needs it in
+	struct RgResourceAccess
+	{
+		Mox::RgResourceHandle m_Resource;
+		Mox::RESOURCE_STATE m_State;
+	};
+
+	// Transition of a graph resource, computed when compiling the graph
+	struct RgTransition
+	{
+		Mox::RgResourceHandle m_Resource;
+		Mox::RESOURCE_STATE m_Before;
+		Mox::RESOURCE_STATE m_After;
+	};
+
+	/*
+	* Provides the memory of the transient textures of the render graph.
+	* Textures are placed at offsets of a single heap chosen by the graph, so that textures that are never used at the same time share memory.
+	*/
+	class TransientResourceAllocator
+	{
+	public:
+		virtual ~TransientResourceAllocator() = default;
+
+		virtual void GetTextureAllocationInfo(const Mox::RgTextureDesc& InDesc, uint64_t& OutSize, uint64_t& OutAlignment) = 0;
+
+		// Makes the heap at least of the given size. Textures placed in a heap that gets replaced are released.
+		virtual void ReserveMemory(uint64_t InSize) = 0;
+
+		// Returns the texture at the given heap offset, creating it in the given state if it did not exist.
+		// Textures are kept across frames, so that the same graph executed again does not create any resource.
+		virtual Mox::Resource& PlaceTexture(const Mox::RgTextureDesc& InDesc, uint64_t InHeapOffset, Mox::RESOURCE_STATE InInitialState) = 0;
+	};
+
+	/*
+	* Schedules the passes of a frame from the resources they declare to read and write.
+	* - Passes are ordered from their accesses: passes writing the same resource run in the order they were added,
+	*   and a pass reading a resource runs after all the passes writing it. Passes declared by different features
+	*   can then be added in any order, as long as the ones writing the same resource are added in the order they draw.
+	*   Among the passes free to run, the one added first runs first, so passes already added in execution order keep it.
+	* - Passes whose results are never used are culled.
+	* - Transitions needed before each pass are computed from the declared states and recorded in a single batch.
+	* - Transient textures are placed in a shared heap, where textures with disjoint lifetimes overlap.
+	*   Each one is discarded before its first pass, so its content is undefined until written.
+	* Compilation only queries texture sizes, so the schedule can be validated without a device.
+	* The graph is meant to be declared again every frame, after calling Reset().
+	*/
+	class RenderGraph
+	{
+	public:
+		using PassExecuteFunction = std::function<void(Mox::CommandList&)>;
+
+		// Clears the passes and resources of the previous frame, keeping the memory allocated for them
+		void Reset();
+
+		// Resource living outside the graph, such as the back buffer. It is expected in InInitialState when the graph starts executing,
+		// and it is left in InFinalState at the end. Passes writing imported resources are never culled.
+		Mox::RgResourceHandle ImportResource(const char* InName, Mox::Resource& InResource, Mox::RESOURCE_STATE InInitialState, Mox::RESOURCE_STATE InFinalState);
+
+		// Its content is undefined until the first pass writing it
+		Mox::RgResourceHandle CreateTexture(const char* InName, const Mox::RgTextureDesc& InDesc);
+
+		// Reads see the content left by all the passes writing the resource, a transient texture being read needs at least one of them.
+		// Passes with effects outside of the graph resources, such as readbacks, need to be flagged so that they are never culled.
+		void AddPass(const char* InName, std::vector<Mox::RgResourceAccess> InReads, std::vector<Mox::RgResourceAccess> InWrites,
+			PassExecuteFunction InExecute, bool InHasSideEffects = false);
+
+		// Orders and culls passes, computes transitions and places transient textures in memory
+		void Compile(Mox::TransientResourceAllocator& InAllocator);
+
+		// Places the transient textures, then records the transitions and the passes on the given command list.
+		// Transitions are requested to the command list, which records them from the states it tracks, so imported resources
+		// are not required to be in their declared initial state.
+		void Execute(Mox::CommandList& InCmdList, Mox::TransientResourceAllocator& InAllocator);
+
+		// Resource to be used by a pass during its execution
+		Mox::Resource& GetResource(Mox::RgResourceHandle InHandle) const;
+
+		// ----- Compilation results -----
+
+		// Indices of the passes, as they were added, in the order they are executed. Culled passes are included.
+		const std::vector<uint32_t>& GetExecutionOrder() const { return m_ExecutionOrder; }
+
+		bool IsPassCulled(uint32_t InPassIdx) const { return m_Passes[InPassIdx].m_IsCulled; }
+
+		// Transitions recorded before the given pass
+		const std::vector<Mox::RgTransition>& GetPassTransitions(uint32_t InPassIdx) const { return m_Passes[InPassIdx].m_Transitions; }
+
+		// Transitions bringing the imported resources to their final states
+		const std::vector<Mox::RgTransition>& GetFinalTransitions() const { return m_FinalTransitions; }
+
+		uint64_t GetTransientHeapOffset(Mox::RgResourceHandle InHandle) const { return m_Resources[InHandle].m_HeapOffset; }
+
+		uint64_t GetTransientMemorySize() const { return m_TransientMemorySize; }
+
+		// Memory the transient textures would take without aliasing
+		uint64_t GetTransientMemorySizeWithoutAliasing() const { return m_TransientMemorySizeWithoutAliasing; }
+
+	private:
+		struct RgResource
+		{
+			const char* m_Name;
+			bool m_IsImported;
+			Mox::Resource* m_Resource;
+			// For transient textures, the initial state is the one of their first access
+			Mox::RESOURCE_STATE m_InitialState;
+			Mox::RESOURCE_STATE m_FinalState;
+			// State after the last compiled access
+			Mox::RESOURCE_STATE m_CurrentState;
+			Mox::RgTextureDesc m_TextureDesc;
+
+			// Position in the execution order of the first and last pass accessing the resource. Unused resources have no lifetime.
+			uint32_t m_FirstPass;
+			uint32_t m_LastPass;
+			bool IsUsed() const { return m_FirstPass <= m_LastPass; }
+
+			uint64_t m_Size;
+			uint64_t m_Alignment;
+			uint64_t m_HeapOffset;
+		};
+
+		struct RgPass
+		{
+			const char* m_Name;
+			std::vector<Mox::RgResourceAccess> m_Reads;
+			std::vector<Mox::RgResourceAccess> m_Writes;
+			PassExecuteFunction m_Execute;
+			bool m_HasSideEffects;
+
+			// Passes that can only run after this one, and number of passes this one waits for
+			std::vector<uint32_t> m_FollowingPasses;
+			uint32_t m_PrecedingPassesNum;
+
+			bool m_IsCulled;
+			std::vector<Mox::RgTransition> m_Transitions;
+			// Transient textures used for the first time by the pass, whose memory could have been used by another texture until then
+			std::vector<Mox::RgResourceHandle> m_AcquiredTextures;
+		};
+
+		void SortPasses();
+
+		void CullPasses();
+
+		void ComputeTransitions();
+
+		void PlaceTransientTextures(Mox::TransientResourceAllocator& InAllocator);
+
+		std::vector<RgResource> m_Resources;
+
+		std::vector<RgPass> m_Passes;
+
+		std::vector<uint32_t> m_ExecutionOrder;
+
+		std::vector<Mox::RgTransition> m_FinalTransitions;
+
+		uint64_t m_TransientMemorySize = 0;
+		uint64_t m_TransientMemorySizeWithoutAliasing = 0;
+
+		// Scratch containers kept to avoid allocations every frame
+		std::vector<uint32_t> m_LastWritingPasses;
+		std::vector<uint32_t> m_ReadyPasses;
+		std::vector<bool> m_IsResourceNeeded;
+		std::vector<Mox::RgResourceHandle> m_PlacementOrder;
+		std::vector<Mox::RgResourceHandle> m_PlacedTextures;
+		std::vector<Mox::Resource*> m_AliasedResources;
+	};
+
+}
+
+#endif // RenderGraph_h__
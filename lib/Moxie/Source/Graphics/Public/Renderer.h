@@ -12,6 +12,8 @@
 #include "Async.h"
 #include "ContextView.h"
 #include "MoxRenderProxy.h"
+#include "UploadTracker.h"
+#include "RenderGraph.h"
 
 namespace Mox {
 
@@ -45,6 +47,9 @@ namespace Mox {
 
 		void RenderMainView();
 
+		// Rasterizes the occluders of the active proxies in the occlusion buffer of the view, if it has one
+		void RenderOccluders(Mox::ContextView& InView);
+
 		void RunThread();
 
 		void OnRenderFrameStarted();
@@ -55,6 +60,16 @@ namespace Mox {
 
 		void ProcessRenderUpdates();
 
+		// Makes render passes aware of the given proxies, so they can create the relative draw commands
+		void ActivateRenderProxies(const std::vector<Mox::RenderProxy*>& InProxies);
+
+		// Sets the new parameters on the drawables, then has the render passes generate again only the draw commands of those drawables
+		void UpdateDrawableParameters(const std::vector<Mox::DrawableParametersUpdate>& InUpdates);
+
+		// Removes the draw commands of the given proxies from all the render passes and releases them with their resources.
+		// Objects the Gpu can still be reading are only destroyed once the frame currently being rendered completes.
+		void ReleaseRenderProxies(const std::vector<std::shared_ptr<Mox::RenderProxy>>& InProxies);
+
 		// This is "camera" related data
 		// TODO move it on a proper object
 		std::vector<Mox::ContextView> m_ContextViews;
@@ -67,6 +82,18 @@ namespace Mox {
 
 		Mox::CommandQueue* m_CmdQueue;
 
+		// Queue executing content uploads, it can be the same as m_CmdQueue
+		Mox::CommandQueue* m_UploadQueue;
+
+		// Uploads in flight on a separate upload queue, with the work depending on them
+		Mox::UploadTracker m_UploadTracker;
+
+		// Transitions for resources whose upload completed, to be executed before the next draw commands
+		Mox::TransitionInfoVector m_ReadyUploadTransitions;
+
+		// Declared again every frame, it keeps the memory of its passes and resources across frames
+		Mox::RenderGraph m_RenderGraph;
+
 		uint64_t m_CurrentRenderFrame = 0;
 
 		uint64_t m_RenderFrameNumber = 0;
@@ -0,0 +1,66 @@
+/*
+ UploadTracker.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef UploadTracker_h__
+#define UploadTracker_h__
+
+#include <deque>
+#include <unordered_set>
+#include "CommandList.h"
+
+namespace Mox {
+
+	class RenderProxy;
+	class CommandQueue;
+	class FencedRingAllocator;
+
+	// Allocates a range of staging memory from the given ring allocator.
+	// If the ring is full, it waits on the upload queue for the oldest upload still in flight and tries again.
+	size_t AllocateStagingRange(Mox::FencedRingAllocator& InRingAllocator, Mox::CommandQueue& InUploadQueue, size_t InRangeSize, size_t InAlignment);
+
+	/*
+	* Keeps track of the content uploads submitted to the Gpu, each one identified by the fence value signaled after it.
+	* Work that depends on an upload (render proxies referencing the new resources and the transitions
+	* that bring uploaded resources to a readable state) is parked here until the relative fence value is reported as completed.
+	* The tracker never queries a command queue: completed fence values are passed in by the caller,
+	* so the same logic can be driven by any queue implementation.
+	*/
+	class UploadTracker
+	{
+	public:
+		// Records an upload that has been submitted with the given fence value,
+		// together with the transitions to execute once the upload completed.
+		void TrackUpload(uint64_t InFenceValue, Mox::TransitionInfoVector&& InPostUploadTransitions);
+
+		// Parks the given proxies behind the most recent tracked upload, if that is still pending.
+		// Returns false if nothing is pending, in which case the proxies can be used straight away.
+		bool DeferUntilUploadsComplete(const std::vector<Mox::RenderProxy*>& InProxies);
+
+		// Moves out the proxies and transitions of all the uploads completed up to the given fence value.
+		void CollectCompleted(uint64_t InCompletedFenceValue, std::vector<Mox::RenderProxy*>& OutReadyProxies, Mox::TransitionInfoVector& OutReadyTransitions);
+
+		// Stops tracking the given proxies, for when they get released before their uploads completed
+		void RemoveDependentProxies(const std::unordered_set<const Mox::RenderProxy*>& InProxies);
+
+		bool HasPendingUploads() const { return !m_PendingUploads.empty(); }
+
+	private:
+		struct PendingUpload
+		{
+			uint64_t m_FenceValue;
+			Mox::TransitionInfoVector m_PostUploadTransitions;
+			std::vector<Mox::RenderProxy*> m_DependentProxies;
+		};
+
+		// Ordered by increasing fence value
+		std::deque<PendingUpload> m_PendingUploads;
+	};
+
+}
+
+#endif // UploadTracker_h__
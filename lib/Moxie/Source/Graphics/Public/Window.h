@@ -52,10 +52,14 @@ namespace Mox {
 		virtual bool IsVSyncEnabled() const = 0;
 		virtual void SetVSyncEnabled(bool InNowEnabled) = 0;
 
+		// The current back buffer is expected to be in render target state already
 		virtual void ClearRtAndDs(Mox::CommandList& InCmdList) = 0;
 
 		virtual Mox::Resource& GetCurrentBackBuffer() = 0;
 
+		// Depth buffer matching the size of the back buffers, kept in depth write state outside of the render graph
+		virtual Mox::Resource& GetDepthStencilBuffer() = 0;
+
 		Mox::MulticastDelegate<> OnPaintDelegate;
 		Mox::MulticastDelegate<> OnCreateDelegate;
 		Mox::MulticastDelegate<> OnDestroyDelegate;
@@ -8,6 +8,7 @@
  
 #include "RangeAllocators.h"
 #include "MoxUtils.h"
+#include "MoxMath.h"
 
 namespace Mox { 
 
@@ -72,7 +73,7 @@ namespace Mox {
 		// 4) Both 1) and 2) cases do not happen.
 
 		// 1) The previous range finishes where the new free range starts.
-		if (prevFreeRangeIt != m_FreeRangesByOffset.end() && prevFreeRangeIt->first + InRangeSize == prevFreeRangeIt->second.m_Size) // Note: we are not checking for any validity on the input parameters
+		if (prevFreeRangeIt != m_FreeRangesByOffset.end() && prevFreeRangeIt->first + prevFreeRangeIt->second.m_Size == InRangeOffset) // Note: we are not checking for any validity on the input parameters
 		{
 			// Merging the previous free range with the current one: create a free range to contain both, and delete the previous free block
 			InRangeSize += prevFreeRangeIt->second.m_Size;
@@ -126,5 +127,74 @@ namespace Mox {
 		m_AllocationLimit = m_StartingOffset + std::trunc(m_PoolSize * InEndPercentage);
 	}
 
+	FencedRingAllocator::FencedRingAllocator(size_t InPoolSize)
+		: m_PoolSize(InPoolSize)
+	{
+
+	}
+
+	bool FencedRingAllocator::TryAllocateRange(size_t InRangeSize, size_t InAlignment, size_t& OutRangeOffset)
+	{
+		if (m_UsedSize == 0)
+		{
+			// Nothing in use, we can restart from the beginning to reduce wrap-around waste
+			m_HeadOffset = m_TailOffset = 0;
+		}
+
+		// If the head is behind the tail, free memory stops at the tail, otherwise it goes up to the end of the pool
+		const bool isHeadBehindTail = m_UsedSize > 0 && m_HeadOffset <= m_TailOffset;
+		const size_t freeRegionEnd = isHeadBehindTail ? m_TailOffset : m_PoolSize;
+
+		size_t candidateOffset = Mox::Align(m_HeadOffset, InAlignment);
+		size_t consumedSize = 0;
+
+		if (candidateOffset + InRangeSize <= freeRegionEnd)
+		{
+			consumedSize = candidateOffset + InRangeSize - m_HeadOffset;
+		}
+		else if (!isHeadBehindTail && InRangeSize <= m_TailOffset)
+		{
+			// Wrap around: the memory left at the end of the pool is consumed as padding
+			candidateOffset = 0;
+			consumedSize = m_PoolSize - m_HeadOffset + InRangeSize;
+		}
+		else
+		{
+			return false;
+		}
+
+		m_HeadOffset = candidateOffset + InRangeSize;
+		m_UsedSize += consumedSize;
+		m_OpenBatchSize += consumedSize;
+
+		OutRangeOffset = candidateOffset;
+
+		return true;
+	}
+
+	void FencedRingAllocator::CloseBatch(uint64_t InFenceValue)
+	{
+		if (m_OpenBatchSize == 0)
+		{
+			return;
+		}
+
+		Check(m_PendingBatches.empty() || m_PendingBatches.back().m_FenceValue <= InFenceValue)
+
+		m_PendingBatches.push_back(FencedBatch{ InFenceValue, m_HeadOffset, m_OpenBatchSize });
+
+		m_OpenBatchSize = 0;
+	}
+
+	void FencedRingAllocator::Retire(uint64_t InCompletedFenceValue)
+	{
+		while (!m_PendingBatches.empty() && m_PendingBatches.front().m_FenceValue <= InCompletedFenceValue)
+		{
+			m_TailOffset = m_PendingBatches.front().m_EndOffset;
+			m_UsedSize -= m_PendingBatches.front().m_Size;
+
+			m_PendingBatches.pop_front();
+		}
+	}
 
-}
\ No newline at end of file
+}
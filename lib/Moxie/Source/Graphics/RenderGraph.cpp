@@ -0,0 +1,412 @@
+/*
+ RenderGraph.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#include "RenderGraph.h"
+#include "MoxUtils.h"
+#include "MoxMath.h"
+
+namespace Mox {
+
+	// State a transient texture needs to be in to be discarded, depending on the usage it allows
+	static Mox::RESOURCE_STATE GetDiscardState(Mox::RESOURCE_FLAGS InFlags)
+	{
+		if (InFlags & Mox::RESOURCE_FLAGS::ALLOW_RENDER_TARGET)
+		{
+			return Mox::RESOURCE_STATE::RENDER_TARGET;
+		}
+
+		if (InFlags & Mox::RESOURCE_FLAGS::ALLOW_DEPTH_STENCIL)
+		{
+			return Mox::RESOURCE_STATE::DEPTH_WRITE;
+		}
+
+		Check(InFlags & Mox::RESOURCE_FLAGS::ALLOW_UNORDERED_ACCESS)
+		return Mox::RESOURCE_STATE::UNORDERED_ACCESS;
+	}
+
+	// Marks passes that are not followed by any other
+	static constexpr uint32_t NoPass = std::numeric_limits<uint32_t>::max();
+
+	void RenderGraph::Reset()
+	{
+		m_Resources.clear();
+		m_Passes.clear();
+		m_ExecutionOrder.clear();
+		m_FinalTransitions.clear();
+
+		m_TransientMemorySize = 0;
+		m_TransientMemorySizeWithoutAliasing = 0;
+	}
+
+	Mox::RgResourceHandle RenderGraph::ImportResource(const char* InName, Mox::Resource& InResource, Mox::RESOURCE_STATE InInitialState, Mox::RESOURCE_STATE InFinalState)
+	{
+		RgResource& newResource = m_Resources.emplace_back();
+		newResource.m_Name = InName;
+		newResource.m_IsImported = true;
+		newResource.m_Resource = &InResource;
+		newResource.m_InitialState = InInitialState;
+		newResource.m_FinalState = InFinalState;
+
+		return static_cast<Mox::RgResourceHandle>(m_Resources.size() - 1);
+	}
+
+	Mox::RgResourceHandle RenderGraph::CreateTexture(const char* InName, const Mox::RgTextureDesc& InDesc)
+	{
+		Check(InDesc.m_Flags & (Mox::RESOURCE_FLAGS::ALLOW_RENDER_TARGET | Mox::RESOURCE_FLAGS::ALLOW_DEPTH_STENCIL))
+
+		RgResource& newResource = m_Resources.emplace_back();
+		newResource.m_Name = InName;
+		newResource.m_IsImported = false;
+		newResource.m_Resource = nullptr;
+		newResource.m_TextureDesc = InDesc;
+		newResource.m_InitialState = Mox::RESOURCE_STATE::NEUTRAL;
+		newResource.m_FinalState = Mox::RESOURCE_STATE::NEUTRAL;
+
+		return static_cast<Mox::RgResourceHandle>(m_Resources.size() - 1);
+	}
+
+	void RenderGraph::AddPass(const char* InName, std::vector<Mox::RgResourceAccess> InReads, std::vector<Mox::RgResourceAccess> InWrites, PassExecuteFunction InExecute, bool InHasSideEffects /*= false*/)
+	{
+		for (const std::vector<Mox::RgResourceAccess>* accesses : { &InReads, &InWrites })
+		{
+			for (const Mox::RgResourceAccess& access : *accesses)
+			{
+				Check(access.m_Resource < m_Resources.size())
+			}
+		}
+
+		RgPass& newPass = m_Passes.emplace_back();
+		newPass.m_Name = InName;
+		newPass.m_Reads = std::move(InReads);
+		newPass.m_Writes = std::move(InWrites);
+		newPass.m_Execute = std::move(InExecute);
+		newPass.m_HasSideEffects = InHasSideEffects;
+	}
+
+	void RenderGraph::Compile(Mox::TransientResourceAllocator& InAllocator)
+	{
+		SortPasses();
+
+		CullPasses();
+
+		ComputeTransitions();
+
+		PlaceTransientTextures(InAllocator);
+	}
+
+	void RenderGraph::SortPasses()
+	{
+		for (RgPass& pass : m_Passes)
+		{
+			pass.m_FollowingPasses.clear();
+			pass.m_PrecedingPassesNum = 0;
+		}
+
+		const auto addDependency = [this](uint32_t InPrecedingPass, uint32_t InFollowingPass)
+		{
+			m_Passes[InPrecedingPass].m_FollowingPasses.push_back(InFollowingPass);
+			++m_Passes[InFollowingPass].m_PrecedingPassesNum;
+		};
+
+		// Passes writing the same resource form a chain in the order they were added
+		m_LastWritingPasses.assign(m_Resources.size(), NoPass);
+		for (uint32_t passIdx = 0; passIdx < m_Passes.size(); ++passIdx)
+		{
+			for (const Mox::RgResourceAccess& writeAccess : m_Passes[passIdx].m_Writes)
+			{
+				uint32_t& lastWritingPass = m_LastWritingPasses[writeAccess.m_Resource];
+				if (lastWritingPass != NoPass && lastWritingPass != passIdx)
+				{
+					addDependency(lastWritingPass, passIdx);
+				}
+				lastWritingPass = passIdx;
+			}
+		}
+
+		// Readers follow the end of the chain, which is after all the writers. Passes also writing the resource are already part of the chain.
+		for (uint32_t passIdx = 0; passIdx < m_Passes.size(); ++passIdx)
+		{
+			for (const Mox::RgResourceAccess& readAccess : m_Passes[passIdx].m_Reads)
+			{
+				const uint32_t lastWritingPass = m_LastWritingPasses[readAccess.m_Resource];
+
+				// Content of imported resources comes from outside the graph, the one of a transient texture nobody writes would be undefined
+				Check(lastWritingPass != NoPass || m_Resources[readAccess.m_Resource].m_IsImported)
+
+				const std::vector<Mox::RgResourceAccess>& passWrites = m_Passes[passIdx].m_Writes;
+				const bool isPassWritingResource = std::any_of(passWrites.begin(), passWrites.end(),
+					[&readAccess](const Mox::RgResourceAccess& InWriteAccess) { return InWriteAccess.m_Resource == readAccess.m_Resource; });
+
+				if (lastWritingPass != NoPass && !isPassWritingResource)
+				{
+					addDependency(lastWritingPass, passIdx);
+				}
+			}
+		}
+
+		// Passes without dependencies left are kept in a min heap, so that the first one added runs first
+		m_ExecutionOrder.clear();
+		m_ReadyPasses.clear();
+		for (uint32_t passIdx = 0; passIdx < m_Passes.size(); ++passIdx)
+		{
+			if (m_Passes[passIdx].m_PrecedingPassesNum == 0)
+			{
+				m_ReadyPasses.push_back(passIdx);
+			}
+		}
+		std::make_heap(m_ReadyPasses.begin(), m_ReadyPasses.end(), std::greater<uint32_t>());
+
+		while (!m_ReadyPasses.empty())
+		{
+			std::pop_heap(m_ReadyPasses.begin(), m_ReadyPasses.end(), std::greater<uint32_t>());
+			const uint32_t readyPass = m_ReadyPasses.back();
+			m_ReadyPasses.pop_back();
+
+			m_ExecutionOrder.push_back(readyPass);
+
+			for (uint32_t followingPass : m_Passes[readyPass].m_FollowingPasses)
+			{
+				if (--m_Passes[followingPass].m_PrecedingPassesNum == 0)
+				{
+					m_ReadyPasses.push_back(followingPass);
+					std::push_heap(m_ReadyPasses.begin(), m_ReadyPasses.end(), std::greater<uint32_t>());
+				}
+			}
+		}
+
+		// Passes left out wait for each other, e.g. each one reading what the other writes
+		Check(m_ExecutionOrder.size() == m_Passes.size())
+	}
+
+	void RenderGraph::CullPasses()
+	{
+		// Going from the last pass to the first, a pass is needed if something outside of the graph depends on it,
+		// or if it writes a resource read by a pass that is needed. All the passes writing a resource run before the ones reading it.
+		m_IsResourceNeeded.assign(m_Resources.size(), false);
+
+		for (auto passIdxIt = m_ExecutionOrder.rbegin(); passIdxIt != m_ExecutionOrder.rend(); ++passIdxIt)
+		{
+			RgPass& pass = m_Passes[*passIdxIt];
+			bool isPassNeeded = pass.m_HasSideEffects;
+			for (const Mox::RgResourceAccess& writeAccess : pass.m_Writes)
+			{
+				isPassNeeded = isPassNeeded || m_Resources[writeAccess.m_Resource].m_IsImported || m_IsResourceNeeded[writeAccess.m_Resource];
+			}
+
+			pass.m_IsCulled = !isPassNeeded;
+
+			if (isPassNeeded)
+			{
+				for (const Mox::RgResourceAccess& readAccess : pass.m_Reads)
+				{
+					m_IsResourceNeeded[readAccess.m_Resource] = true;
+				}
+			}
+		}
+	}
+
+	void RenderGraph::ComputeTransitions()
+	{
+		for (RgResource& resource : m_Resources)
+		{
+			resource.m_FirstPass = std::numeric_limits<uint32_t>::max();
+			resource.m_LastPass = 0;
+			resource.m_CurrentState = resource.m_InitialState;
+		}
+
+		for (uint32_t orderIdx = 0; orderIdx < m_ExecutionOrder.size(); ++orderIdx)
+		{
+			RgPass& pass = m_Passes[m_ExecutionOrder[orderIdx]];
+			pass.m_Transitions.clear();
+			pass.m_AcquiredTextures.clear();
+
+			if (pass.m_IsCulled)
+			{
+				continue;
+			}
+
+			for (const std::vector<Mox::RgResourceAccess>* accesses : { &pass.m_Reads, &pass.m_Writes })
+			{
+				for (const Mox::RgResourceAccess& access : *accesses)
+				{
+					RgResource& resource = m_Resources[access.m_Resource];
+
+					if (!resource.IsUsed())
+					{
+						resource.m_FirstPass = orderIdx;
+
+						// Transient textures are brought to the state of their first access when acquired, see Execute()
+						if (!resource.m_IsImported)
+						{
+							resource.m_InitialState = access.m_State;
+							resource.m_CurrentState = access.m_State;
+							pass.m_AcquiredTextures.push_back(access.m_Resource);
+						}
+					}
+
+					resource.m_LastPass = orderIdx;
+
+					if (resource.m_CurrentState != access.m_State)
+					{
+						// A pass cannot use the same resource in two different states
+						Check(std::none_of(pass.m_Transitions.begin(), pass.m_Transitions.end(),
+							[&access](const Mox::RgTransition& InTransition) { return InTransition.m_Resource == access.m_Resource; }))
+
+						pass.m_Transitions.push_back({ access.m_Resource, resource.m_CurrentState, access.m_State });
+						resource.m_CurrentState = access.m_State;
+					}
+				}
+			}
+		}
+
+		m_FinalTransitions.clear();
+		for (Mox::RgResourceHandle resourceHandle = 0; resourceHandle < m_Resources.size(); ++resourceHandle)
+		{
+			const RgResource& resource = m_Resources[resourceHandle];
+			if (!resource.IsUsed())
+			{
+				continue;
+			}
+
+			// Imported resources are left in the state expected after the graph, all in the same batch
+			if (resource.m_IsImported && resource.m_CurrentState != resource.m_FinalState)
+			{
+				m_FinalTransitions.push_back({ resourceHandle, resource.m_CurrentState, resource.m_FinalState });
+			}
+		}
+	}
+
+	void RenderGraph::PlaceTransientTextures(Mox::TransientResourceAllocator& InAllocator)
+	{
+		m_PlacementOrder.clear();
+		for (Mox::RgResourceHandle resourceHandle = 0; resourceHandle < m_Resources.size(); ++resourceHandle)
+		{
+			RgResource& resource = m_Resources[resourceHandle];
+			if (!resource.m_IsImported && resource.IsUsed())
+			{
+				InAllocator.GetTextureAllocationInfo(resource.m_TextureDesc, resource.m_Size, resource.m_Alignment);
+				m_PlacementOrder.push_back(resourceHandle);
+			}
+		}
+
+		// Placing the largest textures first leaves smaller holes for the others to fill
+		std::stable_sort(m_PlacementOrder.begin(), m_PlacementOrder.end(),
+			[this](Mox::RgResourceHandle InFirst, Mox::RgResourceHandle InSecond) { return m_Resources[InFirst].m_Size > m_Resources[InSecond].m_Size; });
+
+		m_PlacedTextures.clear();
+		m_TransientMemorySize = 0;
+		m_TransientMemorySizeWithoutAliasing = 0;
+
+		for (Mox::RgResourceHandle resourceHandle : m_PlacementOrder)
+		{
+			RgResource& resource = m_Resources[resourceHandle];
+
+			// Starting from the beginning of the heap, the offset is moved past any placed texture that is alive at the same time and overlaps in memory,
+			// until no such texture is left. The offset only increases, so this always ends.
+			uint64_t heapOffset = 0;
+			bool hasOffsetMoved = true;
+			while (hasOffsetMoved)
+			{
+				hasOffsetMoved = false;
+				for (Mox::RgResourceHandle placedHandle : m_PlacedTextures)
+				{
+					const RgResource& placedTexture = m_Resources[placedHandle];
+
+					const bool areLifetimesOverlapping = placedTexture.m_FirstPass <= resource.m_LastPass && resource.m_FirstPass <= placedTexture.m_LastPass;
+					const bool areRangesOverlapping = placedTexture.m_HeapOffset < heapOffset + resource.m_Size && heapOffset < placedTexture.m_HeapOffset + placedTexture.m_Size;
+
+					if (areLifetimesOverlapping && areRangesOverlapping)
+					{
+						heapOffset = Mox::Align(placedTexture.m_HeapOffset + placedTexture.m_Size, resource.m_Alignment);
+						hasOffsetMoved = true;
+					}
+				}
+			}
+
+			resource.m_HeapOffset = heapOffset;
+			m_PlacedTextures.push_back(resourceHandle);
+
+			m_TransientMemorySize = std::max(m_TransientMemorySize, heapOffset + resource.m_Size);
+			m_TransientMemorySizeWithoutAliasing = Mox::Align(m_TransientMemorySizeWithoutAliasing, resource.m_Alignment) + resource.m_Size;
+		}
+	}
+
+	void RenderGraph::Execute(Mox::CommandList& InCmdList, Mox::TransientResourceAllocator& InAllocator)
+	{
+		if (!m_PlacedTextures.empty())
+		{
+			InAllocator.ReserveMemory(m_TransientMemorySize);
+		}
+
+		for (Mox::RgResourceHandle placedHandle : m_PlacedTextures)
+		{
+			RgResource& placedTexture = m_Resources[placedHandle];
+
+			placedTexture.m_Resource = &InAllocator.PlaceTexture(placedTexture.m_TextureDesc, placedTexture.m_HeapOffset, placedTexture.m_InitialState);
+		}
+
+		for (uint32_t passIdx : m_ExecutionOrder)
+		{
+			RgPass& pass = m_Passes[passIdx];
+			if (pass.m_IsCulled)
+			{
+				continue;
+			}
+
+			m_AliasedResources.clear();
+			for (Mox::RgResourceHandle acquiredHandle : pass.m_AcquiredTextures)
+			{
+				m_AliasedResources.push_back(m_Resources[acquiredHandle].m_Resource);
+			}
+
+			if (!m_AliasedResources.empty())
+			{
+				InCmdList.AliasingBarriers(m_AliasedResources);
+
+				// After an aliasing barrier, the first operation on a placed render target or depth stencil needs to be a clear, a copy or a discard.
+				// Discarding all of them here leaves passes free to start with any access, their content being undefined anyway (see CreateTexture).
+				for (Mox::RgResourceHandle acquiredHandle : pass.m_AcquiredTextures)
+				{
+					InCmdList.TransitionResource(*m_Resources[acquiredHandle].m_Resource, GetDiscardState(m_Resources[acquiredHandle].m_TextureDesc.m_Flags));
+				}
+
+				InCmdList.DiscardResources(m_AliasedResources);
+			}
+
+			// The same texture can be returned for transient textures with the same desc and offset, in this frame or in the previous ones,
+			// so it is brought from the state it was last left in, as tracked by the command list, to the state of its first access
+			for (Mox::RgResourceHandle acquiredHandle : pass.m_AcquiredTextures)
+			{
+				InCmdList.TransitionResource(*m_Resources[acquiredHandle].m_Resource, m_Resources[acquiredHandle].m_InitialState);
+			}
+
+			// Recorded in a single batch before the first command of the pass
+			for (const Mox::RgTransition& transition : pass.m_Transitions)
+			{
+				InCmdList.TransitionResource(*m_Resources[transition.m_Resource].m_Resource, transition.m_After);
+			}
+
+			pass.m_Execute(InCmdList);
+		}
+
+		for (const Mox::RgTransition& transition : m_FinalTransitions)
+		{
+			InCmdList.TransitionResource(*m_Resources[transition.m_Resource].m_Resource, transition.m_After);
+		}
+
+		InCmdList.FlushResourceBarriers();
+	}
+
+	Mox::Resource& RenderGraph::GetResource(Mox::RgResourceHandle InHandle) const
+	{
+		Check(m_Resources[InHandle].m_Resource)
+
+		return *m_Resources[InHandle].m_Resource;
+	}
+
+}
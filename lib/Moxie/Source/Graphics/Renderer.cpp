@@ -15,6 +15,9 @@
 #include "CpuProfiling.h"
 #include "Features/Public/RenderPass.h"
 #include "MoxDrawable.h"
+#include "MoxRenderProxy.h"
+#include "RenderGraph.h"
+#include "MoxUtils.h"
 
 namespace Mox {
 
@@ -32,6 +35,11 @@ RenderThread::RenderThread()
 	// Create Command Queue
 	m_CmdQueue = &Mox::GraphicsAllocator::Get()->AllocateCommandQueue(m_GraphicsDevice, Mox::COMMAND_LIST_TYPE::COMMAND_LIST_TYPE_DIRECT);
 
+	// Content uploads can optionally go through a dedicated copy queue
+	m_UploadQueue = Mox::Constants::g_UseCopyQueueForUploads ?
+		&Mox::GraphicsAllocator::Get()->AllocateCommandQueue(m_GraphicsDevice, Mox::COMMAND_LIST_TYPE::COMMAND_LIST_TYPE_COPY) : m_CmdQueue;
+
+	Mox::GraphicsAllocator::Get()->SetUploadQueue(*m_UploadQueue);
 
 	Mox::CommandList& initContentCmdList = GetCmdQueue()->GetAvailableCommandList();
 
@@ -60,40 +68,89 @@ void RenderThread::RenderMainView()
 
 	Mox::CommandList& cmdList = m_CmdQueue->GetAvailableCommandList();
 
-	// Clear render target and depth stencil
-	m_MainWindow->ClearRtAndDs(cmdList);
 	ContextView& mainView = m_ContextViews.front();
 
-	// Set Viewport, Scissor Rect from the main view and back buffer from the window swapchain
+	// Bring resources uploaded on the upload queue to a readable state, transitions get recorded with the ones of the first pass
+	for (const auto& [uploadedResource, beforeState, afterState] : m_ReadyUploadTransitions)
 	{
-		cmdList.SetViewportAndScissorRect(*mainView.m_Viewport, *mainView.m_ScissorRect);
-
-		// TODO: for now, we are directly writing into a backbuffer from the swapchain, but in a real engine scenario,
-		// we would first have an initial render target beforehand where we write anything we want (e.g. multiple context views)
-		// and then copy the content to the swapchain's render target.
-		cmdList.SetRenderTargetFromWindow(*m_MainWindow);
+		cmdList.TransitionResource(*uploadedResource, afterState);
 	}
+	m_ReadyUploadTransitions.clear();
+
+	RenderOccluders(mainView);
+
+	// ----- Declare the frame passes -----
+	m_RenderGraph.Reset();
+
+	// TODO: for now, we are directly writing into a backbuffer from the swapchain, but in a real engine scenario,
+	// we would first have an initial render target beforehand where we write anything we want (e.g. multiple context views)
+	// and then copy the content to the swapchain's render target.
+	const Mox::RgViewTargets mainViewTargets{
+		m_RenderGraph.ImportResource("BackBuffer", backBuffer, RESOURCE_STATE::PRESENT, RESOURCE_STATE::PRESENT),
+		m_RenderGraph.ImportResource("DepthBuffer", m_MainWindow->GetDepthStencilBuffer(), RESOURCE_STATE::DEPTH_WRITE, RESOURCE_STATE::DEPTH_WRITE),
+		[this, &mainView](Mox::CommandList& InCmdList)
+		{
+			// Set Viewport, Scissor Rect from the main view and back buffer from the window swapchain
+			InCmdList.SetViewportAndScissorRect(*mainView.m_Viewport, *mainView.m_ScissorRect);
+
+			InCmdList.SetRenderTargetFromWindow(*m_MainWindow);
+		} };
+
+	// Added first, so that it runs before every other pass writing the targets
+	m_RenderGraph.AddPass("ClearMainView", {}, { {mainViewTargets.m_Color, RESOURCE_STATE::RENDER_TARGET}, {mainViewTargets.m_Depth, RESOURCE_STATE::DEPTH_WRITE} },
+		[this](Mox::CommandList& InCmdList)
+		{
+			// Clear render target and depth stencil
+			m_MainWindow->ClearRtAndDs(InCmdList);
+		});
 
-	// ----- Send Draw Commands -----
 	for (const std::unique_ptr<Mox::RenderPass>& pass : Mox::GetRenderPasses())
 	{
-		pass->SendDrawCommands(cmdList);
+		pass->AddToRenderGraph(m_RenderGraph, mainView, mainViewTargets);
 	}
 
+	// Transitions of the targets are recorded by the graph, around the passes writing them
+	Mox::TransientResourceAllocator& transientAllocator = Mox::GraphicsAllocator::Get()->GetTransientResourceAllocator();
+	m_RenderGraph.Compile(transientAllocator);
+	m_RenderGraph.Execute(cmdList, transientAllocator);
+
 	// Execute command list and present current render target from the main window
 	{
-		cmdList.ResourceBarriers(TransitionInfoVector{ 
-			{&backBuffer, RESOURCE_STATE::RENDER_TARGET, RESOURCE_STATE::PRESENT} 
-			});
-
 		// Mandatory for the command list to close before getting executed by the command queue
-		m_CmdQueue->ExecuteCmdList(cmdList);
+		const uint64_t frameFenceValue = m_CmdQueue->ExecuteCmdList(cmdList);
+
+		// Objects released up to now could have been referenced by any frame up to this one
+		Mox::GraphicsAllocator::Get()->OnFrameSubmitted(frameFenceValue);
 
 		m_MainWindow->Present();
 
 	}
 }
 
+void RenderThread::RenderOccluders(Mox::ContextView& InView)
+{
+	if (!InView.m_OcclusionBuffer)
+	{
+		return;
+	}
+
+	InView.m_OcclusionBuffer->BeginFrame(InView.m_ViewProjMatrix);
+
+	for (const Mox::RenderProxy* activeProxy : m_ActiveRenderProxies)
+	{
+		for (const Mox::Drawable* mesh : activeProxy->m_Meshes)
+		{
+			// Occluders outside the view cannot hide anything in it
+			if (mesh->m_Occluder && (!mesh->m_WorldBounds.IsValid() || InView.m_Frustum.Overlaps(mesh->m_WorldBounds)))
+			{
+				InView.m_OcclusionBuffer->AddOccluder(*mesh->m_Occluder, activeProxy->m_ModelMatrix);
+			}
+		}
+	}
+
+	InView.m_OcclusionBuffer->Rasterize();
+}
+
 void RenderThread::RunThread()
 {
 	while (true)
@@ -138,6 +195,9 @@ void RenderThread::OnRenderFrameStarted()
 	// Trigger all the begin CPU frame mechanics
 	m_CmdQueue->OnRenderFrameStarted();
 
+	// Destroy the released objects that the Gpu is done with
+	Mox::GraphicsAllocator::Get()->ReclaimReleasedObjects(m_CmdQueue->GetCompletedFenceValue());
+
 
 	// Update the live proxies with the given parameters
 	ProcessRenderUpdates();
@@ -161,6 +221,11 @@ void RenderThread::SetMainWindow(Mox::Window* InMainWindow)
 
 	m_ContextViews.emplace_back(0.1f, 100.f, 0.7853981634f, m_MainWindow->GetFrameWidth(), m_MainWindow->GetFrameHeight());
 
+	if (Mox::Constants::g_OcclusionBufferWidth > 0 && Mox::Constants::g_OcclusionBufferHeight > 0)
+	{
+		m_ContextViews.back().m_OcclusionBuffer = std::make_unique<Mox::OcclusionBuffer>(Mox::Constants::g_OcclusionBufferWidth, Mox::Constants::g_OcclusionBufferHeight);
+	}
+
 }
 
 void RenderThread::ImportIncomingRenderUpdates(Mox::FrameRenderUpdates& InOutRenderUpdates)
@@ -175,12 +240,34 @@ void RenderThread::OnFinishRunning()
 	// Finish all the render commands currently in flight
 	m_CmdQueue->Flush();
 
+	if (m_UploadQueue != m_CmdQueue)
+	{
+		m_UploadQueue->Flush();
+	}
+
+	{
+		const Mox::PipelineStateCache& pipelineStateCache = m_GraphicsAllocator->GetPipelineStateCache();
+		char buffer[200];
+		sprintf_s(buffer, 200, "Pipeline state cache: %llu hits, %llu misses (%llu loaded from disk)\n", 
+			pipelineStateCache.GetHitsNum(), pipelineStateCache.GetMissesNum(), pipelineStateCache.GetDiskHitsNum());
+		OutputDebugStringA(buffer);
+	}
+
 	// Release all the allocated graphics resources
 	m_GraphicsAllocator.reset();
 }
 
 void RenderThread::ProcessRenderUpdates()
 {
+	// Give back staging memory of the uploads that the Gpu completed,
+	// and collect the proxies that were waiting for them
+	const uint64_t completedUploadFenceValue = m_UploadQueue->GetCompletedFenceValue();
+
+	GraphicsAllocator::Get()->RetireUploads(completedUploadFenceValue);
+
+	std::vector<Mox::RenderProxy*> readyProxies;
+	m_UploadTracker.CollectCompleted(completedUploadFenceValue, readyProxies, m_ReadyUploadTransitions);
+
 	// Create buffer resources
 	for (const Mox::BufferResourceRequest& resourceRequest : m_RenderUpdatesToProcess.m_BufferResourceRequests)
 	{
@@ -200,16 +287,35 @@ void RenderThread::ProcessRenderUpdates()
 	// Create Drawables
 	GraphicsAllocator::Get()->CreateDrawables(m_RenderUpdatesToProcess.m_DrawableRequests);
 
-	// Handling new render proxies
-	for (Mox::RenderProxy* newProxy : newProxies)
+	// Create spawned entities render data, one batch at a time
+	for (const Mox::SpawnBatchRequest& spawnBatch : m_RenderUpdatesToProcess.m_SpawnBatchRequests)
+	{
+		std::vector<Mox::RenderProxy*> batchProxies = GraphicsAllocator::Get()->CreateSpawnBatch(spawnBatch);
+
+		newProxies.insert(newProxies.end(), batchProxies.begin(), batchProxies.end());
+	}
+
+	// Move the bounds of the drawables, after they have been created
+	std::vector<const Mox::Drawable*> movedDrawables;
+	for (const Mox::RenderProxyTransformUpdate& transformUpdate : m_RenderUpdatesToProcess.m_ProxyTransformUpdates)
+	{
+		transformUpdate.m_TargetProxy->SetModelMatrix(transformUpdate.m_ModelMatrix);
+
+		movedDrawables.insert(movedDrawables.end(), transformUpdate.m_TargetProxy->m_Meshes.begin(), transformUpdate.m_TargetProxy->m_Meshes.end());
+	}
+
+	// Passes only move the drawables they have commands for, the others enter the culling hierarchy of the passes with their new bounds on activation
+	if (!movedDrawables.empty())
 	{
-		// Make every pass aware of the new proxies to be able to create relative draw commands
 		for (const std::unique_ptr<Mox::RenderPass>& pass : Mox::GetRenderPasses())
 		{
-			pass->ProcessRenderProxy(*newProxy);
+			pass->UpdateDrawableBounds(movedDrawables);
 		}
+	}
 
-		m_ActiveRenderProxies.push_back(newProxy);
+	if (!m_RenderUpdatesToProcess.m_DrawableParametersUpdates.empty())
+	{
+		UpdateDrawableParameters(m_RenderUpdatesToProcess.m_DrawableParametersUpdates);
 	}
 
 	// Update constant buffer values
@@ -219,39 +325,203 @@ void RenderThread::ProcessRenderUpdates()
 
 	}
 
+	// Static constant buffers keep their content on the Cpu as well, for the passes writing it in per-instance data
+	for (BufferResourceUpdate& staticUpdate : m_RenderUpdatesToProcess.m_StaticBufferUpdates)
+	{
+		if (staticUpdate.m_BufResHolder->GetContentType() == Mox::RES_CONTENT_TYPE::CONSTANT)
+		{
+			staticUpdate.ApplyUpdate();
+		}
+	}
+
 	if (m_RenderUpdatesToProcess.m_StaticBufferUpdates.size() > 0 
 		|| m_RenderUpdatesToProcess.m_TextureUpdates.size() > 0
 		|| m_RenderUpdatesToProcess.m_TextureResourceRequests.size() > 0)
 	{
+		// Textures that were just created, and the ones receiving new content, need to end up in a read state
+		TransitionInfoVector texTransitions;
+		texTransitions.reserve(m_RenderUpdatesToProcess.m_TextureResourceRequests.size() + m_RenderUpdatesToProcess.m_TextureUpdates.size());
+		for (const Mox::TextureResourceRequest& texRequest : m_RenderUpdatesToProcess.m_TextureResourceRequests)
+		{
+			// This will be filled now but used later
+			texTransitions.emplace_back( &texRequest.m_TargetTexture->GetResource()->GetOwnerResource(), RESOURCE_STATE::COPY_DEST, RESOURCE_STATE::GEN_READ );
+		}
+		for (const Mox::TextureResourceUpdate& texUpdate : m_RenderUpdatesToProcess.m_TextureUpdates)
+		{
+			texTransitions.emplace_back(&texUpdate.m_TargetTexture->GetResource()->GetOwnerResource(), RESOURCE_STATE::COPY_DEST, RESOURCE_STATE::GEN_READ);
+		}
+
+		// A copy queue can only access resources in neutral or copy states. 
+		// Textures that draws are already reading need to be released on the direct queue first, and the upload has to wait for that.
+		bool updatesTexturesInUse = false;
+		if (m_UploadQueue != m_CmdQueue)
+		{
+			Mox::CommandList* releaseCmdList = nullptr;
+			for (const Mox::TextureResourceUpdate& texUpdate : m_RenderUpdatesToProcess.m_TextureUpdates)
+			{
+				Mox::Resource& texResource = texUpdate.m_TargetTexture->GetResource()->GetOwnerResource();
+				const bool isUniformState = texResource.HasUniformTrackedState();
+				if (isUniformState && texResource.GetTrackedState() == RESOURCE_STATE::COPY_DEST)
+				{
+					// Textures are created in copy state, no draw can be reading one that never received content
+					continue;
+				}
+
+				updatesTexturesInUse = true;
+
+				if (isUniformState && texResource.GetTrackedState() == RESOURCE_STATE::NEUTRAL)
+				{
+					continue;
+				}
+
+				if (!releaseCmdList)
+				{
+					releaseCmdList = &m_CmdQueue->GetAvailableCommandList();
+				}
+				releaseCmdList->TransitionResource(texResource, RESOURCE_STATE::NEUTRAL);
+			}
+
+			if (releaseCmdList)
+			{
+				m_UploadQueue->GpuWaitForQueue(*m_CmdQueue, m_CmdQueue->ExecuteCmdList(*releaseCmdList));
+			}
+		}
+
 		// Update static resources
-		Mox::CommandList& loadContentCmdList = GetCmdQueue()->GetAvailableCommandList();
+		Mox::CommandList& loadContentCmdList = m_UploadQueue->GetAvailableCommandList();
 
 		// Upload default views for textures that were just created this frame
-		TransitionInfoVector texTransitions;
-		texTransitions.reserve(m_RenderUpdatesToProcess.m_TextureResourceRequests.size());
 		for (const Mox::TextureResourceRequest& texRequest : m_RenderUpdatesToProcess.m_TextureResourceRequests)
 		{
 			loadContentCmdList.UploadViewToGPU(*texRequest.m_TargetTexture->GetResource()->GetView());
-			// This will be filled now but used later
-			texTransitions.emplace_back( &texRequest.m_TargetTexture->GetResource()->GetOwnerResource(), RESOURCE_STATE::COPY_DEST, RESOURCE_STATE::GEN_READ );
 		}
 		// Upload data for new static buffers
 		Mox::GraphicsAllocator::Get()->UpdateStaticBufferResources(loadContentCmdList, m_RenderUpdatesToProcess.m_StaticBufferUpdates);
 		
-		// Upload data for new textures
+		// Upload data for textures
 		Mox::GraphicsAllocator::Get()->UpdateTextureResources(loadContentCmdList, m_RenderUpdatesToProcess.m_TextureUpdates);
-		if (texTransitions.size() > 0)
+		if (m_UploadQueue == m_CmdQueue)
 		{
-			// Switch new textures back to a read state
-			loadContentCmdList.ResourceBarriers(texTransitions);
+			// Switch textures back to a read state
+			for (const auto& [texResource, beforeState, afterState] : texTransitions)
+			{
+				loadContentCmdList.TransitionResource(*texResource, afterState);
+			}
 		}
 
-		GetCmdQueue()->ExecuteCmdList(loadContentCmdList);
+		// No need to wait for the upload here: staging memory is retired by fence value in the next frames
+		const uint64_t uploadFenceValue = m_UploadQueue->ExecuteCmdList(loadContentCmdList);
+
+		GraphicsAllocator::Get()->OnUploadSubmitted(uploadFenceValue);
 
-		GetCmdQueue()->Flush();
+		if (m_UploadQueue != m_CmdQueue)
+		{
+			// Draws of the next frames keep reading the textures in use, so they cannot start before the new content is there
+			if (updatesTexturesInUse)
+			{
+				m_CmdQueue->GpuWaitForQueue(*m_UploadQueue, uploadFenceValue);
+			}
+
+			// Read state transitions cannot be executed on a copy queue, 
+			// they will be recorded on the direct queue once the upload completed
+			m_UploadTracker.TrackUpload(uploadFenceValue, std::move(texTransitions));
+		}
+	}
+
+	// On the direct queue, uploads are executed ahead of any draw that uses them, so new proxies can be used straight away.
+	// With a separate upload queue, they have to wait for the uploads in flight to complete.
+	if (m_UploadQueue == m_CmdQueue || !m_UploadTracker.DeferUntilUploadsComplete(newProxies))
+	{
+		readyProxies.insert(readyProxies.end(), newProxies.begin(), newProxies.end());
+	}
+
+	ActivateRenderProxies(readyProxies);
+
+	// Releases come last, so that anything requested and released in the same frame has been created already
+	ReleaseRenderProxies(m_RenderUpdatesToProcess.m_ProxyReleases);
+
+	if (!m_RenderUpdatesToProcess.m_BufferReleases.empty())
+	{
+		GraphicsAllocator::Get()->ReleaseBuffers(std::move(m_RenderUpdatesToProcess.m_BufferReleases));
 	}
 
 	m_RenderUpdatesToProcess = Mox::FrameRenderUpdates();
 }
 
+void RenderThread::ActivateRenderProxies(const std::vector<Mox::RenderProxy*>& InProxies)
+{
+	for (Mox::RenderProxy* newProxy : InProxies)
+	{
+		// Make every pass aware of the new proxies to be able to create relative draw commands
+		for (const std::unique_ptr<Mox::RenderPass>& pass : Mox::GetRenderPasses())
+		{
+			pass->ProcessRenderProxy(*newProxy);
+		}
+
+		m_ActiveRenderProxies.push_back(newProxy);
+	}
+}
+
+void RenderThread::UpdateDrawableParameters(const std::vector<Mox::DrawableParametersUpdate>& InUpdates)
+{
+	std::vector<const Mox::Drawable*> updatedDrawables;
+	updatedDrawables.reserve(InUpdates.size());
+
+	for (const Mox::DrawableParametersUpdate& drawableUpdate : InUpdates)
+	{
+		Check(drawableUpdate.m_DrawableIndex < drawableUpdate.m_TargetProxy->m_Meshes.size())
+		Mox::Drawable& drawable = *drawableUpdate.m_TargetProxy->m_Meshes[drawableUpdate.m_DrawableIndex];
+
+		for (const auto& [paramHash, buffer] : drawableUpdate.m_BufferShaderParameters)
+		{
+			drawable.SetCbShaderParamValue(paramHash, buffer);
+		}
+		for (const auto& [paramHash, texture] : drawableUpdate.m_TextureShaderParameters)
+		{
+			drawable.SetTexShaderParamValue(paramHash, texture);
+		}
+
+		updatedDrawables.push_back(&drawable);
+	}
+
+	// The same drawable can be updated more than once in a frame, its commands only need to be generated again once
+	std::sort(updatedDrawables.begin(), updatedDrawables.end());
+	updatedDrawables.erase(std::unique(updatedDrawables.begin(), updatedDrawables.end()), updatedDrawables.end());
+
+	// Drawables of proxies not active yet have no commands, they will be generated with the new parameters on activation
+	for (const std::unique_ptr<Mox::RenderPass>& pass : Mox::GetRenderPasses())
+	{
+		pass->UpdateDrawables(updatedDrawables);
+	}
+}
+
+void RenderThread::ReleaseRenderProxies(const std::vector<std::shared_ptr<Mox::RenderProxy>>& InProxies)
+{
+	if (InProxies.empty())
+	{
+		return;
+	}
+
+	std::unordered_set<const Mox::RenderProxy*> releasedProxies;
+	releasedProxies.reserve(InProxies.size());
+	for (const std::shared_ptr<Mox::RenderProxy>& proxy : InProxies)
+	{
+		releasedProxies.insert(proxy.get());
+	}
+
+	// Proxies still waiting for their uploads were never activated
+	m_UploadTracker.RemoveDependentProxies(releasedProxies);
+
+	for (const std::unique_ptr<Mox::RenderPass>& pass : Mox::GetRenderPasses())
+	{
+		pass->RemoveRenderProxies(releasedProxies);
+	}
+
+	m_ActiveRenderProxies.erase(std::remove_if(m_ActiveRenderProxies.begin(), m_ActiveRenderProxies.end(),
+		[&releasedProxies](const Mox::RenderProxy* InProxy) { return releasedProxies.find(InProxy) != releasedProxies.end(); }),
+		m_ActiveRenderProxies.end());
+
+	GraphicsAllocator::Get()->ReleaseRenderProxies(InProxies);
+}
+
 }
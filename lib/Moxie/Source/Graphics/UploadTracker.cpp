@@ -0,0 +1,85 @@
+/*
+ UploadTracker.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#include "UploadTracker.h"
+#include "MoxUtils.h"
+#include "CommandQueue.h"
+#include "RangeAllocators.h"
+
+namespace Mox {
+
+	size_t AllocateStagingRange(Mox::FencedRingAllocator& InRingAllocator, Mox::CommandQueue& InUploadQueue, size_t InRangeSize, size_t InAlignment)
+	{
+		size_t outRangeOffset = 0;
+
+		while (!InRingAllocator.TryAllocateRange(InRangeSize, InAlignment, outRangeOffset))
+		{
+			if (!InRingAllocator.HasPendingBatches())
+			{
+				// Memory is entirely taken by the uploads being recorded right now, waiting would not help
+				StopForFail("[AllocateStagingRange] Staging memory is not big enough for the uploads of a single frame.")
+				return 0;
+			}
+
+			// Only stall for the oldest upload in flight, instead of flushing the whole queue
+			InUploadQueue.WaitForFenceValue(InRingAllocator.GetOldestPendingFenceValue());
+
+			InRingAllocator.Retire(InUploadQueue.GetCompletedFenceValue());
+		}
+
+		return outRangeOffset;
+	}
+
+	void UploadTracker::TrackUpload(uint64_t InFenceValue, Mox::TransitionInfoVector&& InPostUploadTransitions)
+	{
+		Check(m_PendingUploads.empty() || m_PendingUploads.back().m_FenceValue <= InFenceValue)
+
+		m_PendingUploads.push_back(PendingUpload{ InFenceValue, std::move(InPostUploadTransitions), {} });
+	}
+
+	bool UploadTracker::DeferUntilUploadsComplete(const std::vector<Mox::RenderProxy*>& InProxies)
+	{
+		if (m_PendingUploads.empty())
+		{
+			return false;
+		}
+
+		// Fence values on the same queue are monotonic, so waiting for the most recent upload
+		// guarantees that every resource uploaded before is also ready.
+		std::vector<Mox::RenderProxy*>& dependentProxies = m_PendingUploads.back().m_DependentProxies;
+		dependentProxies.insert(dependentProxies.end(), InProxies.begin(), InProxies.end());
+
+		return true;
+	}
+
+	void UploadTracker::CollectCompleted(uint64_t InCompletedFenceValue, std::vector<Mox::RenderProxy*>& OutReadyProxies, Mox::TransitionInfoVector& OutReadyTransitions)
+	{
+		while (!m_PendingUploads.empty() && m_PendingUploads.front().m_FenceValue <= InCompletedFenceValue)
+		{
+			PendingUpload& completedUpload = m_PendingUploads.front();
+
+			OutReadyTransitions.insert(OutReadyTransitions.end(), completedUpload.m_PostUploadTransitions.begin(), completedUpload.m_PostUploadTransitions.end());
+			OutReadyProxies.insert(OutReadyProxies.end(), completedUpload.m_DependentProxies.begin(), completedUpload.m_DependentProxies.end());
+
+			m_PendingUploads.pop_front();
+		}
+	}
+
+	void UploadTracker::RemoveDependentProxies(const std::unordered_set<const Mox::RenderProxy*>& InProxies)
+	{
+		for (PendingUpload& pendingUpload : m_PendingUploads)
+		{
+			std::vector<Mox::RenderProxy*>& dependentProxies = pendingUpload.m_DependentProxies;
+
+			dependentProxies.erase(std::remove_if(dependentProxies.begin(), dependentProxies.end(),
+				[&InProxies](const Mox::RenderProxy* InProxy) { return InProxies.find(InProxy) != InProxies.end(); }), 
+				dependentProxies.end());
+		}
+	}
+
+}
@@ -0,0 +1,116 @@
+/*
+ MoxBoundingVolumes.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#include "MoxBoundingVolumes.h"
+#include <algorithm>
+
+namespace Mox {
+
+	Mox::Aabb Aabb::Transformed(const Mox::Matrix4f& InTransform) const
+	{
+		// From Jim Arvo "Transforming Axis-Aligned Bounding Boxes", Graphics Gems 1990:
+		// the center is transformed as a point, and the new extents are the extents projected on the absolute value of the linear part.
+		const Mox::Vector3f newCenter = InTransform.block<3, 3>(0, 0) * GetCenter() + InTransform.block<3, 1>(0, 3);
+		const Mox::Vector3f newExtents = InTransform.block<3, 3>(0, 0).cwiseAbs() * GetExtents();
+
+		return Mox::Aabb(newCenter - newExtents, newCenter + newExtents);
+	}
+
+	bool Ray::Intersects(const Mox::Aabb& InBox, float& OutDistance) const
+	{
+		float entryDistance = 0.f;
+		float exitDistance = m_MaxDistance;
+
+		for (int axisIdx = 0; axisIdx < 3; ++axisIdx)
+		{
+			// Note: With a zero direction component the inverse is infinite, 
+			// and the slab is either hit at any distance or never, depending on the origin
+			const float invDirection = 1.f / m_Direction[axisIdx];
+			float nearDistance = (InBox.m_Min[axisIdx] - m_Origin[axisIdx]) * invDirection;
+			float farDistance = (InBox.m_Max[axisIdx] - m_Origin[axisIdx]) * invDirection;
+
+			if (nearDistance > farDistance)
+			{
+				std::swap(nearDistance, farDistance);
+			}
+
+			// Written so that NaN values, from 0 * infinity, never shrink the interval
+			entryDistance = nearDistance > entryDistance ? nearDistance : entryDistance;
+			exitDistance = farDistance < exitDistance ? farDistance : exitDistance;
+
+			if (entryDistance > exitDistance)
+			{
+				return false;
+			}
+		}
+
+		OutDistance = entryDistance;
+		return true;
+	}
+
+	Mox::Frustum Frustum::FromViewProjection(const Mox::Matrix4f& InViewProj)
+	{
+		// Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix".
+		// A point p is inside when -w <= x <= w, -w <= y <= w and 0 <= z <= w, where (x,y,z,w) = M * p.
+		Mox::Frustum outFrustum;
+
+		const Mox::Vector4f row0 = InViewProj.row(0).transpose();
+		const Mox::Vector4f row1 = InViewProj.row(1).transpose();
+		const Mox::Vector4f row2 = InViewProj.row(2).transpose();
+		const Mox::Vector4f row3 = InViewProj.row(3).transpose();
+
+		outFrustum.m_Planes[PLANE_LEFT] = row3 + row0;
+		outFrustum.m_Planes[PLANE_RIGHT] = row3 - row0;
+		outFrustum.m_Planes[PLANE_BOTTOM] = row3 + row1;
+		outFrustum.m_Planes[PLANE_TOP] = row3 - row1;
+		outFrustum.m_Planes[PLANE_NEAR] = row2;
+		outFrustum.m_Planes[PLANE_FAR] = row3 - row2;
+
+		// Normalized planes give actual distances, which makes the box tests exact
+		for (Mox::Vector4f& plane : outFrustum.m_Planes)
+		{
+			plane /= plane.head<3>().norm();
+		}
+
+		return outFrustum;
+	}
+
+	Mox::FRUSTUM_TEST_RESULT Frustum::Test(const Mox::Aabb& InBox, uint32_t& InOutPlaneMask) const
+	{
+		const Mox::Vector3f center = InBox.GetCenter();
+		const Mox::Vector3f extents = InBox.GetExtents();
+
+		for (uint32_t planeIdx = 0; planeIdx < PLANES_NUM; ++planeIdx)
+		{
+			const uint32_t planeBit = 1u << planeIdx;
+			if ((InOutPlaneMask & planeBit) == 0)
+			{
+				continue;
+			}
+
+			const Mox::Vector4f& plane = m_Planes[planeIdx];
+
+			// Signed distance of the center and projected radius of the box on the plane normal
+			const float centerDistance = plane.head<3>().dot(center) + plane.w();
+			const float projectedRadius = plane.head<3>().cwiseAbs().dot(extents);
+
+			if (centerDistance + projectedRadius < 0.f)
+			{
+				return Mox::FRUSTUM_TEST_RESULT::OUTSIDE;
+			}
+
+			if (centerDistance - projectedRadius >= 0.f)
+			{
+				InOutPlaneMask &= ~planeBit;
+			}
+		}
+
+		return InOutPlaneMask == 0 ? Mox::FRUSTUM_TEST_RESULT::INSIDE : Mox::FRUSTUM_TEST_RESULT::INTERSECTING;
+	}
+
+}
@@ -0,0 +1,728 @@
+/*
+ MoxDynamicBvh.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#include "MoxDynamicBvh.h"
+#include "TaskSystem.h"
+#include "MoxUtils.h"
+#include <algorithm>
+
+namespace Mox {
+
+	// Bins used along the split axis to evaluate the surface area heuristic when building subtrees
+	constexpr uint32_t BuildBinsNum = 16;
+	// Under this number of leaves a rebuild runs on the calling thread only
+	constexpr size_t MinParallelSubtreeLeavesNum = 1024;
+	// Proxies created in bulk trigger a full rebuild when they are at least this fraction of the resulting tree
+	constexpr float BulkRebuildFraction = 0.25f;
+
+	DynamicBvh::DynamicBvh(float InFatMargin)
+		: m_FatMargin(InFatMargin)
+	{
+	}
+
+	Mox::BvhProxyId DynamicBvh::CreateProxy(const Mox::Aabb& InBounds, uint32_t InUserValue)
+	{
+		const uint32_t newLeaf = AllocateLeaf(InBounds, InUserValue);
+
+		InsertLeaf(newLeaf);
+
+		return newLeaf;
+	}
+
+	void DynamicBvh::CreateProxies(const Mox::Aabb* InBounds, const uint32_t* InUserValues, size_t InCount, Mox::BvhProxyId* OutProxies)
+	{
+		const bool shouldRebuild = InCount >= MinParallelSubtreeLeavesNum
+			&& InCount >= static_cast<size_t>((m_LeavesNum + InCount) * BulkRebuildFraction);
+
+		for (size_t proxyIdx = 0; proxyIdx < InCount; ++proxyIdx)
+		{
+			OutProxies[proxyIdx] = AllocateLeaf(InBounds[proxyIdx], InUserValues[proxyIdx]);
+
+			if (!shouldRebuild)
+			{
+				InsertLeaf(OutProxies[proxyIdx]);
+			}
+		}
+
+		// The rebuild collects every leaf, including the new ones that are not linked to the tree yet
+		if (shouldRebuild)
+		{
+			Rebuild();
+		}
+	}
+
+	void DynamicBvh::DestroyProxy(Mox::BvhProxyId InProxy)
+	{
+		Check(InProxy < m_Nodes.size() && m_Nodes[InProxy].m_Height == 0)
+
+		RemoveLeaf(InProxy);
+		FreeNode(InProxy);
+
+		m_LeavesNum--;
+	}
+
+	bool DynamicBvh::MoveProxy(Mox::BvhProxyId InProxy, const Mox::Aabb& InBounds)
+	{
+		Check(InProxy < m_Nodes.size() && m_Nodes[InProxy].m_Height == 0)
+
+		const Mox::Aabb previousBounds = m_Nodes[InProxy].m_Bounds;
+		if (previousBounds.Contains(InBounds))
+		{
+			return false;
+		}
+
+		const Mox::Aabb newBounds = InBounds.Inflated(m_FatMargin);
+
+		if (previousBounds.Overlaps(newBounds))
+		{
+			// Small movement: the leaf likely still belongs to the same region of the tree,
+			// so enlarging its ancestors is enough and cheaper than a reinsertion. Rotations keep the tree in shape.
+			m_Nodes[InProxy].m_Bounds = newBounds;
+			RefitAncestors(m_Nodes[InProxy].m_Parent);
+		}
+		else
+		{
+			RemoveLeaf(InProxy);
+			m_Nodes[InProxy].m_Bounds = newBounds;
+			InsertLeaf(InProxy);
+		}
+
+		return true;
+	}
+
+	void DynamicBvh::Rebuild()
+	{
+		// Leaves keep their node index, so proxy ids survive the rebuild, while internal nodes are all recreated
+		std::vector<uint32_t> leaves;
+		leaves.reserve(m_LeavesNum);
+
+		for (uint32_t nodeIdx = 0; nodeIdx < m_Nodes.size(); ++nodeIdx)
+		{
+			if (m_Nodes[nodeIdx].m_Height == 0)
+			{
+				leaves.push_back(nodeIdx);
+			}
+			else if (m_Nodes[nodeIdx].m_Height > 0)
+			{
+				FreeNode(nodeIdx);
+			}
+		}
+
+		Check(leaves.size() == m_LeavesNum)
+
+		m_Root = NullNode;
+
+		if (leaves.empty())
+		{
+			return;
+		}
+
+		// A tree with N leaves has exactly N-1 internal nodes, reserve them upfront so that no allocation happens while building
+		std::vector<uint32_t> internalNodes(leaves.size() - 1);
+		for (uint32_t& currentNode : internalNodes)
+		{
+			currentNode = AllocateNode();
+		}
+
+		// More subtrees than threads, so that threads finishing early can pick up the remaining ones
+		const size_t parallelSubtreesNum = std::max(std::thread::hardware_concurrency(), 1u) * 4;
+		const size_t maxPendingLeavesNum = std::max(leaves.size() / parallelSubtreesNum, MinParallelSubtreeLeavesNum);
+
+		if (leaves.size() <= maxPendingLeavesNum)
+		{
+			m_Root = BuildSubtree(leaves.data(), leaves.size(), internalNodes.data(), NullNode, 0, nullptr, nullptr);
+			return;
+		}
+
+		// The top of the tree is split on this thread, until ranges are small enough to be built independently
+		std::vector<PendingSubtree> pendingSubtrees;
+		std::vector<uint32_t> nodesToRefit;
+		m_Root = BuildSubtree(leaves.data(), leaves.size(), internalNodes.data(), NullNode, maxPendingLeavesNum, &pendingSubtrees, &nodesToRefit);
+
+		// Pending subtrees own disjoint ranges of leaves and internal nodes, so they can be built without synchronization
+		Mox::ParallelFor(pendingSubtrees.size(), [this, &pendingSubtrees](size_t InSubtreeIdx) {
+			const PendingSubtree& currentSubtree = pendingSubtrees[InSubtreeIdx];
+			BuildSubtree(currentSubtree.m_Leaves, currentSubtree.m_LeavesNum, currentSubtree.m_InternalNodes, currentSubtree.m_Parent, 0, nullptr, nullptr);
+		});
+
+		// Top nodes were recorded after their children, so refitting them in order sees the children already updated
+		for (uint32_t currentNode : nodesToRefit)
+		{
+			Refit(currentNode);
+		}
+	}
+
+	void DynamicBvh::QueryAabb(const Mox::Aabb& InBox, std::vector<uint32_t>& OutUserValues) const
+	{
+		if (m_Root == NullNode)
+		{
+			return;
+		}
+
+		std::vector<uint32_t> nodeStack;
+		nodeStack.reserve(64);
+		nodeStack.push_back(m_Root);
+
+		while (!nodeStack.empty())
+		{
+			const Node& currentNode = m_Nodes[nodeStack.back()];
+			nodeStack.pop_back();
+
+			if (!currentNode.m_Bounds.Overlaps(InBox))
+			{
+				continue;
+			}
+
+			if (currentNode.IsLeaf())
+			{
+				OutUserValues.push_back(currentNode.m_UserValue);
+			}
+			else
+			{
+				nodeStack.push_back(currentNode.m_Children[0]);
+				nodeStack.push_back(currentNode.m_Children[1]);
+			}
+		}
+	}
+
+	void DynamicBvh::QuerySphere(const Mox::BoundingSphere& InSphere, std::vector<uint32_t>& OutUserValues) const
+	{
+		if (m_Root == NullNode)
+		{
+			return;
+		}
+
+		std::vector<uint32_t> nodeStack;
+		nodeStack.reserve(64);
+		nodeStack.push_back(m_Root);
+
+		while (!nodeStack.empty())
+		{
+			const Node& currentNode = m_Nodes[nodeStack.back()];
+			nodeStack.pop_back();
+
+			if (!InSphere.Overlaps(currentNode.m_Bounds))
+			{
+				continue;
+			}
+
+			if (currentNode.IsLeaf())
+			{
+				OutUserValues.push_back(currentNode.m_UserValue);
+			}
+			else
+			{
+				nodeStack.push_back(currentNode.m_Children[0]);
+				nodeStack.push_back(currentNode.m_Children[1]);
+			}
+		}
+	}
+
+	void DynamicBvh::QueryFrustum(const Mox::Frustum& InFrustum, std::vector<uint32_t>& OutUserValues) const
+	{
+		if (m_Root == NullNode)
+		{
+			return;
+		}
+
+		// Each entry carries the planes that the node still needs to be tested against
+		std::vector<std::pair<uint32_t, uint32_t>> nodeStack;
+		nodeStack.reserve(64);
+		nodeStack.emplace_back(m_Root, Mox::Frustum::AllPlanesMask);
+
+		while (!nodeStack.empty())
+		{
+			const Node& currentNode = m_Nodes[nodeStack.back().first];
+			uint32_t planeMask = nodeStack.back().second;
+			nodeStack.pop_back();
+
+			// An empty mask means that an ancestor is fully inside the frustum
+			if (planeMask != 0 && InFrustum.Test(currentNode.m_Bounds, planeMask) == Mox::FRUSTUM_TEST_RESULT::OUTSIDE)
+			{
+				continue;
+			}
+
+			if (currentNode.IsLeaf())
+			{
+				OutUserValues.push_back(currentNode.m_UserValue);
+			}
+			else
+			{
+				nodeStack.emplace_back(currentNode.m_Children[0], planeMask);
+				nodeStack.emplace_back(currentNode.m_Children[1], planeMask);
+			}
+		}
+	}
+
+	void DynamicBvh::QueryRay(const Mox::Ray& InRay, std::vector<uint32_t>& OutUserValues) const
+	{
+		if (m_Root == NullNode)
+		{
+			return;
+		}
+
+		std::vector<uint32_t> nodeStack;
+		nodeStack.reserve(64);
+		nodeStack.push_back(m_Root);
+
+		float hitDistance;
+
+		while (!nodeStack.empty())
+		{
+			const Node& currentNode = m_Nodes[nodeStack.back()];
+			nodeStack.pop_back();
+
+			if (!InRay.Intersects(currentNode.m_Bounds, hitDistance))
+			{
+				continue;
+			}
+
+			if (currentNode.IsLeaf())
+			{
+				OutUserValues.push_back(currentNode.m_UserValue);
+			}
+			else
+			{
+				nodeStack.push_back(currentNode.m_Children[0]);
+				nodeStack.push_back(currentNode.m_Children[1]);
+			}
+		}
+	}
+
+	int32_t DynamicBvh::GetHeight() const
+	{
+		return m_Root == NullNode ? 0 : m_Nodes[m_Root].m_Height;
+	}
+
+	float DynamicBvh::ComputeAreaRatio() const
+	{
+		if (m_Root == NullNode)
+		{
+			return 0.f;
+		}
+
+		float internalAreaSum = 0.f;
+		for (const Node& currentNode : m_Nodes)
+		{
+			if (currentNode.m_Height > 0)
+			{
+				internalAreaSum += currentNode.m_Bounds.GetSurfaceArea();
+			}
+		}
+
+		const float rootArea = m_Nodes[m_Root].m_Bounds.GetSurfaceArea();
+
+		return rootArea > 0.f ? internalAreaSum / rootArea : 0.f;
+	}
+
+	void DynamicBvh::Validate() const
+	{
+		if (m_Root == NullNode)
+		{
+			Check(m_LeavesNum == 0)
+			return;
+		}
+
+		Check(m_Nodes[m_Root].m_Parent == NullNode)
+
+		size_t leavesFound = 0;
+		std::vector<uint32_t> nodeStack{ m_Root };
+
+		while (!nodeStack.empty())
+		{
+			const uint32_t nodeIdx = nodeStack.back();
+			nodeStack.pop_back();
+
+			const Node& currentNode = m_Nodes[nodeIdx];
+			if (currentNode.IsLeaf())
+			{
+				Check(currentNode.m_Height == 0)
+				leavesFound++;
+				continue;
+			}
+
+			const Node& firstChild = m_Nodes[currentNode.m_Children[0]];
+			const Node& secondChild = m_Nodes[currentNode.m_Children[1]];
+
+			Check(firstChild.m_Parent == nodeIdx && secondChild.m_Parent == nodeIdx)
+			Check(currentNode.m_Height == 1 + std::max(firstChild.m_Height, secondChild.m_Height))
+			Check(currentNode.m_Bounds.Contains(firstChild.m_Bounds) && currentNode.m_Bounds.Contains(secondChild.m_Bounds))
+
+			nodeStack.push_back(currentNode.m_Children[0]);
+			nodeStack.push_back(currentNode.m_Children[1]);
+		}
+
+		Check(leavesFound == m_LeavesNum)
+	}
+
+	uint32_t DynamicBvh::AllocateNode()
+	{
+		uint32_t newNode;
+		if (m_FreeList != NullNode)
+		{
+			newNode = m_FreeList;
+			m_FreeList = m_Nodes[newNode].m_Parent;
+		}
+		else
+		{
+			newNode = static_cast<uint32_t>(m_Nodes.size());
+			m_Nodes.emplace_back();
+		}
+
+		m_Nodes[newNode] = Node();
+
+		return newNode;
+	}
+
+	void DynamicBvh::FreeNode(uint32_t InNode)
+	{
+		m_Nodes[InNode].m_Height = -1;
+		m_Nodes[InNode].m_Parent = m_FreeList;
+		m_FreeList = InNode;
+	}
+
+	uint32_t DynamicBvh::AllocateLeaf(const Mox::Aabb& InBounds, uint32_t InUserValue)
+	{
+		Check(InBounds.IsValid())
+
+		const uint32_t newLeaf = AllocateNode();
+
+		Node& leafNode = m_Nodes[newLeaf];
+		leafNode.m_Bounds = InBounds.Inflated(m_FatMargin);
+		leafNode.m_UserValue = InUserValue;
+		leafNode.m_Height = 0;
+
+		m_LeavesNum++;
+
+		return newLeaf;
+	}
+
+	void DynamicBvh::InsertLeaf(uint32_t InLeaf)
+	{
+		if (m_Root == NullNode)
+		{
+			m_Root = InLeaf;
+			m_Nodes[InLeaf].m_Parent = NullNode;
+			return;
+		}
+
+		const uint32_t siblingNode = FindBestSibling(m_Nodes[InLeaf].m_Bounds);
+		const uint32_t oldParent = m_Nodes[siblingNode].m_Parent;
+
+		// Note: Allocating can grow the node array, so node references are only taken afterwards
+		const uint32_t newParent = AllocateNode();
+
+		Node& newParentNode = m_Nodes[newParent];
+		newParentNode.m_Parent = oldParent;
+		newParentNode.m_Children[0] = siblingNode;
+		newParentNode.m_Children[1] = InLeaf;
+		newParentNode.m_Bounds = Mox::Aabb::Union(m_Nodes[siblingNode].m_Bounds, m_Nodes[InLeaf].m_Bounds);
+		newParentNode.m_Height = m_Nodes[siblingNode].m_Height + 1;
+
+		m_Nodes[siblingNode].m_Parent = newParent;
+		m_Nodes[InLeaf].m_Parent = newParent;
+
+		if (oldParent == NullNode)
+		{
+			m_Root = newParent;
+		}
+		else
+		{
+			Node& oldParentNode = m_Nodes[oldParent];
+			oldParentNode.m_Children[oldParentNode.m_Children[0] == siblingNode ? 0 : 1] = newParent;
+		}
+
+		RefitAncestors(oldParent);
+	}
+
+	void DynamicBvh::RemoveLeaf(uint32_t InLeaf)
+	{
+		if (InLeaf == m_Root)
+		{
+			m_Root = NullNode;
+			return;
+		}
+
+		const uint32_t parentNode = m_Nodes[InLeaf].m_Parent;
+		const uint32_t grandParentNode = m_Nodes[parentNode].m_Parent;
+		const uint32_t siblingNode = m_Nodes[parentNode].m_Children[0] == InLeaf ? m_Nodes[parentNode].m_Children[1] : m_Nodes[parentNode].m_Children[0];
+
+		// The sibling takes the place of the parent
+		m_Nodes[siblingNode].m_Parent = grandParentNode;
+		FreeNode(parentNode);
+
+		if (grandParentNode == NullNode)
+		{
+			m_Root = siblingNode;
+		}
+		else
+		{
+			Node& grandParent = m_Nodes[grandParentNode];
+			grandParent.m_Children[grandParent.m_Children[0] == parentNode ? 0 : 1] = siblingNode;
+
+			RefitAncestors(grandParentNode);
+		}
+	}
+
+	uint32_t DynamicBvh::FindBestSibling(const Mox::Aabb& InBounds)
+	{
+		// Branch and bound from Erin Catto, "Dynamic Bounding Volume Hierarchies", GDC 2019.
+		// The cost of choosing a node as sibling is the area of the new parent, plus the area that all its ancestors grow by.
+		// That growth is inherited by the children, so a subtree can be skipped once even its best possible child costs more than the best found.
+		const float leafArea = InBounds.GetSurfaceArea();
+
+		uint32_t bestSibling = m_Root;
+		float bestCost = Mox::Aabb::Union(InBounds, m_Nodes[m_Root].m_Bounds).GetSurfaceArea();
+
+		m_SearchStack.clear();
+		m_SearchStack.emplace_back(m_Root, 0.f);
+
+		while (!m_SearchStack.empty())
+		{
+			const uint32_t nodeIdx = m_SearchStack.back().first;
+			const float inheritedCost = m_SearchStack.back().second;
+			m_SearchStack.pop_back();
+
+			const Node& currentNode = m_Nodes[nodeIdx];
+			const float directCost = Mox::Aabb::Union(InBounds, currentNode.m_Bounds).GetSurfaceArea();
+			const float totalCost = directCost + inheritedCost;
+
+			if (totalCost < bestCost)
+			{
+				bestCost = totalCost;
+				bestSibling = nodeIdx;
+			}
+
+			if (currentNode.IsLeaf())
+			{
+				continue;
+			}
+
+			const float childrenInheritedCost = inheritedCost + directCost - currentNode.m_Bounds.GetSurfaceArea();
+			if (leafArea + childrenInheritedCost < bestCost)
+			{
+				m_SearchStack.emplace_back(currentNode.m_Children[0], childrenInheritedCost);
+				m_SearchStack.emplace_back(currentNode.m_Children[1], childrenInheritedCost);
+			}
+		}
+
+		return bestSibling;
+	}
+
+	void DynamicBvh::RefitAncestors(uint32_t InNode)
+	{
+		uint32_t currentNode = InNode;
+		while (currentNode != NullNode)
+		{
+			Refit(currentNode);
+			TryRotate(currentNode);
+
+			currentNode = m_Nodes[currentNode].m_Parent;
+		}
+	}
+
+	void DynamicBvh::Refit(uint32_t InNode)
+	{
+		Node& targetNode = m_Nodes[InNode];
+		const Node& firstChild = m_Nodes[targetNode.m_Children[0]];
+		const Node& secondChild = m_Nodes[targetNode.m_Children[1]];
+
+		targetNode.m_Bounds = Mox::Aabb::Union(firstChild.m_Bounds, secondChild.m_Bounds);
+		targetNode.m_Height = 1 + std::max(firstChild.m_Height, secondChild.m_Height);
+	}
+
+	void DynamicBvh::TryRotate(uint32_t InNode)
+	{
+		// Candidate rotations swap a child of this node with a grandchild under the other child.
+		// The bounds of this node do not change, only the ones of the child that receives the swapped node,
+		// so the best rotation is the one that shrinks that child the most.
+		float bestAreaReduction = 0.f;
+		uint32_t bestChildSlot = 0;
+		uint32_t bestGrandChildSlot = 0;
+
+		const Node& targetNode = m_Nodes[InNode];
+
+		for (uint32_t childSlot = 0; childSlot < 2; ++childSlot)
+		{
+			const uint32_t swappedChild = targetNode.m_Children[childSlot];
+			const Node& otherChild = m_Nodes[targetNode.m_Children[1 - childSlot]];
+
+			if (otherChild.IsLeaf())
+			{
+				continue;
+			}
+
+			const float otherChildArea = otherChild.m_Bounds.GetSurfaceArea();
+
+			for (uint32_t grandChildSlot = 0; grandChildSlot < 2; ++grandChildSlot)
+			{
+				// The other child would then contain the swapped child and the grandchild that is not moved
+				const Node& keptGrandChild = m_Nodes[otherChild.m_Children[1 - grandChildSlot]];
+				const float newArea = Mox::Aabb::Union(m_Nodes[swappedChild].m_Bounds, keptGrandChild.m_Bounds).GetSurfaceArea();
+
+				if (otherChildArea - newArea > bestAreaReduction)
+				{
+					bestAreaReduction = otherChildArea - newArea;
+					bestChildSlot = childSlot;
+					bestGrandChildSlot = grandChildSlot;
+				}
+			}
+		}
+
+		if (bestAreaReduction <= 0.f)
+		{
+			return;
+		}
+
+		const uint32_t swappedChild = targetNode.m_Children[bestChildSlot];
+		const uint32_t otherChild = targetNode.m_Children[1 - bestChildSlot];
+		const uint32_t swappedGrandChild = m_Nodes[otherChild].m_Children[bestGrandChildSlot];
+
+		m_Nodes[InNode].m_Children[bestChildSlot] = swappedGrandChild;
+		m_Nodes[swappedGrandChild].m_Parent = InNode;
+
+		m_Nodes[otherChild].m_Children[bestGrandChildSlot] = swappedChild;
+		m_Nodes[swappedChild].m_Parent = otherChild;
+
+		Refit(otherChild);
+		Refit(InNode);
+	}
+
+	uint32_t DynamicBvh::BuildSubtree(uint32_t* InOutLeaves, size_t InLeavesNum, const uint32_t* InInternalNodes, uint32_t InParent,
+		size_t InMaxPendingLeavesNum, std::vector<PendingSubtree>* OutPendingSubtrees, std::vector<uint32_t>* OutNodesToRefit)
+	{
+		if (InLeavesNum == 1)
+		{
+			m_Nodes[InOutLeaves[0]].m_Parent = InParent;
+			return InOutLeaves[0];
+		}
+
+		// The root of a subtree is always its first internal node, so the parent can be linked before the subtree gets built
+		const uint32_t subtreeRoot = InInternalNodes[0];
+
+		if (OutPendingSubtrees && InLeavesNum <= InMaxPendingLeavesNum)
+		{
+			OutPendingSubtrees->push_back(PendingSubtree{ InOutLeaves, InLeavesNum, InInternalNodes, InParent });
+			return subtreeRoot;
+		}
+
+		const size_t firstLeavesNum = SplitLeaves(InOutLeaves, InLeavesNum);
+
+		// The first subtree uses firstLeavesNum-1 internal nodes and the second one uses the remaining ones
+		const uint32_t firstChild = BuildSubtree(InOutLeaves, firstLeavesNum, InInternalNodes + 1, subtreeRoot,
+			InMaxPendingLeavesNum, OutPendingSubtrees, OutNodesToRefit);
+		const uint32_t secondChild = BuildSubtree(InOutLeaves + firstLeavesNum, InLeavesNum - firstLeavesNum, InInternalNodes + firstLeavesNum, subtreeRoot,
+			InMaxPendingLeavesNum, OutPendingSubtrees, OutNodesToRefit);
+
+		Node& rootNode = m_Nodes[subtreeRoot];
+		rootNode.m_Parent = InParent;
+		rootNode.m_Children[0] = firstChild;
+		rootNode.m_Children[1] = secondChild;
+		rootNode.m_Height = 1;
+
+		// Children might still be pending, in which case bounds are computed after they are built
+		if (OutNodesToRefit)
+		{
+			OutNodesToRefit->push_back(subtreeRoot);
+		}
+		else
+		{
+			Refit(subtreeRoot);
+		}
+
+		return subtreeRoot;
+	}
+
+	size_t DynamicBvh::SplitLeaves(uint32_t* InOutLeaves, size_t InLeavesNum) const
+	{
+		Mox::Aabb centroidBounds;
+		for (size_t leafIdx = 0; leafIdx < InLeavesNum; ++leafIdx)
+		{
+			centroidBounds.Expand(m_Nodes[InOutLeaves[leafIdx]].m_Bounds.GetCenter());
+		}
+
+		// Split along the axis where centroids are the most spread
+		const Mox::Vector3f centroidSpan = centroidBounds.m_Max - centroidBounds.m_Min;
+		int splitAxis;
+		const float axisSpan = centroidSpan.maxCoeff(&splitAxis);
+
+		auto splitAtMedian = [this, InOutLeaves, InLeavesNum, splitAxis]() {
+			const size_t halfLeavesNum = InLeavesNum / 2;
+			std::nth_element(InOutLeaves, InOutLeaves + halfLeavesNum, InOutLeaves + InLeavesNum, [this, splitAxis](uint32_t InFirst, uint32_t InSecond) {
+				return m_Nodes[InFirst].m_Bounds.GetCenter()[splitAxis] < m_Nodes[InSecond].m_Bounds.GetCenter()[splitAxis];
+			});
+			return halfLeavesNum;
+		};
+
+		// Coincident centroids cannot be told apart by position
+		if (axisSpan <= std::numeric_limits<float>::epsilon())
+		{
+			return splitAtMedian();
+		}
+
+		const float binScale = BuildBinsNum / axisSpan;
+		auto computeBin = [this, &centroidBounds, binScale, splitAxis](uint32_t InLeaf) {
+			const float centroidOffset = m_Nodes[InLeaf].m_Bounds.GetCenter()[splitAxis] - centroidBounds.m_Min[splitAxis];
+			return std::min(static_cast<uint32_t>(centroidOffset * binScale), BuildBinsNum - 1);
+		};
+
+		std::array<Mox::Aabb, BuildBinsNum> binBounds;
+		std::array<size_t, BuildBinsNum> binLeavesNum = {};
+
+		for (size_t leafIdx = 0; leafIdx < InLeavesNum; ++leafIdx)
+		{
+			const uint32_t binIdx = computeBin(InOutLeaves[leafIdx]);
+			binBounds[binIdx].Expand(m_Nodes[InOutLeaves[leafIdx]].m_Bounds);
+			binLeavesNum[binIdx]++;
+		}
+
+		// Cost of splitting after each bin is the area of each side times its number of leaves.
+		// Areas of the right side are accumulated first, then the left side is swept while evaluating the cost.
+		std::array<float, BuildBinsNum - 1> rightSideCosts;
+		Mox::Aabb sideBounds;
+		size_t sideLeavesNum = 0;
+		for (uint32_t binIdx = BuildBinsNum - 1; binIdx > 0; --binIdx)
+		{
+			sideBounds.Expand(binBounds[binIdx]);
+			sideLeavesNum += binLeavesNum[binIdx];
+			rightSideCosts[binIdx - 1] = sideLeavesNum > 0 ? sideBounds.GetSurfaceArea() * sideLeavesNum : 0.f;
+		}
+
+		float bestCost = std::numeric_limits<float>::max();
+		uint32_t bestSplitBin = 0;
+		sideBounds = Mox::Aabb();
+		sideLeavesNum = 0;
+		for (uint32_t binIdx = 0; binIdx < BuildBinsNum - 1; ++binIdx)
+		{
+			sideBounds.Expand(binBounds[binIdx]);
+			sideLeavesNum += binLeavesNum[binIdx];
+
+			const float splitCost = (sideLeavesNum > 0 ? sideBounds.GetSurfaceArea() * sideLeavesNum : 0.f) + rightSideCosts[binIdx];
+			if (splitCost < bestCost)
+			{
+				bestCost = splitCost;
+				bestSplitBin = binIdx;
+			}
+		}
+
+		uint32_t* secondSideBegin = std::partition(InOutLeaves, InOutLeaves + InLeavesNum, [&computeBin, bestSplitBin](uint32_t InLeaf) {
+			return computeBin(InLeaf) <= bestSplitBin;
+		});
+
+		const size_t firstLeavesNum = static_cast<size_t>(secondSideBegin - InOutLeaves);
+
+		// Every leaf fell on the same side, which can happen with very uneven distributions
+		if (firstLeavesNum == 0 || firstLeavesNum == InLeavesNum)
+		{
+			return splitAtMedian();
+		}
+
+		return firstLeavesNum;
+	}
+
+}
@@ -0,0 +1,283 @@
+/*
+ MoxFrustumCulling.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#include "MoxFrustumCulling.h"
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define MOX_FRUSTUM_CULLING_SSE 1
+#include <immintrin.h>
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define MOX_FRUSTUM_CULLING_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace Mox {
+
+	void AabbSoA::Clear()
+	{
+		for (std::vector<float>* coordinates : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_ExtentX, &m_ExtentY, &m_ExtentZ })
+		{
+			coordinates->clear();
+		}
+	}
+
+	void AabbSoA::Reserve(size_t InCapacity)
+	{
+		for (std::vector<float>* coordinates : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_ExtentX, &m_ExtentY, &m_ExtentZ })
+		{
+			coordinates->reserve(InCapacity);
+		}
+	}
+
+	void AabbSoA::PushBack(const Mox::Aabb& InBox)
+	{
+		// Note: Max float is used instead of infinity, which would give NaN when multiplied by a zero normal component
+		const bool isValid = InBox.IsValid();
+		const Mox::Vector3f center = isValid ? InBox.GetCenter() : Mox::Vector3f::Zero();
+		const Mox::Vector3f extents = isValid ? InBox.GetExtents() : Mox::Vector3f::Constant(std::numeric_limits<float>::max());
+
+		m_CenterX.push_back(center.x());
+		m_CenterY.push_back(center.y());
+		m_CenterZ.push_back(center.z());
+		m_ExtentX.push_back(extents.x());
+		m_ExtentY.push_back(extents.y());
+		m_ExtentZ.push_back(extents.z());
+	}
+
+	namespace
+	{
+		// A box is outside when it is fully behind any plane, that is when the signed distance of its center
+		// plus the box extents projected on the plane normal is negative.
+		// Same test as Frustum::Test, without classifying the intersecting boxes.
+
+		void CullBoxesScalar(const Mox::Frustum& InFrustum, const Mox::AabbSoA& InBoxes, size_t InFirstBox, std::vector<uint32_t>& OutVisibleIndices)
+		{
+			for (size_t boxIdx = InFirstBox; boxIdx < InBoxes.Size(); ++boxIdx)
+			{
+				bool isVisible = true;
+				for (const Mox::Vector4f& plane : InFrustum.m_Planes)
+				{
+					const float centerDistance = plane.x() * InBoxes.m_CenterX[boxIdx] + plane.y() * InBoxes.m_CenterY[boxIdx] + plane.z() * InBoxes.m_CenterZ[boxIdx] + plane.w();
+					const float projectedRadius = std::abs(plane.x()) * InBoxes.m_ExtentX[boxIdx] + std::abs(plane.y()) * InBoxes.m_ExtentY[boxIdx] + std::abs(plane.z()) * InBoxes.m_ExtentZ[boxIdx];
+
+					if (centerDistance + projectedRadius < 0.f)
+					{
+						isVisible = false;
+						break;
+					}
+				}
+
+				if (isVisible)
+				{
+					OutVisibleIndices.push_back(static_cast<uint32_t>(boxIdx));
+				}
+			}
+		}
+
+#if MOX_FRUSTUM_CULLING_SSE
+
+		void CullBoxesSse(const Mox::Frustum& InFrustum, const Mox::AabbSoA& InBoxes, std::vector<uint32_t>& OutVisibleIndices)
+		{
+			// Plane components broadcast to all the lanes once, they are reused for every group of boxes
+			__m128 planeComponents[Mox::Frustum::PLANES_NUM][7];
+			for (uint32_t planeIdx = 0; planeIdx < Mox::Frustum::PLANES_NUM; ++planeIdx)
+			{
+				const Mox::Vector4f& plane = InFrustum.m_Planes[planeIdx];
+				planeComponents[planeIdx][0] = _mm_set1_ps(plane.x());
+				planeComponents[planeIdx][1] = _mm_set1_ps(plane.y());
+				planeComponents[planeIdx][2] = _mm_set1_ps(plane.z());
+				planeComponents[planeIdx][3] = _mm_set1_ps(plane.w());
+				planeComponents[planeIdx][4] = _mm_set1_ps(std::abs(plane.x()));
+				planeComponents[planeIdx][5] = _mm_set1_ps(std::abs(plane.y()));
+				planeComponents[planeIdx][6] = _mm_set1_ps(std::abs(plane.z()));
+			}
+
+			const __m128 zero = _mm_setzero_ps();
+			const size_t groupedBoxesNum = InBoxes.Size() & ~size_t(3);
+
+			for (size_t boxIdx = 0; boxIdx < groupedBoxesNum; boxIdx += 4)
+			{
+				const __m128 centerX = _mm_loadu_ps(InBoxes.m_CenterX.data() + boxIdx);
+				const __m128 centerY = _mm_loadu_ps(InBoxes.m_CenterY.data() + boxIdx);
+				const __m128 centerZ = _mm_loadu_ps(InBoxes.m_CenterZ.data() + boxIdx);
+				const __m128 extentX = _mm_loadu_ps(InBoxes.m_ExtentX.data() + boxIdx);
+				const __m128 extentY = _mm_loadu_ps(InBoxes.m_ExtentY.data() + boxIdx);
+				const __m128 extentZ = _mm_loadu_ps(InBoxes.m_ExtentZ.data() + boxIdx);
+
+				__m128 visibleLanes = _mm_cmpeq_ps(zero, zero);
+				for (const __m128* plane : planeComponents)
+				{
+					__m128 distance = _mm_add_ps(_mm_mul_ps(centerX, plane[0]), plane[3]);
+					distance = _mm_add_ps(distance, _mm_mul_ps(centerY, plane[1]));
+					distance = _mm_add_ps(distance, _mm_mul_ps(centerZ, plane[2]));
+					distance = _mm_add_ps(distance, _mm_mul_ps(extentX, plane[4]));
+					distance = _mm_add_ps(distance, _mm_mul_ps(extentY, plane[5]));
+					distance = _mm_add_ps(distance, _mm_mul_ps(extentZ, plane[6]));
+
+					visibleLanes = _mm_and_ps(visibleLanes, _mm_cmpge_ps(distance, zero));
+				}
+
+				// One bit per box. Groups fully outside, the common case when most of the scene is off-screen, are skipped right away.
+				const int visibleMask = _mm_movemask_ps(visibleLanes);
+				if (visibleMask == 0)
+				{
+					continue;
+				}
+
+				for (int laneIdx = 0; laneIdx < 4; ++laneIdx)
+				{
+					if (visibleMask & (1 << laneIdx))
+					{
+						OutVisibleIndices.push_back(static_cast<uint32_t>(boxIdx + laneIdx));
+					}
+				}
+			}
+
+			CullBoxesScalar(InFrustum, InBoxes, groupedBoxesNum, OutVisibleIndices);
+		}
+
+#elif MOX_FRUSTUM_CULLING_NEON
+
+		void CullBoxesNeon(const Mox::Frustum& InFrustum, const Mox::AabbSoA& InBoxes, std::vector<uint32_t>& OutVisibleIndices)
+		{
+			float32x4_t planeComponents[Mox::Frustum::PLANES_NUM][7];
+			for (uint32_t planeIdx = 0; planeIdx < Mox::Frustum::PLANES_NUM; ++planeIdx)
+			{
+				const Mox::Vector4f& plane = InFrustum.m_Planes[planeIdx];
+				planeComponents[planeIdx][0] = vdupq_n_f32(plane.x());
+				planeComponents[planeIdx][1] = vdupq_n_f32(plane.y());
+				planeComponents[planeIdx][2] = vdupq_n_f32(plane.z());
+				planeComponents[planeIdx][3] = vdupq_n_f32(plane.w());
+				planeComponents[planeIdx][4] = vdupq_n_f32(std::abs(plane.x()));
+				planeComponents[planeIdx][5] = vdupq_n_f32(std::abs(plane.y()));
+				planeComponents[planeIdx][6] = vdupq_n_f32(std::abs(plane.z()));
+			}
+
+			const float32x4_t zero = vdupq_n_f32(0.f);
+			const size_t groupedBoxesNum = InBoxes.Size() & ~size_t(3);
+
+			for (size_t boxIdx = 0; boxIdx < groupedBoxesNum; boxIdx += 4)
+			{
+				const float32x4_t centerX = vld1q_f32(InBoxes.m_CenterX.data() + boxIdx);
+				const float32x4_t centerY = vld1q_f32(InBoxes.m_CenterY.data() + boxIdx);
+				const float32x4_t centerZ = vld1q_f32(InBoxes.m_CenterZ.data() + boxIdx);
+				const float32x4_t extentX = vld1q_f32(InBoxes.m_ExtentX.data() + boxIdx);
+				const float32x4_t extentY = vld1q_f32(InBoxes.m_ExtentY.data() + boxIdx);
+				const float32x4_t extentZ = vld1q_f32(InBoxes.m_ExtentZ.data() + boxIdx);
+
+				uint32x4_t visibleLanes = vdupq_n_u32(0xFFFFFFFF);
+				for (const float32x4_t* plane : planeComponents)
+				{
+					float32x4_t distance = vfmaq_f32(plane[3], centerX, plane[0]);
+					distance = vfmaq_f32(distance, centerY, plane[1]);
+					distance = vfmaq_f32(distance, centerZ, plane[2]);
+					distance = vfmaq_f32(distance, extentX, plane[4]);
+					distance = vfmaq_f32(distance, extentY, plane[5]);
+					distance = vfmaq_f32(distance, extentZ, plane[6]);
+
+					visibleLanes = vandq_u32(visibleLanes, vcgeq_f32(distance, zero));
+				}
+
+				if (vmaxvq_u32(visibleLanes) == 0)
+				{
+					continue;
+				}
+
+				uint32_t laneResults[4];
+				vst1q_u32(laneResults, visibleLanes);
+				for (uint32_t laneIdx = 0; laneIdx < 4; ++laneIdx)
+				{
+					if (laneResults[laneIdx] != 0)
+					{
+						OutVisibleIndices.push_back(static_cast<uint32_t>(boxIdx + laneIdx));
+					}
+				}
+			}
+
+			CullBoxesScalar(InFrustum, InBoxes, groupedBoxesNum, OutVisibleIndices);
+		}
+
+#endif
+	}
+
+	void CullBoxes(const Mox::Frustum& InFrustum, const Mox::AabbSoA& InBoxes, std::vector<uint32_t>& OutVisibleIndices)
+	{
+		OutVisibleIndices.clear();
+
+#if MOX_FRUSTUM_CULLING_SSE
+		CullBoxesSse(InFrustum, InBoxes, OutVisibleIndices);
+#elif MOX_FRUSTUM_CULLING_NEON
+		CullBoxesNeon(InFrustum, InBoxes, OutVisibleIndices);
+#else
+		CullBoxesScalar(InFrustum, InBoxes, 0, OutVisibleIndices);
+#endif
+	}
+
+	void ComputeScreenSizes(const Mox::Vector4f& InViewDepthRow, float InProjScale, float InMinDepth, const Mox::AabbSoA& InBoxes, std::vector<float>& OutScreenSizes)
+	{
+		// The bounding sphere radius is the length of the extents, and the view height at a given depth is 2 * depth / InProjScale,
+		// so the projected diameter over the view height is radius * InProjScale / depth
+		OutScreenSizes.resize(InBoxes.Size());
+		size_t boxIdx = 0;
+
+#if MOX_FRUSTUM_CULLING_SSE
+		const __m128 rowX = _mm_set1_ps(InViewDepthRow.x()), rowY = _mm_set1_ps(InViewDepthRow.y());
+		const __m128 rowZ = _mm_set1_ps(InViewDepthRow.z()), rowW = _mm_set1_ps(InViewDepthRow.w());
+		const __m128 projScale = _mm_set1_ps(InProjScale), minDepth = _mm_set1_ps(InMinDepth);
+
+		for (; boxIdx + 4 <= InBoxes.Size(); boxIdx += 4)
+		{
+			const __m128 extentX = _mm_loadu_ps(InBoxes.m_ExtentX.data() + boxIdx);
+			const __m128 extentY = _mm_loadu_ps(InBoxes.m_ExtentY.data() + boxIdx);
+			const __m128 extentZ = _mm_loadu_ps(InBoxes.m_ExtentZ.data() + boxIdx);
+
+			__m128 depth = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(InBoxes.m_CenterX.data() + boxIdx), rowX), rowW);
+			depth = _mm_add_ps(depth, _mm_mul_ps(_mm_loadu_ps(InBoxes.m_CenterY.data() + boxIdx), rowY));
+			depth = _mm_add_ps(depth, _mm_mul_ps(_mm_loadu_ps(InBoxes.m_CenterZ.data() + boxIdx), rowZ));
+
+			__m128 radius = _mm_mul_ps(extentX, extentX);
+			radius = _mm_add_ps(radius, _mm_mul_ps(extentY, extentY));
+			radius = _mm_sqrt_ps(_mm_add_ps(radius, _mm_mul_ps(extentZ, extentZ)));
+
+			_mm_storeu_ps(OutScreenSizes.data() + boxIdx, _mm_div_ps(_mm_mul_ps(radius, projScale), _mm_max_ps(depth, minDepth)));
+		}
+#elif MOX_FRUSTUM_CULLING_NEON
+		const float32x4_t rowX = vdupq_n_f32(InViewDepthRow.x()), rowY = vdupq_n_f32(InViewDepthRow.y());
+		const float32x4_t rowZ = vdupq_n_f32(InViewDepthRow.z()), rowW = vdupq_n_f32(InViewDepthRow.w());
+		const float32x4_t projScale = vdupq_n_f32(InProjScale), minDepth = vdupq_n_f32(InMinDepth);
+
+		for (; boxIdx + 4 <= InBoxes.Size(); boxIdx += 4)
+		{
+			const float32x4_t extentX = vld1q_f32(InBoxes.m_ExtentX.data() + boxIdx);
+			const float32x4_t extentY = vld1q_f32(InBoxes.m_ExtentY.data() + boxIdx);
+			const float32x4_t extentZ = vld1q_f32(InBoxes.m_ExtentZ.data() + boxIdx);
+
+			float32x4_t depth = vfmaq_f32(rowW, vld1q_f32(InBoxes.m_CenterX.data() + boxIdx), rowX);
+			depth = vfmaq_f32(depth, vld1q_f32(InBoxes.m_CenterY.data() + boxIdx), rowY);
+			depth = vfmaq_f32(depth, vld1q_f32(InBoxes.m_CenterZ.data() + boxIdx), rowZ);
+
+			float32x4_t radius = vmulq_f32(extentX, extentX);
+			radius = vfmaq_f32(radius, extentY, extentY);
+			radius = vsqrtq_f32(vfmaq_f32(radius, extentZ, extentZ));
+
+			vst1q_f32(OutScreenSizes.data() + boxIdx, vdivq_f32(vmulq_f32(radius, projScale), vmaxq_f32(depth, minDepth)));
+		}
+#endif
+
+		// Boxes left out of the groups of 4, or all of them on platforms without a vector path
+		for (; boxIdx < InBoxes.Size(); ++boxIdx)
+		{
+			const float depth = InViewDepthRow.x() * InBoxes.m_CenterX[boxIdx] + InViewDepthRow.y() * InBoxes.m_CenterY[boxIdx] + InViewDepthRow.z() * InBoxes.m_CenterZ[boxIdx] + InViewDepthRow.w();
+			const float radius = std::sqrt(InBoxes.m_ExtentX[boxIdx] * InBoxes.m_ExtentX[boxIdx] + InBoxes.m_ExtentY[boxIdx] * InBoxes.m_ExtentY[boxIdx] + InBoxes.m_ExtentZ[boxIdx] * InBoxes.m_ExtentZ[boxIdx]);
+
+			OutScreenSizes[boxIdx] = radius * InProjScale / std::max(depth, InMinDepth);
+		}
+	}
+
+}
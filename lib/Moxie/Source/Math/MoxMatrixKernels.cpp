@@ -0,0 +1,381 @@
+/*
+ MoxMatrixKernels.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#include "MoxMatrixKernels.h"
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define MOX_MATRIX_KERNELS_X64 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define MOX_MATRIX_KERNELS_ARM64 1
+#include <arm_neon.h>
+#endif
+
+// MSVC accepts intrinsics of any instruction set in any function, GCC and Clang need to enable them per function
+#if defined(MOX_MATRIX_KERNELS_X64) && (defined(__GNUC__) || defined(__clang__))
+#define MOX_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define MOX_TARGET_AVX2
+#endif
+
+namespace Mox {
+
+	namespace
+	{
+		// Note: All the kernels read and write matrices as 16 consecutive floats in column-major order, as Eigen stores them.
+		// The product of column-major matrices is computed column by column: OutCol[j] = sum_k( LeftCol[k] * Right(k,j) )
+
+		// ----- Scalar -----
+
+		inline void MultiplyScalar(const float* InLeft, const float* InRight, float* OutResult)
+		{
+			float result[16];
+			for (int colIdx = 0; colIdx < 4; ++colIdx)
+			{
+				for (int rowIdx = 0; rowIdx < 4; ++rowIdx)
+				{
+					result[colIdx * 4 + rowIdx] =
+						InLeft[0 * 4 + rowIdx] * InRight[colIdx * 4 + 0] +
+						InLeft[1 * 4 + rowIdx] * InRight[colIdx * 4 + 1] +
+						InLeft[2 * 4 + rowIdx] * InRight[colIdx * 4 + 2] +
+						InLeft[3 * 4 + rowIdx] * InRight[colIdx * 4 + 3];
+				}
+			}
+			// Writing at the end allows the result to alias one of the inputs
+			std::memcpy(OutResult, result, sizeof(result));
+		}
+
+		void MultiplyBatchScalar(const float* InLeft, const float* InRights, float* OutResults, size_t InCount)
+		{
+			for (size_t matIdx = 0; matIdx < InCount; ++matIdx)
+			{
+				MultiplyScalar(InLeft, InRights + matIdx * 16, OutResults + matIdx * 16);
+			}
+		}
+
+		void ConcatenateScalar(float* InOutMatrices, const uint32_t* InTargetIndices, const uint32_t* InParentIndices, size_t InCount)
+		{
+			for (size_t entryIdx = 0; entryIdx < InCount; ++entryIdx)
+			{
+				float* target = InOutMatrices + InTargetIndices[entryIdx] * 16;
+				MultiplyScalar(InOutMatrices + InParentIndices[entryIdx] * 16, target, target);
+			}
+		}
+
+#if MOX_MATRIX_KERNELS_X64
+
+		// ----- SSE -----
+
+		inline void MultiplySse(const __m128 InLeftCols[4], const float* InRight, float* OutResult)
+		{
+			__m128 resultCols[4];
+			for (int colIdx = 0; colIdx < 4; ++colIdx)
+			{
+				const float* rightCol = InRight + colIdx * 4;
+				__m128 resultCol = _mm_mul_ps(InLeftCols[0], _mm_set1_ps(rightCol[0]));
+				resultCol = _mm_add_ps(resultCol, _mm_mul_ps(InLeftCols[1], _mm_set1_ps(rightCol[1])));
+				resultCol = _mm_add_ps(resultCol, _mm_mul_ps(InLeftCols[2], _mm_set1_ps(rightCol[2])));
+				resultCol = _mm_add_ps(resultCol, _mm_mul_ps(InLeftCols[3], _mm_set1_ps(rightCol[3])));
+				resultCols[colIdx] = resultCol;
+			}
+			for (int colIdx = 0; colIdx < 4; ++colIdx)
+			{
+				_mm_storeu_ps(OutResult + colIdx * 4, resultCols[colIdx]);
+			}
+		}
+
+		inline void LoadColumnsSse(const float* InMatrix, __m128 OutCols[4])
+		{
+			for (int colIdx = 0; colIdx < 4; ++colIdx)
+			{
+				OutCols[colIdx] = _mm_loadu_ps(InMatrix + colIdx * 4);
+			}
+		}
+
+		void MultiplyBatchSse(const float* InLeft, const float* InRights, float* OutResults, size_t InCount)
+		{
+			// The shared matrix stays in registers for the whole batch
+			__m128 leftCols[4];
+			LoadColumnsSse(InLeft, leftCols);
+
+			for (size_t matIdx = 0; matIdx < InCount; ++matIdx)
+			{
+				MultiplySse(leftCols, InRights + matIdx * 16, OutResults + matIdx * 16);
+			}
+		}
+
+		void ConcatenateSse(float* InOutMatrices, const uint32_t* InTargetIndices, const uint32_t* InParentIndices, size_t InCount)
+		{
+			for (size_t entryIdx = 0; entryIdx < InCount; ++entryIdx)
+			{
+				__m128 parentCols[4];
+				LoadColumnsSse(InOutMatrices + InParentIndices[entryIdx] * 16, parentCols);
+
+				float* target = InOutMatrices + InTargetIndices[entryIdx] * 16;
+				MultiplySse(parentCols, target, target);
+			}
+		}
+
+		// ----- AVX2 -----
+
+		// Each 256 bit register holds two columns of the result, the left columns are duplicated in both halves
+		MOX_TARGET_AVX2 inline void MultiplyAvx2(const __m256 InLeftCols[4], const float* InRight, float* OutResult)
+		{
+			const __m256 rightCols01 = _mm256_loadu_ps(InRight);
+			const __m256 rightCols23 = _mm256_loadu_ps(InRight + 8);
+
+			// _mm256_permute_ps broadcasts one element within each 128 bit half, that is, one element of each of the two columns
+			__m256 resultCols01 = _mm256_mul_ps(InLeftCols[0], _mm256_permute_ps(rightCols01, 0x00));
+			resultCols01 = _mm256_fmadd_ps(InLeftCols[1], _mm256_permute_ps(rightCols01, 0x55), resultCols01);
+			resultCols01 = _mm256_fmadd_ps(InLeftCols[2], _mm256_permute_ps(rightCols01, 0xAA), resultCols01);
+			resultCols01 = _mm256_fmadd_ps(InLeftCols[3], _mm256_permute_ps(rightCols01, 0xFF), resultCols01);
+
+			__m256 resultCols23 = _mm256_mul_ps(InLeftCols[0], _mm256_permute_ps(rightCols23, 0x00));
+			resultCols23 = _mm256_fmadd_ps(InLeftCols[1], _mm256_permute_ps(rightCols23, 0x55), resultCols23);
+			resultCols23 = _mm256_fmadd_ps(InLeftCols[2], _mm256_permute_ps(rightCols23, 0xAA), resultCols23);
+			resultCols23 = _mm256_fmadd_ps(InLeftCols[3], _mm256_permute_ps(rightCols23, 0xFF), resultCols23);
+
+			_mm256_storeu_ps(OutResult, resultCols01);
+			_mm256_storeu_ps(OutResult + 8, resultCols23);
+		}
+
+		MOX_TARGET_AVX2 inline void LoadColumnsAvx2(const float* InMatrix, __m256 OutCols[4])
+		{
+			for (int colIdx = 0; colIdx < 4; ++colIdx)
+			{
+				OutCols[colIdx] = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(InMatrix + colIdx * 4));
+			}
+		}
+
+		MOX_TARGET_AVX2 void MultiplyBatchAvx2(const float* InLeft, const float* InRights, float* OutResults, size_t InCount)
+		{
+			__m256 leftCols[4];
+			LoadColumnsAvx2(InLeft, leftCols);
+
+			for (size_t matIdx = 0; matIdx < InCount; ++matIdx)
+			{
+				MultiplyAvx2(leftCols, InRights + matIdx * 16, OutResults + matIdx * 16);
+			}
+		}
+
+		MOX_TARGET_AVX2 void ConcatenateAvx2(float* InOutMatrices, const uint32_t* InTargetIndices, const uint32_t* InParentIndices, size_t InCount)
+		{
+			for (size_t entryIdx = 0; entryIdx < InCount; ++entryIdx)
+			{
+				__m256 parentCols[4];
+				LoadColumnsAvx2(InOutMatrices + InParentIndices[entryIdx] * 16, parentCols);
+
+				float* target = InOutMatrices + InTargetIndices[entryIdx] * 16;
+				MultiplyAvx2(parentCols, target, target);
+			}
+		}
+
+		bool IsAvx2Supported()
+		{
+#if defined(_MSC_VER) && !defined(__clang__)
+			int cpuInfo[4];
+			__cpuid(cpuInfo, 1);
+			const bool hasFma = (cpuInfo[2] & (1 << 12)) != 0;
+			const bool hasOsXSave = (cpuInfo[2] & (1 << 27)) != 0;
+			const bool hasAvx = (cpuInfo[2] & (1 << 28)) != 0;
+			if (!(hasFma && hasOsXSave && hasAvx))
+			{
+				return false;
+			}
+			// The OS needs to preserve the YMM registers across context switches
+			if ((_xgetbv(0) & 0x6) != 0x6)
+			{
+				return false;
+			}
+			__cpuidex(cpuInfo, 7, 0);
+			return (cpuInfo[1] & (1 << 5)) != 0;
+#else
+			return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+		}
+
+#elif MOX_MATRIX_KERNELS_ARM64
+
+		// ----- NEON -----
+
+		inline void MultiplyNeon(const float32x4_t InLeftCols[4], const float* InRight, float* OutResult)
+		{
+			float32x4_t resultCols[4];
+			for (int colIdx = 0; colIdx < 4; ++colIdx)
+			{
+				const float32x4_t rightCol = vld1q_f32(InRight + colIdx * 4);
+				float32x4_t resultCol = vmulq_laneq_f32(InLeftCols[0], rightCol, 0);
+				resultCol = vfmaq_laneq_f32(resultCol, InLeftCols[1], rightCol, 1);
+				resultCol = vfmaq_laneq_f32(resultCol, InLeftCols[2], rightCol, 2);
+				resultCol = vfmaq_laneq_f32(resultCol, InLeftCols[3], rightCol, 3);
+				resultCols[colIdx] = resultCol;
+			}
+			for (int colIdx = 0; colIdx < 4; ++colIdx)
+			{
+				vst1q_f32(OutResult + colIdx * 4, resultCols[colIdx]);
+			}
+		}
+
+		inline void LoadColumnsNeon(const float* InMatrix, float32x4_t OutCols[4])
+		{
+			for (int colIdx = 0; colIdx < 4; ++colIdx)
+			{
+				OutCols[colIdx] = vld1q_f32(InMatrix + colIdx * 4);
+			}
+		}
+
+		void MultiplyBatchNeon(const float* InLeft, const float* InRights, float* OutResults, size_t InCount)
+		{
+			float32x4_t leftCols[4];
+			LoadColumnsNeon(InLeft, leftCols);
+
+			for (size_t matIdx = 0; matIdx < InCount; ++matIdx)
+			{
+				MultiplyNeon(leftCols, InRights + matIdx * 16, OutResults + matIdx * 16);
+			}
+		}
+
+		void ConcatenateNeon(float* InOutMatrices, const uint32_t* InTargetIndices, const uint32_t* InParentIndices, size_t InCount)
+		{
+			for (size_t entryIdx = 0; entryIdx < InCount; ++entryIdx)
+			{
+				float32x4_t parentCols[4];
+				LoadColumnsNeon(InOutMatrices + InParentIndices[entryIdx] * 16, parentCols);
+
+				float* target = InOutMatrices + InTargetIndices[entryIdx] * 16;
+				MultiplyNeon(parentCols, target, target);
+			}
+		}
+
+#endif
+
+		// ----- Dispatch -----
+
+		struct MatrixKernels
+		{
+			Mox::MATRIX_KERNEL_PATH m_Path;
+			void (*m_MultiplyBatch)(const float*, const float*, float*, size_t);
+			void (*m_Concatenate)(float*, const uint32_t*, const uint32_t*, size_t);
+		};
+
+		MatrixKernels GetKernelsForPath(Mox::MATRIX_KERNEL_PATH InPath)
+		{
+			switch (InPath)
+			{
+#if MOX_MATRIX_KERNELS_X64
+			case Mox::MATRIX_KERNEL_PATH::SSE:
+				return MatrixKernels{ InPath, &MultiplyBatchSse, &ConcatenateSse };
+			case Mox::MATRIX_KERNEL_PATH::AVX2:
+				return MatrixKernels{ InPath, &MultiplyBatchAvx2, &ConcatenateAvx2 };
+#elif MOX_MATRIX_KERNELS_ARM64
+			case Mox::MATRIX_KERNEL_PATH::NEON:
+				return MatrixKernels{ InPath, &MultiplyBatchNeon, &ConcatenateNeon };
+#endif
+			default:
+				return MatrixKernels{ Mox::MATRIX_KERNEL_PATH::SCALAR, &MultiplyBatchScalar, &ConcatenateScalar };
+			}
+		}
+
+		// Selected on first use, can be changed later only by SetMatrixKernelPath
+		MatrixKernels& GetActiveKernels()
+		{
+			static MatrixKernels activeKernels = GetKernelsForPath(Mox::GetBestMatrixKernelPath());
+			return activeKernels;
+		}
+	}
+
+	const char* GetMatrixKernelPathName(Mox::MATRIX_KERNEL_PATH InPath)
+	{
+		switch (InPath)
+		{
+		case Mox::MATRIX_KERNEL_PATH::SSE: return "SSE";
+		case Mox::MATRIX_KERNEL_PATH::AVX2: return "AVX2";
+		case Mox::MATRIX_KERNEL_PATH::NEON: return "NEON";
+		default: return "Scalar";
+		}
+	}
+
+	bool IsMatrixKernelPathSupported(Mox::MATRIX_KERNEL_PATH InPath)
+	{
+		switch (InPath)
+		{
+		case Mox::MATRIX_KERNEL_PATH::SCALAR:
+			return true;
+#if MOX_MATRIX_KERNELS_X64
+		case Mox::MATRIX_KERNEL_PATH::SSE:
+			return true;
+		case Mox::MATRIX_KERNEL_PATH::AVX2:
+		{
+			static const bool isAvx2Supported = IsAvx2Supported();
+			return isAvx2Supported;
+		}
+#elif MOX_MATRIX_KERNELS_ARM64
+		case Mox::MATRIX_KERNEL_PATH::NEON:
+			return true;
+#endif
+		default:
+			return false;
+		}
+	}
+
+	Mox::MATRIX_KERNEL_PATH GetBestMatrixKernelPath()
+	{
+		for (Mox::MATRIX_KERNEL_PATH curPath : { Mox::MATRIX_KERNEL_PATH::AVX2, Mox::MATRIX_KERNEL_PATH::NEON, Mox::MATRIX_KERNEL_PATH::SSE })
+		{
+			if (IsMatrixKernelPathSupported(curPath))
+			{
+				return curPath;
+			}
+		}
+		return Mox::MATRIX_KERNEL_PATH::SCALAR;
+	}
+
+	Mox::MATRIX_KERNEL_PATH GetMatrixKernelPath()
+	{
+		return GetActiveKernels().m_Path;
+	}
+
+	bool SetMatrixKernelPath(Mox::MATRIX_KERNEL_PATH InPath)
+	{
+		if (!IsMatrixKernelPathSupported(InPath))
+		{
+			return false;
+		}
+
+		GetActiveKernels() = GetKernelsForPath(InPath);
+		return true;
+	}
+
+	void MultiplyMatrixBatch(const Mox::Matrix4f& InLeft, const Mox::Matrix4f* InRights, Mox::Matrix4f* OutResults, size_t InCount)
+	{
+		// Matrix4f is a plain array of 16 floats, so an array of them can be walked as an array of floats
+		static_assert(sizeof(Mox::Matrix4f) == 16 * sizeof(float), "Matrix kernels expect tightly packed 4x4 float matrices");
+
+		if (InCount == 0)
+		{
+			return;
+		}
+
+		GetActiveKernels().m_MultiplyBatch(InLeft.data(), InRights->data(), OutResults->data(), InCount);
+	}
+
+	void ConcatenateMatrices(Mox::Matrix4f* InOutMatrices, const uint32_t* InTargetIndices, const uint32_t* InParentIndices, size_t InCount)
+	{
+		if (InCount == 0)
+		{
+			return;
+		}
+
+		GetActiveKernels().m_Concatenate(InOutMatrices->data(), InTargetIndices, InParentIndices, InCount);
+	}
+
+}
@@ -0,0 +1,380 @@
+/*
+ MoxMeshOptimizer.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#include "MoxMeshOptimizer.h"
+#include "MoxUtils.h"
+#include <algorithm>
+#include <limits>
+
+namespace Mox {
+
+	namespace
+	{
+		// Triangles around each vertex, as ranges of OutVertexTriangles
+		void BuildVertexTriangles(const std::vector<uint32_t>& InIndices, uint32_t InVerticesNum, std::vector<uint32_t>& OutOffsets, std::vector<uint32_t>& OutVertexTriangles)
+		{
+			OutOffsets.assign(InVerticesNum + 1, 0);
+			for (uint32_t vertexIdx : InIndices)
+			{
+				++OutOffsets[vertexIdx + 1];
+			}
+
+			for (uint32_t vertexIdx = 0; vertexIdx < InVerticesNum; ++vertexIdx)
+			{
+				OutOffsets[vertexIdx + 1] += OutOffsets[vertexIdx];
+			}
+
+			OutVertexTriangles.resize(InIndices.size());
+			std::vector<uint32_t> fillOffsets(OutOffsets.begin(), OutOffsets.end() - 1);
+			for (uint32_t cornerIdx = 0; cornerIdx < InIndices.size(); ++cornerIdx)
+			{
+				OutVertexTriangles[fillOffsets[InIndices[cornerIdx]]++] = cornerIdx / 3;
+			}
+		}
+
+		// FIFO cache where a vertex is a hit while fewer than InCacheSize misses happened since it was loaded
+		class VertexCacheSimulator
+		{
+		public:
+			VertexCacheSimulator(uint32_t InVerticesNum, uint32_t InCacheSize)
+				: m_CacheSize(InCacheSize), m_MissesNum(InCacheSize + 1), m_LoadTimes(InVerticesNum, 0)
+			{ }
+
+			// Returns true on a miss
+			bool Access(uint32_t InVertex)
+			{
+				if (m_MissesNum - m_LoadTimes[InVertex] > m_CacheSize)
+				{
+					m_LoadTimes[InVertex] = m_MissesNum++;
+					return true;
+				}
+				return false;
+			}
+
+		private:
+			uint32_t m_CacheSize;
+			uint32_t m_MissesNum;
+			std::vector<uint32_t> m_LoadTimes;
+		};
+	}
+
+	Mox::VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& InIndices, uint32_t InVerticesNum, uint32_t InCacheSize /*= Mox::DefaultVertexCacheSize*/)
+	{
+		VertexCacheSimulator cache(InVerticesNum, InCacheSize);
+		std::vector<bool> isReferenced(InVerticesNum, false);
+
+		uint32_t missesNum = 0, referencedVerticesNum = 0;
+		for (uint32_t vertexIdx : InIndices)
+		{
+			missesNum += cache.Access(vertexIdx) ? 1 : 0;
+
+			if (!isReferenced[vertexIdx])
+			{
+				isReferenced[vertexIdx] = true;
+				++referencedVerticesNum;
+			}
+		}
+
+		const size_t trianglesNum = InIndices.size() / 3;
+		return Mox::VertexCacheStats{
+			trianglesNum > 0 ? static_cast<float>(missesNum) / trianglesNum : 0.f,
+			referencedVerticesNum > 0 ? static_cast<float>(missesNum) / referencedVerticesNum : 0.f
+		};
+	}
+
+	void OptimizeVertexCache(std::vector<uint32_t>& InOutIndices, uint32_t InVerticesNum, uint32_t InCacheSize /*= Mox::DefaultVertexCacheSize*/)
+	{
+		Check(InOutIndices.size() % 3 == 0)
+
+		std::vector<uint32_t> vertexTrianglesOffsets, vertexTriangles;
+		BuildVertexTriangles(InOutIndices, InVerticesNum, vertexTrianglesOffsets, vertexTriangles);
+
+		// Triangles still to emit around each vertex
+		std::vector<uint32_t> liveTrianglesNum(InVerticesNum);
+		for (uint32_t vertexIdx = 0; vertexIdx < InVerticesNum; ++vertexIdx)
+		{
+			liveTrianglesNum[vertexIdx] = vertexTrianglesOffsets[vertexIdx + 1] - vertexTrianglesOffsets[vertexIdx];
+		}
+
+		// Same cache model as VertexCacheSimulator, where the time only advances on misses
+		std::vector<uint32_t> cacheTimes(InVerticesNum, 0);
+		uint32_t time = InCacheSize + 1;
+
+		std::vector<bool> isTriangleEmitted(InOutIndices.size() / 3, false);
+		std::vector<uint32_t> deadEndStack;
+		std::vector<uint32_t> candidates;
+
+		std::vector<uint32_t> outIndices;
+		outIndices.reserve(InOutIndices.size());
+
+		// Vertices are scanned in input order when no better fanning vertex is left
+		uint32_t nextInputVertex = 0;
+		auto skipDeadEnd = [&]() -> uint32_t
+		{
+			while (!deadEndStack.empty())
+			{
+				const uint32_t vertexIdx = deadEndStack.back();
+				deadEndStack.pop_back();
+				if (liveTrianglesNum[vertexIdx] > 0)
+				{
+					return vertexIdx;
+				}
+			}
+
+			for (; nextInputVertex < InVerticesNum; ++nextInputVertex)
+			{
+				if (liveTrianglesNum[nextInputVertex] > 0)
+				{
+					return nextInputVertex;
+				}
+			}
+
+			return std::numeric_limits<uint32_t>::max();
+		};
+
+		uint32_t fanningVertex = skipDeadEnd();
+		while (fanningVertex != std::numeric_limits<uint32_t>::max())
+		{
+			// Emits all the triangles around the fanning vertex
+			candidates.clear();
+			for (uint32_t adjacencyIdx = vertexTrianglesOffsets[fanningVertex]; adjacencyIdx < vertexTrianglesOffsets[fanningVertex + 1]; ++adjacencyIdx)
+			{
+				const uint32_t triangleIdx = vertexTriangles[adjacencyIdx];
+				if (isTriangleEmitted[triangleIdx])
+				{
+					continue;
+				}
+
+				isTriangleEmitted[triangleIdx] = true;
+				for (uint32_t cornerIdx = 0; cornerIdx < 3; ++cornerIdx)
+				{
+					const uint32_t vertexIdx = InOutIndices[triangleIdx * 3 + cornerIdx];
+					outIndices.push_back(vertexIdx);
+					deadEndStack.push_back(vertexIdx);
+					candidates.push_back(vertexIdx);
+					--liveTrianglesNum[vertexIdx];
+
+					if (time - cacheTimes[vertexIdx] > InCacheSize)
+					{
+						cacheTimes[vertexIdx] = time++;
+					}
+				}
+			}
+
+			// The next fanning vertex is the one among the vertices just emitted that has been in the cache the longest,
+			// as long as its remaining triangles would be emitted before it gets evicted
+			uint32_t bestVertex = std::numeric_limits<uint32_t>::max();
+			int64_t bestPriority = -1;
+			for (uint32_t candidate : candidates)
+			{
+				if (liveTrianglesNum[candidate] == 0)
+				{
+					continue;
+				}
+
+				int64_t priority = 0;
+				if (time - cacheTimes[candidate] + 2 * liveTrianglesNum[candidate] <= InCacheSize)
+				{
+					priority = time - cacheTimes[candidate];
+				}
+
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					bestVertex = candidate;
+				}
+			}
+
+			fanningVertex = bestVertex != std::numeric_limits<uint32_t>::max() ? bestVertex : skipDeadEnd();
+		}
+
+		InOutIndices = std::move(outIndices);
+	}
+
+	void OptimizeOverdraw(std::vector<uint32_t>& InOutIndices, const std::vector<Mox::Vector3f>& InPositions, uint32_t InCacheSize /*= Mox::DefaultVertexCacheSize*/)
+	{
+		const uint32_t trianglesNum = static_cast<uint32_t>(InOutIndices.size() / 3);
+		if (trianglesNum == 0)
+		{
+			return;
+		}
+
+		// A triangle missing all its vertices in the cache starts a new cluster, reordering clusters then costs almost no cache misses
+		std::vector<uint32_t> clusterStarts;
+		VertexCacheSimulator cache(static_cast<uint32_t>(InPositions.size()), InCacheSize);
+		for (uint32_t triangleIdx = 0; triangleIdx < trianglesNum; ++triangleIdx)
+		{
+			uint32_t triangleMissesNum = 0;
+			for (uint32_t cornerIdx = 0; cornerIdx < 3; ++cornerIdx)
+			{
+				triangleMissesNum += cache.Access(InOutIndices[triangleIdx * 3 + cornerIdx]) ? 1 : 0;
+			}
+
+			if (triangleMissesNum == 3)
+			{
+				clusterStarts.push_back(triangleIdx);
+			}
+		}
+		clusterStarts.push_back(trianglesNum);
+
+		// Centroid of the mesh, weighted by triangle area
+		Mox::Vector3f meshCenter = Mox::Vector3f::Zero();
+		float meshArea = 0.f;
+		for (uint32_t triangleIdx = 0; triangleIdx < trianglesNum; ++triangleIdx)
+		{
+			const Mox::Vector3f& first = InPositions[InOutIndices[triangleIdx * 3]];
+			const Mox::Vector3f& second = InPositions[InOutIndices[triangleIdx * 3 + 1]];
+			const Mox::Vector3f& third = InPositions[InOutIndices[triangleIdx * 3 + 2]];
+			const float area = (second - first).cross(third - first).norm();
+
+			meshCenter += (first + second + third) * (area / 3.f);
+			meshArea += area;
+		}
+		meshCenter = meshArea > 0.f ? Mox::Vector3f(meshCenter / meshArea) : Mox::Vector3f::Zero();
+
+		// Clusters whose surface faces away from the center are on the outside of the mesh, and get drawn first
+		const size_t clustersNum = clusterStarts.size() - 1;
+		std::vector<float> clusterSortKeys(clustersNum);
+		for (size_t clusterIdx = 0; clusterIdx < clustersNum; ++clusterIdx)
+		{
+			Mox::Vector3f clusterCenter = Mox::Vector3f::Zero();
+			Mox::Vector3f clusterNormal = Mox::Vector3f::Zero();
+			float clusterArea = 0.f;
+
+			for (uint32_t triangleIdx = clusterStarts[clusterIdx]; triangleIdx < clusterStarts[clusterIdx + 1]; ++triangleIdx)
+			{
+				const Mox::Vector3f& first = InPositions[InOutIndices[triangleIdx * 3]];
+				const Mox::Vector3f& second = InPositions[InOutIndices[triangleIdx * 3 + 1]];
+				const Mox::Vector3f& third = InPositions[InOutIndices[triangleIdx * 3 + 2]];
+				// Its length is twice the area, so summing them weighs the normals by area
+				const Mox::Vector3f areaNormal = (second - first).cross(third - first);
+				const float area = areaNormal.norm();
+
+				clusterCenter += (first + second + third) * (area / 3.f);
+				clusterNormal += areaNormal;
+				clusterArea += area;
+			}
+
+			clusterCenter = clusterArea > 0.f ? Mox::Vector3f(clusterCenter / clusterArea) : clusterCenter;
+			clusterSortKeys[clusterIdx] = (clusterCenter - meshCenter).dot(clusterNormal.normalized());
+		}
+
+		std::vector<uint32_t> clusterOrder(clustersNum);
+		for (uint32_t clusterIdx = 0; clusterIdx < clustersNum; ++clusterIdx)
+		{
+			clusterOrder[clusterIdx] = clusterIdx;
+		}
+
+		std::stable_sort(clusterOrder.begin(), clusterOrder.end(),
+			[&clusterSortKeys](uint32_t InFirst, uint32_t InSecond) { return clusterSortKeys[InFirst] > clusterSortKeys[InSecond]; });
+
+		std::vector<uint32_t> outIndices;
+		outIndices.reserve(InOutIndices.size());
+		for (uint32_t clusterIdx : clusterOrder)
+		{
+			outIndices.insert(outIndices.end(), InOutIndices.begin() + clusterStarts[clusterIdx] * 3, InOutIndices.begin() + clusterStarts[clusterIdx + 1] * 3);
+		}
+
+		InOutIndices = std::move(outIndices);
+	}
+
+	void OptimizeVertexFetch(std::vector<uint32_t>& InOutIndices, uint32_t InVerticesNum, std::vector<uint32_t>& OutRemap)
+	{
+		OutRemap.assign(InVerticesNum, std::numeric_limits<uint32_t>::max());
+
+		uint32_t nextVertexIdx = 0;
+		for (uint32_t& vertexIdx : InOutIndices)
+		{
+			if (OutRemap[vertexIdx] == std::numeric_limits<uint32_t>::max())
+			{
+				OutRemap[vertexIdx] = nextVertexIdx++;
+			}
+
+			vertexIdx = OutRemap[vertexIdx];
+		}
+
+		// Other index buffers, such as levels of detail, can still reference vertices not used here
+		for (uint32_t& newVertexIdx : OutRemap)
+		{
+			if (newVertexIdx == std::numeric_limits<uint32_t>::max())
+			{
+				newVertexIdx = nextVertexIdx++;
+			}
+		}
+	}
+
+	void RemapVertices(void* InOutVertexData, uint32_t InVertexStride, uint32_t InVerticesNum, const std::vector<uint32_t>& InRemap)
+	{
+		Check(InRemap.size() == InVerticesNum)
+
+		std::byte* vertexData = static_cast<std::byte*>(InOutVertexData);
+		const std::vector<std::byte> sourceData(vertexData, vertexData + static_cast<size_t>(InVertexStride) * InVerticesNum);
+
+		for (uint32_t vertexIdx = 0; vertexIdx < InVerticesNum; ++vertexIdx)
+		{
+			memcpy(vertexData + static_cast<size_t>(InRemap[vertexIdx]) * InVertexStride, sourceData.data() + static_cast<size_t>(vertexIdx) * InVertexStride, InVertexStride);
+		}
+	}
+
+	void OptimizeMeshBuffers(void* InOutVertexData, uint32_t InVertexStride, uint32_t InVerticesNum, int32_t InPositionOffset,
+		void* InOutIndexData, uint32_t InIndexStride, uint32_t InIndicesNum, Mox::MeshOptimizationStats* OutStats /*= nullptr*/)
+	{
+		Check(InIndexStride == sizeof(uint16_t) || InIndexStride == sizeof(uint32_t))
+
+		// Passes work on 32 bit indices, whatever the format of the buffer
+		std::vector<uint32_t> indices(InIndicesNum);
+		for (uint32_t indexIdx = 0; indexIdx < InIndicesNum; ++indexIdx)
+		{
+			indices[indexIdx] = InIndexStride == sizeof(uint16_t) ? static_cast<const uint16_t*>(InOutIndexData)[indexIdx] : static_cast<const uint32_t*>(InOutIndexData)[indexIdx];
+			Check(indices[indexIdx] < InVerticesNum)
+		}
+
+		if (OutStats)
+		{
+			OutStats->m_Before = Mox::AnalyzeVertexCache(indices, InVerticesNum);
+		}
+
+		Mox::OptimizeVertexCache(indices, InVerticesNum);
+
+		if (InPositionOffset >= 0)
+		{
+			Check(InPositionOffset + sizeof(Mox::Vector3f) <= InVertexStride)
+
+			std::vector<Mox::Vector3f> positions(InVerticesNum);
+			const std::byte* vertexData = static_cast<const std::byte*>(InOutVertexData);
+			for (uint32_t vertexIdx = 0; vertexIdx < InVerticesNum; ++vertexIdx)
+			{
+				memcpy(positions[vertexIdx].data(), vertexData + static_cast<size_t>(vertexIdx) * InVertexStride + InPositionOffset, sizeof(Mox::Vector3f));
+			}
+
+			Mox::OptimizeOverdraw(indices, positions);
+		}
+
+		std::vector<uint32_t> vertexRemap;
+		Mox::OptimizeVertexFetch(indices, InVerticesNum, vertexRemap);
+		Mox::RemapVertices(InOutVertexData, InVertexStride, InVerticesNum, vertexRemap);
+
+		if (OutStats)
+		{
+			OutStats->m_After = Mox::AnalyzeVertexCache(indices, InVerticesNum);
+		}
+
+		for (uint32_t indexIdx = 0; indexIdx < InIndicesNum; ++indexIdx)
+		{
+			if (InIndexStride == sizeof(uint16_t))
+			{
+				static_cast<uint16_t*>(InOutIndexData)[indexIdx] = static_cast<uint16_t>(indices[indexIdx]);
+			}
+			else
+			{
+				static_cast<uint32_t*>(InOutIndexData)[indexIdx] = indices[indexIdx];
+			}
+		}
+	}
+
+}
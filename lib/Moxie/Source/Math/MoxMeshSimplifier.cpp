@@ -0,0 +1,723 @@
+/*
+ MoxMeshSimplifier.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#include "MoxMeshSimplifier.h"
+#include "TaskSystem.h"
+#include "MoxUtils.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Mox {
+
+	namespace
+	{
+		// Border quadrics keep open borders in place, they weigh more than the triangle ones so that borders are the last to move
+		constexpr double BorderQuadricWeight = 10.;
+
+		constexpr uint32_t SimplifierMaxDimension = 3 + Mox::SimplifierMaxAttributesNum;
+
+		enum class SIMPLIFIER_VERTEX_KIND : uint8_t
+		{
+			INTERIOR,
+			// On an open border, it can only collapse along the border
+			BORDER,
+			// On a seam or a non-manifold edge, it never moves
+			LOCKED
+		};
+
+		// Edge of a triangle, with the vertices ordered so that the same edge of two triangles compares equal
+		struct SimplifierEdge
+		{
+			uint32_t m_First;
+			uint32_t m_Second;
+			// Index of the triangle corner the edge starts from
+			uint32_t m_Corner;
+
+			bool operator<(const SimplifierEdge& InOther) const
+			{
+				return std::tie(m_First, m_Second, m_Corner) < std::tie(InOther.m_First, InOther.m_Second, InOther.m_Corner);
+			}
+
+			bool IsSameEdge(const SimplifierEdge& InOther) const { return m_First == InOther.m_First && m_Second == InOther.m_Second; }
+		};
+
+		struct SimplifierCollapse
+		{
+			// Vertex removed by the collapse
+			uint32_t m_From;
+			// Vertex the triangles of m_From get attached to
+			uint32_t m_To;
+			double m_Cost;
+
+			bool operator<(const SimplifierCollapse& InOther) const
+			{
+				return std::tie(m_Cost, m_From, m_To) < std::tie(InOther.m_Cost, InOther.m_From, InOther.m_To);
+			}
+		};
+
+		/*
+		* Quadrics have dimension 3 + attributes num, each one stored as the upper triangle of the matrix A, the vector b,
+		* the constant c and the sum of the weights, so that the error of a point x is (xT*A*x + 2*bT*x + c) / weight.
+		* Collapses are done in passes: the cheapest collapses are picked in order, skipping the ones close to a collapse
+		* already done in the pass, then triangles are rewritten and the adjacency is built again for the next pass.
+		*/
+		class QuadricSimplifier
+		{
+		public:
+			QuadricSimplifier(const Mox::SimplifierMesh& InMesh, const Mox::MeshLodSettings& InSettings);
+
+			// Collapses edges until the mesh has at most the given triangles. Returns false if no collapse under the max error is left before that.
+			bool Simplify(uint32_t InTargetTrianglesNum);
+
+			const std::vector<uint32_t>& GetIndices() const { return m_Indices; }
+
+			uint32_t GetTrianglesNum() const { return static_cast<uint32_t>(m_Indices.size() / 3); }
+
+			// In the same units as the source positions
+			float GetError() const { return static_cast<float>(std::sqrt(m_MaxCollapseCost) * m_PositionScale); }
+
+		private:
+			void ClassifyVertices(const Mox::SimplifierMesh& InMesh);
+
+			void ComputeQuadrics();
+
+			void AddTriangleQuadric(double* InOutQuadric, const double* InFirst, const double* InSecond, const double* InThird, double InWeight) const;
+
+			void AddBorderQuadric(double* InOutQuadric, const double* InFirst, const double* InSecond, const double* InOpposite) const;
+
+			double EvaluateQuadric(const double* InQuadric, const double* InPoint) const;
+
+			void BuildAdjacency();
+
+			void GatherCollapses();
+
+			bool IsCollapseValid(const SimplifierCollapse& InCollapse);
+
+			void GatherNeighbours(uint32_t InVertex, std::vector<uint32_t>& OutNeighbours) const;
+
+			const double* GetPoint(uint32_t InVertex) const { return m_Points.data() + InVertex * m_Dimension; }
+			double* GetQuadric(uint32_t InVertex) { return m_Quadrics.data() + InVertex * m_QuadricStride; }
+			const double* GetQuadric(uint32_t InVertex) const { return m_Quadrics.data() + InVertex * m_QuadricStride; }
+
+			uint32_t m_VerticesNum;
+			uint32_t m_Dimension;
+			uint32_t m_QuadricStride;
+
+			// Positions are normalized to the size of the mesh, so that the attributes weight does not depend on it
+			double m_PositionScale = 1.;
+			// Squared and in normalized units
+			double m_MaxAllowedCost;
+			double m_MaxCollapseCost = 0.;
+
+			// Normalized position followed by the weighted attributes, for each vertex
+			std::vector<double> m_Points;
+			std::vector<double> m_Quadrics;
+			std::vector<SIMPLIFIER_VERTEX_KIND> m_VertexKinds;
+
+			std::vector<uint32_t> m_Indices;
+
+			// Triangles around each vertex, as ranges of m_VertexTriangles
+			std::vector<uint32_t> m_VertexTrianglesOffsets;
+			std::vector<uint32_t> m_VertexTriangles;
+
+			// Scratch containers kept across passes
+			std::vector<Mox::SimplifierEdge> m_Edges;
+			std::vector<Mox::SimplifierCollapse> m_Collapses;
+			std::vector<bool> m_IsVertexTouched;
+			std::vector<uint32_t> m_FromNeighbours;
+			std::vector<uint32_t> m_ToNeighbours;
+		};
+
+		QuadricSimplifier::QuadricSimplifier(const Mox::SimplifierMesh& InMesh, const Mox::MeshLodSettings& InSettings)
+			: m_VerticesNum(static_cast<uint32_t>(InMesh.m_Positions.size())), m_Dimension(3 + InMesh.m_AttributesNum), m_Indices(InMesh.m_Indices)
+		{
+			Check(m_Indices.size() % 3 == 0)
+			Check(InMesh.m_Attributes.size() == static_cast<size_t>(m_VerticesNum) * InMesh.m_AttributesNum)
+
+			// Upper triangle of A, then b, c and the weight
+			m_QuadricStride = m_Dimension * (m_Dimension + 1) / 2 + m_Dimension + 2;
+
+			Mox::Vector3f minPosition = Mox::Vector3f::Constant(std::numeric_limits<float>::max());
+			Mox::Vector3f maxPosition = Mox::Vector3f::Constant(std::numeric_limits<float>::lowest());
+			for (const Mox::Vector3f& position : InMesh.m_Positions)
+			{
+				minPosition = minPosition.cwiseMin(position);
+				maxPosition = maxPosition.cwiseMax(position);
+			}
+
+			const double meshSize = m_VerticesNum > 0 ? static_cast<double>((maxPosition - minPosition).maxCoeff()) : 0.;
+			m_PositionScale = meshSize > 0. ? meshSize : 1.;
+
+			const double maxError = static_cast<double>(InSettings.m_MaxError) / m_PositionScale;
+			m_MaxAllowedCost = maxError * maxError;
+
+			m_Points.resize(static_cast<size_t>(m_VerticesNum) * m_Dimension);
+			for (uint32_t vertexIdx = 0; vertexIdx < m_VerticesNum; ++vertexIdx)
+			{
+				double* point = m_Points.data() + vertexIdx * m_Dimension;
+				for (uint32_t coordIdx = 0; coordIdx < 3; ++coordIdx)
+				{
+					point[coordIdx] = (InMesh.m_Positions[vertexIdx][coordIdx] - minPosition[coordIdx]) / m_PositionScale;
+				}
+				for (uint32_t attributeIdx = 0; attributeIdx < InMesh.m_AttributesNum; ++attributeIdx)
+				{
+					point[3 + attributeIdx] = InMesh.m_Attributes[vertexIdx * InMesh.m_AttributesNum + attributeIdx] * static_cast<double>(InSettings.m_AttributesWeight);
+				}
+			}
+
+			ClassifyVertices(InMesh);
+
+			if (InSettings.m_LockBorders)
+			{
+				std::replace(m_VertexKinds.begin(), m_VertexKinds.end(), SIMPLIFIER_VERTEX_KIND::BORDER, SIMPLIFIER_VERTEX_KIND::LOCKED);
+			}
+
+			ComputeQuadrics();
+		}
+
+		void QuadricSimplifier::ClassifyVertices(const Mox::SimplifierMesh& InMesh)
+		{
+			m_VertexKinds.assign(m_VerticesNum, SIMPLIFIER_VERTEX_KIND::INTERIOR);
+
+			// Vertices with the same position are welded for the topology, so that seams are not taken for borders.
+			// Sorting by position with the vertex index as tie break makes the first vertex of each group the same on every run.
+			std::vector<uint32_t> sortedVertices(m_VerticesNum);
+			for (uint32_t vertexIdx = 0; vertexIdx < m_VerticesNum; ++vertexIdx)
+			{
+				sortedVertices[vertexIdx] = vertexIdx;
+			}
+
+			std::sort(sortedVertices.begin(), sortedVertices.end(), [&InMesh](uint32_t InFirst, uint32_t InSecond) {
+				const Mox::Vector3f& first = InMesh.m_Positions[InFirst];
+				const Mox::Vector3f& second = InMesh.m_Positions[InSecond];
+				return std::make_tuple(first.x(), first.y(), first.z(), InFirst) < std::make_tuple(second.x(), second.y(), second.z(), InSecond);
+			});
+
+			std::vector<uint32_t> weldedVertices(m_VerticesNum);
+			for (size_t sortedIdx = 0; sortedIdx < sortedVertices.size(); )
+			{
+				size_t groupEnd = sortedIdx + 1;
+				while (groupEnd < sortedVertices.size() && InMesh.m_Positions[sortedVertices[groupEnd]] == InMesh.m_Positions[sortedVertices[sortedIdx]])
+				{
+					++groupEnd;
+				}
+
+				for (size_t groupIdx = sortedIdx; groupIdx < groupEnd; ++groupIdx)
+				{
+					weldedVertices[sortedVertices[groupIdx]] = sortedVertices[sortedIdx];
+
+					// Moving one of the vertices of a seam would open it
+					if (groupEnd - sortedIdx > 1)
+					{
+						m_VertexKinds[sortedVertices[groupIdx]] = SIMPLIFIER_VERTEX_KIND::LOCKED;
+					}
+				}
+
+				sortedIdx = groupEnd;
+			}
+
+			// Edges of a single triangle are on a border, edges of more than two triangles are non-manifold
+			std::vector<Mox::SimplifierEdge> weldedEdges;
+			weldedEdges.reserve(m_Indices.size());
+			for (uint32_t triangleIdx = 0; triangleIdx < GetTrianglesNum(); ++triangleIdx)
+			{
+				for (uint32_t cornerIdx = 0; cornerIdx < 3; ++cornerIdx)
+				{
+					const uint32_t first = weldedVertices[m_Indices[triangleIdx * 3 + cornerIdx]];
+					const uint32_t second = weldedVertices[m_Indices[triangleIdx * 3 + (cornerIdx + 1) % 3]];
+					weldedEdges.push_back({ std::min(first, second), std::max(first, second), triangleIdx * 3 + cornerIdx });
+				}
+			}
+
+			std::sort(weldedEdges.begin(), weldedEdges.end());
+
+			for (size_t edgeIdx = 0; edgeIdx < weldedEdges.size(); )
+			{
+				size_t edgeEnd = edgeIdx + 1;
+				while (edgeEnd < weldedEdges.size() && weldedEdges[edgeEnd].IsSameEdge(weldedEdges[edgeIdx]))
+				{
+					++edgeEnd;
+				}
+
+				if (edgeEnd - edgeIdx != 2)
+				{
+					// Welded vertices are only used to match edges, the actual vertices of the edge are the ones of its triangle
+					const uint32_t corner = weldedEdges[edgeIdx].m_Corner;
+					const uint32_t triangleFirstCorner = corner - corner % 3;
+					const uint32_t edgeVertices[2] = { m_Indices[corner], m_Indices[triangleFirstCorner + (corner + 1) % 3] };
+
+					for (uint32_t edgeVertex : edgeVertices)
+					{
+						if (edgeEnd - edgeIdx > 2)
+						{
+							m_VertexKinds[edgeVertex] = SIMPLIFIER_VERTEX_KIND::LOCKED;
+						}
+						else if (m_VertexKinds[edgeVertex] == SIMPLIFIER_VERTEX_KIND::INTERIOR)
+						{
+							m_VertexKinds[edgeVertex] = SIMPLIFIER_VERTEX_KIND::BORDER;
+						}
+					}
+				}
+
+				edgeIdx = edgeEnd;
+			}
+		}
+
+		void QuadricSimplifier::ComputeQuadrics()
+		{
+			m_Quadrics.assign(static_cast<size_t>(m_VerticesNum) * m_QuadricStride, 0.);
+
+			// Triangle edges, to find the border ones
+			m_Edges.clear();
+
+			for (uint32_t triangleIdx = 0; triangleIdx < GetTrianglesNum(); ++triangleIdx)
+			{
+				const uint32_t* triangle = m_Indices.data() + triangleIdx * 3;
+				const double* points[3] = { GetPoint(triangle[0]), GetPoint(triangle[1]), GetPoint(triangle[2]) };
+
+				const Eigen::Vector3d firstEdge = Eigen::Vector3d(points[1]) - Eigen::Vector3d(points[0]);
+				const Eigen::Vector3d secondEdge = Eigen::Vector3d(points[2]) - Eigen::Vector3d(points[0]);
+				const double area = .5 * firstEdge.cross(secondEdge).norm();
+
+				// Weighting by area makes the error of a vertex independent of how finely the surface around it is tessellated
+				for (uint32_t cornerIdx = 0; cornerIdx < 3; ++cornerIdx)
+				{
+					AddTriangleQuadric(GetQuadric(triangle[cornerIdx]), points[0], points[1], points[2], area);
+
+					const uint32_t first = triangle[cornerIdx], second = triangle[(cornerIdx + 1) % 3];
+					m_Edges.push_back({ std::min(first, second), std::max(first, second), triangleIdx * 3 + cornerIdx });
+				}
+			}
+
+			std::sort(m_Edges.begin(), m_Edges.end());
+
+			for (size_t edgeIdx = 0; edgeIdx < m_Edges.size(); ++edgeIdx)
+			{
+				const bool isSingleTriangleEdge = (edgeIdx == 0 || !m_Edges[edgeIdx - 1].IsSameEdge(m_Edges[edgeIdx]))
+					&& (edgeIdx + 1 == m_Edges.size() || !m_Edges[edgeIdx + 1].IsSameEdge(m_Edges[edgeIdx]));
+
+				const uint32_t first = m_Edges[edgeIdx].m_First, second = m_Edges[edgeIdx].m_Second;
+				const bool isBorderEdge = isSingleTriangleEdge
+					&& m_VertexKinds[first] != SIMPLIFIER_VERTEX_KIND::INTERIOR && m_VertexKinds[second] != SIMPLIFIER_VERTEX_KIND::INTERIOR;
+
+				if (isBorderEdge)
+				{
+					const uint32_t corner = m_Edges[edgeIdx].m_Corner;
+					const uint32_t opposite = m_Indices[corner - corner % 3 + (corner + 2) % 3];
+
+					AddBorderQuadric(GetQuadric(first), GetPoint(first), GetPoint(second), GetPoint(opposite));
+					AddBorderQuadric(GetQuadric(second), GetPoint(first), GetPoint(second), GetPoint(opposite));
+				}
+			}
+		}
+
+		void QuadricSimplifier::AddTriangleQuadric(double* InOutQuadric, const double* InFirst, const double* InSecond, const double* InThird, double InWeight) const
+		{
+			// Generalized quadric of the plane of the triangle in n dimensions: the error is the squared distance from the plane,
+			// that is the squared length of the point minus its projection on the two orthonormal directions of the triangle.
+			// A = I - e1*e1T - e2*e2T, b = (p.e1)*e1 + (p.e2)*e2 - p, c = p.p - (p.e1)^2 - (p.e2)^2
+			const uint32_t dimension = m_Dimension;
+			double e1[SimplifierMaxDimension], e2[SimplifierMaxDimension];
+
+			double e1Length = 0., e1DotE2 = 0.;
+			for (uint32_t coordIdx = 0; coordIdx < dimension; ++coordIdx)
+			{
+				e1[coordIdx] = InSecond[coordIdx] - InFirst[coordIdx];
+				e1Length += e1[coordIdx] * e1[coordIdx];
+			}
+			e1Length = std::sqrt(e1Length);
+			if (e1Length <= 0.)
+			{
+				return;
+			}
+
+			for (uint32_t coordIdx = 0; coordIdx < dimension; ++coordIdx)
+			{
+				e1[coordIdx] /= e1Length;
+				e2[coordIdx] = InThird[coordIdx] - InFirst[coordIdx];
+				e1DotE2 += e1[coordIdx] * e2[coordIdx];
+			}
+
+			double e2Length = 0.;
+			for (uint32_t coordIdx = 0; coordIdx < dimension; ++coordIdx)
+			{
+				e2[coordIdx] -= e1DotE2 * e1[coordIdx];
+				e2Length += e2[coordIdx] * e2[coordIdx];
+			}
+			e2Length = std::sqrt(e2Length);
+			if (e2Length <= 0.)
+			{
+				return;
+			}
+
+			double pDotE1 = 0., pDotE2 = 0., pDotP = 0.;
+			for (uint32_t coordIdx = 0; coordIdx < dimension; ++coordIdx)
+			{
+				e2[coordIdx] /= e2Length;
+				pDotE1 += InFirst[coordIdx] * e1[coordIdx];
+				pDotE2 += InFirst[coordIdx] * e2[coordIdx];
+				pDotP += InFirst[coordIdx] * InFirst[coordIdx];
+			}
+
+			double* quadricA = InOutQuadric;
+			for (uint32_t rowIdx = 0; rowIdx < dimension; ++rowIdx)
+			{
+				for (uint32_t columnIdx = rowIdx; columnIdx < dimension; ++columnIdx)
+				{
+					const double identity = rowIdx == columnIdx ? 1. : 0.;
+					*quadricA++ += InWeight * (identity - e1[rowIdx] * e1[columnIdx] - e2[rowIdx] * e2[columnIdx]);
+				}
+			}
+
+			double* quadricB = quadricA;
+			for (uint32_t coordIdx = 0; coordIdx < dimension; ++coordIdx)
+			{
+				quadricB[coordIdx] += InWeight * (pDotE1 * e1[coordIdx] + pDotE2 * e2[coordIdx] - InFirst[coordIdx]);
+			}
+
+			quadricB[dimension] += InWeight * (pDotP - pDotE1 * pDotE1 - pDotE2 * pDotE2);
+			quadricB[dimension + 1] += InWeight;
+		}
+
+		void QuadricSimplifier::AddBorderQuadric(double* InOutQuadric, const double* InFirst, const double* InSecond, const double* InOpposite) const
+		{
+			// Plane containing the border edge and perpendicular to its triangle, so that moving a vertex away from the border costs more.
+			// It only constrains positions, attributes have no part in it.
+			const Eigen::Vector3d first(InFirst), second(InSecond), opposite(InOpposite);
+			const Eigen::Vector3d edge = second - first;
+			const Eigen::Vector3d triangleNormal = edge.cross(opposite - first);
+			const Eigen::Vector3d planeNormal = edge.cross(triangleNormal);
+
+			const double planeNormalLength = planeNormal.norm();
+			if (planeNormalLength <= 0.)
+			{
+				return;
+			}
+
+			const Eigen::Vector3d normal = planeNormal / planeNormalLength;
+			const double distance = -normal.dot(first);
+			// Scaled by the squared edge length, as the triangle quadrics are by their area
+			const double weight = BorderQuadricWeight * edge.squaredNorm();
+
+			// Squared distance from the plane: xT*(n*nT)*x + 2*d*nT*x + d^2
+			double* quadricA = InOutQuadric;
+			for (uint32_t rowIdx = 0; rowIdx < m_Dimension; ++rowIdx)
+			{
+				for (uint32_t columnIdx = rowIdx; columnIdx < m_Dimension; ++columnIdx)
+				{
+					if (rowIdx < 3 && columnIdx < 3)
+					{
+						*quadricA += weight * normal[rowIdx] * normal[columnIdx];
+					}
+					++quadricA;
+				}
+			}
+
+			double* quadricB = quadricA;
+			for (uint32_t coordIdx = 0; coordIdx < 3; ++coordIdx)
+			{
+				quadricB[coordIdx] += weight * distance * normal[coordIdx];
+			}
+
+			quadricB[m_Dimension] += weight * distance * distance;
+			// The weight is not accumulated, so that the error stays an average over the surface
+		}
+
+		double QuadricSimplifier::EvaluateQuadric(const double* InQuadric, const double* InPoint) const
+		{
+			double error = 0.;
+
+			const double* quadricA = InQuadric;
+			for (uint32_t rowIdx = 0; rowIdx < m_Dimension; ++rowIdx)
+			{
+				error += *quadricA++ * InPoint[rowIdx] * InPoint[rowIdx];
+				for (uint32_t columnIdx = rowIdx + 1; columnIdx < m_Dimension; ++columnIdx)
+				{
+					error += 2. * *quadricA++ * InPoint[rowIdx] * InPoint[columnIdx];
+				}
+			}
+
+			const double* quadricB = quadricA;
+			for (uint32_t coordIdx = 0; coordIdx < m_Dimension; ++coordIdx)
+			{
+				error += 2. * quadricB[coordIdx] * InPoint[coordIdx];
+			}
+
+			return error + quadricB[m_Dimension];
+		}
+
+		void QuadricSimplifier::BuildAdjacency()
+		{
+			m_VertexTrianglesOffsets.assign(m_VerticesNum + 1, 0);
+			for (uint32_t vertexIdx : m_Indices)
+			{
+				++m_VertexTrianglesOffsets[vertexIdx + 1];
+			}
+
+			for (uint32_t vertexIdx = 0; vertexIdx < m_VerticesNum; ++vertexIdx)
+			{
+				m_VertexTrianglesOffsets[vertexIdx + 1] += m_VertexTrianglesOffsets[vertexIdx];
+			}
+
+			m_VertexTriangles.resize(m_Indices.size());
+			std::vector<uint32_t> vertexFillOffsets(m_VertexTrianglesOffsets.begin(), m_VertexTrianglesOffsets.end() - 1);
+			for (uint32_t cornerIdx = 0; cornerIdx < m_Indices.size(); ++cornerIdx)
+			{
+				m_VertexTriangles[vertexFillOffsets[m_Indices[cornerIdx]]++] = cornerIdx / 3;
+			}
+		}
+
+		void QuadricSimplifier::GatherCollapses()
+		{
+			m_Edges.clear();
+			for (uint32_t cornerIdx = 0; cornerIdx < m_Indices.size(); ++cornerIdx)
+			{
+				const uint32_t first = m_Indices[cornerIdx], second = m_Indices[cornerIdx - cornerIdx % 3 + (cornerIdx + 1) % 3];
+				m_Edges.push_back({ std::min(first, second), std::max(first, second), cornerIdx });
+			}
+
+			std::sort(m_Edges.begin(), m_Edges.end());
+
+			m_Collapses.clear();
+			for (size_t edgeIdx = 0; edgeIdx < m_Edges.size(); )
+			{
+				size_t edgeEnd = edgeIdx + 1;
+				while (edgeEnd < m_Edges.size() && m_Edges[edgeEnd].IsSameEdge(m_Edges[edgeIdx]))
+				{
+					++edgeEnd;
+				}
+
+				const uint32_t first = m_Edges[edgeIdx].m_First, second = m_Edges[edgeIdx].m_Second;
+				const bool isBorderEdge = edgeEnd - edgeIdx == 1;
+
+				// Either vertex can be the one removed, the cheapest of the allowed directions is kept
+				const double edgeWeight = GetQuadric(first)[m_QuadricStride - 1] + GetQuadric(second)[m_QuadricStride - 1];
+				SimplifierCollapse bestCollapse{ 0, 0, std::numeric_limits<double>::max() };
+
+				for (const auto& [from, to] : { std::make_pair(first, second), std::make_pair(second, first) })
+				{
+					const bool isAllowed = m_VertexKinds[from] == SIMPLIFIER_VERTEX_KIND::INTERIOR
+						|| (m_VertexKinds[from] == SIMPLIFIER_VERTEX_KIND::BORDER && isBorderEdge && m_VertexKinds[to] != SIMPLIFIER_VERTEX_KIND::INTERIOR);
+
+					if (!isAllowed)
+					{
+						continue;
+					}
+
+					const double cost = (EvaluateQuadric(GetQuadric(from), GetPoint(to)) + EvaluateQuadric(GetQuadric(to), GetPoint(to))) / std::max(edgeWeight, std::numeric_limits<double>::min());
+
+					// Rounding can give slightly negative errors for points on the planes
+					const SimplifierCollapse collapse{ from, to, std::max(cost, 0.) };
+					if (collapse < bestCollapse)
+					{
+						bestCollapse = collapse;
+					}
+				}
+
+				if (bestCollapse.m_Cost <= m_MaxAllowedCost)
+				{
+					m_Collapses.push_back(bestCollapse);
+				}
+
+				edgeIdx = edgeEnd;
+			}
+
+			std::sort(m_Collapses.begin(), m_Collapses.end());
+		}
+
+		void QuadricSimplifier::GatherNeighbours(uint32_t InVertex, std::vector<uint32_t>& OutNeighbours) const
+		{
+			OutNeighbours.clear();
+			for (uint32_t adjacencyIdx = m_VertexTrianglesOffsets[InVertex]; adjacencyIdx < m_VertexTrianglesOffsets[InVertex + 1]; ++adjacencyIdx)
+			{
+				const uint32_t* triangle = m_Indices.data() + m_VertexTriangles[adjacencyIdx] * 3;
+				for (uint32_t cornerIdx = 0; cornerIdx < 3; ++cornerIdx)
+				{
+					if (triangle[cornerIdx] != InVertex)
+					{
+						OutNeighbours.push_back(triangle[cornerIdx]);
+					}
+				}
+			}
+
+			std::sort(OutNeighbours.begin(), OutNeighbours.end());
+			OutNeighbours.erase(std::unique(OutNeighbours.begin(), OutNeighbours.end()), OutNeighbours.end());
+		}
+
+		bool QuadricSimplifier::IsCollapseValid(const SimplifierCollapse& InCollapse)
+		{
+			// Triangles around the removed vertex get the position of the other one, none of them is allowed to flip
+			uint32_t sharedTrianglesNum = 0;
+			for (uint32_t adjacencyIdx = m_VertexTrianglesOffsets[InCollapse.m_From]; adjacencyIdx < m_VertexTrianglesOffsets[InCollapse.m_From + 1]; ++adjacencyIdx)
+			{
+				const uint32_t* triangle = m_Indices.data() + m_VertexTriangles[adjacencyIdx] * 3;
+				if (triangle[0] == InCollapse.m_To || triangle[1] == InCollapse.m_To || triangle[2] == InCollapse.m_To)
+				{
+					// It becomes degenerate and gets removed
+					++sharedTrianglesNum;
+					continue;
+				}
+
+				Eigen::Vector3d corners[3], movedCorners[3];
+				for (uint32_t cornerIdx = 0; cornerIdx < 3; ++cornerIdx)
+				{
+					corners[cornerIdx] = Eigen::Vector3d(GetPoint(triangle[cornerIdx]));
+					movedCorners[cornerIdx] = triangle[cornerIdx] == InCollapse.m_From ? Eigen::Vector3d(GetPoint(InCollapse.m_To)) : corners[cornerIdx];
+				}
+
+				const Eigen::Vector3d normal = (corners[1] - corners[0]).cross(corners[2] - corners[0]);
+				const Eigen::Vector3d movedNormal = (movedCorners[1] - movedCorners[0]).cross(movedCorners[2] - movedCorners[0]);
+				if (normal.dot(movedNormal) <= 0.)
+				{
+					return false;
+				}
+			}
+
+			// Link condition: the two vertices can only share the neighbours of the triangles on the collapsed edge,
+			// otherwise the collapse would join two sheets of the surface in a non-manifold edge
+			GatherNeighbours(InCollapse.m_From, m_FromNeighbours);
+			GatherNeighbours(InCollapse.m_To, m_ToNeighbours);
+
+			uint32_t sharedNeighboursNum = 0;
+			for (size_t fromIdx = 0, toIdx = 0; fromIdx < m_FromNeighbours.size() && toIdx < m_ToNeighbours.size(); )
+			{
+				if (m_FromNeighbours[fromIdx] == m_ToNeighbours[toIdx])
+				{
+					++sharedNeighboursNum; ++fromIdx; ++toIdx;
+				}
+				else if (m_FromNeighbours[fromIdx] < m_ToNeighbours[toIdx])
+				{
+					++fromIdx;
+				}
+				else
+				{
+					++toIdx;
+				}
+			}
+
+			return sharedNeighboursNum == sharedTrianglesNum;
+		}
+
+		bool QuadricSimplifier::Simplify(uint32_t InTargetTrianglesNum)
+		{
+			while (GetTrianglesNum() > InTargetTrianglesNum)
+			{
+				BuildAdjacency();
+
+				GatherCollapses();
+
+				m_IsVertexTouched.assign(m_VerticesNum, false);
+
+				// Every collapse removes the triangles on its edge, the pass stops once enough of them are gone
+				const uint32_t trianglesToRemove = GetTrianglesNum() - InTargetTrianglesNum;
+				uint32_t removedTrianglesNum = 0;
+				bool hasCollapsed = false;
+
+				for (const SimplifierCollapse& collapse : m_Collapses)
+				{
+					// Collapses next to one already done in the pass were evaluated on triangles that changed
+					if (m_IsVertexTouched[collapse.m_From] || m_IsVertexTouched[collapse.m_To] || !IsCollapseValid(collapse))
+					{
+						continue;
+					}
+
+					for (uint32_t adjacencyIdx = m_VertexTrianglesOffsets[collapse.m_From]; adjacencyIdx < m_VertexTrianglesOffsets[collapse.m_From + 1]; ++adjacencyIdx)
+					{
+						uint32_t* triangle = m_Indices.data() + m_VertexTriangles[adjacencyIdx] * 3;
+
+						removedTrianglesNum += (triangle[0] == collapse.m_To || triangle[1] == collapse.m_To || triangle[2] == collapse.m_To) ? 1 : 0;
+
+						for (uint32_t cornerIdx = 0; cornerIdx < 3; ++cornerIdx)
+						{
+							m_IsVertexTouched[triangle[cornerIdx]] = true;
+							triangle[cornerIdx] = triangle[cornerIdx] == collapse.m_From ? collapse.m_To : triangle[cornerIdx];
+						}
+					}
+
+					double* toQuadric = GetQuadric(collapse.m_To);
+					const double* fromQuadric = GetQuadric(collapse.m_From);
+					for (uint32_t quadricIdx = 0; quadricIdx < m_QuadricStride; ++quadricIdx)
+					{
+						toQuadric[quadricIdx] += fromQuadric[quadricIdx];
+					}
+
+					m_MaxCollapseCost = std::max(m_MaxCollapseCost, collapse.m_Cost);
+					hasCollapsed = true;
+
+					if (removedTrianglesNum >= trianglesToRemove)
+					{
+						break;
+					}
+				}
+
+				// Triangles on the collapsed edges now have two equal corners
+				size_t keptIndicesNum = 0;
+				for (size_t cornerIdx = 0; cornerIdx < m_Indices.size(); cornerIdx += 3)
+				{
+					const uint32_t* triangle = m_Indices.data() + cornerIdx;
+					if (triangle[0] != triangle[1] && triangle[1] != triangle[2] && triangle[2] != triangle[0])
+					{
+						std::copy(triangle, triangle + 3, m_Indices.data() + keptIndicesNum);
+						keptIndicesNum += 3;
+					}
+				}
+				m_Indices.resize(keptIndicesNum);
+
+				if (!hasCollapsed)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+	}
+
+	void GenerateMeshLods(const Mox::SimplifierMesh& InMesh, const Mox::MeshLodSettings& InSettings, std::vector<Mox::SimplifiedMeshLod>& OutLods)
+	{
+		Check(InMesh.m_AttributesNum <= Mox::SimplifierMaxAttributesNum)
+
+		OutLods.clear();
+
+		QuadricSimplifier simplifier(InMesh, InSettings);
+
+		uint32_t prevTrianglesNum = simplifier.GetTrianglesNum();
+		for (uint32_t lodIdx = 0; lodIdx < InSettings.m_LodsNum; ++lodIdx)
+		{
+			const uint32_t targetTrianglesNum = static_cast<uint32_t>(prevTrianglesNum * InSettings.m_TrianglesRatio);
+			const bool isTargetReached = simplifier.Simplify(targetTrianglesNum);
+
+			// A level with the triangles of the previous one would only take memory
+			if (simplifier.GetTrianglesNum() == prevTrianglesNum)
+			{
+				break;
+			}
+
+			OutLods.push_back({ simplifier.GetIndices(), simplifier.GetError() });
+			prevTrianglesNum = simplifier.GetTrianglesNum();
+
+			// The next levels would be stopped by the same collapses
+			if (!isTargetReached)
+			{
+				break;
+			}
+		}
+	}
+
+	void GenerateMeshLods(const std::vector<const Mox::SimplifierMesh*>& InMeshes, const Mox::MeshLodSettings& InSettings,
+		std::vector<std::vector<Mox::SimplifiedMeshLod>>& OutMeshLods)
+	{
+		OutMeshLods.resize(InMeshes.size());
+
+		// Meshes are independent and each one writes its own levels, so the result does not depend on the scheduling
+		Mox::ParallelFor(InMeshes.size(), [&InMeshes, &InSettings, &OutMeshLods](size_t InMeshIdx) {
+			GenerateMeshLods(*InMeshes[InMeshIdx], InSettings, OutMeshLods[InMeshIdx]);
+		});
+	}
+
+}
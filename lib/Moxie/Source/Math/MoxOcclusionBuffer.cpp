@@ -0,0 +1,334 @@
+/*
+ MoxOcclusionBuffer.cpp
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#include "MoxOcclusionBuffer.h"
+#include "TaskSystem.h"
+#include "MoxUtils.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define MOX_OCCLUSION_BUFFER_SSE 1
+#include <immintrin.h>
+#endif
+
+namespace Mox {
+
+	namespace
+	{
+		// Screen position of a clip space point, with y going down from the top of the screen
+		inline Mox::Vector3f ClipToScreen(const Mox::Vector4f& InClipPos, float InWidth, float InHeight)
+		{
+			const float invW = 1.f / InClipPos.w();
+			return Mox::Vector3f(
+				(InClipPos.x() * invW * 0.5f + 0.5f) * InWidth,
+				(0.5f - InClipPos.y() * invW * 0.5f) * InHeight,
+				InClipPos.z() * invW);
+		}
+
+		// Edge function in the form A * x + B * y + C, positive on the inner side of the edge
+		struct EdgeFunction
+		{
+			float m_A, m_B, m_C;
+
+			EdgeFunction(float InStartX, float InStartY, float InEndX, float InEndY)
+				: m_A(InStartY - InEndY), m_B(InEndX - InStartX), m_C(InStartX * InEndY - InStartY * InEndX) { }
+		};
+	}
+
+	OcclusionBuffer::OcclusionBuffer(uint32_t InWidth, uint32_t InHeight)
+		: m_TilesX((InWidth + TileWidth - 1) / TileWidth), m_TilesY((InHeight + TileHeight - 1) / TileHeight)
+	{
+		m_Width = m_TilesX * TileWidth;
+		m_Height = m_TilesY * TileHeight;
+
+		m_Depth.resize(m_Width * m_Height, 1.f);
+		m_TileMaxDepth.resize(m_TilesX * m_TilesY, 1.f);
+	}
+
+	void OcclusionBuffer::BeginFrame(const Mox::Matrix4f& InViewProj)
+	{
+		m_ViewProj = InViewProj;
+
+		std::fill(m_Depth.begin(), m_Depth.end(), 1.f);
+		std::fill(m_TileMaxDepth.begin(), m_TileMaxDepth.end(), 1.f);
+
+		m_Triangles.clear();
+	}
+
+	void OcclusionBuffer::AddOccluder(const Mox::OccluderMesh& InMesh, const Mox::Matrix4f& InModelMatrix)
+	{
+		Check(InMesh.m_Indices.size() % 3 == 0)
+
+		const Mox::Matrix4f modelViewProj = m_ViewProj * InModelMatrix;
+
+		const float width = static_cast<float>(m_Width);
+		const float height = static_cast<float>(m_Height);
+
+		for (size_t firstIndex = 0; firstIndex < InMesh.m_Indices.size(); firstIndex += 3)
+		{
+			Mox::Vector3f screenPositions[3];
+			bool isCrossingNearPlane = false;
+
+			for (uint32_t vertexIdx = 0; vertexIdx < 3; ++vertexIdx)
+			{
+				const Mox::Vector3f& position = InMesh.m_Positions[InMesh.m_Indices[firstIndex + vertexIdx]];
+				const Mox::Vector4f clipPosition = modelViewProj * Mox::Vector4f(position.x(), position.y(), position.z(), 1.f);
+
+				// With Direct3D depth, points in front of the near plane have negative z, and this includes points behind the camera
+				if (clipPosition.z() < 0.f)
+				{
+					isCrossingNearPlane = true;
+					break;
+				}
+
+				screenPositions[vertexIdx] = ClipToScreen(clipPosition, width, height);
+			}
+
+			if (isCrossingNearPlane)
+			{
+				continue;
+			}
+
+			// Winding is made consistent, so that inner sides of the edges always have positive edge functions
+			float doubleArea = (screenPositions[1].x() - screenPositions[0].x()) * (screenPositions[2].y() - screenPositions[0].y())
+				- (screenPositions[2].x() - screenPositions[0].x()) * (screenPositions[1].y() - screenPositions[0].y());
+
+			if (std::abs(doubleArea) < 1e-6f)
+			{
+				continue;
+			}
+
+			if (doubleArea < 0.f)
+			{
+				std::swap(screenPositions[1], screenPositions[2]);
+				doubleArea = -doubleArea;
+			}
+
+			const float minY = std::min({ screenPositions[0].y(), screenPositions[1].y(), screenPositions[2].y() });
+			const float maxY = std::max({ screenPositions[0].y(), screenPositions[1].y(), screenPositions[2].y() });
+
+			// Rows whose pixel centers can be inside the triangle
+			ScreenTriangle newTriangle;
+			newTriangle.m_MinRow = std::max(static_cast<int32_t>(std::ceil(minY - 0.5f)), 0);
+			newTriangle.m_MaxRow = std::min(static_cast<int32_t>(std::floor(maxY - 0.5f)), static_cast<int32_t>(m_Height) - 1);
+
+			if (newTriangle.m_MinRow > newTriangle.m_MaxRow)
+			{
+				continue;
+			}
+
+			for (uint32_t vertexIdx = 0; vertexIdx < 3; ++vertexIdx)
+			{
+				newTriangle.m_X[vertexIdx] = screenPositions[vertexIdx].x();
+				newTriangle.m_Y[vertexIdx] = screenPositions[vertexIdx].y();
+			}
+
+			// Depth is linear in screen space after the perspective divide, so it can be expressed as a plane over x and y
+			const Mox::Vector3f firstEdge = screenPositions[1] - screenPositions[0];
+			const Mox::Vector3f secondEdge = screenPositions[2] - screenPositions[0];
+			newTriangle.m_DepthPlane[0] = (firstEdge.z() * secondEdge.y() - secondEdge.z() * firstEdge.y()) / doubleArea;
+			newTriangle.m_DepthPlane[1] = (firstEdge.x() * secondEdge.z() - secondEdge.x() * firstEdge.z()) / doubleArea;
+			newTriangle.m_DepthPlane[2] = screenPositions[0].z() - newTriangle.m_DepthPlane[0] * screenPositions[0].x() - newTriangle.m_DepthPlane[1] * screenPositions[0].y();
+
+			m_Triangles.push_back(newTriangle);
+		}
+	}
+
+	void OcclusionBuffer::Rasterize()
+	{
+		// Every band writes to its own rows only, so bands can be rasterized concurrently without synchronization
+		Mox::ParallelFor(m_TilesY, [this](size_t InTileRow) {
+			RasterizeBand(static_cast<uint32_t>(InTileRow));
+		});
+	}
+
+	bool OcclusionBuffer::IsOccluded(const Mox::Aabb& InWorldBox) const
+	{
+		if (!InWorldBox.IsValid())
+		{
+			return false;
+		}
+
+		const float width = static_cast<float>(m_Width);
+		const float height = static_cast<float>(m_Height);
+
+		// Screen rectangle and nearest depth of the box, from its projected corners
+		Mox::Aabb screenBounds;
+		for (uint32_t cornerIdx = 0; cornerIdx < 8; ++cornerIdx)
+		{
+			const Mox::Vector4f corner(
+				cornerIdx & 1 ? InWorldBox.m_Max.x() : InWorldBox.m_Min.x(),
+				cornerIdx & 2 ? InWorldBox.m_Max.y() : InWorldBox.m_Min.y(),
+				cornerIdx & 4 ? InWorldBox.m_Max.z() : InWorldBox.m_Min.z(),
+				1.f);
+
+			const Mox::Vector4f clipPosition = m_ViewProj * corner;
+
+			// Boxes reaching the camera cannot be hidden
+			if (clipPosition.z() < 0.f)
+			{
+				return false;
+			}
+
+			screenBounds.Expand(ClipToScreen(clipPosition, width, height));
+		}
+
+		// Boxes outside the screen are left to frustum culling
+		if (screenBounds.m_Max.x() < 0.f || screenBounds.m_Min.x() >= width || screenBounds.m_Max.y() < 0.f || screenBounds.m_Min.y() >= height)
+		{
+			return false;
+		}
+
+		const uint32_t minCol = static_cast<uint32_t>(std::max(screenBounds.m_Min.x(), 0.f));
+		const uint32_t maxCol = std::min(static_cast<uint32_t>(screenBounds.m_Max.x()), m_Width - 1);
+		const uint32_t minRow = static_cast<uint32_t>(std::max(screenBounds.m_Min.y(), 0.f));
+		const uint32_t maxRow = std::min(static_cast<uint32_t>(screenBounds.m_Max.y()), m_Height - 1);
+		const float nearestDepth = screenBounds.m_Min.z();
+
+		for (uint32_t tileY = minRow / TileHeight; tileY <= maxRow / TileHeight; ++tileY)
+		{
+			for (uint32_t tileX = minCol / TileWidth; tileX <= maxCol / TileWidth; ++tileX)
+			{
+				// The whole tile is nearer than the box
+				if (nearestDepth > m_TileMaxDepth[tileY * m_TilesX + tileX])
+				{
+					continue;
+				}
+
+				// Otherwise the pixels of the tile covered by the box decide
+				const uint32_t tileMinRow = std::max(minRow, tileY * TileHeight);
+				const uint32_t tileMaxRow = std::min(maxRow, tileY * TileHeight + TileHeight - 1);
+				const uint32_t tileMinCol = std::max(minCol, tileX * TileWidth);
+				const uint32_t tileMaxCol = std::min(maxCol, tileX * TileWidth + TileWidth - 1);
+
+				for (uint32_t row = tileMinRow; row <= tileMaxRow; ++row)
+				{
+					for (uint32_t col = tileMinCol; col <= tileMaxCol; ++col)
+					{
+						if (nearestDepth <= m_Depth[row * m_Width + col])
+						{
+							return false;
+						}
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	void OcclusionBuffer::RasterizeBand(uint32_t InTileRow)
+	{
+		const int32_t bandMinRow = static_cast<int32_t>(InTileRow * TileHeight);
+		const int32_t bandMaxRow = bandMinRow + static_cast<int32_t>(TileHeight) - 1;
+
+		for (const ScreenTriangle& curTriangle : m_Triangles)
+		{
+			if (curTriangle.m_MaxRow < bandMinRow || curTriangle.m_MinRow > bandMaxRow)
+			{
+				continue;
+			}
+
+			RasterizeTriangle(curTriangle, std::max(curTriangle.m_MinRow, bandMinRow), std::min(curTriangle.m_MaxRow, bandMaxRow));
+		}
+
+		UpdateTileDepths(InTileRow);
+	}
+
+	void OcclusionBuffer::RasterizeTriangle(const ScreenTriangle& InTriangle, int32_t InMinRow, int32_t InMaxRow)
+	{
+		const EdgeFunction edges[3] = {
+			EdgeFunction(InTriangle.m_X[0], InTriangle.m_Y[0], InTriangle.m_X[1], InTriangle.m_Y[1]),
+			EdgeFunction(InTriangle.m_X[1], InTriangle.m_Y[1], InTriangle.m_X[2], InTriangle.m_Y[2]),
+			EdgeFunction(InTriangle.m_X[2], InTriangle.m_Y[2], InTriangle.m_X[0], InTriangle.m_Y[0])
+		};
+
+		const float minX = std::min({ InTriangle.m_X[0], InTriangle.m_X[1], InTriangle.m_X[2] });
+		const float maxX = std::max({ InTriangle.m_X[0], InTriangle.m_X[1], InTriangle.m_X[2] });
+
+		const int32_t minCol = std::max(static_cast<int32_t>(std::ceil(minX - 0.5f)), 0);
+		const int32_t maxCol = std::min(static_cast<int32_t>(std::floor(maxX - 0.5f)), static_cast<int32_t>(m_Width) - 1);
+
+		if (minCol > maxCol)
+		{
+			return;
+		}
+
+		// Pixels are processed in aligned groups of 4. The width is a multiple of the tile width, so groups never go past the end of a row.
+		const int32_t firstGroupCol = minCol & ~3;
+
+		for (int32_t row = InMinRow; row <= InMaxRow; ++row)
+		{
+			const float centerY = row + 0.5f;
+			float* rowDepth = m_Depth.data() + row * m_Width;
+
+			// Terms that are constant along the row
+			const float edgeRowTerms[3] = {
+				edges[0].m_B * centerY + edges[0].m_C,
+				edges[1].m_B * centerY + edges[1].m_C,
+				edges[2].m_B * centerY + edges[2].m_C
+			};
+			const float depthRowTerm = InTriangle.m_DepthPlane[1] * centerY + InTriangle.m_DepthPlane[2];
+
+#if MOX_OCCLUSION_BUFFER_SSE
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+			for (int32_t groupCol = firstGroupCol; groupCol <= maxCol; groupCol += 4)
+			{
+				const __m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(groupCol)), laneOffsets);
+
+				__m128 insideLanes = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(edges[0].m_A)), _mm_set1_ps(edgeRowTerms[0])), zero);
+				insideLanes = _mm_and_ps(insideLanes, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(edges[1].m_A)), _mm_set1_ps(edgeRowTerms[1])), zero));
+				insideLanes = _mm_and_ps(insideLanes, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(edges[2].m_A)), _mm_set1_ps(edgeRowTerms[2])), zero));
+
+				if (_mm_movemask_ps(insideLanes) == 0)
+				{
+					continue;
+				}
+
+				const __m128 triangleDepth = _mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(InTriangle.m_DepthPlane[0])), _mm_set1_ps(depthRowTerm));
+				const __m128 currentDepth = _mm_loadu_ps(rowDepth + groupCol);
+
+				// Nearest depth where the triangle covers the pixel, current depth elsewhere
+				const __m128 nearestDepth = _mm_min_ps(currentDepth, triangleDepth);
+				_mm_storeu_ps(rowDepth + groupCol, _mm_or_ps(_mm_and_ps(insideLanes, nearestDepth), _mm_andnot_ps(insideLanes, currentDepth)));
+			}
+#else
+			for (int32_t col = firstGroupCol; col <= maxCol; ++col)
+			{
+				const float centerX = col + 0.5f;
+
+				if (edges[0].m_A * centerX + edgeRowTerms[0] >= 0.f
+					&& edges[1].m_A * centerX + edgeRowTerms[1] >= 0.f
+					&& edges[2].m_A * centerX + edgeRowTerms[2] >= 0.f)
+				{
+					rowDepth[col] = std::min(rowDepth[col], InTriangle.m_DepthPlane[0] * centerX + depthRowTerm);
+				}
+			}
+#endif
+		}
+	}
+
+	void OcclusionBuffer::UpdateTileDepths(uint32_t InTileRow)
+	{
+		for (uint32_t tileX = 0; tileX < m_TilesX; ++tileX)
+		{
+			float tileMaxDepth = 0.f;
+			for (uint32_t row = InTileRow * TileHeight; row < (InTileRow + 1) * TileHeight; ++row)
+			{
+				const float* tileRowDepth = m_Depth.data() + row * m_Width + tileX * TileWidth;
+				tileMaxDepth = std::max(tileMaxDepth, *std::max_element(tileRowDepth, tileRowDepth + TileWidth));
+			}
+
+			m_TileMaxDepth[InTileRow * m_TilesX + tileX] = tileMaxDepth;
+		}
+	}
+
+}
@@ -0,0 +1,123 @@
+/*
+ MoxBoundingVolumes.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef MoxBoundingVolumes_h__
+#define MoxBoundingVolumes_h__
+
+#include "MoxMath.h"
+#include <array>
+#include <limits>
+
+namespace Mox {
+
+	// Axis aligned bounding box. A default constructed box is empty and it can be grown with Expand().
+	struct Aabb
+	{
+		Mox::Vector3f m_Min = Mox::Vector3f::Constant(std::numeric_limits<float>::max());
+		Mox::Vector3f m_Max = Mox::Vector3f::Constant(std::numeric_limits<float>::lowest());
+
+		Aabb() = default;
+		Aabb(const Mox::Vector3f& InMin, const Mox::Vector3f& InMax) : m_Min(InMin), m_Max(InMax) { }
+
+		bool IsValid() const { return (m_Min.array() <= m_Max.array()).all(); }
+
+		Mox::Vector3f GetCenter() const { return (m_Min + m_Max) * 0.5f; }
+
+		Mox::Vector3f GetExtents() const { return (m_Max - m_Min) * 0.5f; }
+
+		// Used as cost metric by the bounding volume hierarchy
+		float GetSurfaceArea() const
+		{
+			const Mox::Vector3f size = m_Max - m_Min;
+			return 2.f * (size.x() * size.y() + size.y() * size.z() + size.z() * size.x());
+		}
+
+		void Expand(const Mox::Vector3f& InPoint) { m_Min = m_Min.cwiseMin(InPoint); m_Max = m_Max.cwiseMax(InPoint); }
+
+		void Expand(const Mox::Aabb& InOther) { m_Min = m_Min.cwiseMin(InOther.m_Min); m_Max = m_Max.cwiseMax(InOther.m_Max); }
+
+		// Grows the box by the given amount on every side
+		Mox::Aabb Inflated(float InMargin) const { return Mox::Aabb(m_Min.array() - InMargin, m_Max.array() + InMargin); }
+
+		bool Contains(const Mox::Aabb& InOther) const 
+		{ 
+			return (m_Min.array() <= InOther.m_Min.array()).all() && (InOther.m_Max.array() <= m_Max.array()).all(); 
+		}
+
+		bool Overlaps(const Mox::Aabb& InOther) const
+		{
+			return (m_Min.array() <= InOther.m_Max.array()).all() && (InOther.m_Min.array() <= m_Max.array()).all();
+		}
+
+		// Bounds of this box after being transformed by the given affine matrix
+		Mox::Aabb Transformed(const Mox::Matrix4f& InTransform) const;
+
+		static Mox::Aabb Union(const Mox::Aabb& InFirst, const Mox::Aabb& InSecond)
+		{
+			return Mox::Aabb(InFirst.m_Min.cwiseMin(InSecond.m_Min), InFirst.m_Max.cwiseMax(InSecond.m_Max));
+		}
+	};
+
+	struct BoundingSphere
+	{
+		Mox::Vector3f m_Center = Mox::Vector3f::Zero();
+		float m_Radius = 0.f;
+
+		bool Overlaps(const Mox::Aabb& InBox) const
+		{
+			// Distance from the center to the closest point of the box
+			const Mox::Vector3f closestPoint = m_Center.cwiseMax(InBox.m_Min).cwiseMin(InBox.m_Max);
+			return (closestPoint - m_Center).squaredNorm() <= m_Radius * m_Radius;
+		}
+	};
+
+	struct Ray
+	{
+		Mox::Vector3f m_Origin = Mox::Vector3f::Zero();
+		// Does not need to be normalized, distances are then expressed in multiples of its length
+		Mox::Vector3f m_Direction = Mox::Vector3f::UnitZ();
+		float m_MaxDistance = std::numeric_limits<float>::max();
+
+		// Slab test. If the ray hits the box, returns true with the distance of the entry point (0 if the origin is inside).
+		bool Intersects(const Mox::Aabb& InBox, float& OutDistance) const;
+	};
+
+	enum class FRUSTUM_TEST_RESULT : uint8_t
+	{
+		OUTSIDE,
+		INTERSECTING,
+		INSIDE
+	};
+
+	// Convex volume delimited by 6 planes, each stored as (normal, distance) with the normal pointing inwards
+	struct Frustum
+	{
+		// Note: Plain NEAR and FAR would collide with the macros defined by Windows.h
+		enum PLANE_INDEX : uint32_t { PLANE_LEFT = 0, PLANE_RIGHT, PLANE_BOTTOM, PLANE_TOP, PLANE_NEAR, PLANE_FAR, PLANES_NUM };
+
+		std::array<Mox::Vector4f, PLANES_NUM> m_Planes;
+
+		// Extracts the planes of a view-projection matrix, for column vectors and Direct3D clip space depth [0, 1]
+		static Mox::Frustum FromViewProjection(const Mox::Matrix4f& InViewProj);
+
+		// Only the planes set in InOutPlaneMask are tested. 
+		// Planes that fully contain the box are cleared from the mask, so that children of the box do not need to test them again.
+		Mox::FRUSTUM_TEST_RESULT Test(const Mox::Aabb& InBox, uint32_t& InOutPlaneMask) const;
+
+		bool Overlaps(const Mox::Aabb& InBox) const
+		{
+			uint32_t planeMask = AllPlanesMask;
+			return Test(InBox, planeMask) != Mox::FRUSTUM_TEST_RESULT::OUTSIDE;
+		}
+
+		static constexpr uint32_t AllPlanesMask = (1u << PLANES_NUM) - 1;
+	};
+
+}
+
+#endif // MoxBoundingVolumes_h__
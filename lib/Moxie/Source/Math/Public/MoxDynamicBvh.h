@@ -0,0 +1,155 @@
+/*
+ MoxDynamicBvh.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef MoxDynamicBvh_h__
+#define MoxDynamicBvh_h__
+
+#include "MoxBoundingVolumes.h"
+#include <vector>
+
+namespace Mox {
+
+	// Identifies an object stored in a DynamicBvh, it stays valid until the object is destroyed
+	using BvhProxyId = uint32_t;
+
+	/*
+	* Dynamic bounding volume hierarchy over axis aligned boxes, used as spatial index for objects that move, appear and disappear.
+	* - Leaves store fat boxes, enlarged by a margin, so that small movements do not need to touch the tree.
+	* - Insertions pick the sibling that adds the least surface area, then refit the ancestors on the way up
+	*   and apply tree rotations wherever they reduce the surface area of an internal node.
+	* - Bulk loads rebuild the tree top-down with a binned surface area heuristic, building separate subtrees in parallel.
+	* - Queries only visit subtrees overlapping the query volume, so their cost depends on the number of results rather than the number of objects.
+	* Each proxy carries a user value, which is what queries return.
+	* Queries can run concurrently with each other, but not with modifications.
+	* Inspired by the dynamic trees of Box2D and Bullet, and by "Fast, Effective BVH Updates for Animated Scenes" by Kopta et al.
+	*/
+	class DynamicBvh
+	{
+	public:
+		static constexpr Mox::BvhProxyId InvalidProxy = std::numeric_limits<Mox::BvhProxyId>::max();
+
+		explicit DynamicBvh(float InFatMargin = 0.1f);
+
+		Mox::BvhProxyId CreateProxy(const Mox::Aabb& InBounds, uint32_t InUserValue);
+
+		// Creates many proxies at once. When the new proxies are a significant part of the tree,
+		// the whole tree is rebuilt in parallel instead of inserting them one by one.
+		void CreateProxies(const Mox::Aabb* InBounds, const uint32_t* InUserValues, size_t InCount, Mox::BvhProxyId* OutProxies);
+
+		void DestroyProxy(Mox::BvhProxyId InProxy);
+
+		// Nothing happens while the bounds stay within the fat box of the proxy.
+		// Otherwise, small movements refit the ancestors in place and bigger ones reinsert the proxy.
+		// Returns true if the tree changed.
+		bool MoveProxy(Mox::BvhProxyId InProxy, const Mox::Aabb& InBounds);
+
+		// Rebuilds the whole tree top-down from the current proxies,
+		// which gives a better tree than the one resulting from incremental changes.
+		void Rebuild();
+
+		uint32_t GetUserValue(Mox::BvhProxyId InProxy) const { return m_Nodes[InProxy].m_UserValue; }
+
+		const Mox::Aabb& GetFatBounds(Mox::BvhProxyId InProxy) const { return m_Nodes[InProxy].m_Bounds; }
+
+		// ----- Queries -----
+		// Queries append the user values of the proxies whose fat box overlaps the query volume, in no particular order.
+
+		void QueryAabb(const Mox::Aabb& InBox, std::vector<uint32_t>& OutUserValues) const;
+
+		void QuerySphere(const Mox::BoundingSphere& InSphere, std::vector<uint32_t>& OutUserValues) const;
+
+		// Subtrees fully inside the frustum are collected without testing their nodes
+		void QueryFrustum(const Mox::Frustum& InFrustum, std::vector<uint32_t>& OutUserValues) const;
+
+		void QueryRay(const Mox::Ray& InRay, std::vector<uint32_t>& OutUserValues) const;
+
+		// ----- Statistics -----
+
+		size_t GetProxiesNum() const { return m_LeavesNum; }
+
+		// Number of edges from the root to the deepest leaf, 0 for an empty tree
+		int32_t GetHeight() const;
+
+		// Sum of the internal node areas relative to the root area. Lower values mean cheaper queries.
+		float ComputeAreaRatio() const;
+
+		// Checks the consistency of the whole structure, meant for debugging
+		void Validate() const;
+
+	private:
+		static constexpr uint32_t NullNode = std::numeric_limits<uint32_t>::max();
+
+		struct Node
+		{
+			Mox::Aabb m_Bounds;
+			// When the node is free, this is the next free node
+			uint32_t m_Parent = NullNode;
+			uint32_t m_Children[2] = { NullNode, NullNode };
+			uint32_t m_UserValue = 0;
+			// Leaves have height 0, free nodes have height -1
+			int32_t m_Height = -1;
+
+			bool IsLeaf() const { return m_Children[0] == NullNode; }
+		};
+
+		// Range of leaves whose subtree still needs to be built, together with the internal nodes reserved for it
+		struct PendingSubtree
+		{
+			uint32_t* m_Leaves;
+			size_t m_LeavesNum;
+			const uint32_t* m_InternalNodes;
+			uint32_t m_Parent;
+		};
+
+		uint32_t AllocateNode();
+
+		void FreeNode(uint32_t InNode);
+
+		uint32_t AllocateLeaf(const Mox::Aabb& InBounds, uint32_t InUserValue);
+
+		void InsertLeaf(uint32_t InLeaf);
+
+		void RemoveLeaf(uint32_t InLeaf);
+
+		// Sibling that minimizes the total surface area added to the tree, found with branch and bound
+		uint32_t FindBestSibling(const Mox::Aabb& InBounds);
+
+		// Recomputes bounds and height of the given node and all its ancestors, rotating them where it helps
+		void RefitAncestors(uint32_t InNode);
+
+		void Refit(uint32_t InNode);
+
+		// Swaps a child with a grandchild on the other side, if that reduces the area of the internal node involved
+		void TryRotate(uint32_t InNode);
+
+		// Builds the subtree over the given leaves using the given internal nodes, and returns its root.
+		// When pending subtrees are passed, ranges below a size are deferred there instead of being built,
+		// and the nodes created meanwhile are recorded to be refitted once the pending subtrees are done.
+		uint32_t BuildSubtree(uint32_t* InOutLeaves, size_t InLeavesNum, const uint32_t* InInternalNodes, uint32_t InParent,
+			size_t InMaxPendingLeavesNum, std::vector<PendingSubtree>* OutPendingSubtrees, std::vector<uint32_t>* OutNodesToRefit);
+
+		// Reorders the leaves so that the ones on the left of the returned position go in the first subtree
+		size_t SplitLeaves(uint32_t* InOutLeaves, size_t InLeavesNum) const;
+
+		std::vector<Node> m_Nodes;
+
+		uint32_t m_Root = NullNode;
+
+		uint32_t m_FreeList = NullNode;
+
+		size_t m_LeavesNum = 0;
+
+		float m_FatMargin;
+
+		// Scratch memory for the insertion search, kept to avoid allocations
+		std::vector<std::pair<uint32_t, float>> m_SearchStack;
+	};
+
+}
+
+#endif // MoxDynamicBvh_h__
@@ -0,0 +1,49 @@
+/*
+ MoxFrustumCulling.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef MoxFrustumCulling_h__
+#define MoxFrustumCulling_h__
+
+#include "MoxBoundingVolumes.h"
+#include <vector>
+
+namespace Mox {
+
+	/*
+	* Boxes stored as separate arrays of center and extents coordinates,
+	* so that the culling kernel can load the same coordinate of 4 boxes with a single instruction.
+	*/
+	struct AabbSoA
+	{
+		std::vector<float> m_CenterX, m_CenterY, m_CenterZ;
+		std::vector<float> m_ExtentX, m_ExtentY, m_ExtentZ;
+
+		void Clear();
+
+		void Reserve(size_t InCapacity);
+
+		// Empty boxes are stored as infinite ones, so that objects without bounds are never culled
+		void PushBack(const Mox::Aabb& InBox);
+
+		size_t Size() const { return m_CenterX.size(); }
+	};
+
+	// Fills OutVisibleIndices with the indices of the boxes that are not fully outside the frustum, in increasing order.
+	// Boxes are tested 4 at a time with SSE on x64 and NEON on ARM64, other platforms use a scalar loop.
+	// The test is conservative: boxes near frustum corners can be reported visible while being outside.
+	void CullBoxes(const Mox::Frustum& InFrustum, const Mox::AabbSoA& InBoxes, std::vector<uint32_t>& OutVisibleIndices);
+
+	// Fills OutScreenSizes with the projected diameter of the bounding sphere of each box, as a fraction of the view height.
+	// Depth is the dot product of InViewDepthRow with the box center, clamped to InMinDepth so that boxes around the eye get the largest size.
+	// InProjScale is the vertical scale of the projection, cotangent of half the vertical field of view.
+	// Boxes are processed 4 at a time with the same instruction sets as CullBoxes.
+	void ComputeScreenSizes(const Mox::Vector4f& InViewDepthRow, float InProjScale, float InMinDepth, const Mox::AabbSoA& InBoxes, std::vector<float>& OutScreenSizes);
+
+}
+
+#endif // MoxFrustumCulling_h__
@@ -41,6 +41,8 @@ namespace Mox {
 
 	using Vector2f = Eigen::Vector2f;
 
+	using Vector4f = Eigen::Vector4f;
+
 	using Vector3i = Eigen::Vector3i;
 
 
@@ -0,0 +1,54 @@
+/*
+ MoxMatrixKernels.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef MoxMatrixKernels_h__
+#define MoxMatrixKernels_h__
+
+#include "MoxMath.h"
+
+// ---------- MOX MATRIX KERNELS ----------
+
+// Batch operations on contiguous arrays of 4x4 column-major matrices.
+// Each operation has a SIMD implementation for every supported instruction set and a scalar fallback:
+// the best one for the running CPU is chosen at runtime, the first time a kernel is used.
+
+namespace Mox {
+
+	enum class MATRIX_KERNEL_PATH : int
+	{
+		SCALAR = 0,
+		SSE,  // 128 bit, always available on x64
+		AVX2, // 256 bit with FMA, two matrix columns per instruction
+		NEON  // 128 bit with FMA, always available on ARM64
+	};
+
+	const char* GetMatrixKernelPathName(Mox::MATRIX_KERNEL_PATH InPath);
+
+	bool IsMatrixKernelPathSupported(Mox::MATRIX_KERNEL_PATH InPath);
+
+	// Fastest path supported by the running CPU
+	Mox::MATRIX_KERNEL_PATH GetBestMatrixKernelPath();
+
+	Mox::MATRIX_KERNEL_PATH GetMatrixKernelPath();
+
+	// Forces the kernels to use the given path, mostly useful for testing and benchmarking.
+	// Returns false, and leaves the current path unchanged, if the path is not supported by the CPU.
+	bool SetMatrixKernelPath(Mox::MATRIX_KERNEL_PATH InPath);
+
+	// OutResults[i] = InLeft * InRights[i]
+	// e.g. to transform a batch of model matrices by a shared view-projection matrix.
+	// Note: OutResults can be the same array as InRights.
+	void MultiplyMatrixBatch(const Mox::Matrix4f& InLeft, const Mox::Matrix4f* InRights, Mox::Matrix4f* OutResults, size_t InCount);
+
+	// InOutMatrices[InTargetIndices[i]] = InOutMatrices[InParentIndices[i]] * InOutMatrices[InTargetIndices[i]]
+	// Entries are processed in order, so a parent can be the target of a previous entry, as in a transform hierarchy sorted by depth.
+	void ConcatenateMatrices(Mox::Matrix4f* InOutMatrices, const uint32_t* InTargetIndices, const uint32_t* InParentIndices, size_t InCount);
+
+}
+
+#endif // MoxMatrixKernels_h__
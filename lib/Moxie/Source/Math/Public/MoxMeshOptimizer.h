@@ -0,0 +1,64 @@
+/*
+ MoxMeshOptimizer.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef MoxMeshOptimizer_h__
+#define MoxMeshOptimizer_h__
+
+#include "MoxMath.h"
+#include <vector>
+
+namespace Mox {
+
+	// Post-transform cache size assumed when ordering triangles, in vertices. Close to the reuse window of current Gpus.
+	constexpr uint32_t DefaultVertexCacheSize = 16;
+
+	struct VertexCacheStats
+	{
+		// Average Cache Miss Ratio: vertex shader invocations per triangle, from 3 down to about 0.5 for regular grids
+		float m_Acmr;
+
+		// Average Transformed Vertex Ratio: vertex shader invocations per vertex referenced by the triangles, 1 at best
+		float m_Atvr;
+	};
+
+	struct MeshOptimizationStats
+	{
+		Mox::VertexCacheStats m_Before;
+		Mox::VertexCacheStats m_After;
+	};
+
+	// Simulates a FIFO post-transform cache of the given size on the triangle list
+	Mox::VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& InIndices, uint32_t InVerticesNum, uint32_t InCacheSize = Mox::DefaultVertexCacheSize);
+
+	// Reorders triangles so that vertices are reused while they are still in the post-transform cache, with the Tipsify algorithm
+	// (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"). Linear in the number of triangles.
+	void OptimizeVertexCache(std::vector<uint32_t>& InOutIndices, uint32_t InVerticesNum, uint32_t InCacheSize = Mox::DefaultVertexCacheSize);
+
+	// Reorders the clusters of triangles left by OptimizeVertexCache so that the ones facing away from the mesh center come first,
+	// as they are more likely to hide the others. Clusters start where the cache would be flushed, so the cache efficiency is kept.
+	void OptimizeOverdraw(std::vector<uint32_t>& InOutIndices, const std::vector<Mox::Vector3f>& InPositions, uint32_t InCacheSize = Mox::DefaultVertexCacheSize);
+
+	// Numbers vertices in the order the triangles first reference them, so that vertex fetches walk memory forward.
+	// Vertices not referenced keep their relative order after the others.
+	// OutRemap gives the new index of each vertex, to be applied to the vertex data and to any other index buffer sharing it.
+	void OptimizeVertexFetch(std::vector<uint32_t>& InOutIndices, uint32_t InVerticesNum, std::vector<uint32_t>& OutRemap);
+
+	// Moves each vertex of the buffer to the position given by the remap
+	void RemapVertices(void* InOutVertexData, uint32_t InVertexStride, uint32_t InVerticesNum, const std::vector<uint32_t>& InRemap);
+
+	/*
+	* Runs all the passes above on the content of a vertex and an index buffer, in place, as given to the graphics allocator.
+	* Index stride can be 2 or 4 bytes. Positions for the overdraw pass are read as 3 floats at InPositionOffset of each vertex,
+	* a negative offset skips that pass.
+	*/
+	void OptimizeMeshBuffers(void* InOutVertexData, uint32_t InVertexStride, uint32_t InVerticesNum, int32_t InPositionOffset,
+		void* InOutIndexData, uint32_t InIndexStride, uint32_t InIndicesNum, Mox::MeshOptimizationStats* OutStats = nullptr);
+
+}
+
+#endif // MoxMeshOptimizer_h__
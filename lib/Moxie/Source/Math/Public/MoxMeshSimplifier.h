@@ -0,0 +1,79 @@
+/*
+ MoxMeshSimplifier.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef MoxMeshSimplifier_h__
+#define MoxMeshSimplifier_h__
+
+#include "MoxMath.h"
+#include <vector>
+#include <limits>
+
+namespace Mox {
+
+	// Quadrics are kept for positions and attributes together, so their size grows with the square of the attributes
+	constexpr uint32_t SimplifierMaxAttributesNum = 8;
+
+	// Triangle list to simplify, with optional per-vertex attributes that are preserved together with the shape
+	struct SimplifierMesh
+	{
+		std::vector<Mox::Vector3f> m_Positions;
+
+		// m_AttributesNum values for each vertex, one vertex after the other, such as texture coordinates and colors.
+		// Up to SimplifierMaxAttributesNum per vertex.
+		std::vector<float> m_Attributes;
+		uint32_t m_AttributesNum = 0;
+
+		std::vector<uint32_t> m_Indices;
+	};
+
+	struct MeshLodSettings
+	{
+		uint32_t m_LodsNum = 3;
+
+		// Triangles each level is aiming to keep, as a fraction of the triangles of the previous level
+		float m_TrianglesRatio = .5f;
+
+		// Largest error allowed for a level, in the same units as the positions. Levels stop being generated once it is reached.
+		float m_MaxError = std::numeric_limits<float>::max();
+
+		// Scale of attribute differences compared to position distances, once positions are normalized to the size of the mesh
+		float m_AttributesWeight = 1.f;
+
+		// When set, vertices on open borders never move, otherwise they can only slide along the border
+		bool m_LockBorders = false;
+	};
+
+	struct SimplifiedMeshLod
+	{
+		// Triangles of the level, indexing the vertices of the source mesh, so that all the levels can share its vertex buffer
+		std::vector<uint32_t> m_Indices;
+
+		// Largest quadric error of the collapses done to reach the level: the root mean square distance, weighted by area,
+		// of the merged vertices from the planes of the source triangles around them. Same units as the positions.
+		float m_Error;
+	};
+
+	/*
+	* Generates levels of detail of a mesh with quadric error edge collapses (Garland and Heckbert).
+	* - Each collapse moves a vertex onto a neighbour, so levels use a subset of the source vertices and no vertex is created.
+	* - Quadrics are built in the space of positions and attributes together, so collapses that would stretch texture coordinates
+	*   or colors cost more, even when the shape does not change.
+	* - Vertices sharing a position with different attributes, along texture seams, never move, so seams do not open.
+	* - Collapses flipping a triangle or making the mesh non-manifold are rejected.
+	* Each level is simplified from the previous one, and generation stops early when the error or the topology prevent
+	* reaching the triangles of the next level. The result only depends on the input.
+	*/
+	void GenerateMeshLods(const Mox::SimplifierMesh& InMesh, const Mox::MeshLodSettings& InSettings, std::vector<Mox::SimplifiedMeshLod>& OutLods);
+
+	// Generates the levels of detail of each mesh, processing meshes in parallel
+	void GenerateMeshLods(const std::vector<const Mox::SimplifierMesh*>& InMeshes, const Mox::MeshLodSettings& InSettings,
+		std::vector<std::vector<Mox::SimplifiedMeshLod>>& OutMeshLods);
+
+}
+
+#endif // MoxMeshSimplifier_h__
@@ -0,0 +1,99 @@
+/*
+ MoxOcclusionBuffer.h
+
+ Moxie Engine - https://github.com/logins/MoxieEngine
+
+ MIT License - Copyright (c) 2022 Riccardo Loggini
+*/
+
+#ifndef MoxOcclusionBuffer_h__
+#define MoxOcclusionBuffer_h__
+
+#include "MoxBoundingVolumes.h"
+#include <vector>
+
+namespace Mox {
+
+	// Simplified geometry of an object that hides what is behind it, rasterized on the Cpu for occlusion culling.
+	// It should be contained in the rendered mesh, so that it never hides something the mesh does not hide.
+	struct OccluderMesh
+	{
+		std::vector<Mox::Vector3f> m_Positions;
+		// Three indices per triangle, winding does not matter
+		std::vector<uint32_t> m_Indices;
+	};
+
+	/*
+	* Low resolution depth buffer rasterized on the Cpu from occluder meshes, used to skip objects hidden behind them.
+	* - Occluder triangles are set up when added, then rasterized in parallel over horizontal bands of tiles.
+	*   The rasterizer evaluates edge functions and depth for 4 pixels at a time with SSE, on other platforms it falls back to scalar code.
+	* - Each tile stores the farthest depth of its pixels, so that most occludees are resolved with a test per tile
+	*   and only the tiles where that is not enough are tested per pixel.
+	* - Depth follows Direct3D conventions: 0 at the near plane, 1 at the far plane and for pixels not covered by occluders.
+	* Everything runs on the Cpu, so the depth result can be validated against reference images without a Gpu.
+	*/
+	class OcclusionBuffer
+	{
+	public:
+		static constexpr uint32_t TileWidth = 8;
+		static constexpr uint32_t TileHeight = 8;
+
+		// Dimensions are rounded up to a multiple of the tile size
+		OcclusionBuffer(uint32_t InWidth = 256, uint32_t InHeight = 128);
+
+		// Clears the buffer and sets the matrix used to project both occluders and occludees
+		void BeginFrame(const Mox::Matrix4f& InViewProj);
+
+		// Projects the triangles of the occluder and queues them for rasterization.
+		// Triangles crossing the near plane are dropped, which can only make culling less aggressive.
+		void AddOccluder(const Mox::OccluderMesh& InMesh, const Mox::Matrix4f& InModelMatrix);
+
+		// Rasterizes all the queued occluders
+		void Rasterize();
+
+		// True if the box is fully hidden by the rasterized occluders
+		bool IsOccluded(const Mox::Aabb& InWorldBox) const;
+
+		uint32_t GetWidth() const { return m_Width; }
+		uint32_t GetHeight() const { return m_Height; }
+
+		// Depth of each pixel, row by row from the top of the screen
+		const std::vector<float>& GetDepth() const { return m_Depth; }
+
+		size_t GetTrianglesNum() const { return m_Triangles.size(); }
+
+	private:
+		// Triangle in screen space, with x and y in pixels and the depth as a plane equation over the screen
+		struct ScreenTriangle
+		{
+			float m_X[3];
+			float m_Y[3];
+			// depth = m_DepthPlane[0] * x + m_DepthPlane[1] * y + m_DepthPlane[2]
+			float m_DepthPlane[3];
+			int32_t m_MinRow;
+			int32_t m_MaxRow;
+		};
+
+		void RasterizeBand(uint32_t InTileRow);
+
+		void RasterizeTriangle(const ScreenTriangle& InTriangle, int32_t InMinRow, int32_t InMaxRow);
+
+		void UpdateTileDepths(uint32_t InTileRow);
+
+		uint32_t m_Width;
+		uint32_t m_Height;
+		uint32_t m_TilesX;
+		uint32_t m_TilesY;
+
+		Mox::Matrix4f m_ViewProj = Mox::Matrix4f::Identity();
+
+		std::vector<float> m_Depth;
+		// Farthest depth of the pixels of each tile
+		std::vector<float> m_TileMaxDepth;
+
+		std::vector<ScreenTriangle> m_Triangles;
+	};
+
+}
+
+#endif // MoxOcclusionBuffer_h__
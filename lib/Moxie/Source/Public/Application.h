@@ -12,6 +12,7 @@
 #include "MoxUtils.h"
 #include "MoxMath.h"
 #include "ContextView.h"
+#include "MoxEntity.h"
 #include <mutex>
 
 namespace Mox {
@@ -26,6 +27,7 @@ namespace Mox {
 		class RenderThread;
 		class Entity;
 		struct EntityCreationInfo;
+		class FrameScheduler;
 
 	/*
 	 * Represents the whole application run from the executable.
@@ -65,6 +67,9 @@ namespace Mox {
 
 		static constexpr uint32_t GetMaxGpuConcurrentFramesNum() { return Mox::Constants::g_MaxConcurrentFramesNum; };
 
+		// Caps the main loop to the given frame rate, 0 means no limit
+		void SetTargetFrameRate(uint32_t InTargetFrameRate);
+
 		virtual void OnQuitApplication();
 
 		bool SyncForFrameStart_SimThread();
@@ -85,9 +90,21 @@ namespace Mox {
 
 		bool CanComputeFrame();
 
+		// Dispatches all the window messages currently in queue. Returns false if the application has been asked to quit.
+		bool PumpWindowMessages();
+
 		// Scene Related
 
-		Mox::Entity& AddEntity(const Mox::EntityCreationInfo& InInfo);
+		Mox::EntityHandle AddEntity(const Mox::EntityCreationInfo& InInfo);
+
+		// Meant for spawning a large number of entities at once, e.g. when loading a level
+		std::vector<Mox::EntityHandle> SpawnEntities(size_t InCount, const Mox::EntitySpawnTemplate& InTemplate);
+
+		bool RemoveEntity(Mox::EntityHandle InHandle);
+
+		// Returns nullptr if the entity has been removed.
+		// Note: the returned pointer is only valid until the next entity addition or removal.
+		Mox::Entity* GetEntity(Mox::EntityHandle InHandle);
 
 		// Render related
 
@@ -105,6 +122,8 @@ namespace Mox {
 
 		std::unique_ptr<Mox::SimulatonThread> m_Simulator;
 		std::unique_ptr<Mox::RenderThread> m_Renderer;
+
+		std::unique_ptr<Mox::FrameScheduler> m_FrameScheduler;
 		// Used to sync frames numbers between sim and render threads
 		std::mutex m_FramesMutex;
 		std::condition_variable m_SimToRenderFrameCondVar;
@@ -11,6 +11,8 @@
 
 #include "MoxGeometry.h"
 #include "GraphicsUtils.h"
+#include "MoxBoundingVolumes.h"
+#include "MoxOcclusionBuffer.h"
 
 namespace Mox {
 
@@ -28,6 +30,8 @@ namespace Mox {
 
 			m_ProjMatrix = Mox::Perspective(InZMin, InZMax, m_AspectRatio, InFov);
 
+			UpdateViewProjMatrix();
+
 			m_ScissorRect = Mox::AllocateRect(0l, 0l, LONG_MAX, LONG_MAX); // TODO we probably do not need to allocate platform specific scissor rect and viewport, we can just create the platform specific version when needed
 
 			m_Viewport = Mox::AllocateViewport(0.f, 0.f, static_cast<float>(InFrameWidth), static_cast<float>(InFrameHeight));
@@ -38,6 +42,8 @@ namespace Mox {
 			m_Fov = InFov;
 			// Projection Matrix needs updating
 			m_ProjMatrix = Mox::Perspective(m_ZMin, m_ZMax, m_AspectRatio, m_Fov);
+
+			UpdateViewProjMatrix();
 		}
 
 		void SetAspectRatio(float InAspectRatio)
@@ -45,6 +51,24 @@ namespace Mox {
 			m_AspectRatio = InAspectRatio;
 			// Projection Matrix needs updating
 			m_ProjMatrix = Mox::Perspective(m_ZMin, m_ZMax, m_AspectRatio, m_Fov);
+
+			UpdateViewProjMatrix();
+		}
+
+		void SetViewMatrix(const Mox::Matrix4f& InViewMatrix)
+		{
+			m_ViewMatrix = InViewMatrix;
+
+			UpdateViewProjMatrix();
+		}
+
+		// View and projection are combined once per view, the per-object model matrix is applied in the vertex shader
+		void UpdateViewProjMatrix()
+		{
+			// Note: We are working with column major matrices and vectors are columns, so it's: projection * view * model * point
+			m_ViewProjMatrix = m_ProjMatrix * m_ViewMatrix;
+
+			m_Frustum = Mox::Frustum::FromViewProjection(m_ViewProjMatrix);
 		}
 
 		void SetFrameDimension(float InFrameWidth, float InFrameHeight)
@@ -58,6 +82,21 @@ namespace Mox {
 
 		Mox::Matrix4f m_ProjMatrix;
 		Mox::Matrix4f m_ViewMatrix;
+		Mox::Matrix4f m_ViewProjMatrix;
+
+		// World space frustum of the view, used by render passes to cull draw commands
+		Mox::Frustum m_Frustum;
+
+		// Depth of the occluders seen from the view, rasterized each frame before render passes send their draw commands.
+		// Null when the view does not use occlusion culling.
+		std::unique_ptr<Mox::OcclusionBuffer> m_OcclusionBuffer;
+
+		// Levels of detail are selected as if objects were 2^m_LodBias times smaller on screen, positive values favor coarser levels
+		float m_LodBias = 0.f;
+
+		// Fraction of a level threshold the screen size needs to move past before the level changes, so that objects
+		// staying around a threshold do not switch level back and forth
+		float m_LodHysteresis = 0.1f;
 
 		std::unique_ptr<Mox::Rect> m_ScissorRect;
 		std::unique_ptr<Mox::ViewPort> m_Viewport;
@@ -21,6 +21,35 @@ namespace Mox {
 	namespace Constants {
 		static constexpr size_t g_MaxConcurrentFramesNum = 2;
 
+		// When enabled, content uploads are executed on a dedicated copy queue and can overlap with rendering work.
+		// Otherwise they are executed on the direct queue, ahead of the frame that needs them.
+		static constexpr bool g_UseCopyQueueForUploads = false;
+
+		// Frame rate the main loop is paced to. Applications can opt out of the limit with SetTargetFrameRate(0).
+		static constexpr uint32_t g_DefaultTargetFrameRate = 60;
+
+		// Resolution of the Cpu depth buffer where occluder meshes are rasterized, 0 disables occlusion culling
+		static constexpr uint32_t g_OcclusionBufferWidth = 256;
+		static constexpr uint32_t g_OcclusionBufferHeight = 128;
+
+		// Directory, relative to the working directory, where compiled pipeline states are kept between runs. Empty disables the cache.
+		static constexpr const char* g_PersistentCacheDirectory = "MoxieCache";
+
+		// Size in bytes of the ring buffer holding data written once per frame, such as per-instance data, shared by all the frames in flight
+		static constexpr uint32_t g_FrameDataRingSize = 8388608;
+
+	}
+
+	// 64-bit FNV-1a hash of arbitrary data, the same on every run and platform.
+	// Passing the result of a previous call as InHash continues hashing from there.
+	inline uint64_t HashBytes(const void* InData, size_t InSize, uint64_t InHash = 14695981039346656037ULL)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(InData);
+		for (size_t byteIdx = 0; byteIdx < InSize; ++byteIdx)
+		{
+			InHash = (InHash ^ bytes[byteIdx]) * 1099511628211ULL;
+		}
+		return InHash;
 	}
 
 	// In a bigger application this would go in an Input class
@@ -12,6 +12,7 @@
 #include "Async.h"
 #include "MoxEntity.h"
 #include "MoxRenderProxy.h"
+#include "MoxWorld.h"
 
 namespace Mox {
 
@@ -40,7 +41,20 @@ namespace Mox {
 
 		void OnFinishRunning();
 
-		Mox::Entity& CreateEntity(const Mox::EntityCreationInfo& InInfo);
+		Mox::EntityHandle CreateEntity(const Mox::EntityCreationInfo& InInfo);
+
+		// Creates many entities from the same template in one go. 
+		// Storage is reserved up front and the render data of all the entities is requested as a single batch.
+		std::vector<Mox::EntityHandle> SpawnEntities(size_t InCount, const Mox::EntitySpawnTemplate& InTemplate);
+
+		// Returns false if the handle does not refer to a live entity
+		bool DestroyEntity(Mox::EntityHandle InHandle);
+
+		// Returns nullptr if the entity has been destroyed.
+		// Note: the returned pointer is only valid until the next entity creation or destruction.
+		Mox::Entity* GetEntity(Mox::EntityHandle InHandle) { return m_WorldEntities.Get(InHandle); }
+
+		Mox::World& GetWorld() { return m_World; }
 
 		uint64_t GetCpuFrameNumber() { return m_SimulationFrameNumber; }
 
@@ -56,7 +70,11 @@ namespace Mox {
 
 
 
-		std::vector<Mox::Entity> m_WorldEntities;
+		// Entities are densely packed, and referenced from outside through generational handles
+		Mox::SlotMap<Mox::Entity> m_WorldEntities;
+
+		// Data-oriented storage of the entities state, processed in bulk once per frame
+		Mox::World m_World;
 
 
 		uint64_t m_SimulationFrameNumber = 1;